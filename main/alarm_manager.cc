@@ -7,10 +7,39 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstring>
 
 #define TAG "AlarmManager"
 #define ALARM_SETTINGS_NAMESPACE "alarms"
 
+// 闹钟列表整体存成一个NVS blob,启动时一次读取直接按结构体解析,
+// 不再逐条读JSON字符串再逐条cJSON_Parse
+#define ALARM_BLOB_KEY "alarms"
+#define ALARM_BLOB_VERSION 1
+
+namespace {
+
+struct __attribute__((packed)) AlarmBlobHeader {
+    uint16_t version;
+    uint16_t count;
+};
+
+struct __attribute__((packed)) AlarmRecord {
+    int32_t id;
+    int8_t hour;
+    int8_t minute;
+    uint8_t repeat_mode;
+    uint8_t weekdays_mask;
+    uint8_t status;
+    uint8_t snooze_minutes;
+    uint8_t max_snooze_count;
+    uint8_t reserved;
+    char label[32];       // 截断到31字符+NUL
+    char music_name[32];
+};
+
+}  // namespace
+
 AlarmManager::AlarmManager() 
     : initialized_(false), next_alarm_id_(1), 
       default_snooze_minutes_(5), default_max_snooze_count_(3) {
@@ -110,6 +139,7 @@ int AlarmManager::AddAlarm(int hour, int minute, AlarmRepeatMode repeat_mode,
     // 保存到存储
     SaveAlarmToStorage(*alarms_.back());
     settings_->SetInt("next_id", next_alarm_id_);
+    InvalidateNextDeadline();
     
     ESP_LOGI(TAG, "Added alarm %d: %02d:%02d, repeat=%d, label='%s', music='%s'", 
              alarm_id, hour, minute, repeat_mode, label.c_str(), music_name.c_str());
@@ -131,6 +161,7 @@ bool AlarmManager::RemoveAlarm(int alarm_id) {
         ESP_LOGI(TAG, "Removing alarm %d", alarm_id);
         alarms_.erase(it);
         RemoveAlarmFromStorage(alarm_id);
+        InvalidateNextDeadline();
         return true;
     }
     
@@ -151,6 +182,7 @@ bool AlarmManager::EnableAlarm(int alarm_id, bool enabled) {
     if (it != alarms_.end()) {
         (*it)->status = enabled ? kAlarmEnabled : kAlarmDisabled;
         SaveAlarmToStorage(**it);
+        InvalidateNextDeadline();
         ESP_LOGI(TAG, "Alarm %d %s", alarm_id, enabled ? "enabled" : "disabled");
         return true;
     }
@@ -197,6 +229,7 @@ bool AlarmManager::ModifyAlarm(int alarm_id, int hour, int minute, AlarmRepeatMo
         }
         
         SaveAlarmToStorage(**it);
+        InvalidateNextDeadline();
         ESP_LOGI(TAG, "Modified alarm %d: %02d:%02d", alarm_id, hour, minute);
         return true;
     }
@@ -339,7 +372,8 @@ bool AlarmManager::SnoozeAlarm(int alarm_id) {
             (*it)->status = kAlarmSnoozed;
             (*it)->snooze_count++;
             (*it)->next_snooze_time = esp_timer_get_time() / 1000000 + (*it)->snooze_minutes * 60;
-            
+            InvalidateNextDeadline();
+
             ESP_LOGI(TAG, "Snoozed alarm %d for %d minutes (count: %d/%d)", 
                      alarm_id, (*it)->snooze_minutes, (*it)->snooze_count, (*it)->max_snooze_count);
             
@@ -373,7 +407,8 @@ bool AlarmManager::StopAlarm(int alarm_id) {
         (*it)->status = ((*it)->repeat_mode == kAlarmOnce) ? kAlarmDisabled : kAlarmEnabled;
         (*it)->snooze_count = 0;
         (*it)->next_snooze_time = 0;
-        
+        InvalidateNextDeadline();
+
         ESP_LOGI(TAG, "Stopped alarm %d", alarm_id);
         
         if (on_alarm_stopped_) {
@@ -404,7 +439,8 @@ void AlarmManager::StopAllActiveAlarms() {
             }
         }
     }
-    
+
+    InvalidateNextDeadline();
     ESP_LOGI(TAG, "Stopped all active alarms");
 }
 
@@ -412,12 +448,26 @@ void AlarmManager::CheckAlarms() {
     if (!initialized_) {
         return;
     }
-    
+
+    // 快路径:还没到缓存的最近期限就直接返回,不加锁不扫列表。
+    // 只有集合变化(期限被置0)或真正到点时才走下面的完整扫描
+    time_t now_epoch;
+    time(&now_epoch);
+    int64_t deadline = next_check_epoch_s_.load(std::memory_order_relaxed);
+    if (now_epoch + 2 < last_check_epoch_s_) {
+        // 墙钟被回拨(SNTP校时),缓存的期限已不可信,强制重算
+        deadline = 0;
+    }
+    last_check_epoch_s_ = now_epoch;
+    if (deadline != 0 && now_epoch < deadline) {
+        return;
+    }
+
     int64_t current_time_seconds = esp_timer_get_time() / 1000000;
     int64_t current_time_minutes = GetCurrentTimeInMinutes();
-    
+
     std::lock_guard<std::mutex> lock(alarms_mutex_);
-    
+
     for (auto& alarm : alarms_) {
         // 检查贪睡闹钟
         if (alarm->status == kAlarmSnoozed && 
@@ -470,6 +520,8 @@ void AlarmManager::CheckAlarms() {
             on_alarm_triggered_(*alarm);
         }
     }
+
+    RecomputeNextDeadlineLocked();
 }
 
 void AlarmManager::SetAlarmTriggeredCallback(AlarmTriggeredCallback callback) {
@@ -537,11 +589,51 @@ bool AlarmManager::IsWeekdayActive(const AlarmItem& alarm, int weekday) {
 void AlarmManager::LoadAlarmsFromStorage() {
     std::lock_guard<std::mutex> lock(alarms_mutex_);
     alarms_.clear();
-    
-    // 读取闹钟数量
+
+    // 优先走blob:一次NVS读取加载整个闹钟列表
+    std::string blob = settings_->GetBlob(ALARM_BLOB_KEY);
+    if (blob.size() >= sizeof(AlarmBlobHeader)) {
+        AlarmBlobHeader header;
+        memcpy(&header, blob.data(), sizeof(header));
+        size_t expected_size = sizeof(AlarmBlobHeader) + (size_t)header.count * sizeof(AlarmRecord);
+        if (header.version == ALARM_BLOB_VERSION && blob.size() == expected_size) {
+            const char* p = blob.data() + sizeof(AlarmBlobHeader);
+            for (uint16_t i = 0; i < header.count; i++, p += sizeof(AlarmRecord)) {
+                AlarmRecord record;
+                memcpy(&record, p, sizeof(record));
+
+                auto alarm = std::make_unique<AlarmItem>();
+                alarm->id = record.id;
+                alarm->hour = record.hour;
+                alarm->minute = record.minute;
+                alarm->repeat_mode = (AlarmRepeatMode)record.repeat_mode;
+                alarm->weekdays_mask = record.weekdays_mask;
+                alarm->status = (AlarmStatus)record.status;
+                alarm->snooze_minutes = record.snooze_minutes;
+                alarm->max_snooze_count = record.max_snooze_count;
+                record.label[sizeof(record.label) - 1] = '\0';
+                record.music_name[sizeof(record.music_name) - 1] = '\0';
+                alarm->label = record.label;
+                alarm->music_name = record.music_name;
+
+                // 重置运行时状态
+                if (alarm->status == kAlarmTriggered || alarm->status == kAlarmSnoozed) {
+                    alarm->status = kAlarmEnabled;
+                }
+
+                alarms_.push_back(std::move(alarm));
+            }
+            ESP_LOGI(TAG, "Loaded %d alarms from blob", alarms_.size());
+            return;
+        }
+        ESP_LOGW(TAG, "Alarm blob invalid (version=%u, size=%u), falling back to legacy keys",
+                 header.version, blob.size());
+    }
+
+    // 旧格式:逐条JSON字符串,读完后迁移到blob并清掉旧键
     int alarm_count = settings_->GetInt("count", 0);
-    ESP_LOGI(TAG, "Loading %d alarms from storage", alarm_count);
-    
+    ESP_LOGI(TAG, "Loading %d alarms from legacy storage", alarm_count);
+
     for (int i = 0; i < alarm_count; i++) {
         std::string alarm_key = "alarm_" + std::to_string(i);
         std::string alarm_json = settings_->GetString(alarm_key);
@@ -581,72 +673,116 @@ void AlarmManager::LoadAlarmsFromStorage() {
         alarms_.push_back(std::move(alarm));
         cJSON_Delete(json);
     }
-    
-    ESP_LOGI(TAG, "Loaded %d alarms successfully", alarms_.size());
+
+    ESP_LOGI(TAG, "Loaded %d alarms successfully, migrating to blob format", alarms_.size());
+
+    // 迁移:写入blob并清掉旧的逐条键
+    SaveAlarmsLocked();
+    settings_->EraseKey("count");
+    for (int i = 0; i < alarm_count; i++) {
+        settings_->EraseKey("alarm_" + std::to_string(i));
+    }
 }
 
 void AlarmManager::SaveAlarmsToStorage() {
+    std::lock_guard<std::mutex> lock(alarms_mutex_);
+    SaveAlarmsLocked();
+}
+
+void AlarmManager::SaveAlarmsLocked() {
     if (!settings_) {
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(alarms_mutex_);
-    
-    // 保存闹钟数量
-    settings_->SetInt("count", alarms_.size());
-    
-    // 保存每个闹钟
-    for (size_t i = 0; i < alarms_.size(); i++) {
-        std::string alarm_key = "alarm_" + std::to_string(i);
-        SaveAlarmToStorage(*alarms_[i]);
-    }
-    
+
+    std::string blob;
+    blob.resize(sizeof(AlarmBlobHeader) + alarms_.size() * sizeof(AlarmRecord));
+
+    AlarmBlobHeader header;
+    header.version = ALARM_BLOB_VERSION;
+    header.count = (uint16_t)alarms_.size();
+    memcpy(blob.data(), &header, sizeof(header));
+
+    char* p = blob.data() + sizeof(AlarmBlobHeader);
+    for (const auto& alarm : alarms_) {
+        AlarmRecord record = {};
+        record.id = alarm->id;
+        record.hour = (int8_t)alarm->hour;
+        record.minute = (int8_t)alarm->minute;
+        record.repeat_mode = (uint8_t)alarm->repeat_mode;
+        record.weekdays_mask = alarm->weekdays_mask;
+        record.status = (uint8_t)alarm->status;
+        record.snooze_minutes = (uint8_t)alarm->snooze_minutes;
+        record.max_snooze_count = (uint8_t)alarm->max_snooze_count;
+        strncpy(record.label, alarm->label.c_str(), sizeof(record.label) - 1);
+        strncpy(record.music_name, alarm->music_name.c_str(), sizeof(record.music_name) - 1);
+        memcpy(p, &record, sizeof(record));
+        p += sizeof(record);
+    }
+
+    settings_->SetBlob(ALARM_BLOB_KEY, blob.data(), blob.size());
     ESP_LOGI(TAG, "Saved %d alarms to storage", alarms_.size());
 }
 
 void AlarmManager::SaveAlarmToStorage(const AlarmItem& alarm) {
-    if (!settings_) {
-        return;
-    }
-    
-    cJSON* json = cJSON_CreateObject();
-    
-    cJSON_AddNumberToObject(json, "id", alarm.id);
-    cJSON_AddNumberToObject(json, "hour", alarm.hour);
-    cJSON_AddNumberToObject(json, "minute", alarm.minute);
-    cJSON_AddNumberToObject(json, "repeat", alarm.repeat_mode);
-    cJSON_AddNumberToObject(json, "weekdays", alarm.weekdays_mask);
-    cJSON_AddNumberToObject(json, "status", alarm.status);
-    cJSON_AddStringToObject(json, "label", alarm.label.c_str());
-    cJSON_AddStringToObject(json, "music", alarm.music_name.c_str());
-    cJSON_AddNumberToObject(json, "snooze_minutes", alarm.snooze_minutes);
-    cJSON_AddNumberToObject(json, "max_snooze", alarm.max_snooze_count);
-    
-    char* json_string = cJSON_PrintUnformatted(json);
-    
-    // 找到这个闹钟在数组中的位置
-    auto it = std::find_if(alarms_.begin(), alarms_.end(),
-                          [&alarm](const auto& a) { return a->id == alarm.id; });
-    
-    if (it != alarms_.end()) {
-        size_t index = std::distance(alarms_.begin(), it);
-        std::string alarm_key = "alarm_" + std::to_string(index);
-        settings_->SetString(alarm_key, json_string);
-    }
-    
-    cJSON_free(json_string);
-    cJSON_Delete(json);
+    // 整个列表存在一个blob里,单条修改也整体重写
+    // (调用方已持有alarms_mutex_)
+    SaveAlarmsLocked();
 }
 
 void AlarmManager::RemoveAlarmFromStorage(int alarm_id) {
-    // 重新保存所有闹钟（简单实现）
-    SaveAlarmsToStorage();
+    // 调用方已持有alarms_mutex_
+    SaveAlarmsLocked();
 }
 
 int AlarmManager::GetNextAlarmId() {
     return next_alarm_id_++;
 }
 
+void AlarmManager::RecomputeNextDeadlineLocked() {
+    time_t now;
+    time(&now);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    int64_t now_mono_s = esp_timer_get_time() / 1000000;
+
+    // 保底每小时重算一次,自愈时区/夏令时这类epoch不变但本地时间变的情况
+    int64_t deadline = (int64_t)now + 3600;
+
+    int current_sec_of_day = timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec;
+    int current_weekday = timeinfo.tm_wday;
+
+    for (const auto& alarm : alarms_) {
+        if (alarm->status == kAlarmSnoozed) {
+            // 贪睡期限记的是esp_timer单调秒,换算回墙钟
+            int64_t remaining = alarm->next_snooze_time - now_mono_s;
+            if (remaining < 0) {
+                remaining = 0;
+            }
+            deadline = std::min(deadline, (int64_t)now + remaining);
+            continue;
+        }
+        if (alarm->status != kAlarmEnabled) {
+            continue;
+        }
+
+        // 找这个闹钟未来7天内最近的触发时刻(对齐到触发分钟的第0秒)
+        int alarm_sec_of_day = alarm->hour * 3600 + alarm->minute * 60;
+        for (int day_offset = 0; day_offset < 8; day_offset++) {
+            if (day_offset == 0 && alarm_sec_of_day <= current_sec_of_day) {
+                continue;  // 今天这个分钟已经过了
+            }
+            if (!IsWeekdayActive(*alarm, (current_weekday + day_offset) % 7)) {
+                continue;
+            }
+            int64_t seconds_until = (int64_t)day_offset * 24 * 3600 + alarm_sec_of_day - current_sec_of_day;
+            deadline = std::min(deadline, (int64_t)now + seconds_until);
+            break;
+        }
+    }
+
+    next_check_epoch_s_.store(deadline, std::memory_order_relaxed);
+}
+
 bool AlarmManager::ShouldTriggerToday(const AlarmItem& alarm) const {
     if (alarm.repeat_mode == kAlarmOnce) {
         return true;
@@ -5,6 +5,7 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <atomic>
 #include <esp_timer.h>
 #include "settings.h"
 
@@ -87,6 +88,8 @@ public:
     void StopAllActiveAlarms();
     
     // 时间检查 (由Application的CLOCK_TICK调用)
+    // 平时只做一次时间比较就返回,到达缓存的最近期限才真正扫描列表,
+    // 每秒开销与闹钟数量无关
     void CheckAlarms();
     
     // 回调设置
@@ -110,10 +113,13 @@ private:
     // 内部方法
     void LoadAlarmsFromStorage();
     void SaveAlarmsToStorage();
+    void SaveAlarmsLocked();  // 调用方必须已持有alarms_mutex_
     void SaveAlarmToStorage(const AlarmItem& alarm);
     void RemoveAlarmFromStorage(int alarm_id);
     
     int GetNextAlarmId();
+    void RecomputeNextDeadlineLocked();  // 调用方必须已持有alarms_mutex_
+    void InvalidateNextDeadline() { next_check_epoch_s_.store(0, std::memory_order_relaxed); }
     bool ShouldTriggerToday(const AlarmItem& alarm) const;
     int64_t GetCurrentTimeInMinutes() const;  // 获取当前时间的分钟数(从午夜开始)
     int GetCurrentWeekday() const;            // 获取当前星期几
@@ -123,6 +129,11 @@ private:
     std::unique_ptr<Settings> settings_;
     bool initialized_;
     int next_alarm_id_;
+
+    // 最近一次需要扫描的墙钟时刻(epoch秒),0表示需要重算。
+    // 闹钟集合变化时置0,下个tick会完整扫描一次并重算期限
+    std::atomic<int64_t> next_check_epoch_s_{0};
+    int64_t last_check_epoch_s_ = 0;
     
     // 配置
     int default_snooze_minutes_;
@@ -9,11 +9,21 @@
 #include "mcp_server.h"
 #include "assets.h"
 #include "settings.h"
+#include "boot_profiler.h"
+#include "dns_prefetch.h"
+#include "heap_telemetry.h"
+#include "json_arena.h"
+#include "metrics_registry.h"
+#include "session_snapshot.h"
 
 #include <cstring>
 #include <cstdlib>
 #include <vector>
+#include <thread>
 #include <esp_log.h>
+#include <esp_pthread.h>
+#include <esp_cpu.h>
+#include <esp_heap_caps.h>
 #include <cJSON.h>
 #include <driver/gpio.h>
 #include <arpa/inet.h>
@@ -197,6 +207,28 @@ void Application::CheckNewVersion(Ota& ota) {
     }
 }
 
+void Application::HandleLocalCommand(const std::string& command) {
+    ESP_LOGI(TAG, "Local command: %s", command.c_str());
+    auto& mcp_server = McpServer::GetInstance();
+    if (command == "volume_up" || command == "volume_down") {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        int volume = codec->output_volume() + (command == "volume_up" ? 10 : -10);
+        if (volume < 0) volume = 0;
+        if (volume > 100) volume = 100;
+        mcp_server.CallToolFromLocal("self.audio_speaker.set_volume",
+            PropertyList({Property("volume", kPropertyTypeInteger, volume)}));
+    } else if (command == "stop") {
+        if (device_state_ == kDeviceStateSpeaking) {
+            AbortSpeaking(kAbortReasonNone);
+        }
+        mcp_server.CallToolFromLocal("self.music.stop_playlist", PropertyList());
+    } else if (command == "pause") {
+        mcp_server.CallToolFromLocal("self.music.stop_playlist", PropertyList());
+    } else {
+        ESP_LOGW(TAG, "Unknown local command: %s", command.c_str());
+    }
+}
+
 void Application::ShowActivationCode(const std::string& code, const std::string& message) {
     struct digit_sound {
         char digit;
@@ -276,15 +308,15 @@ void Application::ToggleChatState() {
             }
 
             SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
-        });
+        }, "toggle_chat");
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
-        });
+        }, "abort_speaking");
     } else if (device_state_ == kDeviceStateListening) {
         Schedule([this]() {
             protocol_->CloseAudioChannel();
-        });
+        }, "close_channel");
     }
 }
 
@@ -313,12 +345,12 @@ void Application::StartListening() {
             }
 
             SetListeningMode(kListeningModeManualStop);
-        });
+        }, "start_listening");
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
             SetListeningMode(kListeningModeManualStop);
-        });
+        }, "start_listening");
     }
 }
 
@@ -344,11 +376,27 @@ void Application::StopListening() {
             protocol_->SendStopListening();
             SetDeviceState(kDeviceStateIdle);
         }
-    });
+    }, "stop_listening");
 }
 
 void Application::Start() {
     auto& board = Board::GetInstance();
+
+    // 趁堆还完整先把cJSON arena按上限占住,几周后不用在碎片堆里抠整块
+    JsonArena::Preallocate();
+
+    // 灯效/界面的状态响应注册为cosmetic级订阅,延迟到主循环执行,
+    // 不占用状态切换的快路径(音频处理的开关仍在SetDeviceState内联)
+    auto& state_events = DeviceStateEventManager::GetInstance();
+    state_events.RegisterStateChangeCallback(kStateEventPriorityCosmetic, "led",
+        [](DeviceState, DeviceState) {
+            Board::GetInstance().GetLed()->OnStateChanged();
+        });
+    state_events.RegisterStateChangeCallback(kStateEventPriorityCosmetic, "display",
+        [](DeviceState, DeviceState) {
+            Board::GetInstance().GetDisplay()->OnStateChanged();
+        });
+
     SetDeviceState(kDeviceStateStarting);
 
     /* Setup the display */
@@ -357,22 +405,59 @@ void Application::Start() {
     // Print board name/version info
     display->SetChatMessage("system", SystemInfo::GetUserAgent().c_str());
 
-    /* Setup the audio service */
-    auto codec = board.GetAudioCodec();
-    audio_service_.Initialize(codec);
-    audio_service_.Start();
-
-    AudioServiceCallbacks callbacks;
-    callbacks.on_send_queue_available = [this]() {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
-    };
-    callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
-    };
-    callbacks.on_vad_change = [this](bool speaking) {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
-    };
-    audio_service_.SetCallbacks(callbacks);
+    // 启动耗时打点:第一段涵盖复位到显示就绪(含板级构造)
+    auto& boot_profiler = BootProfiler::GetInstance();
+    boot_profiler.MarkStage("display");
+
+    /* Setup the audio service on a worker thread, overlapped with network
+     * association below: the two are independent and together dominate boot time */
+    esp_pthread_cfg_t audio_init_cfg = esp_pthread_get_default_config();
+    audio_init_cfg.stack_size = 8192;
+    audio_init_cfg.prio = 4;
+    audio_init_cfg.thread_name = "audio_init";
+    esp_pthread_set_cfg(&audio_init_cfg);
+    std::thread audio_init_thread([this, &board]() {
+        auto codec = board.GetAudioCodec();
+        audio_service_.Initialize(codec);
+        audio_service_.Start();
+
+        // 预解码常用提示音:唤醒后的"叮"即点即响,不受解码队列忙闲影响
+        audio_service_.PrecacheSound(Lang::Sounds::OGG_POPUP);
+        audio_service_.PrecacheSound(Lang::Sounds::OGG_SUCCESS);
+        audio_service_.PrecacheSound(Lang::Sounds::OGG_EXCLAMATION);
+        audio_service_.PrecacheSound(Lang::Sounds::OGG_VIBRATION);
+
+        AudioServiceCallbacks callbacks;
+        callbacks.on_send_queue_available = [this]() {
+            xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+        };
+        callbacks.on_send_queue_watermark = [this](bool congested) {
+            // 上行拥塞时采集不会卡住(最旧的帧被丢弃),这里只负责提示
+            if (congested) {
+                ESP_LOGW(TAG, "Uplink congested, listening audio frames may be dropped");
+            } else {
+                ESP_LOGI(TAG, "Uplink recovered");
+            }
+            // 让动画给音频让路,具体降帧策略由各 Display 实现
+            Schedule([congested]() {
+                Board::GetInstance().GetDisplay()->SetAnimationPressure(congested);
+            }, "animation_pressure");
+        };
+        callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
+            wake_detected_time_us_ = esp_timer_get_time();
+            xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
+        };
+        callbacks.on_vad_change = [this](bool speaking) {
+            xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
+        };
+        callbacks.on_local_command = [this](const std::string& command) {
+            // 在音频任务上触发,丢给主循环分发
+            Schedule([this, command]() {
+                HandleLocalCommand(command);
+            }, "local_command");
+        };
+        audio_service_.SetCallbacks(callbacks);
+    });
 
     // Start the main event loop task with priority 3
     xTaskCreate([](void* arg) {
@@ -383,18 +468,57 @@ void Application::Start() {
     /* Start the clock timer to update the status bar */
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
 
-    /* Wait for the network to be ready */
+    /* Wait for the network to be ready (audio init keeps running in parallel;
+     * if this enters WiFi config mode it never returns, and the audio thread
+     * finishes on its own so the config-mode voice prompts still play) */
     board.StartNetwork();
+    boot_profiler.MarkStage("network");
+
+    /* 已知端点DNS预热:后台解析进lwIP缓存,后面的版本检查和
+     * 会话建立里客户端内部的同步解析变成缓存命中 */
+    DnsPrefetch::WarmKnownEndpoints();
+
+    // 汇合点:后面的资产下载和OTA提示要播报声音,必须等音频服务就绪
+    audio_init_thread.join();
+    boot_profiler.MarkStage("audio_join");
+    auto codec = board.GetAudioCodec();
 
     // Update the status bar immediately to show the network state
     display->UpdateStatusBar(true);
 
-    // Check for new assets version
-    CheckAssetsVersion();
-
     // Check for new firmware version or get the MQTT broker address
     Ota ota;
-    CheckNewVersion(ota);
+    /* 深睡唤醒快路径:协议端点配置还留在NVS里,RTC快照没过期就跳过资产
+     * 检查和OTA检查(省一次TLS往返,这是唤醒到可聆听的大头)。升级和
+     * coredump上传推迟到下一次冷启动,快照24小时后自动过期兜底 */
+    bool fast_resume = SessionSnapshot::CanFastResume();
+    bool version_check_from_cache = false;
+    if (fast_resume) {
+        ESP_LOGI(TAG, "Deep sleep wake, fast resume with cached session");
+        xEventGroupSetBits(event_group_, MAIN_EVENT_CHECK_NEW_VERSION_DONE);
+    } else {
+        // Check for new assets version
+        CheckAssetsVersion();
+        boot_profiler.MarkStage("assets");
+
+        /* 版本应答缓存命中时跳过阻塞的网络检查,启动不再等版本接口;
+         * 进Idle后会后台复核一次,刷新缓存并处理期间发布的新固件 */
+        version_check_from_cache = ota.CheckVersionFromCache();
+        if (version_check_from_cache) {
+            ota.MarkCurrentVersionValid();
+            xEventGroupSetBits(event_group_, MAIN_EVENT_CHECK_NEW_VERSION_DONE);
+        } else {
+            CheckNewVersion(ota);
+        }
+
+        // 崩溃遥测:上次运行如果崩了,coredump分区里会留下转储,
+        // 这里上传并把无崩溃运行时长清零
+        if (ota.UploadCoreDump()) {
+            Settings settings("crash", true);
+            settings.SetInt("uptime_hours", 0);
+        }
+    }
+    boot_profiler.MarkStage("ota_check");
 
     // Initialize the protocol
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
@@ -404,12 +528,20 @@ void Application::Start() {
     mcp_server.AddCommonTools();
     mcp_server.AddUserOnlyTools();
 
-    if (ota.HasMqttConfig()) {
-        protocol_ = std::make_unique<MqttProtocol>();
+    auto protocol_kind = SessionSnapshot::kProtocolMqtt;
+    if (fast_resume) {
+        // 快路径没有OTA应答,协议类型取上次启动的快照
+        protocol_kind = SessionSnapshot::protocol_kind();
+    } else if (ota.HasMqttConfig()) {
+        protocol_kind = SessionSnapshot::kProtocolMqtt;
     } else if (ota.HasWebsocketConfig()) {
-        protocol_ = std::make_unique<WebsocketProtocol>();
+        protocol_kind = SessionSnapshot::kProtocolWebsocket;
     } else {
         ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
+    }
+    if (protocol_kind == SessionSnapshot::kProtocolWebsocket) {
+        protocol_ = std::make_unique<WebsocketProtocol>();
+    } else {
         protocol_ = std::make_unique<MqttProtocol>();
     }
 
@@ -432,6 +564,9 @@ void Application::Start() {
             ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
                 protocol_->server_sample_rate(), codec->output_sample_rate());
         }
+        // Rebuild the decoder for the negotiated format now, so the first
+        // incoming packet decodes without a setup stall
+        audio_service_.PrewarmDecoder(protocol_->server_sample_rate(), protocol_->server_frame_duration());
     });
     protocol_->OnAudioChannelClosed([this, &board]() {
         board.SetPowerSaveMode(true);
@@ -439,7 +574,7 @@ void Application::Start() {
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
-        });
+        }, "channel_closed");
     });
     protocol_->OnIncomingJson([this, display](const cJSON* root) {
         // Parse JSON data
@@ -452,7 +587,7 @@ void Application::Start() {
                     if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
                         SetDeviceState(kDeviceStateSpeaking);
                     }
-                });
+                }, "tts_start");
             } else if (strcmp(state->valuestring, "stop") == 0) {
                 Schedule([this]() {
                     if (device_state_ == kDeviceStateSpeaking) {
@@ -462,14 +597,14 @@ void Application::Start() {
                             SetDeviceState(kDeviceStateListening);
                         }
                     }
-                });
+                }, "tts_stop");
             } else if (strcmp(state->valuestring, "sentence_start") == 0) {
                 auto text = cJSON_GetObjectItem(root, "text");
                 if (cJSON_IsString(text)) {
                     ESP_LOGI(TAG, "<< %s", text->valuestring);
                     Schedule([this, display, message = std::string(text->valuestring)]() {
                         display->SetChatMessage("assistant", message.c_str());
-                    });
+                    }, "tts_sentence");
                 }
             }
         } else if (strcmp(type->valuestring, "stt") == 0) {
@@ -478,14 +613,14 @@ void Application::Start() {
                 ESP_LOGI(TAG, ">> %s", text->valuestring);
                 Schedule([this, display, message = std::string(text->valuestring)]() {
                     display->SetChatMessage("user", message.c_str());
-                });
+                }, "stt_message");
             }
         } else if (strcmp(type->valuestring, "llm") == 0) {
             auto emotion = cJSON_GetObjectItem(root, "emotion");
             if (cJSON_IsString(emotion)) {
                 Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
                     display->SetEmotion(emotion_str.c_str());
-                });
+                }, "set_emotion");
             }
         } else if (strcmp(type->valuestring, "mcp") == 0) {
             auto payload = cJSON_GetObjectItem(root, "payload");
@@ -500,7 +635,7 @@ void Application::Start() {
                     // Do a reboot if user requests a OTA update
                     Schedule([this]() {
                         Reboot();
-                    });
+                    }, "reboot");
                 } else {
                     ESP_LOGW(TAG, "Unknown system command: %s", command->valuestring);
                 }
@@ -521,7 +656,7 @@ void Application::Start() {
             if (cJSON_IsObject(payload)) {
                 Schedule([this, display, payload_str = std::string(cJSON_PrintUnformatted(payload))]() {
                     display->SetChatMessage("system", payload_str.c_str());
-                });
+                }, "custom_message");
             } else {
                 ESP_LOGW(TAG, "Invalid custom message format: missing payload");
             }
@@ -531,12 +666,16 @@ void Application::Start() {
         }
     });
     bool protocol_started = protocol_->Start();
+    boot_profiler.MarkStage("protocol");
+    boot_profiler.Finish();
 
     SystemInfo::PrintHeapStats();
     SetDeviceState(kDeviceStateIdle);
 
-    has_server_time_ = ota.HasServerTime();
+    has_server_time_ = fast_resume ? true : ota.HasServerTime();
     if (protocol_started) {
+        // 记下会话快照,深睡唤醒后凭它走快路径
+        SessionSnapshot::Save(protocol_kind, protocol_->session_id());
         std::string message = std::string(Lang::Strings::VERSION) + ota.GetCurrentVersion();
         display->ShowNotification(message.c_str());
         display->SetChatMessage("system", "");
@@ -547,27 +686,123 @@ void Application::Start() {
         
         // 设置闹钟回调
         alarm_manager.SetAlarmTriggeredCallback([this](const AlarmItem& alarm) {
-            Schedule([this, alarm]() { OnAlarmTriggered(alarm); });
+            Schedule([this, alarm]() { OnAlarmTriggered(alarm); }, "alarm_triggered");
         });
         alarm_manager.SetAlarmSnoozeCallback([this](const AlarmItem& alarm) {
-            Schedule([this, alarm]() { OnAlarmSnoozed(alarm); });
+            Schedule([this, alarm]() { OnAlarmSnoozed(alarm); }, "alarm_snoozed");
         });
         alarm_manager.SetAlarmStopCallback([this](const AlarmItem& alarm) {
-            Schedule([this, alarm]() { OnAlarmStopped(alarm); });
+            Schedule([this, alarm]() { OnAlarmStopped(alarm); }, "alarm_stopped");
         });
         
         // Play the success sound to indicate the device is ready
         audio_service_.PlaySound(Lang::Sounds::OGG_SUCCESS);
     }
+
+    if (version_check_from_cache) {
+        // 启动用的是缓存应答,进Idle后真正访问一次版本接口:刷新缓存、
+        // 校准服务器时间,发现新固件再调度回主循环走统一升级流程
+        xTaskCreate([](void* arg) {
+            auto self = (Application*)arg;
+            vTaskDelay(pdMS_TO_TICKS(10000));
+            auto ota = std::make_shared<Ota>();
+            if (ota->CheckVersion()) {
+                if (!self->has_server_time_) {
+                    self->has_server_time_ = ota->HasServerTime();
+                }
+                if (ota->HasNewVersion()) {
+                    ESP_LOGI(TAG, "Background version check found new version %s",
+                             ota->GetFirmwareVersion().c_str());
+                    self->Schedule([self, ota]() {
+                        if (self->device_state_ == kDeviceStateIdle) {
+                            self->UpgradeFirmware(*ota);
+                        }
+                    }, "ota_bg_upgrade");
+                }
+            } else {
+                ESP_LOGW(TAG, "Background version re-check failed, keeping cached result");
+            }
+            vTaskDelete(NULL);
+        }, "ota_recheck", 4096 * 2, this, 1, nullptr);
+    }
+
+    if (Settings("flash_bench").GetInt("seq_kbps", 0) == 0) {
+        // 首启还没有flash健康基线:等系统安静下来后跑一次基准存下来,
+        // 之后的手动运行(MCP工具)才有对比对象
+        xTaskCreate([](void* arg) {
+            vTaskDelay(pdMS_TO_TICKS(30000));
+            SystemInfo::RunFlashBenchmark();
+            vTaskDelete(NULL);
+        }, "flash_bench", 4096, nullptr, 1, nullptr);
+    }
+
+    // 低内存卸载动作:停掉音乐流(释放预读缓冲压力),让动画降帧
+    auto& heap_telemetry = HeapTelemetry::GetInstance();
+    heap_telemetry.RegisterLoadShedder("stop_music_streaming", []() {
+        auto music = Board::GetInstance().GetMusic();
+        if (music && music->IsDownloading()) {
+            music->StopStreaming();
+        }
+    });
+    heap_telemetry.RegisterLoadShedder("animation_pressure", []() {
+        Board::GetInstance().GetDisplay()->SetAnimationPressure(true);
+    });
+
+    // 空闲维护动作:内部RAM碎到TLS握手将败未败时,趁Idle主动回收。
+    // 空闲的控制通道直接关掉(释放TLS缓冲,下次交互重新握手即可);
+    // 没在放歌却还挂着的音乐流连同预读缓冲一并停掉
+    heap_telemetry.RegisterRecycler("close_idle_channel", [this]() {
+        if (protocol_ && protocol_->IsAudioChannelOpened() && device_state_ == kDeviceStateIdle) {
+            ESP_LOGW(TAG, "Closing idle audio channel to defragment internal RAM");
+            protocol_->CloseAudioChannel();
+            return true;
+        }
+        return false;
+    });
+    heap_telemetry.RegisterRecycler("drop_stale_music_stream", [this]() {
+        auto music = Board::GetInstance().GetMusic();
+        if (music && music->IsDownloading() && !is_music_playing_) {
+            music->StopStreaming();
+            return true;
+        }
+        return false;
+    });
 }
 
 // Add a async task to MainLoop
-void Application::Schedule(std::function<void()> callback) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
+void Application::Schedule(std::function<void()> callback, const char* name) {
+    main_tasks_.Push(std::move(callback), name);
+    // 中断上下文走FromISR快速路径(队列本身无锁,任意上下文可投递)
+    if (xPortInIsrContext()) {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        xEventGroupSetBitsFromISR(event_group_, MAIN_EVENT_SCHEDULE, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    } else {
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
     }
-    xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+}
+
+std::string Application::GetMainLoopReportJson() const {
+    auto root = cJSON_CreateObject();
+    std::lock_guard<std::mutex> lock(slow_events_mutex_);
+    cJSON_AddNumberToObject(root, "threshold_ms", kSlowCallbackThresholdMs);
+    cJSON_AddNumberToObject(root, "slow_count", slow_callback_count_);
+    cJSON_AddNumberToObject(root, "max_duration_ms", max_callback_duration_ms_);
+    auto events = cJSON_CreateArray();
+    for (const auto& event : slow_events_) {
+        auto item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", event.name);
+        cJSON_AddNumberToObject(item, "duration_ms", event.duration_ms);
+        cJSON_AddNumberToObject(item, "uptime_s", event.uptime_s);
+        cJSON_AddItemToArray(events, item);
+    }
+    cJSON_AddItemToObject(root, "slow_events", events);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
 }
 
 // The Main Event Loop controls the chat state and websocket connection
@@ -607,11 +842,23 @@ void Application::MainEventLoop() {
         }
 
         if (bits & MAIN_EVENT_SCHEDULE) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto& task : tasks) {
-                task();
+            while (auto item = main_tasks_.Pop()) {
+                // 看门狗:回调阻塞主循环会拖慢音频状态切换,超阈值的记下来归因
+                int64_t start_us = esp_timer_get_time();
+                item.task();
+                uint32_t duration_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+                if (duration_ms > max_callback_duration_ms_) {
+                    max_callback_duration_ms_ = duration_ms;
+                }
+                if (duration_ms >= kSlowCallbackThresholdMs) {
+                    ESP_LOGW(TAG, "Slow callback '%s' blocked main loop for %u ms", item.name, duration_ms);
+                    std::lock_guard<std::mutex> lock(slow_events_mutex_);
+                    slow_callback_count_++;
+                    if (slow_events_.size() >= kMaxSlowCallbackEvents) {
+                        slow_events_.pop_front();
+                    }
+                    slow_events_.push_back({item.name, duration_ms, (uint32_t)(start_us / 1000000)});
+                }
             }
         }
 
@@ -629,12 +876,32 @@ void Application::MainEventLoop() {
             if (is_music_playing_) {
                 UpdateMusicProgress();
             }
-        
+
+            // 指标飞行记录:刷新核心槽位并采样进历史环(1Hz)
+            UpdateMetrics();
+
             // Print the debug info every 10 seconds
             if (clock_ticks_ % 10 == 0) {
                 // SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
                 // SystemInfo::PrintTaskList();
                 SystemInfo::PrintHeapStats();
+                // 各子系统堆水位与低内存检查(内部RAM告急时触发负载卸载)
+                HeapTelemetry::GetInstance().Check();
+                // 会话期间同时打印链路质量计数,便于远程排查网络问题
+                if (protocol_ && protocol_->IsAudioChannelOpened()) {
+                    ESP_LOGI(TAG, "Network stats: %s", protocol_->GetNetworkStatsJson().c_str());
+                }
+            }
+
+            // 空闲维护:内部RAM碎片化时趁Idle做预防性回收(每分钟最多一个动作)
+            if (clock_ticks_ % 60 == 0 && device_state_ == kDeviceStateIdle) {
+                HeapTelemetry::GetInstance().CheckIdleMaintenance();
+            }
+
+            // 无崩溃运行时长计数,每小时落盘一次(写合并层会攒批提交)
+            if (clock_ticks_ % 3600 == 0 && clock_ticks_ > 0) {
+                Settings settings("crash", true);
+                settings.SetInt("uptime_hours", settings.GetInt("uptime_hours") + 1);
             }
         }
     }
@@ -648,7 +915,11 @@ void Application::OnWakeWordDetected() {
     if (device_state_ == kDeviceStateIdle) {
         audio_service_.EncodeWakeWord();
 
-        if (!protocol_->IsAudioChannelOpened()) {
+        /* 热通道快路径:会话通道还开着时跳过Connecting整趟状态迁移,
+         * 先把采集/上行拉起来,显示那些cosmetic工作放在后面补。
+         * 留存音频在后台编码,首个Opus包只差一个编码帧的功夫 */
+        bool warm_channel = protocol_->IsAudioChannelOpened();
+        if (!warm_channel) {
             SetDeviceState(kDeviceStateConnecting);
             if (!protocol_->OpenAudioChannel()) {
                 audio_service_.EnableWakeWordDetection(true);
@@ -658,6 +929,13 @@ void Application::OnWakeWordDetected() {
 
         auto wake_word = audio_service_.GetLastWakeWord();
         ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
+        auto mode = aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime;
+        if (warm_channel) {
+            /* 实时采集先行:留存音频排空期间新语音进发送队列攒着,
+             * 消息顺序不变(留存帧→detect→start),队列在函数返回后排空 */
+            audio_service_.EnableVoiceProcessing(true);
+            audio_service_.EnableWakeWordDetection(false);
+        }
 #if CONFIG_SEND_WAKE_WORD_DATA
         // Encode and send the wake word data to the server
         while (auto packet = audio_service_.PopWakeWordPacket()) {
@@ -665,9 +943,24 @@ void Application::OnWakeWordDetected() {
         }
         // Set the chat state to wake word detected
         protocol_->SendWakeWordDetected(wake_word);
-        SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+        if (warm_channel) {
+            protocol_->SendStartListening(mode);
+            if (wake_detected_time_us_ > 0) {
+                ESP_LOGI(TAG, "Fast path: wake word to uplink in %lld ms",
+                    (esp_timer_get_time() - wake_detected_time_us_) / 1000);
+            }
+        }
+        // 处理器已在跑时SetDeviceState只补显示,不会重发start
+        SetListeningMode(mode);
 #else
-        SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+        if (warm_channel) {
+            protocol_->SendStartListening(mode);
+            if (wake_detected_time_us_ > 0) {
+                ESP_LOGI(TAG, "Fast path: wake word to uplink in %lld ms",
+                    (esp_timer_get_time() - wake_detected_time_us_) / 1000);
+            }
+        }
+        SetListeningMode(mode);
         // Play the pop up sound to indicate the wake word is detected
         audio_service_.PlaySound(Lang::Sounds::OGG_POPUP);
 #endif
@@ -701,14 +994,11 @@ void Application::SetDeviceState(DeviceState state) {
     device_state_ = state;
     ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
 
-    // Send the state change event
+    // Send the state change event (critical级同步执行,LED/显示等cosmetic级延迟分发)
     DeviceStateEventManager::GetInstance().PostStateChangeEvent(previous_state, state);
 
     auto& board = Board::GetInstance();
     auto display = board.GetDisplay();
-    auto led = board.GetLed();
-    led->OnStateChanged();
-    display->OnStateChanged();
     switch (state) {
         case kDeviceStateUnknown:
         case kDeviceStateIdle:
@@ -743,6 +1033,8 @@ void Application::SetDeviceState(DeviceState state) {
                 audio_service_.EnableWakeWordDetection(audio_service_.IsAfeWakeWord());
             }
             audio_service_.ResetDecoder();
+            // 播放时钟归零:口型同步按本轮说话内容从0起算
+            audio_service_.ResetPlaybackClock();
             break;
         default:
             // Do nothing
@@ -750,6 +1042,14 @@ void Application::SetDeviceState(DeviceState state) {
     }
 }
 
+void Application::OnNetworkMigrated() {
+    Schedule([this]() {
+        if (protocol_ && protocol_->IsAudioChannelOpened()) {
+            protocol_->CloseAudioChannel();
+        }
+    }, "network_migrated");
+}
+
 void Application::Reboot() {
     ESP_LOGI(TAG, "Rebooting...");
     // Disconnect the audio channel
@@ -759,6 +1059,9 @@ void Application::Reboot() {
     protocol_.reset();
     audio_service_.Stop();
 
+    // 把写合并层里还没落盘的设置提交掉
+    Settings::Flush();
+
     vTaskDelay(pdMS_TO_TICKS(1000));
     esp_restart();
 }
@@ -823,17 +1126,17 @@ void Application::WakeWordInvoke(const std::string& wake_word) {
             if (protocol_) {
                 protocol_->SendWakeWordDetected(wake_word); 
             }
-        }); 
+        }, "wake_word_invoke"); 
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
-        });
+        }, "abort_speaking");
     } else if (device_state_ == kDeviceStateListening) {   
         Schedule([this]() {
             if (protocol_) {
                 protocol_->CloseAudioChannel();
             }
-        });
+        }, "close_channel");
     }
 }
 
@@ -854,18 +1157,42 @@ bool Application::CanEnterSleepMode() {
     return true;
 }
 
-void Application::SendMcpMessage(const std::string& payload) {
+std::string Application::GetNetworkStatsJson() const {
+    if (protocol_ == nullptr) {
+        return "{}";
+    }
+    auto json = protocol_->GetNetworkStatsJson();
+    // 附上当前上行Opus码率:拥塞自适应降过档的话从这里能看出来
+    char bitrate_field[48];
+    snprintf(bitrate_field, sizeof(bitrate_field), ",\"uplink_bitrate\":%d}",
+             audio_service_.GetUplinkBitrate());
+    json.replace(json.size() - 1, 1, bitrate_field);
+    return json;
+}
+
+std::string Application::RunNetworkBenchmark(int seconds) {
+    if (protocol_ == nullptr) {
+        return "{\"error\":\"protocol not started\"}";
+    }
+    // 通道没开先开起来(这里在工具worker线程上,阻塞没关系)
+    if (!protocol_->IsAudioChannelOpened() && !protocol_->OpenAudioChannel()) {
+        return "{\"error\":\"failed to open audio channel\"}";
+    }
+    return protocol_->RunNetworkBench(seconds);
+}
+
+void Application::SendMcpMessage(std::string payload) {
     if (protocol_ == nullptr) {
         return;
     }
 
     // Make sure you are using main thread to send MCP message
     if (xTaskGetCurrentTaskHandle() == main_event_loop_task_handle_) {
-        protocol_->SendMcpMessage(payload);
+        protocol_->SendMcpMessage(std::move(payload));
     } else {
-        Schedule([this, payload = std::move(payload)]() {
-            protocol_->SendMcpMessage(payload);
-        });
+        Schedule([this, payload = std::move(payload)]() mutable {
+            protocol_->SendMcpMessage(std::move(payload));
+        }, "mcp_message");
     }
 }
 
@@ -904,88 +1231,100 @@ void Application::PlaySound(const std::string_view& sound) {
 void Application::AddAudioData(AudioStreamPacket&& packet) {
     auto codec = Board::GetInstance().GetAudioCodec();
     if (device_state_ == kDeviceStateIdle && codec->output_enabled()) {
-        // packet.payload包含的是原始PCM数据（int16_t）
+        // packet.payload包含的是原始PCM数据（int16_t）,直接借用原地播放,
+        // 不再按帧分配+memcpy一份副本(payload归本函数所有,斜坡可就地改)
         if (packet.payload.size() >= 2) {
+            auto pcm = reinterpret_cast<int16_t*>(packet.payload.data());
             size_t num_samples = packet.payload.size() / sizeof(int16_t);
-            std::vector<int16_t> pcm_data(num_samples);
-            memcpy(pcm_data.data(), packet.payload.data(), packet.payload.size());
-            
-            // 检查采样率是否匹配，如果不匹配则进行简单重采样
+
+            // DAC固定跑板级原生采样率,内容采样率的差异一律软件重采样。
+            // 以前这里会先试着重配I2S时钟到内容采样率:TTS(24k)和音乐
+            // (44.1k)来回切导致整条通道disable/重配/enable,有可闻断点,
+            // es8311的PLL偶尔还会失锁。OpusResampler与AudioService的
+            // 输出重采样同一实现;暂存区复用,不逐帧分配
             if (packet.sample_rate != codec->output_sample_rate()) {
-                // 验证采样率参数
                 if (packet.sample_rate <= 0 || codec->output_sample_rate() <= 0) {
-                    ESP_LOGE(TAG, "Invalid sample rates: %d -> %d", 
+                    ESP_LOGE(TAG, "Invalid sample rates: %d -> %d",
                             packet.sample_rate, codec->output_sample_rate());
                     return;
                 }
-                
-                // 尝试动态切换采样率
-                if (codec->SetOutputSampleRate(packet.sample_rate)) {
-                    ESP_LOGI(TAG, "Successfully switched to music playback sampling rate: %d Hz", packet.sample_rate);
-                } else {
-                    ESP_LOGW(TAG, "Unable to switch sampling rate, continue using current sampling rate: %d Hz", codec->output_sample_rate());
-                    // 如果无法切换采样率，继续使用当前的采样率进行处理
-                    if (packet.sample_rate > codec->output_sample_rate()) {
-                        // 下采样：简单丢弃部分样本
-                        float downsample_ratio = static_cast<float>(packet.sample_rate) / codec->output_sample_rate();
-                        size_t expected_size = static_cast<size_t>(pcm_data.size() / downsample_ratio + 0.5f);
-                        std::vector<int16_t> resampled(expected_size);
-                        size_t resampled_index = 0;
-                        
-                        for (size_t i = 0; i < pcm_data.size(); ++i) {
-                            if (i % static_cast<size_t>(downsample_ratio) == 0) {
-                                resampled[resampled_index++] = pcm_data[i];
-                            }
-                        }
-                        
-                        pcm_data = std::move(resampled);
-                        ESP_LOGI(TAG, "Downsampled %d -> %d samples (ratio: %.2f)", 
-                                pcm_data.size(), resampled.size(), downsample_ratio);
-                    } else if (packet.sample_rate < codec->output_sample_rate()) {
-                        // 上采样：线性插值
-                        float upsample_ratio = codec->output_sample_rate() / static_cast<float>(packet.sample_rate);
-                        size_t expected_size = static_cast<size_t>(pcm_data.size() * upsample_ratio + 0.5f);
-                        std::vector<int16_t> resampled(expected_size);
-                        
-                        for (size_t i = 0; i < pcm_data.size(); ++i) {
-                            // 添加原始样本
-                            resampled[i * static_cast<size_t>(upsample_ratio)] = pcm_data[i];
-                            
-                            // 计算需要插值的样本数
-                            int interpolation_count = static_cast<int>(upsample_ratio) - 1;
-                            if (interpolation_count > 0 && i + 1 < pcm_data.size()) {
-                                int16_t current = pcm_data[i];
-                                int16_t next = pcm_data[i + 1];
-                                for (int j = 1; j <= interpolation_count; ++j) {
-                                    float t = static_cast<float>(j) / (interpolation_count + 1);
-                                    int16_t interpolated = static_cast<int16_t>(current + (next - current) * t);
-                                    resampled[i * static_cast<size_t>(upsample_ratio) + j] = interpolated;
-                                }
-                            } else if (interpolation_count > 0) {
-                                // 最后一个样本，直接重复
-                                for (int j = 1; j <= interpolation_count; ++j) {
-                                    resampled[i * static_cast<size_t>(upsample_ratio) + j] = pcm_data[i];
-                                }
-                            }
-                        }
-                        
-                        pcm_data = std::move(resampled);
-                        ESP_LOGI(TAG, "Upsampled %d -> %d samples (ratio: %.2f)", 
-                                pcm_data.size() / static_cast<size_t>(upsample_ratio), pcm_data.size(), upsample_ratio);
-                    }
+                if (music_resampler_in_rate_ != packet.sample_rate ||
+                    music_resampler_out_rate_ != codec->output_sample_rate()) {
+                    music_output_resampler_.Configure(packet.sample_rate, codec->output_sample_rate());
+                    music_resampler_in_rate_ = packet.sample_rate;
+                    music_resampler_out_rate_ = codec->output_sample_rate();
+                    ESP_LOGI(TAG, "Music resampler configured: %d -> %d Hz",
+                            music_resampler_in_rate_, music_resampler_out_rate_);
+                }
+
+                uint32_t start_cycles = esp_cpu_get_cycle_count();
+                size_t target_size = music_output_resampler_.GetOutputSamples(num_samples);
+                music_resample_scratch_.resize(target_size);
+                music_output_resampler_.Process(pcm, num_samples,
+                                                music_resample_scratch_.data());
+                pcm = music_resample_scratch_.data();
+                num_samples = music_resample_scratch_.size();
+                uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+
+                // 周期数/帧滚动平均,定期打出来评估重采样开销
+                music_resample_cycles_ = (music_resample_cycles_ * 7 + cycles) / 8;
+                if ((++music_resample_frames_ % 256) == 0) {
+                    ESP_LOGI(TAG, "Music resample cost: %u cycles/frame (avg)",
+                            (unsigned int)music_resample_cycles_);
                 }
             }
-            
+
             // 确保音频输出已启用
             if (!codec->output_enabled()) {
                 codec->EnableOutput(true);
             }
-            
-            // 发送PCM数据到音频编解码器
-            codec->OutputData(pcm_data);
-            
+
+            // 发送PCM数据到音频编解码器(借用视图,阻塞写完即返回)
+            codec->OutputData(pcm, num_samples);
+
             audio_service_.UpdateOutputTimestamp();
         }
+    } else if (device_state_ == kDeviceStateSpeaking && codec->output_enabled()) {
+        // 说话期间音乐不再整段停掉:重采样到当前输出采样率后交给
+        // AudioService低混在TTS帧下面,回到待机立即原音量续播,
+        // 省掉以前每次对话后的重缓冲停顿
+        if (packet.payload.size() >= 2) {
+            auto pcm = reinterpret_cast<int16_t*>(packet.payload.data());
+            size_t num_samples = packet.payload.size() / sizeof(int16_t);
+
+            std::vector<int16_t> pcm_data;
+            // TTS占着codec,不能切采样率,直接走OpusResampler;重采样时
+            // 直接从payload读、写进环要持有的新缓冲,没有中间副本
+            if (packet.sample_rate != codec->output_sample_rate()) {
+                if (packet.sample_rate <= 0 || codec->output_sample_rate() <= 0) {
+                    ESP_LOGE(TAG, "Invalid sample rates: %d -> %d",
+                            packet.sample_rate, codec->output_sample_rate());
+                    return;
+                }
+                if (music_resampler_in_rate_ != packet.sample_rate ||
+                    music_resampler_out_rate_ != codec->output_sample_rate()) {
+                    music_output_resampler_.Configure(packet.sample_rate, codec->output_sample_rate());
+                    music_resampler_in_rate_ = packet.sample_rate;
+                    music_resampler_out_rate_ = codec->output_sample_rate();
+                    ESP_LOGI(TAG, "Music resampler configured: %d -> %d Hz",
+                            music_resampler_in_rate_, music_resampler_out_rate_);
+                }
+                pcm_data.resize(music_output_resampler_.GetOutputSamples(num_samples));
+                music_output_resampler_.Process(pcm, num_samples, pcm_data.data());
+            } else {
+                // 压混环要跨出packet的生命周期持有样本,这一次拷贝省不掉
+                pcm_data.assign(pcm, pcm + num_samples);
+            }
+
+            // 压混环满说明TTS消费得慢,小睡重试让音乐推进跟着播放节拍走;
+            // 重试耗尽才丢帧(TTS欠载时宁可音乐小跳也不堆积压延迟)
+            for (int retry = 0; retry < 10; retry++) {
+                if (audio_service_.MixUnderPlayback(std::move(pcm_data))) {
+                    break;
+                }
+                vTaskDelay(pdMS_TO_TICKS(20));
+            }
+        }
     }
 }
 
@@ -1153,6 +1492,35 @@ std::vector<std::string> Application::GetDefaultAlarmMusicList() const {
 }
 
 // 更新音乐播放进度
+void Application::UpdateMetrics() {
+    auto& metrics = MetricsRegistry::GetInstance();
+    // 首次进来注册槽位,之后每秒只刷值
+    static int id_heap_internal = metrics.Register("heap_internal_free", kMetricGauge);
+    static int id_heap_psram = metrics.Register("heap_psram_free", kMetricGauge);
+    static int id_underruns = metrics.Register("playback_underruns", kMetricCounter);
+    static int id_send_drops = metrics.Register("send_drops", kMetricCounter);
+    static int id_concealed = metrics.Register("concealed_frames", kMetricCounter);
+    static int id_encode_lat = metrics.Register("encode_latency_us", kMetricGauge);
+    static int id_playback_lat = metrics.Register("playback_latency_us", kMetricGauge);
+    static int id_rx_overruns = metrics.Register("i2s_rx_overruns", kMetricCounter);
+    static int id_tx_overruns = metrics.Register("i2s_tx_overruns", kMetricCounter);
+    static int id_uplink_bps = metrics.Register("uplink_bitrate_bps", kMetricGauge);
+
+    const auto& stats = audio_service_.GetDebugStatistics();
+    metrics.Set(id_heap_internal, (int32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    metrics.Set(id_heap_psram, (int32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    metrics.Set(id_underruns, (int32_t)stats.playback_underrun_count);
+    metrics.Set(id_send_drops, (int32_t)stats.send_drop_count);
+    metrics.Set(id_concealed, (int32_t)stats.concealed_frame_count);
+    metrics.Set(id_encode_lat, (int32_t)stats.encode_latency_us);
+    metrics.Set(id_playback_lat, (int32_t)stats.playback_latency_us);
+    metrics.Set(id_rx_overruns, (int32_t)stats.i2s_rx_overrun_count);
+    metrics.Set(id_tx_overruns, (int32_t)stats.i2s_tx_overrun_count);
+    metrics.Set(id_uplink_bps, audio_service_.GetUplinkBitrate());
+
+    metrics.Sample();
+}
+
 void Application::UpdateMusicProgress() {
     if (!is_music_playing_) {
         return;
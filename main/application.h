@@ -10,8 +10,10 @@
 #include <mutex>
 #include <deque>
 #include <memory>
+#include <vector>
 
 #include "protocol.h"
+#include "mpsc_queue.h"
 #include "ota.h"
 #include "audio_service.h"
 #include "device_state_event.h"
@@ -47,7 +49,10 @@ public:
     void MainEventLoop();
     DeviceState GetDeviceState() const { return device_state_; }
     bool IsVoiceDetected() const { return audio_service_.IsVoiceDetected(); }
-    void Schedule(std::function<void()> callback);
+    // name用于主循环慢回调归因,必须是静态生存期字符串
+    void Schedule(std::function<void()> callback, const char* name = "unnamed");
+    // 主循环慢回调记录(JSON,供MCP查询)
+    std::string GetMainLoopReportJson() const;
     void SetDeviceState(DeviceState state);
     void Alert(const char* status, const char* message, const char* emotion = "", const std::string_view& sound = "");
     void DismissAlert();
@@ -59,7 +64,12 @@ public:
     void WakeWordInvoke(const std::string& wake_word);
     bool UpgradeFirmware(Ota& ota, const std::string& url = "");
     bool CanEnterSleepMode();
-    void SendMcpMessage(const std::string& payload);
+    void SendMcpMessage(std::string payload);
+    // 网络接口切换(双网板卡failover)后调用:关闭现有音频通道,
+    // 下一次会话在新接口上重连
+    void OnNetworkMigrated();
+    std::string GetNetworkStatsJson() const;
+    std::string RunNetworkBenchmark(int seconds);
     void SetAecMode(AecMode mode);
     AecMode GetAecMode() const { return aec_mode_; }
     void PlaySound(const std::string_view& sound);
@@ -75,8 +85,21 @@ private:
     Application();
     ~Application();
 
-    std::mutex mutex_;
-    std::deque<std::function<void()>> main_tasks_;
+    // Schedule的投递队列:无锁MPSC,音频路径投递不会被主循环的慢回调卡住
+    MpscTaskQueue main_tasks_;
+
+    // 主循环看门狗:记录超过阈值的回调,按投递方标签归因
+    struct SlowCallbackEvent {
+        const char* name;
+        uint32_t duration_ms;
+        uint32_t uptime_s;
+    };
+    static constexpr size_t kMaxSlowCallbackEvents = 16;
+    static constexpr uint32_t kSlowCallbackThresholdMs = 100;
+    mutable std::mutex slow_events_mutex_;
+    std::deque<SlowCallbackEvent> slow_events_;
+    uint32_t slow_callback_count_ = 0;
+    uint32_t max_callback_duration_ms_ = 0;
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
@@ -88,15 +111,21 @@ private:
 
     bool has_server_time_ = false;
     bool aborted_ = false;
+    // 检测回调里打点,热通道快路径用来度量"唤醒→首个上行包"的耗时
+    int64_t wake_detected_time_us_ = 0;
     int clock_ticks_ = 0;
     TaskHandle_t check_new_version_task_handle_ = nullptr;
     TaskHandle_t main_event_loop_task_handle_ = nullptr;
 
     void OnWakeWordDetected();
     void CheckNewVersion(Ota& ota);
+    // 本地命令词分发:映射到MCP工具直呼或状态操作,不等服务器往返
+    void HandleLocalCommand(const std::string& command);
     void CheckAssetsVersion();
     void ShowActivationCode(const std::string& code, const std::string& message);
     void SetListeningMode(ListeningMode mode);
+    // 时钟每秒调用:刷新核心指标槽位并把快照采进历史环
+    void UpdateMetrics();
     
     // 闹钟相关私有方法
     void OnAlarmTriggered(const AlarmItem& alarm);
@@ -109,6 +138,15 @@ private:
     int64_t music_start_time_ms_ = 0;      // 音乐开始播放的时间戳
     int music_duration_seconds_ = 180;      // 默认歌曲长度（3分钟）
     bool is_music_playing_ = false;
+
+    // 音乐输出重采样:与 AudioService 同一个 OpusResampler 实现,
+    // 复用成员暂存区避免逐帧分配,并统计周期数/帧
+    OpusResampler music_output_resampler_;
+    int music_resampler_in_rate_ = 0;
+    int music_resampler_out_rate_ = 0;
+    std::vector<int16_t> music_resample_scratch_;
+    uint32_t music_resample_cycles_ = 0;   // 滚动平均
+    uint32_t music_resample_frames_ = 0;
 };
 
 
@@ -9,11 +9,7 @@
 #include <esp_partition.h>
 #include <model_path.h>
 
-
-struct Asset {
-    size_t size;
-    size_t offset;
-};
+struct mmap_assets_table;
 
 class Assets {
 public:
@@ -26,6 +22,9 @@ public:
     bool Download(std::string url, std::function<void(int progress, size_t speed)> progress_callback);
     bool Apply();
     bool GetAssetData(const std::string& name, void*& ptr, size_t& size);
+    // flash读吞吐基准:顺序扫读资产数据区 + 随机4KB块读,单位MB/s。
+    // 分区无效或太小时返回false
+    bool BenchmarkReads(float* seq_mbps, float* rand_mbps);
 
     inline bool partition_valid() const { return partition_valid_; }
     inline bool checksum_valid() const { return checksum_valid_; }
@@ -38,6 +37,7 @@ private:
 
     bool InitializePartition();
     uint32_t CalculateChecksum(const char* data, uint32_t length);
+    void ClearDecompressedCache();
 
     const esp_partition_t* partition_ = nullptr;
     esp_partition_mmap_handle_t mmap_handle_ = 0;
@@ -46,7 +46,13 @@ private:
     bool checksum_valid_ = false;
     std::string default_assets_url_;
     srmodel_list_t* models_list_ = nullptr;
-    std::map<std::string, Asset> assets_;
+    // 资产目录直接指向mmap表,不再在堆上建std::map
+    const mmap_assets_table* asset_table_ = nullptr;
+    uint32_t asset_count_ = 0;
+    bool asset_table_sorted_ = false;
+    const char* asset_data_root_ = nullptr;
+    // 压缩资产解压后的PSRAM缓存;调用方长期持有返回的指针,条目不做淘汰
+    std::map<std::string, std::pair<void*, size_t>> decompressed_cache_;
 };
 
 #endif
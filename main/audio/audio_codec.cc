@@ -14,18 +14,6 @@ AudioCodec::AudioCodec() {
 AudioCodec::~AudioCodec() {
 }
 
-void AudioCodec::OutputData(std::vector<int16_t>& data) {
-    Write(data.data(), data.size());
-}
-
-bool AudioCodec::InputData(std::vector<int16_t>& data) {
-    int samples = Read(data.data(), data.size());
-    if (samples > 0) {
-        return true;
-    }
-    return false;
-}
-
 void AudioCodec::Start() {
     Settings settings("audio", false);
     output_volume_ = settings.GetInt("output_volume", output_volume_);
@@ -38,11 +26,19 @@ void AudioCodec::Start() {
         original_output_sample_rate_ = output_sample_rate_;
         ESP_LOGI(TAG, "Saved original output sample rate: %d Hz", original_output_sample_rate_);
     }
+    /* 欠载/过载遥测:注册要在通道enable之前,已enable的通道(交给
+     * esp_codec_dev管理的那类)注册会失败,静默跳过即可 */
     if (tx_handle_ != nullptr) {
+        i2s_event_callbacks_t tx_callbacks = {};
+        tx_callbacks.on_send_q_ovf = OnTxQueueOverflow;
+        i2s_channel_register_event_callback(tx_handle_, &tx_callbacks, this);
         ESP_ERROR_CHECK(i2s_channel_enable(tx_handle_));
     }
 
     if (rx_handle_ != nullptr) {
+        i2s_event_callbacks_t rx_callbacks = {};
+        rx_callbacks.on_recv_q_ovf = OnRxQueueOverflow;
+        i2s_channel_register_event_callback(rx_handle_, &rx_callbacks, this);
         ESP_ERROR_CHECK(i2s_channel_enable(rx_handle_));
     }
 
@@ -52,13 +48,66 @@ void AudioCodec::Start() {
 }
 
 void AudioCodec::SetOutputVolume(int volume) {
+    /* 子类此时已把寄存器一次写到目标档(仅一笔I2C),这里补数字斜坡:
+     * 增益从新旧比值出发滑回1.0,播放中改音量不再有台阶声 */
+    StartVolumeRamp(output_volume_, volume);
     output_volume_ = volume;
     ESP_LOGI(TAG, "Set output volume to %d", output_volume_);
-    
+
     Settings settings("audio", true);
     settings.SetInt("output_volume", output_volume_);
 }
 
+bool AudioCodec::OnRxQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    ((AudioCodec*)user_ctx)->rx_overrun_count_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool AudioCodec::OnTxQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    ((AudioCodec*)user_ctx)->tx_overrun_count_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void AudioCodec::StartVolumeRamp(int old_volume, int new_volume) {
+    if (!output_enabled_ || old_volume <= 0 || new_volume <= 0 || old_volume == new_volume) {
+        return;
+    }
+    /* 起点=旧/新。调大音量时<1(从偏轻滑上来);调小时>1,上限压到2.0,
+     * 应用时带饱和,常规±10一档的比值离削波还很远 */
+    int32_t gain = (int32_t)(((int64_t)old_volume << 15) / new_volume);
+    if (gain > 2 * kVolumeRampUnity) {
+        gain = 2 * kVolumeRampUnity;
+    } else if (gain < kVolumeRampUnity / 4) {
+        gain = kVolumeRampUnity / 4;
+    }
+    int32_t ramp_samples = output_sample_rate_ * AUDIO_CODEC_VOLUME_RAMP_MS / 1000;
+    if (ramp_samples <= 0) {
+        return;
+    }
+    int32_t step = (gain > kVolumeRampUnity ? gain - kVolumeRampUnity : kVolumeRampUnity - gain) / ramp_samples;
+    volume_ramp_step_q15_.store(step > 0 ? step : 1, std::memory_order_relaxed);
+    volume_ramp_gain_q15_.store(gain, std::memory_order_relaxed);
+}
+
+void AudioCodec::ApplyVolumeRamp(int16_t* data, size_t samples) {
+    int32_t gain = volume_ramp_gain_q15_.load(std::memory_order_relaxed);
+    int32_t step = volume_ramp_step_q15_.load(std::memory_order_relaxed);
+    size_t i = 0;
+    for (; i < samples && gain != kVolumeRampUnity; i++) {
+        int32_t s = ((int32_t)data[i] * gain) >> 15;
+        data[i] = (int16_t)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+        if (gain > kVolumeRampUnity) {
+            gain -= step;
+            if (gain < kVolumeRampUnity) gain = kVolumeRampUnity;
+        } else {
+            gain += step;
+            if (gain > kVolumeRampUnity) gain = kVolumeRampUnity;
+        }
+    }
+    volume_ramp_gain_q15_.store(gain, std::memory_order_relaxed);
+    /* 到达1.0后其余样本原样直写DMA */
+}
+
 void AudioCodec::EnableInput(bool enable) {
     if (enable == input_enabled_) {
         return;
@@ -8,12 +8,20 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <atomic>
 
 #include "board.h"
 
+/* DMA几何的保守默认值:desc_num×frame_num决定硬件侧缓冲深度(也就是
+ * 尾延迟)。双工ES8311和PDM单麦的最优深度差别很大,各codec构造时可
+ * 按板子覆盖(见dma_desc_num_/dma_frame_num_),欠载/过载计数提供
+ * 调小缓冲是否安全的实测依据 */
 #define AUDIO_CODEC_DMA_DESC_NUM 6
 #define AUDIO_CODEC_DMA_FRAME_NUM 240
 #define AUDIO_CODEC_DEFAULT_MIC_GAIN 30.0
+/* 音量变化的数字斜坡时长。寄存器一次写到目标值,数字增益从新旧比值
+ * 滑回1.0,听感上是平滑渐变而不是咔哒一跳 */
+#define AUDIO_CODEC_VOLUME_RAMP_MS 50
 
 class AudioCodec {
 public:
@@ -23,14 +31,38 @@ public:
     virtual void SetOutputVolume(int volume);
     virtual void EnableInput(bool enable);
     virtual void EnableOutput(bool enable);
+    /* 分级下电的浅档:数据通路按关闭处理(enabled标志清掉),但保留偏置
+     * 与设备配置,下一次EnableInput/Output(true)亚10ms恢复,不再有整套
+     * 重新初始化的可闻延迟。默认实现等同整段下电,未重写的codec行为不变 */
+    virtual void DozeInput() { EnableInput(false); }
+    virtual void DozeOutput() { EnableOutput(false); }
     virtual bool SetOutputSampleRate(int sample_rate);
 
-    virtual void OutputData(std::vector<int16_t>& data);
-    virtual bool InputData(std::vector<int16_t>& data);
+    // 每帧热路径。非虚内联:外层包装直接在调用点展开,每帧只剩
+    // Read/Write一次虚调用(子类确实会重写的那一层)
+    /* 借用缓冲(span)版本:调用方保留所有权,底层Write阻塞直写DMA,
+     * 返回即表示样本已消费完毕,所以不需要完成回调;音量斜坡就地
+     * 修改样本,借出的缓冲须可写 */
+    void OutputData(int16_t* data, size_t samples) {
+        /* 斜坡不活动时只多一次load+分支 */
+        if (volume_ramp_gain_q15_.load(std::memory_order_relaxed) != kVolumeRampUnity) {
+            ApplyVolumeRamp(data, samples);
+        }
+        Write(data, samples);
+    }
+    void OutputData(std::vector<int16_t>& data) {
+        OutputData(data.data(), data.size());
+    }
+    bool InputData(std::vector<int16_t>& data) {
+        return Read(data.data(), data.size()) > 0;
+    }
     virtual void Start();
 
     inline bool duplex() const { return duplex_; }
     inline bool input_reference() const { return input_reference_; }
+    // 软件回声参考:没有硬件回采布线的双工板由AudioService把播放帧旁路给AFE
+    inline bool software_echo_reference() const { return software_echo_reference_; }
+    inline void SetSoftwareEchoReference(bool enable) { software_echo_reference_ = enable; }
     inline int input_sample_rate() const { return input_sample_rate_; }
     inline int output_sample_rate() const { return output_sample_rate_; }
     inline int original_output_sample_rate() const { return original_output_sample_rate_; }
@@ -39,6 +71,9 @@ public:
     inline int output_volume() const { return output_volume_; }
     inline bool input_enabled() const { return input_enabled_; }
     inline bool output_enabled() const { return output_enabled_; }
+    // I2S DMA层事件计数:接收覆盖(采集侧没跟上被硬件覆写)与发送队列溢出
+    inline uint32_t rx_overrun_count() const { return rx_overrun_count_.load(std::memory_order_relaxed); }
+    inline uint32_t tx_overrun_count() const { return tx_overrun_count_.load(std::memory_order_relaxed); }
 
 protected:
     i2s_chan_handle_t tx_handle_ = nullptr;
@@ -46,6 +81,7 @@ protected:
 
     bool duplex_ = false;
     bool input_reference_ = false;
+    bool software_echo_reference_ = false;
     bool input_enabled_ = false;
     bool output_enabled_ = false;
     int input_sample_rate_ = 0;
@@ -55,8 +91,29 @@ protected:
     int output_channels_ = 1;
     int output_volume_ = 70;
 
+    /* DMA几何,I2S通道创建之前由子类构造参数覆盖 */
+    int dma_desc_num_ = AUDIO_CODEC_DMA_DESC_NUM;
+    int dma_frame_num_ = AUDIO_CODEC_DMA_FRAME_NUM;
+
     virtual int Read(int16_t* dest, int samples) = 0;
     virtual int Write(const int16_t* data, int samples) = 0;
+
+private:
+    static constexpr int32_t kVolumeRampUnity = 32768; /* Q15的1.0 */
+
+    void StartVolumeRamp(int old_volume, int new_volume);
+    void ApplyVolumeRamp(int16_t* data, size_t samples);
+
+    /* ISR回调,只做一次relaxed自增 */
+    static bool OnRxQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+    static bool OnTxQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+    std::atomic<uint32_t> rx_overrun_count_{0};
+    std::atomic<uint32_t> tx_overrun_count_{0};
+
+    /* 设置线程写入起点,输出线程向1.0推进;都是relaxed原子,
+     * 中途重设音量只是让斜坡换个起点继续 */
+    std::atomic<int32_t> volume_ramp_gain_q15_{kVolumeRampUnity};
+    std::atomic<int32_t> volume_ramp_step_q15_{0};
 };
 
 #endif // _AUDIO_CODEC_H
@@ -0,0 +1,71 @@
+#ifndef AUDIO_POOL_H
+#define AUDIO_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+/*
+ * A small fixed-capacity object pool used by the audio pipeline to recycle
+ * AudioTask / AudioStreamPacket objects (and, more importantly, the vector
+ * capacity inside them). This keeps the steady-state audio path free of
+ * per-frame heap allocations, which otherwise fragment the internal heap
+ * over long conversations.
+ *
+ * Release() is best-effort: once the pool is full the object is simply
+ * destroyed, so the pool never grows beyond its configured capacity.
+ */
+template <typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t capacity, std::function<void(T&)> reset = nullptr)
+        : capacity_(capacity), reset_(std::move(reset)) {
+        free_list_.reserve(capacity);
+    }
+
+    std::unique_ptr<T> Acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_list_.empty()) {
+            return std::make_unique<T>();
+        }
+        auto item = std::move(free_list_.back());
+        free_list_.pop_back();
+        return item;
+    }
+
+    /* Pre-populate the pool with count objects prepared by init (typically a
+     * capacity reservation), so the first frames of a session do not allocate.
+     * Reservations made here happen at startup while the heap is unfragmented,
+     * and large ones land in PSRAM under the usual SPIRAM malloc policy. */
+    void Prewarm(size_t count, std::function<void(T&)> init) {
+        for (size_t i = 0; i < count && i < capacity_; ++i) {
+            auto item = std::make_unique<T>();
+            if (init) {
+                init(*item);
+            }
+            Release(std::move(item));
+        }
+    }
+
+    void Release(std::unique_ptr<T> item) {
+        if (item == nullptr) {
+            return;
+        }
+        if (reset_) {
+            reset_(*item);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_list_.size() < capacity_) {
+            free_list_.push_back(std::move(item));
+        }
+    }
+
+private:
+    size_t capacity_;
+    std::function<void(T&)> reset_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<T>> free_list_;
+};
+
+#endif // AUDIO_POOL_H
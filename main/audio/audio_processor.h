@@ -7,6 +7,10 @@
 
 #include <model_path.h>
 #include "audio_codec.h"
+#include "fixed_callback.h"
+
+// 每帧一发的采集输出回调:固定容量委托,注册时不落堆,调用时单次间接跳转
+using AudioOutputCallback = FixedCallback<void(std::vector<int16_t>&& data)>;
 
 class AudioProcessor {
 public:
@@ -17,10 +21,13 @@ public:
     virtual void Start() = 0;
     virtual void Stop() = 0;
     virtual bool IsRunning() = 0;
-    virtual void OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) = 0;
+    virtual void OnOutput(AudioOutputCallback callback) = 0;
     virtual void OnVadStateChange(std::function<void(bool speaking)> callback) = 0;
     virtual size_t GetFeedSize() = 0;
     virtual void EnableDeviceAec(bool enable) = 0;
+    /* Whether Feed() expects the echo reference channel interleaved with the mic.
+     * Server-side AEC aligns by timestamp, so only device-side AEC needs it. */
+    virtual bool NeedsReference() = 0;
 };
 
 #endif
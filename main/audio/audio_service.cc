@@ -1,6 +1,17 @@
 #include "audio_service.h"
 #include <esp_log.h>
+#include <esp_cpu.h>
 #include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include "pcm_ops.h"
+#include "heap_telemetry.h"
+#include "log_ring.h"
+#include "perf_trace.h"
 
 #if CONFIG_USE_AUDIO_PROCESSOR
 #include "processors/afe_audio_processor.h"
@@ -11,12 +22,37 @@
 #if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
 #include "wake_words/afe_wake_word.h"
 #include "wake_words/custom_wake_word.h"
+#include "wake_words/combined_wake_word.h"
 #else
 #include "wake_words/esp_wake_word.h"
 #endif
 
 #define TAG "AudioService"
 
+namespace {
+
+/* 上行Opus码率阶梯(16kHz单声道语音):第0档是初始值,拥塞时逐档下降。
+ * 最低8kbps下语音仍可懂,比起整帧丢弃(send_drop)音质损失小得多 */
+constexpr int kUplinkBitrateLadder[] = {24000, 16000, 12000, 8000};
+constexpr int kUplinkBitrateLevels = sizeof(kUplinkBitrateLadder) / sizeof(kUplinkBitrateLadder[0]);
+
+/* esp-opus-encoder的版本演进探测:新版wrapper暴露SetBitrate,旧版没有。
+ * 用表达式探测让两种组件版本都能编译——旧版上换档只影响统计和日志,
+ * 码率本身维持编码器默认值 */
+template <typename T, typename = void>
+struct HasSetBitrate : std::false_type {};
+template <typename T>
+struct HasSetBitrate<T, std::void_t<decltype(std::declval<T&>().SetBitrate(0))>> : std::true_type {};
+
+template <typename T>
+void ApplyEncoderBitrate(T* encoder, int bps) {
+    if constexpr (HasSetBitrate<T>::value) {
+        encoder->SetBitrate(bps);
+    }
+}
+
+}  // namespace
+
 
 AudioService::AudioService() {
     event_group_ = xEventGroupCreate();
@@ -37,19 +73,59 @@ void AudioService::Initialize(AudioCodec* codec) {
     opus_decoder_ = std::make_unique<OpusDecoderWrapper>(codec->output_sample_rate(), 1, OPUS_FRAME_DURATION_MS);
     opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
     opus_encoder_->SetComplexity(0);
+    ApplyEncoderBitrate(opus_encoder_.get(), kUplinkBitrateLadder[0]);
+#if CONFIG_USE_OPUS_DTX
+    opus_encoder_->SetDtx(true);
+#endif
 
     if (codec->input_sample_rate() != 16000) {
         input_resampler_.Configure(codec->input_sample_rate(), 16000);
         reference_resampler_.Configure(codec->input_sample_rate(), 16000);
     }
 
+#if CONFIG_USE_DEVICE_AEC
+    /* 没有硬件回采通道的单mic双工板:把播放帧软件旁路进AFE当回声参考,
+     * 设备端AEC不再依赖codec的回环布线 */
+    if (codec->duplex() && !codec->input_reference() &&
+        codec->input_channels() == 1 && codec->output_channels() == 1) {
+        software_ref_enabled_ = true;
+        codec->SetSoftwareEchoReference(true);
+        ESP_LOGI(TAG, "Software echo reference enabled for device-side AEC");
+    }
+#endif
+
 #if CONFIG_USE_AUDIO_PROCESSOR
     audio_processor_ = std::make_unique<AfeAudioProcessor>();
 #else
     audio_processor_ = std::make_unique<NoAudioProcessor>();
 #endif
 
+#if CONFIG_USE_LOCAL_COMMANDS
+    command_recognizer_ = std::make_unique<LocalCommandRecognizer>();
+    command_recognizer_->OnCommandDetected([this](const std::string& command, float prob) {
+        if (callbacks_.on_local_command) {
+            callbacks_.on_local_command(command);
+        }
+    });
+#endif
+
     audio_processor_->OnOutput([this](std::vector<int16_t>&& data) {
+#if CONFIG_USE_LOCAL_COMMANDS
+        /* 本地命令词旁路:吃的是同一份降噪后输出,命中直接走本地分发,
+         * 帧本身照常上行(没命中时由服务器兜底) */
+        if (command_recognizer_) {
+            command_recognizer_->Feed(data);
+        }
+#endif
+#if CONFIG_USE_OPUS_DTX
+        /* Keep encoding for a short hangover after the VAD goes silent, so
+         * utterance tails are not clipped, then stop queueing uplink frames */
+        if (voice_detected_) {
+            silence_frames_ = 0;
+        } else if (++silence_frames_ > VAD_ENCODE_HANGOVER_FRAMES) {
+            return;
+        }
+#endif
         PushTaskToEncodeQueue(kAudioTaskTypeEncodeToSendQueue, std::move(data));
     });
 
@@ -71,6 +147,19 @@ void AudioService::Initialize(AudioCodec* codec) {
         .skip_unhandled_events = true,
     };
     esp_timer_create(&audio_power_timer_args, &audio_power_timer_);
+
+    /* Reserve task/packet buffer capacity while the heap is still unfragmented:
+     * a decoded 60ms frame at the codec output rate for PCM, and a generous
+     * upper bound for an encoded Opus frame */
+    size_t max_pcm_samples = codec->output_sample_rate() * OPUS_FRAME_DURATION_MS / 1000 * codec->output_channels();
+    task_pool_.Prewarm(MAX_PLAYBACK_TASKS_IN_QUEUE + MAX_ENCODE_TASKS_IN_QUEUE,
+        [max_pcm_samples](AudioTask& task) { task.pcm.reserve(max_pcm_samples); });
+    packet_pool_.Prewarm(MAX_SEND_PACKETS_IN_QUEUE,
+        [](AudioStreamPacket& packet) { packet.payload.reserve(256); });
+    // 池是常驻的,按预留容量一次性计入音频子系统水位
+    HeapTelemetry::GetInstance().Track(kHeapTagAudio,
+        (MAX_PLAYBACK_TASKS_IN_QUEUE + MAX_ENCODE_TASKS_IN_QUEUE) * max_pcm_samples * sizeof(int16_t) +
+        MAX_SEND_PACKETS_IN_QUEUE * 256);
 }
 
 void AudioService::Start() {
@@ -109,61 +198,155 @@ void AudioService::Start() {
     }, "audio_output", 2048, this, 4, &audio_output_task_handle_);
 #endif
 
+#if CONFIG_USE_DUAL_CORE_OPUS_CODEC
+    /* Split encode and decode onto separate cores so barge-in does not starve playback.
+     * Decode runs on core 0 at a slightly higher priority to avoid underruns. */
+    xTaskCreatePinnedToCore([](void* arg) {
+        AudioService* audio_service = (AudioService*)arg;
+        audio_service->OpusEncodeTask();
+        vTaskDelete(NULL);
+    }, "opus_encode", 2048 * 13, this, 2, &opus_codec_task_handle_, 1);
+
+    xTaskCreatePinnedToCore([](void* arg) {
+        AudioService* audio_service = (AudioService*)arg;
+        audio_service->OpusDecodeTask();
+        vTaskDelete(NULL);
+    }, "opus_decode", 2048 * 13, this, 3, &opus_decode_task_handle_, 0);
+#else
     /* Start the opus codec task */
     xTaskCreate([](void* arg) {
         AudioService* audio_service = (AudioService*)arg;
         audio_service->OpusCodecTask();
         vTaskDelete(NULL);
     }, "opus_codec", 2048 * 13, this, 2, &opus_codec_task_handle_);
+#endif
+
+#if CONFIG_USE_AUDIO_LOOPBACK_BENCHMARK
+    xTaskCreate([](void* arg) {
+        ((AudioService*)arg)->RunLoopbackBenchmark();
+        vTaskDelete(NULL);
+    }, "audio_bench", 2048 * 13, this, 1, nullptr);
+#endif
 }
 
+#if CONFIG_USE_AUDIO_LOOPBACK_BENCHMARK
+void AudioService::RunLoopbackBenchmark() {
+    const int frames = 1000 / OPUS_FRAME_DURATION_MS;
+    const int samples_per_frame = 16000 * OPUS_FRAME_DURATION_MS / 1000;
+
+    /* 440Hz tone so the encoder does real work instead of coding silence */
+    std::vector<int16_t> pcm(samples_per_frame);
+    for (int i = 0; i < samples_per_frame; ++i) {
+        pcm[i] = (int16_t)(8000.0f * sinf(2.0f * 3.14159265f * 440.0f * i / 16000.0f));
+    }
+
+    auto decoder = std::make_unique<OpusDecoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
+    std::vector<uint8_t> opus;
+    std::vector<int16_t> decoded;
+    size_t total_bytes = 0;
+    int64_t encode_us = 0, decode_us = 0;
+
+    for (int i = 0; i < frames; ++i) {
+        auto frame = pcm;
+        int64_t start = esp_timer_get_time();
+        if (!opus_encoder_->Encode(std::move(frame), opus)) {
+            ESP_LOGE(TAG, "Benchmark encode failed");
+            return;
+        }
+        encode_us += esp_timer_get_time() - start;
+        total_bytes += opus.size();
+
+        start = esp_timer_get_time();
+        if (!decoder->Decode(std::move(opus), decoded)) {
+            ESP_LOGE(TAG, "Benchmark decode failed");
+            return;
+        }
+        decode_us += esp_timer_get_time() - start;
+    }
+    opus_encoder_->ResetState();
+
+    int64_t audio_us = (int64_t)frames * OPUS_FRAME_DURATION_MS * 1000;
+    ESP_LOGI(TAG, "Loopback benchmark: %d frames, complexity %d, %u bytes/s",
+        frames, opus_complexity_, (unsigned)(total_bytes * 1000000 / audio_us));
+    ESP_LOGI(TAG, "  encode: %lld us/frame (RTF %.3f)", encode_us / frames, (float)encode_us / audio_us);
+    ESP_LOGI(TAG, "  decode: %lld us/frame (RTF %.3f)", decode_us / frames, (float)decode_us / audio_us);
+}
+#endif
+
 void AudioService::Stop() {
     esp_timer_stop(audio_power_timer_);
     service_stopped_ = true;
     xEventGroupSetBits(event_group_, AS_EVENT_AUDIO_TESTING_RUNNING |
         AS_EVENT_WAKE_WORD_RUNNING |
-        AS_EVENT_AUDIO_PROCESSOR_RUNNING);
+        AS_EVENT_AUDIO_PROCESSOR_RUNNING |
+        AS_EVENT_PLAYBACK_NOT_EMPTY);
 
     std::lock_guard<std::mutex> lock(audio_queue_mutex_);
     audio_encode_queue_.clear();
     audio_decode_queue_.clear();
-    audio_playback_queue_.clear();
+    audio_playback_queue_.Clear();
     audio_testing_queue_.clear();
+    pcm_sound_queue_.clear();
     audio_queue_cv_.notify_all();
 }
 
-bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples) {
+bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples, bool include_reference) {
+    PERF_TRACE_PROBE(kProbeCaptureRead);
     if (!codec_->input_enabled()) {
         esp_timer_stop(audio_power_timer_);
         esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
         codec_->EnableInput(true);
     }
 
+    /* Consumers that do not use the echo reference (server AEC aligns by
+     * timestamp) get a mono frame: the reference channel is dropped before
+     * resampling, saving one resample pass and the re-interleave entirely */
+    if (codec_->input_channels() == 2 && !include_reference) {
+        input_scratch_.resize(samples * codec_->input_sample_rate() / sample_rate * 2);
+        if (!codec_->InputData(input_scratch_)) {
+            return false;
+        }
+        size_t channel_samples = input_scratch_.size() / 2;
+        mic_scratch_.resize(channel_samples);
+        reference_scratch_.resize(channel_samples);
+        pcm_deinterleave_stereo(input_scratch_.data(), mic_scratch_.data(), reference_scratch_.data(), channel_samples);
+        if (codec_->input_sample_rate() != sample_rate) {
+            data.resize(input_resampler_.GetOutputSamples(channel_samples));
+            input_resampler_.Process(mic_scratch_.data(), channel_samples, data.data());
+        } else {
+            data.assign(mic_scratch_.begin(), mic_scratch_.end());
+        }
+
+        last_input_time_ = std::chrono::steady_clock::now();
+        debug_statistics_.input_count++;
+        return true;
+    }
+
     if (codec_->input_sample_rate() != sample_rate) {
-        data.resize(samples * codec_->input_sample_rate() / sample_rate * codec_->input_channels());
-        if (!codec_->InputData(data)) {
+        /* Read into a persistent scratch buffer so the steady-state capture path
+         * performs no heap allocations. resize() only reallocates on the first frame,
+         * afterwards the capacity is reused. */
+        input_scratch_.resize(samples * codec_->input_sample_rate() / sample_rate * codec_->input_channels());
+        if (!codec_->InputData(input_scratch_)) {
             return false;
         }
         if (codec_->input_channels() == 2) {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2) {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
-            }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2) {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
-            }
+            size_t channel_samples = input_scratch_.size() / 2;
+            mic_scratch_.resize(channel_samples);
+            reference_scratch_.resize(channel_samples);
+            pcm_deinterleave_stereo(input_scratch_.data(), mic_scratch_.data(), reference_scratch_.data(), channel_samples);
+            size_t resampled_mic_size = input_resampler_.GetOutputSamples(channel_samples);
+            size_t resampled_reference_size = reference_resampler_.GetOutputSamples(channel_samples);
+            resample_scratch_.resize(resampled_mic_size + resampled_reference_size);
+            int16_t* resampled_mic = resample_scratch_.data();
+            int16_t* resampled_reference = resample_scratch_.data() + resampled_mic_size;
+            input_resampler_.Process(mic_scratch_.data(), channel_samples, resampled_mic);
+            reference_resampler_.Process(reference_scratch_.data(), channel_samples, resampled_reference);
+            data.resize(resampled_mic_size + resampled_reference_size);
+            pcm_interleave_stereo(resampled_mic, resampled_reference, data.data(), resampled_mic_size);
         } else {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
-            input_resampler_.Process(data.data(), data.size(), resampled.data());
-            data = std::move(resampled);
+            data.resize(input_resampler_.GetOutputSamples(input_scratch_.size()));
+            input_resampler_.Process(input_scratch_.data(), input_scratch_.size(), data.data());
         }
     } else {
         data.resize(samples * codec_->input_channels());
@@ -187,6 +370,107 @@ bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, in
     return true;
 }
 
+/* 输出任务侧:刚写进DMA的播放帧复制一份进参考环。环满说明采集侧没在消费
+ * (处理器刚起或刚停),直接丢帧,缺口由AEC自适应滤波器收敛兜底 */
+void AudioService::PushSoftwareReference(const std::vector<int16_t>& pcm) {
+    std::vector<int16_t> copy(pcm);
+    software_ref_ring_.Push(std::move(copy));
+}
+
+/* 采集任务侧:从参考环取播放帧,重采样到16k后与mono mic帧交错成MR格式。
+ * 环空(没在播/刚开播)补零;播放停顿造成的积压只保留最新两帧,让参考的
+ * 滞后收敛回DMA环深度这一固定值 */
+void AudioService::AppendSoftwareReference(std::vector<int16_t>& data) {
+    size_t mic_samples = data.size();
+
+    /* 输出采样率可能被下行协商切换,滞后重配重采样器 */
+    if (software_ref_rate_ != codec_->output_sample_rate()) {
+        software_ref_rate_ = codec_->output_sample_rate();
+        if (software_ref_rate_ != 16000) {
+            software_ref_resampler_.Configure(software_ref_rate_, 16000);
+        }
+        software_ref_pending_.clear();
+    }
+
+    std::vector<int16_t> frame;
+    while (software_ref_pending_.size() < mic_samples && software_ref_ring_.Pop(frame)) {
+        size_t old_size = software_ref_pending_.size();
+        if (software_ref_rate_ != 16000) {
+            size_t resampled = software_ref_resampler_.GetOutputSamples(frame.size());
+            software_ref_pending_.resize(old_size + resampled);
+            software_ref_resampler_.Process(frame.data(), frame.size(),
+                                            software_ref_pending_.data() + old_size);
+        } else {
+            software_ref_pending_.insert(software_ref_pending_.end(), frame.begin(), frame.end());
+        }
+    }
+
+    if (software_ref_pending_.size() > mic_samples * 3) {
+        software_ref_pending_.erase(software_ref_pending_.begin(),
+                                    software_ref_pending_.end() - mic_samples * 2);
+    }
+    if (software_ref_pending_.size() < mic_samples) {
+        software_ref_pending_.resize(mic_samples, 0);
+    }
+
+    mic_scratch_.assign(data.begin(), data.end());
+    data.resize(mic_samples * 2);
+    pcm_interleave_stereo(mic_scratch_.data(), software_ref_pending_.data(), data.data(), mic_samples);
+    software_ref_pending_.erase(software_ref_pending_.begin(),
+                                software_ref_pending_.begin() + mic_samples);
+}
+
+/* 音乐送出线程侧:说话期间的音乐帧(已重采样到当前输出采样率)入压混环 */
+bool AudioService::MixUnderPlayback(std::vector<int16_t>&& pcm) {
+    return duck_ring_.Push(std::move(pcm));
+}
+
+/* 输出任务侧:把排队的音乐样本以约-12dB饱和叠加进TTS帧。增益按样本向
+ * 目标值爬坡(约20ms到位),音乐断档时归零重新爬坡,起混/停混都无爆音;
+ * 环空就原样播TTS,不引入任何额外拷贝 */
+void AudioService::MixDuckedMusic(std::vector<int16_t>& pcm) {
+    constexpr int32_t kDuckGainQ15 = 8192;  // ~-12dB
+    constexpr int32_t kGainStep = 16;       // 每样本步进,8192/16=512样本爬满
+
+    std::vector<int16_t> frame;
+    while (duck_pending_.size() < pcm.size() && duck_ring_.Pop(frame)) {
+        duck_pending_.insert(duck_pending_.end(), frame.begin(), frame.end());
+    }
+
+    size_t n = std::min(duck_pending_.size(), pcm.size());
+    if (n == 0) {
+        duck_gain_q15_ = 0;
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (duck_gain_q15_ < kDuckGainQ15) {
+            duck_gain_q15_ += kGainStep;
+        }
+        int32_t mixed = (int32_t)pcm[i] + (((int32_t)duck_pending_[i] * duck_gain_q15_) >> 15);
+        if (mixed > 32767) mixed = 32767;
+        if (mixed < -32768) mixed = -32768;
+        pcm[i] = (int16_t)mixed;
+    }
+    duck_pending_.erase(duck_pending_.begin(), duck_pending_.begin() + n);
+}
+
+/* 见头文件:已写进DMA的内容微秒数,写间隔内按墙钟外插、封顶一帧 */
+int64_t AudioService::GetPlaybackPositionUs() {
+    int64_t wall = playback_clock_wall_us_.load(std::memory_order_relaxed);
+    if (wall == 0) {
+        return 0;
+    }
+    int64_t elapsed = esp_timer_get_time() - wall;
+    int64_t cap = playback_last_frame_us_.load(std::memory_order_relaxed);
+    return playback_position_us_.load(std::memory_order_relaxed) + std::min(elapsed, cap);
+}
+
+void AudioService::ResetPlaybackClock() {
+    playback_position_us_.store(0, std::memory_order_relaxed);
+    playback_clock_wall_us_.store(0, std::memory_order_relaxed);
+    playback_last_frame_us_.store(0, std::memory_order_relaxed);
+}
+
 void AudioService::AudioInputTask() {
     while (true) {
         EventBits_t bits = xEventGroupWaitBits(event_group_, AS_EVENT_AUDIO_TESTING_RUNNING |
@@ -211,15 +495,8 @@ void AudioService::AudioInputTask() {
             }
             std::vector<int16_t> data;
             int samples = OPUS_FRAME_DURATION_MS * 16000 / 1000;
-            if (ReadAudioData(data, 16000, samples)) {
-                // If input channels is 2, we need to fetch the left channel data
-                if (codec_->input_channels() == 2) {
-                    auto mono_data = std::vector<int16_t>(data.size() / 2);
-                    for (size_t i = 0, j = 0; i < mono_data.size(); ++i, j += 2) {
-                        mono_data[i] = data[j];
-                    }
-                    data = std::move(mono_data);
-                }
+            /* Testing only needs the mic channel */
+            if (ReadAudioData(data, 16000, samples, false)) {
                 PushTaskToEncodeQueue(kAudioTaskTypeEncodeToTestingQueue, std::move(data));
                 continue;
             }
@@ -242,7 +519,11 @@ void AudioService::AudioInputTask() {
             std::vector<int16_t> data;
             int samples = audio_processor_->GetFeedSize();
             if (samples > 0) {
-                if (ReadAudioData(data, 16000, samples)) {
+                if (ReadAudioData(data, 16000, samples, audio_processor_->NeedsReference())) {
+                    /* 软件参考:把播放旁路帧拼成R通道(MR交错)再喂AFE */
+                    if (software_ref_enabled_ && audio_processor_->NeedsReference()) {
+                        AppendSoftwareReference(data);
+                    }
                     audio_processor_->Feed(std::move(data));
                     continue;
                 }
@@ -258,35 +539,77 @@ void AudioService::AudioInputTask() {
 
 void AudioService::AudioOutputTask() {
     while (true) {
-        std::unique_lock<std::mutex> lock(audio_queue_mutex_);
-        audio_queue_cv_.wait(lock, [this]() { return !audio_playback_queue_.empty() || service_stopped_; });
+        xEventGroupWaitBits(event_group_, AS_EVENT_PLAYBACK_NOT_EMPTY, pdTRUE, pdFALSE, portMAX_DELAY);
         if (service_stopped_) {
             break;
         }
 
-        auto task = std::move(audio_playback_queue_.front());
-        audio_playback_queue_.pop_front();
-        audio_queue_cv_.notify_all();
-        lock.unlock();
+        std::unique_ptr<AudioTask> task;
+        while (audio_playback_queue_.Pop(task)) {
+            /* Wake the codec task in case it is waiting for playback queue space */
+            audio_queue_cv_.notify_all();
 
-        if (!codec_->output_enabled()) {
-            esp_timer_stop(audio_power_timer_);
-            esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
-            codec_->EnableOutput(true);
-        }
-        codec_->OutputData(task->pcm);
+            if (!codec_->output_enabled()) {
+                esp_timer_stop(audio_power_timer_);
+                esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
+                codec_->EnableOutput(true);
+            }
 
-        /* Update the last output time */
-        last_output_time_ = std::chrono::steady_clock::now();
-        debug_statistics_.playback_count++;
+            /* The blocking DMA write paces output sample-accurately; a gap of
+             * more than one frame between writes therefore means the DMA ring
+             * drained and a gap was audible. Count it, and prime the DMA with
+             * one frame of silence so the restart edge does not click. */
+            auto gap = std::chrono::steady_clock::now() - last_output_time_;
+            if (gap > std::chrono::milliseconds(OPUS_FRAME_DURATION_MS * 2) &&
+                gap < std::chrono::milliseconds(AUDIO_POWER_TIMEOUT_MS)) {
+                debug_statistics_.playback_underrun_count++;
+                silence_scratch_.assign(task->pcm.size(), 0);
+                codec_->OutputData(silence_scratch_);
+            }
+#if CONFIG_USE_OUTPUT_DSP
+            output_dsp_.Configure(codec_->output_sample_rate());
+            output_dsp_.Process(task->pcm);
+#endif
+            /* 音乐压混在DSP之后、写DMA之前:混入的样本同样进AEC软件参考,
+             * 回声消除看到的就是扬声器实际播出的信号 */
+            MixDuckedMusic(task->pcm);
+            PERF_TRACE_PROBE(kProbePlaybackWrite);
+            codec_->OutputData(task->pcm);
+
+            /* Update the last output time */
+            last_output_time_ = std::chrono::steady_clock::now();
+
+            /* 播放时钟推进:按刚写进DMA的样本数折算微秒(静音垫帧不算内容) */
+            if (codec_->output_sample_rate() > 0) {
+                int64_t frame_us = (int64_t)task->pcm.size() * 1000000 / codec_->output_sample_rate();
+                playback_last_frame_us_.store(frame_us, std::memory_order_relaxed);
+                playback_position_us_.fetch_add(frame_us, std::memory_order_relaxed);
+                playback_clock_wall_us_.store(esp_timer_get_time(), std::memory_order_relaxed);
+            }
+            output_activity_us_.store(esp_timer_get_time(), std::memory_order_relaxed);
+            debug_statistics_.playback_count++;
+            UpdateLatencyStat(debug_statistics_.playback_latency_us, task->enqueue_time);
+
+            /* 软件AEC参考旁路:采集任务在跑时把刚写进DMA的这帧复制进参考环 */
+            if (software_ref_enabled_ && IsAudioProcessorRunning()) {
+                PushSoftwareReference(task->pcm);
+            }
 
 #if CONFIG_USE_SERVER_AEC
-        /* Record the timestamp for server AEC */
-        if (task->timestamp > 0) {
-            lock.lock();
-            timestamp_queue_.push_back(task->timestamp);
-        }
+            /* Record the timestamp for server AEC, on the dedicated wait-free
+             * ring. A full ring means playback produced several frames while
+             * capture consumed none — the clocks have diverged */
+            if (task->timestamp > 0) {
+                uint32_t timestamp = task->timestamp;
+                if (!timestamp_ring_.Push(std::move(timestamp)) &&
+                    ++timestamp_overrun_count_ % 16 == 1) {
+                    LOGR_W(TAG, "AEC timestamp ring full, playback ahead of capture (x%lu)",
+                        (uint32_t)timestamp_overrun_count_);
+                }
+            }
 #endif
+            task_pool_.Release(std::move(task));
+        }
     }
 
     ESP_LOGW(TAG, "Audio output task stopped");
@@ -295,75 +618,108 @@ void AudioService::AudioOutputTask() {
 void AudioService::OpusCodecTask() {
     while (true) {
         std::unique_lock<std::mutex> lock(audio_queue_mutex_);
-        audio_queue_cv_.wait(lock, [this]() {
+        /* Use a bounded wait so a prebuffering jitter buffer still drains the
+         * stream tail when no further packets arrive */
+        audio_queue_cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() {
             return service_stopped_ ||
-                (!audio_encode_queue_.empty() && audio_send_queue_.size() < MAX_SEND_PACKETS_IN_QUEUE) ||
-                (!audio_decode_queue_.empty() && audio_playback_queue_.size() < MAX_PLAYBACK_TASKS_IN_QUEUE);
+                !audio_encode_queue_.empty() ||
+                ((!pcm_sound_queue_.empty() || IsDecodeQueueReady()) &&
+                 audio_playback_queue_.Size() < MAX_PLAYBACK_TASKS_IN_QUEUE);
         });
         if (service_stopped_) {
             break;
         }
+        if (decode_prebuffering_ && !audio_decode_queue_.empty() &&
+            std::chrono::steady_clock::now() - last_decode_packet_time_ > std::chrono::milliseconds(2 * OPUS_FRAME_DURATION_MS)) {
+            /* The stream has gone quiet; play out whatever is buffered */
+            decode_prebuffering_ = false;
+        }
+
+        /* 缓存提示音直通:已是输出采样率的PCM,这里只负责搬进播放队列
+         * (播放队列是SPSC环,生产者必须是本任务) */
+        if (!pcm_sound_queue_.empty() && audio_playback_queue_.Size() < MAX_PLAYBACK_TASKS_IN_QUEUE) {
+            auto pcm = std::move(pcm_sound_queue_.front());
+            pcm_sound_queue_.pop_front();
+            lock.unlock();
+
+            auto task = task_pool_.Acquire();
+            task->type = kAudioTaskTypeDecodeToPlaybackQueue;
+            task->timestamp = 0;
+            task->enqueue_time = std::chrono::steady_clock::now();
+            task->pcm = std::move(pcm);
+            audio_playback_queue_.Push(std::move(task));
+            xEventGroupSetBits(event_group_, AS_EVENT_PLAYBACK_NOT_EMPTY);
+            lock.lock();
+        }
 
         /* Decode the audio from decode queue */
-        if (!audio_decode_queue_.empty() && audio_playback_queue_.size() < MAX_PLAYBACK_TASKS_IN_QUEUE) {
+        if (IsDecodeQueueReady() && audio_playback_queue_.Size() < MAX_PLAYBACK_TASKS_IN_QUEUE) {
             auto packet = std::move(audio_decode_queue_.front());
             audio_decode_queue_.pop_front();
             audio_queue_cv_.notify_all();
             lock.unlock();
 
-            auto task = std::make_unique<AudioTask>();
+            if (packet->sequence != 0) {
+                if (last_decode_sequence_ != 0 && packet->sequence > last_decode_sequence_ + 1) {
+                    ConcealLostFrames(packet->sequence - last_decode_sequence_ - 1);
+                }
+                last_decode_sequence_ = packet->sequence;
+            }
+
+            auto task = task_pool_.Acquire();
             task->type = kAudioTaskTypeDecodeToPlaybackQueue;
             task->timestamp = packet->timestamp;
+            task->enqueue_time = std::chrono::steady_clock::now();
 
             SetDecodeSampleRate(packet->sample_rate, packet->frame_duration);
-            if (opus_decoder_->Decode(std::move(packet->payload), task->pcm)) {
+            bool decoded = opus_decoder_->Decode(std::move(packet->payload), task->pcm);
+            packet_pool_.Release(std::move(packet));
+            if (decoded) {
                 // Resample if the sample rate is different
                 if (opus_decoder_->sample_rate() != codec_->output_sample_rate()) {
-                    int target_size = output_resampler_.GetOutputSamples(task->pcm.size());
-                    std::vector<int16_t> resampled(target_size);
-                    output_resampler_.Process(task->pcm.data(), task->pcm.size(), resampled.data());
-                    task->pcm = std::move(resampled);
+                    ResampleOutput(task->pcm);
                 }
 
+                last_decoded_pcm_.assign(task->pcm.begin(), task->pcm.end());
+                audio_playback_queue_.Push(std::move(task));
+                xEventGroupSetBits(event_group_, AS_EVENT_PLAYBACK_NOT_EMPTY);
                 lock.lock();
-                audio_playback_queue_.push_back(std::move(task));
-                audio_queue_cv_.notify_all();
             } else {
-                ESP_LOGE(TAG, "Failed to decode audio");
+                LOGR_E(TAG, "Failed to decode audio");
                 lock.lock();
             }
             debug_statistics_.decode_count++;
         }
         
         /* Encode the audio to send queue */
-        if (!audio_encode_queue_.empty() && audio_send_queue_.size() < MAX_SEND_PACKETS_IN_QUEUE) {
+        if (!audio_encode_queue_.empty()) {
             auto task = std::move(audio_encode_queue_.front());
             audio_encode_queue_.pop_front();
             audio_queue_cv_.notify_all();
             lock.unlock();
 
-            auto packet = std::make_unique<AudioStreamPacket>();
+            auto packet = packet_pool_.Acquire();
             packet->frame_duration = OPUS_FRAME_DURATION_MS;
             packet->sample_rate = 16000;
             packet->timestamp = task->timestamp;
+            PERF_TRACE_PROBE(kProbeEncodeStart);
             if (!opus_encoder_->Encode(std::move(task->pcm), packet->payload)) {
-                ESP_LOGE(TAG, "Failed to encode audio");
+                LOGR_E(TAG, "Failed to encode audio");
+                task_pool_.Release(std::move(task));
                 continue;
             }
+            PERF_TRACE_PROBE(kProbeEncodeEnd);
 
             if (task->type == kAudioTaskTypeEncodeToSendQueue) {
-                {
-                    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-                    audio_send_queue_.push_back(std::move(packet));
-                }
-                if (callbacks_.on_send_queue_available) {
-                    callbacks_.on_send_queue_available();
-                }
+                PushPacketToSendQueue(std::move(packet));
+                UpdateUplinkBitrate();
             } else if (task->type == kAudioTaskTypeEncodeToTestingQueue) {
                 std::lock_guard<std::mutex> lock(audio_queue_mutex_);
                 audio_testing_queue_.push_back(std::move(packet));
             }
             debug_statistics_.encode_count++;
+            UpdateLatencyStat(debug_statistics_.encode_latency_us, task->enqueue_time);
+            task_pool_.Release(std::move(task));
             lock.lock();
         }
     }
@@ -371,6 +727,148 @@ void AudioService::OpusCodecTask() {
     ESP_LOGW(TAG, "Opus codec task stopped");
 }
 
+#if CONFIG_USE_DUAL_CORE_OPUS_CODEC
+void AudioService::OpusDecodeTask() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(audio_queue_mutex_);
+        audio_queue_cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+            return service_stopped_ ||
+                ((!pcm_sound_queue_.empty() || IsDecodeQueueReady()) &&
+                 audio_playback_queue_.Size() < MAX_PLAYBACK_TASKS_IN_QUEUE);
+        });
+        if (service_stopped_) {
+            break;
+        }
+        if (decode_prebuffering_ && !audio_decode_queue_.empty() &&
+            std::chrono::steady_clock::now() - last_decode_packet_time_ > std::chrono::milliseconds(2 * OPUS_FRAME_DURATION_MS)) {
+            /* The stream has gone quiet; play out whatever is buffered */
+            decode_prebuffering_ = false;
+        }
+        /* 缓存提示音直通,同单核路径:PCM只搬运,不过解码器和抖动缓冲 */
+        if (!pcm_sound_queue_.empty() && audio_playback_queue_.Size() < MAX_PLAYBACK_TASKS_IN_QUEUE) {
+            auto pcm = std::move(pcm_sound_queue_.front());
+            pcm_sound_queue_.pop_front();
+            lock.unlock();
+
+            auto task = task_pool_.Acquire();
+            task->type = kAudioTaskTypeDecodeToPlaybackQueue;
+            task->timestamp = 0;
+            task->enqueue_time = std::chrono::steady_clock::now();
+            task->pcm = std::move(pcm);
+            audio_playback_queue_.Push(std::move(task));
+            xEventGroupSetBits(event_group_, AS_EVENT_PLAYBACK_NOT_EMPTY);
+            continue;
+        }
+        if (!IsDecodeQueueReady() || audio_playback_queue_.Size() >= MAX_PLAYBACK_TASKS_IN_QUEUE) {
+            continue;
+        }
+
+        auto packet = std::move(audio_decode_queue_.front());
+        audio_decode_queue_.pop_front();
+        audio_queue_cv_.notify_all();
+        lock.unlock();
+
+        if (packet->sequence != 0) {
+            if (last_decode_sequence_ != 0 && packet->sequence > last_decode_sequence_ + 1) {
+                ConcealLostFrames(packet->sequence - last_decode_sequence_ - 1);
+            }
+            last_decode_sequence_ = packet->sequence;
+        }
+
+        auto task = task_pool_.Acquire();
+        task->type = kAudioTaskTypeDecodeToPlaybackQueue;
+        task->timestamp = packet->timestamp;
+        task->enqueue_time = std::chrono::steady_clock::now();
+
+        SetDecodeSampleRate(packet->sample_rate, packet->frame_duration);
+        bool decoded = opus_decoder_->Decode(std::move(packet->payload), task->pcm);
+        packet_pool_.Release(std::move(packet));
+        if (decoded) {
+            if (opus_decoder_->sample_rate() != codec_->output_sample_rate()) {
+                ResampleOutput(task->pcm);
+            }
+
+            last_decoded_pcm_.assign(task->pcm.begin(), task->pcm.end());
+            audio_playback_queue_.Push(std::move(task));
+            xEventGroupSetBits(event_group_, AS_EVENT_PLAYBACK_NOT_EMPTY);
+        } else {
+            ESP_LOGE(TAG, "Failed to decode audio");
+        }
+        debug_statistics_.decode_count++;
+    }
+
+    ESP_LOGW(TAG, "Opus decode task stopped");
+}
+
+void AudioService::OpusEncodeTask() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(audio_queue_mutex_);
+        audio_queue_cv_.wait(lock, [this]() {
+            return service_stopped_ ||
+                !audio_encode_queue_.empty();
+        });
+        if (service_stopped_) {
+            break;
+        }
+
+        auto task = std::move(audio_encode_queue_.front());
+        audio_encode_queue_.pop_front();
+        audio_queue_cv_.notify_all();
+        lock.unlock();
+
+        auto packet = packet_pool_.Acquire();
+        packet->frame_duration = OPUS_FRAME_DURATION_MS;
+        packet->sample_rate = 16000;
+        packet->timestamp = task->timestamp;
+        PERF_TRACE_PROBE(kProbeEncodeStart);
+        if (!opus_encoder_->Encode(std::move(task->pcm), packet->payload)) {
+            ESP_LOGE(TAG, "Failed to encode audio");
+            task_pool_.Release(std::move(task));
+            continue;
+        }
+        PERF_TRACE_PROBE(kProbeEncodeEnd);
+
+        if (task->type == kAudioTaskTypeEncodeToSendQueue) {
+            PushPacketToSendQueue(std::move(packet));
+            UpdateUplinkBitrate();
+        } else if (task->type == kAudioTaskTypeEncodeToTestingQueue) {
+            std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+            audio_testing_queue_.push_back(std::move(packet));
+        }
+        debug_statistics_.encode_count++;
+        UpdateLatencyStat(debug_statistics_.encode_latency_us, task->enqueue_time);
+        task_pool_.Release(std::move(task));
+    }
+
+    ESP_LOGW(TAG, "Opus encode task stopped");
+}
+#endif
+
+/* Rebuild the decoder for the negotiated server format while the channel is
+ * still being set up, so the first TTS packet is not delayed by decoder
+ * construction and resampler configuration */
+void AudioService::PrewarmDecoder(int sample_rate, int frame_duration) {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    SetDecodeSampleRate(sample_rate, frame_duration);
+}
+
+/* Shared output resample step for both decode paths, with a rolling
+ * cycles-per-frame average so the cost is measurable at runtime. */
+void AudioService::ResampleOutput(std::vector<int16_t>& pcm) {
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+    int target_size = output_resampler_.GetOutputSamples(pcm.size());
+    std::vector<int16_t> resampled(target_size);
+    output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
+    pcm = std::move(resampled);
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+
+    output_resample_cycles_ = (output_resample_cycles_ * 7 + cycles) / 8;
+    if ((++output_resample_frames_ % 256) == 0) {
+        ESP_LOGD(TAG, "Output resample cost: %u cycles/frame (avg)",
+                (unsigned int)output_resample_cycles_);
+    }
+}
+
 void AudioService::SetDecodeSampleRate(int sample_rate, int frame_duration) {
     if (opus_decoder_->sample_rate() == sample_rate && opus_decoder_->duration_ms() == frame_duration) {
         return;
@@ -387,30 +885,101 @@ void AudioService::SetDecodeSampleRate(int sample_rate, int frame_duration) {
 }
 
 void AudioService::PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm) {
-    auto task = std::make_unique<AudioTask>();
+    auto task = task_pool_.Acquire();
     task->type = type;
     task->pcm = std::move(pcm);
+    task->enqueue_time = std::chrono::steady_clock::now();
     
-    /* Push the task to the encode queue */
-    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
-
-    /* If the task is to send queue, we need to set the timestamp */
-    if (type == kAudioTaskTypeEncodeToSendQueue && !timestamp_queue_.empty()) {
-        if (timestamp_queue_.size() <= MAX_TIMESTAMPS_IN_QUEUE) {
-            task->timestamp = timestamp_queue_.front();
-        } else {
-            ESP_LOGW(TAG, "Timestamp queue (%u) is full, dropping timestamp", timestamp_queue_.size());
+    /* Send-queue frames carry the matching playback timestamp for server AEC,
+     * popped off the wait-free ring without touching the audio mutex. In steady
+     * state at most one entry is outstanding; a deeper backlog means the
+     * playback clock pulled ahead of capture by more than a frame, so log the
+     * drift and drain to the freshest entry to re-align */
+    if (type == kAudioTaskTypeEncodeToSendQueue) {
+        uint32_t timestamp = 0;
+        if (timestamp_ring_.Pop(timestamp)) {
+            task->timestamp = timestamp;
+            if (timestamp_ring_.Size() > 1) {
+                LOGR_W(TAG, "AEC timestamp backlog %u frames (~%u ms), re-aligning",
+                    (uint32_t)timestamp_ring_.Size(),
+                    (uint32_t)(timestamp_ring_.Size() * OPUS_FRAME_DURATION_MS));
+                while (timestamp_ring_.Size() > 1 && timestamp_ring_.Pop(timestamp)) {
+                    task->timestamp = timestamp;
+                }
+            }
         }
-        timestamp_queue_.pop_front();
     }
 
+    /* Push the task to the encode queue */
+    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
+
     audio_queue_cv_.wait(lock, [this]() { return audio_encode_queue_.size() < MAX_ENCODE_TASKS_IN_QUEUE; });
     audio_encode_queue_.push_back(std::move(task));
     audio_queue_cv_.notify_all();
 }
 
+/* Fold one queue-to-completion latency sample into an EWMA, in microseconds */
+void AudioService::UpdateLatencyStat(uint32_t& stat_us, const std::chrono::steady_clock::time_point& enqueue_time) {
+    auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - enqueue_time).count();
+    stat_us = (stat_us * 7 + (uint32_t)elapsed_us) / 8;
+}
+
+/* Called under audio_queue_mutex_. Track an EWMA of how far packet arrivals
+ * deviate from the nominal frame cadence and derive the number of frames to
+ * prebuffer before (re)starting decode. */
+void AudioService::UpdateJitterEstimate(int frame_duration) {
+    auto now = std::chrono::steady_clock::now();
+    if (last_decode_packet_time_.time_since_epoch().count() != 0) {
+        auto gap_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_decode_packet_time_).count();
+        uint32_t deviation = (uint32_t)std::abs((int)gap_ms - frame_duration);
+        decode_jitter_ms_ = (decode_jitter_ms_ * 7 + deviation) / 8;
+    }
+    last_decode_packet_time_ = now;
+
+    uint32_t frames = decode_jitter_ms_ / frame_duration + 1;
+    jitter_prebuffer_frames_ = std::min(frames, (uint32_t)MAX_JITTER_PREBUFFER_FRAMES);
+}
+
+/* Called under audio_queue_mutex_ */
+bool AudioService::IsDecodeQueueReady() {
+    if (audio_decode_queue_.empty()) {
+        /* Underrun: prebuffer again before the next burst */
+        decode_prebuffering_ = true;
+        return false;
+    }
+    if (decode_prebuffering_ && audio_decode_queue_.size() < jitter_prebuffer_frames_) {
+        return false;
+    }
+    decode_prebuffering_ = false;
+    return true;
+}
+
 bool AudioService::PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> packet, bool wait) {
     std::unique_lock<std::mutex> lock(audio_queue_mutex_);
+
+    /* 话轮起点优先道:入站静默超过门限后到来的第一包就是新回复的首帧。
+     * 状态切换路径有ResetDecoder兜底,但实时模式/多句回复全程停在
+     * Speaking,打断后没放完的残尾帧会让新回复排队等完整段旧音频;
+     * 这里直接清掉。思考间隙也不能喂进抖动EWMA——按|gap-帧长|折算,
+     * 一次2秒的推理间隙能把预缓冲推到上限,首帧白等几百毫秒 */
+    auto now = std::chrono::steady_clock::now();
+    if (last_decode_packet_time_.time_since_epoch().count() != 0 &&
+        now - last_decode_packet_time_ > std::chrono::milliseconds(UTTERANCE_START_GAP_MS)) {
+        if (!audio_decode_queue_.empty()) {
+            ESP_LOGI(TAG, "Utterance start after gap, dropping %u stale frames",
+                     (unsigned)audio_decode_queue_.size());
+            for (auto& stale : audio_decode_queue_) {
+                packet_pool_.Release(std::move(stale));
+            }
+            audio_decode_queue_.clear();
+        }
+        decode_prebuffering_ = true;
+        last_decode_sequence_ = 0;  // 丢掉的残尾不算丢包,别为它们做隐藏帧
+        last_decode_packet_time_ = now;
+    } else {
+        UpdateJitterEstimate(packet->frame_duration > 0 ? packet->frame_duration : OPUS_FRAME_DURATION_MS);
+    }
     if (audio_decode_queue_.size() >= MAX_DECODE_PACKETS_IN_QUEUE) {
         if (wait) {
             audio_queue_cv_.wait(lock, [this]() { return audio_decode_queue_.size() < MAX_DECODE_PACKETS_IN_QUEUE; });
@@ -423,14 +992,96 @@ bool AudioService::PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> pa
     return true;
 }
 
+/* Backpressure policy for the uplink: the encoder never blocks on a stalled
+ * network. When the queue is full the oldest listening frame is dropped, and
+ * crossing the watermarks notifies the application so it can surface network
+ * distress instead of freezing capture. Wake word packets are unaffected:
+ * they travel through their own holdover buffer, not this queue. */
+void AudioService::PushPacketToSendQueue(std::unique_ptr<AudioStreamPacket> packet) {
+    bool congestion_changed = false;
+    {
+        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+        if (audio_send_queue_.size() >= MAX_SEND_PACKETS_IN_QUEUE) {
+            packet_pool_.Release(std::move(audio_send_queue_.front()));
+            audio_send_queue_.pop_front();
+            if (++debug_statistics_.send_drop_count % 16 == 1) {
+                LOGR_W(TAG, "Send queue full, dropped oldest frame (x%lu)",
+                    (uint32_t)debug_statistics_.send_drop_count);
+            }
+        }
+        audio_send_queue_.push_back(std::move(packet));
+        if (!send_queue_congested_ && audio_send_queue_.size() >= SEND_QUEUE_HIGH_WATERMARK) {
+            send_queue_congested_ = true;
+            congestion_changed = true;
+        }
+    }
+    if (congestion_changed && callbacks_.on_send_queue_watermark) {
+        callbacks_.on_send_queue_watermark(true);
+    }
+    if (callbacks_.on_send_queue_available) {
+        callbacks_.on_send_queue_available();
+    }
+}
+
+/* Closed-loop uplink bitrate control, run on the encode task after each frame
+ * enters the send queue. The watermark flag already integrates queue depth and
+ * drain pacing; sustained congestion steps the bitrate down one ladder rung so
+ * live audio keeps flowing at lower quality instead of dropping whole frames,
+ * and a long clear stretch steps it back up. Opus packets are self-describing,
+ * so the server needs no signaling — the current rate is surfaced in the
+ * network stats JSON for diagnostics. */
+void AudioService::UpdateUplinkBitrate() {
+    bool congested;
+    {
+        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+        congested = send_queue_congested_;
+    }
+
+    if (congested) {
+        uplink_clear_frames_ = 0;
+        if (++uplink_congested_frames_ >= UPLINK_BITRATE_STEP_DOWN_FRAMES &&
+            uplink_bitrate_level_ + 1 < kUplinkBitrateLevels) {
+            uplink_congested_frames_ = 0;
+            uplink_bitrate_level_++;
+            ApplyEncoderBitrate(opus_encoder_.get(), kUplinkBitrateLadder[uplink_bitrate_level_]);
+            LOGR_W(TAG, "Uplink congested, Opus bitrate down to %d bps",
+                kUplinkBitrateLadder[uplink_bitrate_level_]);
+        }
+    } else {
+        uplink_congested_frames_ = 0;
+        if (uplink_bitrate_level_ > 0 && ++uplink_clear_frames_ >= UPLINK_BITRATE_STEP_UP_FRAMES) {
+            uplink_clear_frames_ = 0;
+            uplink_bitrate_level_--;
+            ApplyEncoderBitrate(opus_encoder_.get(), kUplinkBitrateLadder[uplink_bitrate_level_]);
+            ESP_LOGI(TAG, "Uplink recovered, Opus bitrate restored to %d bps",
+                kUplinkBitrateLadder[uplink_bitrate_level_]);
+        }
+    }
+}
+
+int AudioService::GetUplinkBitrate() const {
+    return kUplinkBitrateLadder[uplink_bitrate_level_];
+}
+
 std::unique_ptr<AudioStreamPacket> AudioService::PopPacketFromSendQueue() {
-    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-    if (audio_send_queue_.empty()) {
-        return nullptr;
+    bool congestion_changed = false;
+    std::unique_ptr<AudioStreamPacket> packet;
+    {
+        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+        if (audio_send_queue_.empty()) {
+            return nullptr;
+        }
+        packet = std::move(audio_send_queue_.front());
+        audio_send_queue_.pop_front();
+        if (send_queue_congested_ && audio_send_queue_.size() <= SEND_QUEUE_LOW_WATERMARK) {
+            send_queue_congested_ = false;
+            congestion_changed = true;
+        }
+        audio_queue_cv_.notify_all();
+    }
+    if (congestion_changed && callbacks_.on_send_queue_watermark) {
+        callbacks_.on_send_queue_watermark(false);
     }
-    auto packet = std::move(audio_send_queue_.front());
-    audio_send_queue_.pop_front();
-    audio_queue_cv_.notify_all();
     return packet;
 }
 
@@ -459,12 +1110,22 @@ void AudioService::EnableWakeWordDetection(bool enable) {
 
     ESP_LOGD(TAG, "%s wake word detection", enable ? "Enabling" : "Disabling");
     if (enable) {
-        if (!wake_word_initialized_) {
-            if (!wake_word_->Initialize(codec_, models_list_)) {
-                ESP_LOGE(TAG, "Failed to initialize wake word");
-                return;
+        {
+            std::lock_guard<std::mutex> lock(wake_word_init_mutex_);
+            if (!wake_word_initialized_) {
+                if (!wake_word_->Initialize(codec_, models_list_)) {
+                    ESP_LOGE(TAG, "Failed to initialize wake word");
+                    return;
+                }
+                wake_word_initialized_ = true;
             }
-            wake_word_initialized_ = true;
+        }
+        /* 投机唤醒采集通路:在检测启动时就恢复,而不是等第一次读数据。
+         * 从doze恢复是亚10ms的,冷启动的codec则省掉吃字的那一下 */
+        if (!codec_->input_enabled()) {
+            esp_timer_stop(audio_power_timer_);
+            esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
+            codec_->EnableInput(true);
         }
         wake_word_->Start();
         xEventGroupSetBits(event_group_, AS_EVENT_WAKE_WORD_RUNNING);
@@ -481,14 +1142,42 @@ void AudioService::EnableVoiceProcessing(bool enable) {
             audio_processor_->Initialize(codec_, OPUS_FRAME_DURATION_MS, models_list_);
             audio_processor_initialized_ = true;
         }
+#if CONFIG_USE_LOCAL_COMMANDS
+        if (!command_recognizer_initialized_) {
+            // flash里没有mn模型时初始化失败,旁路彻底关掉
+            if (!command_recognizer_->Initialize(models_list_)) {
+                command_recognizer_.reset();
+            }
+            command_recognizer_initialized_ = true;
+        }
+#endif
 
         /* We should make sure no audio is playing */
         ResetDecoder();
+        /* 软件参考环清零重新对齐:上个会话的残留帧不能混进新会话 */
+        if (software_ref_enabled_) {
+            software_ref_ring_.Clear();
+            software_ref_pending_.clear();
+        }
+        /* 压混环同理:上一轮说话末尾没混完的音乐帧已经过时,直接丢掉 */
+        duck_ring_.Clear();
+        duck_pending_.clear();
+        duck_gain_q15_ = 0;
         audio_input_need_warmup_ = true;
         audio_processor_->Start();
+#if CONFIG_USE_LOCAL_COMMANDS
+        if (command_recognizer_) {
+            command_recognizer_->Start();
+        }
+#endif
         xEventGroupSetBits(event_group_, AS_EVENT_AUDIO_PROCESSOR_RUNNING);
     } else {
         audio_processor_->Stop();
+#if CONFIG_USE_LOCAL_COMMANDS
+        if (command_recognizer_) {
+            command_recognizer_->Stop();
+        }
+#endif
         xEventGroupClearBits(event_group_, AS_EVENT_AUDIO_PROCESSOR_RUNNING);
     }
 }
@@ -527,6 +1216,102 @@ void AudioService::PlaySound(const std::string_view& ogg) {
         codec_->EnableOutput(true);
     }
 
+    /* 命中预解码缓存:帧已是输出采样率的PCM,排进直通队列由解码任务
+     * 搬进播放队列,不过Opus解码也不过抖动缓冲,解码队列再忙也即点即响 */
+    auto cached = sound_pcm_cache_.find(ogg.data());
+    if (cached != sound_pcm_cache_.end()) {
+        std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+        for (const auto& frame : cached->second) {
+            pcm_sound_queue_.push_back(frame);  // 拷贝,缓存可重复播放
+        }
+        audio_queue_cv_.notify_all();
+        return;
+    }
+
+    /* 长音频(助眠声等几MB的资产)不整段展开成包列表:交给流式任务
+     * 逐帧从mmap窗口解析喂队列,解码队列的背压天然限速,内存占用恒定 */
+    if (ogg.size() > SOUND_STREAM_THRESHOLD_BYTES) {
+        uint32_t generation = ++sound_stream_generation_;
+        struct StreamArgs {
+            AudioService* service;
+            std::string_view ogg;
+            uint32_t generation;
+        };
+        auto args = new StreamArgs{this, ogg, generation};
+        xTaskCreate([](void* arg) {
+            auto args = static_cast<StreamArgs*>(arg);
+            args->service->StreamSoundTask(args->ogg, args->generation);
+            delete args;
+            vTaskDelete(NULL);
+        }, "sound_stream", 2048 * 2, args, 3, nullptr);
+        return;
+    }
+
+    ForEachOggOpusPacket(ogg, [this](std::unique_ptr<AudioStreamPacket> packet) {
+        return PushPacketToDecodeQueue(std::move(packet), true);
+    });
+}
+
+void AudioService::StreamSoundTask(std::string_view ogg, uint32_t generation) {
+    ForEachOggOpusPacket(ogg, [this, generation](std::unique_ptr<AudioStreamPacket> packet) {
+        // 服务停止/解码器重置/新的长音频开播都会换代,旧流立刻退出
+        if (service_stopped_ || generation != sound_stream_generation_.load()) {
+            return false;
+        }
+        return PushPacketToDecodeQueue(std::move(packet), true);
+    });
+}
+
+void AudioService::PrecacheSound(const std::string_view& ogg) {
+    if (sound_pcm_cache_.find(ogg.data()) != sound_pcm_cache_.end()) {
+        return;
+    }
+    auto packets = ParseOggOpus(ogg);
+    if (packets.empty()) {
+        return;
+    }
+
+    // 一次性的解码器/重采样器,不碰解码任务拥有的opus_decoder_
+    int sample_rate = packets.front()->sample_rate;
+    int frame_duration = packets.front()->frame_duration;
+    OpusDecoderWrapper decoder(sample_rate, 1, frame_duration);
+    OpusResampler resampler;
+    int output_rate = codec_->output_sample_rate();
+    if (sample_rate != output_rate) {
+        resampler.Configure(sample_rate, output_rate);
+    }
+
+    std::vector<std::vector<int16_t>> frames;
+    size_t total_samples = 0;
+    for (auto& packet : packets) {
+        std::vector<int16_t> pcm;
+        if (!decoder.Decode(std::move(packet->payload), pcm)) {
+            continue;
+        }
+        if (sample_rate != output_rate) {
+            std::vector<int16_t> resampled(resampler.GetOutputSamples(pcm.size()));
+            resampler.Process(pcm.data(), pcm.size(), resampled.data());
+            pcm = std::move(resampled);
+        }
+        total_samples += pcm.size();
+        frames.push_back(std::move(pcm));
+    }
+    ESP_LOGI(TAG, "Precached sound: %u frames, %u bytes PCM",
+        (unsigned int)frames.size(), (unsigned int)(total_samples * sizeof(int16_t)));
+    sound_pcm_cache_[ogg.data()] = std::move(frames);
+}
+
+std::vector<std::unique_ptr<AudioStreamPacket>> AudioService::ParseOggOpus(const std::string_view& ogg) {
+    std::vector<std::unique_ptr<AudioStreamPacket>> packets;
+    ForEachOggOpusPacket(ogg, [&packets](std::unique_ptr<AudioStreamPacket> packet) {
+        packets.push_back(std::move(packet));
+        return true;
+    });
+    return packets;
+}
+
+bool AudioService::ForEachOggOpusPacket(const std::string_view& ogg,
+                                        FixedCallback<bool(std::unique_ptr<AudioStreamPacket>)> sink) {
     const uint8_t* buf = reinterpret_cast<const uint8_t*>(ogg.data());
     size_t size = ogg.size();
     size_t offset = 0;
@@ -612,39 +1397,112 @@ void AudioService::PlaySound(const std::string_view& ogg) {
             packet->frame_duration = 60;
             packet->payload.resize(pkt_len);
             std::memcpy(packet->payload.data(), pkt_ptr, pkt_len);
-            PushPacketToDecodeQueue(std::move(packet), true);
+            if (!sink(std::move(packet))) {
+                return false;
+            }
         }
 
         offset = body_off + body_size;
     }
+    return true;
 }
 
 bool AudioService::IsIdle() {
     std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-    return audio_encode_queue_.empty() && audio_decode_queue_.empty() && audio_playback_queue_.empty() && audio_testing_queue_.empty();
+    return audio_encode_queue_.empty() && audio_decode_queue_.empty() && audio_playback_queue_.Empty() &&
+        audio_testing_queue_.empty() && pcm_sound_queue_.empty();
+}
+
+/* Cover a sequence gap with faded repeats of the last played frame so a lost
+ * packet degrades into a soft decay instead of a click. Each synthesized frame
+ * fades linearly towards silence, so consecutive losses decay naturally.
+ * Called from the decode task only. */
+void AudioService::ConcealLostFrames(uint32_t lost_frames) {
+    if (last_decoded_pcm_.empty()) {
+        return;
+    }
+    if (lost_frames > MAX_CONCEALED_FRAMES_PER_GAP) {
+        lost_frames = MAX_CONCEALED_FRAMES_PER_GAP;
+    }
+    for (uint32_t i = 0; i < lost_frames && audio_playback_queue_.Size() < MAX_PLAYBACK_TASKS_IN_QUEUE; i++) {
+        auto task = task_pool_.Acquire();
+        task->type = kAudioTaskTypeDecodeToPlaybackQueue;
+        task->timestamp = 0;
+        task->enqueue_time = std::chrono::steady_clock::now();
+        size_t samples = last_decoded_pcm_.size();
+        task->pcm.resize(samples);
+        for (size_t j = 0; j < samples; j++) {
+            task->pcm[j] = (int16_t)((int32_t)last_decoded_pcm_[j] * (int32_t)(samples - j) / (int32_t)samples);
+        }
+        last_decoded_pcm_.assign(task->pcm.begin(), task->pcm.end());
+        audio_playback_queue_.Push(std::move(task));
+        xEventGroupSetBits(event_group_, AS_EVENT_PLAYBACK_NOT_EMPTY);
+        debug_statistics_.concealed_frame_count++;
+    }
 }
 
 void AudioService::ResetDecoder() {
+    sound_stream_generation_++;  // 让在播的长音频流任务收尾
     std::lock_guard<std::mutex> lock(audio_queue_mutex_);
     opus_decoder_->ResetState();
-    timestamp_queue_.clear();
+    decode_prebuffering_ = true;
+    last_decode_packet_time_ = {};
+    last_decode_sequence_ = 0;
+    last_decoded_pcm_.clear();
+    timestamp_ring_.Clear();
     audio_decode_queue_.clear();
-    audio_playback_queue_.clear();
+    audio_playback_queue_.Clear();
     audio_testing_queue_.clear();
+    pcm_sound_queue_.clear();
     audio_queue_cv_.notify_all();
 }
 
 void AudioService::CheckAndUpdateAudioPowerState() {
+    ESP_LOGD(TAG, "latency: encode %lu us, playback %lu us (in=%lu enc=%lu dec=%lu play=%lu)",
+        (unsigned long)debug_statistics_.encode_latency_us, (unsigned long)debug_statistics_.playback_latency_us,
+        (unsigned long)debug_statistics_.input_count, (unsigned long)debug_statistics_.encode_count,
+        (unsigned long)debug_statistics_.decode_count, (unsigned long)debug_statistics_.playback_count);
+    /* Scale encoder complexity with the measured headroom: one step per check
+     * so bursts of load only cost a second of lower quality, not an overrun */
+    if (IsAudioProcessorRunning()) {
+        uint32_t latency = debug_statistics_.encode_latency_us;
+        if (latency > OPUS_COMPLEXITY_LOWER_THRESHOLD_US && opus_complexity_ > 0) {
+            opus_encoder_->SetComplexity(--opus_complexity_);
+            ESP_LOGI(TAG, "Encode latency %lu us, lowering opus complexity to %d", (unsigned long)latency, opus_complexity_);
+        } else if (latency > 0 && latency < OPUS_COMPLEXITY_RAISE_THRESHOLD_US && opus_complexity_ < OPUS_MAX_AUTO_COMPLEXITY) {
+            opus_encoder_->SetComplexity(++opus_complexity_);
+            ESP_LOGD(TAG, "Encode latency %lu us, raising opus complexity to %d", (unsigned long)latency, opus_complexity_);
+        }
+    }
+
+    // 把I2S DMA层的欠载/过载计数镜像进调试统计(ISR侧只自增原子量)
+    auto rx_overruns = codec_->rx_overrun_count();
+    if (rx_overruns != debug_statistics_.i2s_rx_overrun_count) {
+        LOGR_W(TAG, "I2S rx overrun count now %lu", (unsigned long)rx_overruns);
+        debug_statistics_.i2s_rx_overrun_count = rx_overruns;
+    }
+    debug_statistics_.i2s_tx_overrun_count = codec_->tx_overrun_count();
+
     auto now = std::chrono::steady_clock::now();
     auto input_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_input_time_).count();
     auto output_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_output_time_).count();
+    /* 分级下电:先进浅休眠(支持的codec保偏置,恢复无可闻延迟),
+     * 长时间没动静再真正深下电。对没有分级支持的codec,DozeX的
+     * 默认实现就是整段下电,行为与原先一致 */
     if (input_elapsed > AUDIO_POWER_TIMEOUT_MS && codec_->input_enabled()) {
-        codec_->EnableInput(false);
+        codec_->DozeInput();
+    } else if (input_elapsed > AUDIO_POWER_DEEP_OFF_TIMEOUT_MS && !codec_->input_enabled()) {
+        codec_->EnableInput(false);  // doze转深下电;已深下电时是空操作
     }
     if (output_elapsed > AUDIO_POWER_TIMEOUT_MS && codec_->output_enabled()) {
+        codec_->DozeOutput();
+    } else if (output_elapsed > AUDIO_POWER_DEEP_OFF_TIMEOUT_MS && !codec_->output_enabled()) {
         codec_->EnableOutput(false);
     }
-    if (!codec_->input_enabled() && !codec_->output_enabled()) {
+    // 定时器要陪到深下电完成,浅休眠期间继续跑
+    if (!codec_->input_enabled() && !codec_->output_enabled() &&
+        input_elapsed > AUDIO_POWER_DEEP_OFF_TIMEOUT_MS &&
+        output_elapsed > AUDIO_POWER_DEEP_OFF_TIMEOUT_MS) {
         esp_timer_stop(audio_power_timer_);
     }
 }
@@ -653,9 +1511,17 @@ void AudioService::SetModelsList(srmodel_list_t* models_list) {
     models_list_ = models_list;
 
 #if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
-    if (esp_srmodel_filter(models_list_, ESP_MN_PREFIX, NULL) != nullptr) {
+    bool has_mn = esp_srmodel_filter(models_list_, ESP_MN_PREFIX, NULL) != nullptr;
+    bool has_wn = esp_srmodel_filter(models_list_, ESP_WN_PREFIX, NULL) != nullptr;
+#if CONFIG_USE_COMBINED_WAKE_WORD
+    // 并行模式:wn跑在AFE里,mn挂在AFE输出钩子上,共享同一遍前端
+    if (has_wn && has_mn) {
+        wake_word_ = std::make_unique<CombinedWakeWord>();
+    } else
+#endif
+    if (has_mn) {
         wake_word_ = std::make_unique<CustomWakeWord>();
-    } else if (esp_srmodel_filter(models_list_, ESP_WN_PREFIX, NULL) != nullptr) {
+    } else if (has_wn) {
         wake_word_ = std::make_unique<AfeWakeWord>();
     } else {
         wake_word_ = nullptr;
@@ -670,10 +1536,39 @@ void AudioService::SetModelsList(srmodel_list_t* models_list) {
 
     if (wake_word_) {
         wake_word_->OnWakeWordDetected([this](const std::string& wake_word) {
+            ESP_LOGI(TAG, "Wake word detected: %s (engine=%s, confidence=%.2f)", wake_word.c_str(),
+                wake_word_->GetLastDetectedEngine(), wake_word_->GetLastDetectedConfidence());
+            /* 对话马上要回TTS:投机拉起输出通路,回复首帧不付恢复延迟 */
+            if (!codec_->output_enabled()) {
+                esp_timer_stop(audio_power_timer_);
+                esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
+                codec_->EnableOutput(true);
+                last_output_time_ = std::chrono::steady_clock::now();
+            }
             if (callbacks_.on_wake_word_detected) {
                 callbacks_.on_wake_word_detected(wake_word);
             }
         });
+
+        /* Warm standby: initialize the engine (model mmap, AFE setup) in a
+         * low-priority task so the first EnableWakeWordDetection is instant */
+        xTaskCreate([](void* arg) {
+            ((AudioService*)arg)->WarmUpWakeWord();
+            vTaskDelete(NULL);
+        }, "ww_warmup", 2048 * 2, this, 1, nullptr);
+    }
+}
+
+void AudioService::WarmUpWakeWord() {
+    std::lock_guard<std::mutex> lock(wake_word_init_mutex_);
+    if (wake_word_initialized_ || codec_ == nullptr) {
+        return;
+    }
+    if (wake_word_->Initialize(codec_, models_list_)) {
+        wake_word_initialized_ = true;
+        ESP_LOGI(TAG, "Wake word engine warmed up");
+    } else {
+        ESP_LOGE(TAG, "Failed to warm up wake word engine");
     }
 }
 
@@ -687,4 +1582,15 @@ bool AudioService::IsAfeWakeWord() {
 
 void AudioService::UpdateOutputTimestamp() {
     last_output_time_ = std::chrono::steady_clock::now();
+    output_activity_us_.store(esp_timer_get_time(), std::memory_order_relaxed);
+}
+
+/* flash调度的空窗信号(见头文件):音乐直写路径经UpdateOutputTimestamp
+ * 刷新活跃时刻,TTS路径由输出任务刷新 */
+bool AudioService::IsAudioActive() {
+    if (IsAudioProcessorRunning()) {
+        return true;
+    }
+    int64_t last = output_activity_us_.load(std::memory_order_relaxed);
+    return last != 0 && esp_timer_get_time() - last < 200 * 1000;
 }
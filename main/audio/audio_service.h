@@ -3,9 +3,11 @@
 
 #include <memory>
 #include <deque>
+#include <map>
 #include <condition_variable>
 #include <chrono>
 #include <mutex>
+#include <atomic>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -18,8 +20,17 @@
 #include <opus_resampler.h>
 
 #include "audio_codec.h"
+#include "fixed_callback.h"
+#include "audio_pool.h"
+#include "spsc_ring.h"
 #include "audio_processor.h"
 #include "processors/audio_debugger.h"
+#if CONFIG_USE_OUTPUT_DSP
+#include "output_dsp.h"
+#endif
+#if CONFIG_USE_LOCAL_COMMANDS
+#include "local_command_recognizer.h"
+#endif
 #include "wake_word.h"
 #include "protocol.h"
 
@@ -35,15 +46,48 @@
  * 
  */
 
-#define OPUS_FRAME_DURATION_MS 60
+/* Selected at configure time (20/40/60ms); all queue depths, jitter thresholds
+ * and hangover times below scale with it */
+#define OPUS_FRAME_DURATION_MS CONFIG_OPUS_FRAME_DURATION_MS
 #define MAX_ENCODE_TASKS_IN_QUEUE 2
 #define MAX_PLAYBACK_TASKS_IN_QUEUE 2
 #define MAX_DECODE_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
 #define MAX_SEND_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
+/* Uplink congestion watermarks: signal distress when the send queue climbs past
+ * the high mark, signal recovery once it drains below the low mark */
+#define SEND_QUEUE_HIGH_WATERMARK (MAX_SEND_PACKETS_IN_QUEUE * 3 / 4)
+#define SEND_QUEUE_LOW_WATERMARK (MAX_SEND_PACKETS_IN_QUEUE / 4)
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
-#define MAX_TIMESTAMPS_IN_QUEUE 3
+// 超过这个体积的提示音走流式解析任务,逐帧从mmap喂解码队列,不整段展开
+#define SOUND_STREAM_THRESHOLD_BYTES (64 * 1024)
 
+#define MAX_JITTER_PREBUFFER_FRAMES (MAX_DECODE_PACKETS_IN_QUEUE / 2)
+
+/* 入站静默超过此门限后的首包按"话轮起点"处理:清掉上一轮残尾帧、
+ * 思考间隙不计入抖动EWMA,首帧只受抖动预缓冲下限门控 */
+#define UTTERANCE_START_GAP_MS 500
+
+/* Cap on how many lost frames one gap is concealed with; longer gaps are
+ * real dropouts and the jitter buffer handles them instead */
+#define MAX_CONCEALED_FRAMES_PER_GAP 2
+
+#define VAD_ENCODE_HANGOVER_FRAMES 8
+
+/* Opus complexity auto-scaling: raise quality while the encoder finishes well
+ * within the frame budget, back off as soon as it gets close to overrunning */
+#define OPUS_MAX_AUTO_COMPLEXITY 5
+#define OPUS_COMPLEXITY_RAISE_THRESHOLD_US (OPUS_FRAME_DURATION_MS * 1000 / 5)
+#define OPUS_COMPLEXITY_LOWER_THRESHOLD_US (OPUS_FRAME_DURATION_MS * 1000 * 3 / 5)
+
+/* Closed-loop uplink bitrate: step the Opus bitrate down a ladder rung after
+ * ~2s of sustained send-queue congestion, step back up after ~10s clear */
+#define UPLINK_BITRATE_STEP_DOWN_FRAMES (2000 / OPUS_FRAME_DURATION_MS)
+#define UPLINK_BITRATE_STEP_UP_FRAMES (10000 / OPUS_FRAME_DURATION_MS)
+
+/* Staged power-down: doze (bias kept, sub-10ms resume on codecs that support
+ * it) after 15s idle, real power-down a couple of minutes later */
 #define AUDIO_POWER_TIMEOUT_MS 15000
+#define AUDIO_POWER_DEEP_OFF_TIMEOUT_MS (2 * 60 * 1000)
 #define AUDIO_POWER_CHECK_INTERVAL_MS 1000
 
 
@@ -52,11 +96,17 @@
 #define AS_EVENT_AUDIO_PROCESSOR_RUNNING    (1 << 2)
 #define AS_EVENT_PLAYBACK_NOT_EMPTY         (1 << 3)
 
+// 这些回调都从音频任务按帧节奏触发,用固定容量委托避免注册时堆分配
 struct AudioServiceCallbacks {
-    std::function<void(void)> on_send_queue_available;
-    std::function<void(const std::string&)> on_wake_word_detected;
-    std::function<void(bool)> on_vad_change;
-    std::function<void(void)> on_audio_testing_queue_full;
+    FixedCallback<void(void)> on_send_queue_available;
+    // true when the send queue crosses the high watermark (uplink congested),
+    // false once it drains below the low watermark again
+    FixedCallback<void(bool)> on_send_queue_watermark;
+    FixedCallback<void(const std::string&)> on_wake_word_detected;
+    FixedCallback<void(bool)> on_vad_change;
+    FixedCallback<void(void)> on_audio_testing_queue_full;
+    // 本地命令词命中(volume_up/volume_down/stop/pause),在音频任务上触发
+    FixedCallback<void(const std::string&)> on_local_command;
 };
 
 
@@ -70,6 +120,8 @@ struct AudioTask {
     AudioTaskType type;
     std::vector<int16_t> pcm;
     uint32_t timestamp;
+    // When the task entered its queue, for latency accounting
+    std::chrono::steady_clock::time_point enqueue_time;
 };
 
 struct DebugStatistics {
@@ -77,6 +129,20 @@ struct DebugStatistics {
     uint32_t decode_count = 0;
     uint32_t encode_count = 0;
     uint32_t playback_count = 0;
+    // EWMA queue-to-completion latencies, in microseconds:
+    // capture frame queued -> opus packet ready, and opus packet queued -> PCM written to codec
+    uint32_t encode_latency_us = 0;
+    uint32_t playback_latency_us = 0;
+    // Mid-stream gaps where the playback queue ran dry while the DMA drained
+    uint32_t playback_underrun_count = 0;
+    // Listening frames dropped (oldest first) because the uplink stalled
+    uint32_t send_drop_count = 0;
+    // Frames synthesized to cover sequence gaps in the incoming stream
+    uint32_t concealed_frame_count = 0;
+    /* I2S DMA层事件计数(镜像自codec,每秒刷新):采集数据被硬件覆写 /
+     * 发送队列溢出。缩小DMA缓冲换低延迟时,这两个数就是安全性的实测依据 */
+    uint32_t i2s_rx_overrun_count = 0;
+    uint32_t i2s_tx_overrun_count = 0;
 };
 
 class AudioService {
@@ -91,6 +157,10 @@ public:
     std::unique_ptr<AudioStreamPacket> PopWakeWordPacket();
     const std::string& GetLastWakeWord() const;
     bool IsVoiceDetected() const { return voice_detected_; }
+    const DebugStatistics& GetDebugStatistics() const { return debug_statistics_; }
+    // 当前上行Opus码率(bps),拥塞自适应降档后与初始值不同
+    int GetUplinkBitrate() const;
+    uint32_t GetOutputResampleCyclesPerFrame() const { return output_resample_cycles_; }
     bool IsIdle();
     bool IsWakeWordRunning() const { return xEventGroupGetBits(event_group_) & AS_EVENT_WAKE_WORD_RUNNING; }
     bool IsAudioProcessorRunning() const { return xEventGroupGetBits(event_group_) & AS_EVENT_AUDIO_PROCESSOR_RUNNING; }
@@ -106,15 +176,31 @@ public:
     bool PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> packet, bool wait = false);
     std::unique_ptr<AudioStreamPacket> PopPacketFromSendQueue();
     void PlaySound(const std::string_view& sound);
-    bool ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples);
+    // 启动时把常用提示音预解码成输出采样率的PCM,之后PlaySound零解码直通
+    void PrecacheSound(const std::string_view& sound);
+    bool ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples, bool include_reference = true);
     void ResetDecoder();
+    void PrewarmDecoder(int sample_rate, int frame_duration);
     void SetModelsList(srmodel_list_t* models_list);
     void UpdateOutputTimestamp();
+    // 说话期间音乐帧入压混环,环满返回false(调用方小睡重试即可跟上节拍)
+    bool MixUnderPlayback(std::vector<int16_t>&& pcm);
+    /* 采样精确的播放时钟:当轮说话内容已写进DMA的微秒数。写是阻塞的,
+     * 两次写之间按墙钟外插、封顶一帧,播放停顿时时钟跟着冻结。相对
+     * 扬声器只差DMA环深度这一固定滞后,做口型同步时被校正阈值吸收 */
+    int64_t GetPlaybackPositionUs();
+    void ResetPlaybackClock();
+    // flash调度的空窗信号:采集处理在跑、或最近200ms内有播放写即为活跃
+    bool IsAudioActive();
 
 private:
     AudioCodec* codec_ = nullptr;
     AudioServiceCallbacks callbacks_;
     std::unique_ptr<AudioProcessor> audio_processor_;
+#if CONFIG_USE_LOCAL_COMMANDS
+    std::unique_ptr<LocalCommandRecognizer> command_recognizer_;
+    bool command_recognizer_initialized_ = false;
+#endif
     std::unique_ptr<WakeWord> wake_word_;
     std::unique_ptr<AudioDebugger> audio_debugger_;
     std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
@@ -122,6 +208,8 @@ private:
     OpusResampler input_resampler_;
     OpusResampler reference_resampler_;
     OpusResampler output_resampler_;
+    uint32_t output_resample_cycles_ = 0;  // 输出重采样周期数/帧(滚动平均)
+    uint32_t output_resample_frames_ = 0;
     DebugStatistics debug_statistics_;
     srmodel_list_t* models_list_ = nullptr;
 
@@ -131,21 +219,115 @@ private:
     TaskHandle_t audio_input_task_handle_ = nullptr;
     TaskHandle_t audio_output_task_handle_ = nullptr;
     TaskHandle_t opus_codec_task_handle_ = nullptr;
+#if CONFIG_USE_DUAL_CORE_OPUS_CODEC
+    TaskHandle_t opus_decode_task_handle_ = nullptr;
+#endif
     std::mutex audio_queue_mutex_;
     std::condition_variable audio_queue_cv_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_decode_queue_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_send_queue_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_testing_queue_;
     std::deque<std::unique_ptr<AudioTask>> audio_encode_queue_;
-    std::deque<std::unique_ptr<AudioTask>> audio_playback_queue_;
-    // For server AEC
-    std::deque<uint32_t> timestamp_queue_;
+    /* Decode -> playback handoff is single-producer / single-consumer, so it
+     * runs over a lock-free ring; AS_EVENT_PLAYBACK_NOT_EMPTY wakes the output task */
+    SpscRing<std::unique_ptr<AudioTask>, 4> audio_playback_queue_;
+    /* Server AEC echo alignment: playback timestamps ride their own wait-free
+     * SPSC ring (producer: output task right after the DMA write; consumer: the
+     * capture path stamping send-queue frames), so alignment no longer contends
+     * on audio_queue_mutex_ exactly when the system is loaded */
+    SpscRing<uint32_t, 4> timestamp_ring_;
+    uint32_t timestamp_overrun_count_ = 0;  // 环满:播放时钟跑到采集前面去了
+
+    // Recycle tasks and packets (and their buffer capacity) between frames,
+    // sized to cover the queues they feed
+    ObjectPool<AudioTask> task_pool_{MAX_ENCODE_TASKS_IN_QUEUE + MAX_PLAYBACK_TASKS_IN_QUEUE + 2,
+        [](AudioTask& task) { task.pcm.clear(); task.timestamp = 0; }};
+    ObjectPool<AudioStreamPacket> packet_pool_{MAX_SEND_PACKETS_IN_QUEUE,
+        [](AudioStreamPacket& packet) { packet.payload.clear(); packet.timestamp = 0; }};
+
+    // Persistent scratch buffers for the capture path, so ReadAudioData does not
+    // allocate on every frame (see the data flow comment above)
+    std::vector<int16_t> input_scratch_;
+    std::vector<int16_t> mic_scratch_;
+    std::vector<int16_t> reference_scratch_;
+    std::vector<int16_t> resample_scratch_;
+    std::vector<int16_t> silence_scratch_;
+
+    /* 软件回声参考(设备端AEC,无硬件回采通道的双工板):输出任务把刚写进
+     * DMA的播放帧推进SPSC环,采集任务取出重采样到16k后与mic帧交错成MR格式
+     * 喂给AFE。对齐不依赖时间戳:DMA写是阻塞的,参考相对扬声器只差DMA环深度
+     * 这一固定滞后,积压裁剪把它维持在AEC滤波器覆盖范围内 */
+    bool software_ref_enabled_ = false;
+    int software_ref_rate_ = 0;  // 参考重采样器当前配置的输入采样率
+    SpscRing<std::vector<int16_t>, 16> software_ref_ring_;
+    std::vector<int16_t> software_ref_pending_;  // 重采样后待交错的参考样本(仅采集任务触碰)
+    OpusResampler software_ref_resampler_;
+
+    /* 音乐压混(ducking):说话期间音乐PCM经此环低混(约-12dB)在TTS帧
+     * 下面而不是整段停掉,回到待机直接原音量续播。生产者是音乐送出
+     * 线程(经Application::AddAudioData),消费者是输出任务;增益按样本
+     * 快速爬坡,起混/停混无爆音 */
+    SpscRing<std::vector<int16_t>, 8> duck_ring_;
+    std::vector<int16_t> duck_pending_;  // 待混入的音乐样本(仅输出任务触碰)
+    int32_t duck_gain_q15_ = 0;          // 当前压混增益(Q15),向目标值爬坡
+
+    // 播放时钟(见GetPlaybackPositionUs):输出任务写、任意任务读
+    std::atomic<int64_t> playback_position_us_{0};   // 已写进DMA的内容微秒数
+    std::atomic<int64_t> playback_clock_wall_us_{0};  // 上次推进时的esp_timer时刻
+    std::atomic<int64_t> playback_last_frame_us_{0};  // 上一帧时长,外插封顶用
+    std::atomic<int64_t> output_activity_us_{0};      // 最近一次播放写的esp_timer时刻
+
+#if CONFIG_USE_OUTPUT_DSP
+    // 扬声器EQ+软限幅,只在输出任务里使用(单线程持有滤波器状态)
+    OutputDsp output_dsp_;
+#endif
+
+    // Adaptive jitter buffer: hold back decode until enough packets are queued to
+    // ride out the network jitter observed on recent arrivals (guarded by audio_queue_mutex_)
+#if CONFIG_USE_OPUS_DTX
+    // Number of consecutive silent frames reported by the VAD, used to gate the uplink
+    uint32_t silence_frames_ = 0;
+#endif
+
+    int opus_complexity_ = 0;
+
+    /* 上行码率档位(阶梯见audio_service.cc),只在编码任务上读写;
+     * 计数器统计连续拥塞/畅通的帧数,跨过阈值才换档避免振荡 */
+    int uplink_bitrate_level_ = 0;
+    uint32_t uplink_congested_frames_ = 0;
+    uint32_t uplink_clear_frames_ = 0;
+
+    // Set between the send queue watermarks, guarded by audio_queue_mutex_
+    bool send_queue_congested_ = false;
+
+    /* Loss concealment: last sequence seen by the decode task and a copy of the
+     * last played frame, used to synthesize faded fill frames over gaps
+     * (touched only by the decode task) */
+    uint32_t last_decode_sequence_ = 0;
+    std::vector<int16_t> last_decoded_pcm_;
+
+    /* 预解码的提示音PCM缓存,按资产数据指针索引,已重采样到输出采样率并
+     * 按帧切块(大块分配在开了PSRAM的板子上自动落到PSRAM)。播放时绕过
+     * Opus解码和抖动缓冲,解码队列再忙提示音也即点即响 */
+    std::map<const void*, std::vector<std::vector<int16_t>>> sound_pcm_cache_;
+    /* 待播放的缓存提示音帧,由解码任务搬进播放队列——播放队列是SPSC环,
+     * 生产者只能是解码任务(guarded by audio_queue_mutex_) */
+    std::deque<std::vector<int16_t>> pcm_sound_queue_;
+
+    bool decode_prebuffering_ = true;
+    uint32_t jitter_prebuffer_frames_ = 1;
+    uint32_t decode_jitter_ms_ = 0;
+    std::chrono::steady_clock::time_point last_decode_packet_time_;
 
     bool wake_word_initialized_ = false;
+    // Serializes warm-standby initialization against EnableWakeWordDetection
+    std::mutex wake_word_init_mutex_;
     bool audio_processor_initialized_ = false;
     bool voice_detected_ = false;
     bool service_stopped_ = true;
     bool audio_input_need_warmup_ = false;
+    // 长音频流式播放的代际号:重置/新的长音频开播自增,旧流任务据此收尾
+    std::atomic<uint32_t> sound_stream_generation_{0};
 
     esp_timer_handle_t audio_power_timer_ = nullptr;
     std::chrono::steady_clock::time_point last_input_time_;
@@ -154,9 +336,36 @@ private:
     void AudioInputTask();
     void AudioOutputTask();
     void OpusCodecTask();
+#if CONFIG_USE_DUAL_CORE_OPUS_CODEC
+    void OpusEncodeTask();
+    void OpusDecodeTask();
+#endif
     void PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm);
+    // 软件回声参考:输出任务复制播放帧进环 / 采集任务给mono mic帧拼上R通道
+    void PushSoftwareReference(const std::vector<int16_t>& pcm);
+    void AppendSoftwareReference(std::vector<int16_t>& data);
+    // 音乐压混:输出任务在写DMA前把排队的音乐样本低增益叠进TTS帧
+    void MixDuckedMusic(std::vector<int16_t>& pcm);
+    void PushPacketToSendQueue(std::unique_ptr<AudioStreamPacket> packet);
+    // 编码任务每帧调用:按送出队列的拥塞状态给码率换档
+    void UpdateUplinkBitrate();
+    void ConcealLostFrames(uint32_t lost_frames);
+    bool IsDecodeQueueReady();
+    void UpdateJitterEstimate(int frame_duration);
+    void UpdateLatencyStat(uint32_t& stat_us, const std::chrono::steady_clock::time_point& enqueue_time);
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
+    void ResampleOutput(std::vector<int16_t>& pcm);  // 输出重采样+周期数统计,两个解码路径共用
+    // 解析Ogg封装的Opus资产,整段展开成包列表(PrecacheSound和短音频用)
+    std::vector<std::unique_ptr<AudioStreamPacket>> ParseOggOpus(const std::string_view& ogg);
+    // 流式遍历Ogg页逐包回调,sink返回false即中止;数据就地从mmap窗口取用
+    bool ForEachOggOpusPacket(const std::string_view& ogg,
+                              FixedCallback<bool(std::unique_ptr<AudioStreamPacket>)> sink);
+    void StreamSoundTask(std::string_view ogg, uint32_t generation);
     void CheckAndUpdateAudioPowerState();
+    void WarmUpWakeWord();
+#if CONFIG_USE_AUDIO_LOOPBACK_BENCHMARK
+    void RunLoopbackBenchmark();
+#endif
 };
 
 #endif
\ No newline at end of file
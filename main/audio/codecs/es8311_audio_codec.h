@@ -31,7 +31,8 @@ private:
 public:
     Es8311AudioCodec(void* i2c_master_handle, i2c_port_t i2c_port, int input_sample_rate, int output_sample_rate,
         gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din,
-        gpio_num_t pa_pin, uint8_t es8311_addr, bool use_mclk = true, bool pa_inverted = false);
+        gpio_num_t pa_pin, uint8_t es8311_addr, bool use_mclk = true, bool pa_inverted = false,
+        int dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM, int dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM);
     virtual ~Es8311AudioCodec();
 
     virtual void SetOutputVolume(int volume) override;
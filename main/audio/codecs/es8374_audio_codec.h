@@ -1,41 +1,14 @@
 #ifndef _ES8374_AUDIO_CODEC_H
 #define _ES8374_AUDIO_CODEC_H
 
-#include "audio_codec.h"
+#include "es83xx_audio_codec.h"
 
-#include <driver/i2c.h>
-#include <driver/gpio.h>
-#include <esp_codec_dev.h>
-#include <esp_codec_dev_defaults.h>
-#include <mutex>
-
-
-class Es8374AudioCodec : public AudioCodec {
-private:
-    const audio_codec_data_if_t* data_if_ = nullptr;
-    const audio_codec_ctrl_if_t* ctrl_if_ = nullptr;
-    const audio_codec_if_t* codec_if_ = nullptr;
-    const audio_codec_gpio_if_t* gpio_if_ = nullptr;
-
-    esp_codec_dev_handle_t output_dev_ = nullptr;
-    esp_codec_dev_handle_t input_dev_ = nullptr;
-    gpio_num_t pa_pin_ = GPIO_NUM_NC;
-    std::mutex data_if_mutex_;
-
-    void CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din);
-
-    virtual int Read(int16_t* dest, int samples) override;
-    virtual int Write(const int16_t* data, int samples) override;
 
+class Es8374AudioCodec : public Es83xxAudioCodec {
 public:
     Es8374AudioCodec(void* i2c_master_handle, i2c_port_t i2c_port, int input_sample_rate, int output_sample_rate,
         gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din,
         gpio_num_t pa_pin, uint8_t es8374_addr, bool use_mclk = true);
-    virtual ~Es8374AudioCodec();
-
-    virtual void SetOutputVolume(int volume) override;
-    virtual void EnableInput(bool enable) override;
-    virtual void EnableOutput(bool enable) override;
 };
 
-#endif // _ES8374_AUDIO_CODEC_H
\ No newline at end of file
+#endif // _ES8374_AUDIO_CODEC_H
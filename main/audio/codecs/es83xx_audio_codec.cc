@@ -0,0 +1,242 @@
+#include "es83xx_audio_codec.h"
+
+#include <esp_log.h>
+
+#define TAG "Es83xxAudioCodec"
+
+Es83xxAudioCodec::~Es83xxAudioCodec() {
+    ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
+    esp_codec_dev_delete(output_dev_);
+    ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
+    esp_codec_dev_delete(input_dev_);
+
+    audio_codec_delete_codec_if(codec_if_);
+    audio_codec_delete_ctrl_if(ctrl_if_);
+    audio_codec_delete_gpio_if(gpio_if_);
+    audio_codec_delete_data_if(data_if_);
+}
+
+void Es83xxAudioCodec::CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din) {
+    assert(input_sample_rate_ == output_sample_rate_);
+
+    i2s_chan_config_t chan_cfg = {
+        .id = I2S_NUM_0,
+        .role = I2S_ROLE_MASTER,
+        .dma_desc_num = (uint32_t)dma_desc_num_,
+        .dma_frame_num = (uint32_t)dma_frame_num_,
+        .auto_clear_after_cb = true,
+        .auto_clear_before_cb = false,
+        .intr_priority = 0,
+    };
+    ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle_, &rx_handle_));
+
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = {
+            .sample_rate_hz = (uint32_t)output_sample_rate_,
+            .clk_src = I2S_CLK_SRC_DEFAULT,
+            .mclk_multiple = I2S_MCLK_MULTIPLE_256,
+			#ifdef   I2S_HW_VERSION_2
+				.ext_clk_freq_hz = 0,
+			#endif
+        },
+        .slot_cfg = {
+            .data_bit_width = I2S_DATA_BIT_WIDTH_16BIT,
+            .slot_bit_width = I2S_SLOT_BIT_WIDTH_AUTO,
+            .slot_mode = I2S_SLOT_MODE_STEREO,
+            .slot_mask = I2S_STD_SLOT_BOTH,
+            .ws_width = I2S_DATA_BIT_WIDTH_16BIT,
+            .ws_pol = false,
+            .bit_shift = true,
+            #ifdef   I2S_HW_VERSION_2
+                .left_align = true,
+                .big_endian = false,
+                .bit_order_lsb = false
+            #endif
+        },
+        .gpio_cfg = {
+            .mclk = mclk,
+            .bclk = bclk,
+            .ws = ws,
+            .dout = dout,
+            .din = din,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false
+            }
+        }
+    };
+
+    ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle_, &std_cfg));
+    ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle_, &std_cfg));
+    ESP_LOGI(TAG, "Duplex channels created");
+}
+
+void Es83xxAudioCodec::CreateInterfaces(void* i2c_master_handle, i2c_port_t i2c_port, uint8_t addr) {
+    // Do initialize of related interface: data_if, ctrl_if and gpio_if
+    audio_codec_i2s_cfg_t i2s_cfg = {
+        .port = I2S_NUM_0,
+        .rx_handle = rx_handle_,
+        .tx_handle = tx_handle_,
+    };
+    data_if_ = audio_codec_new_i2s_data(&i2s_cfg);
+    assert(data_if_ != NULL);
+
+    audio_codec_i2c_cfg_t i2c_cfg = {
+        .port = i2c_port,
+        .addr = addr,
+        .bus_handle = i2c_master_handle,
+    };
+    ctrl_if_ = audio_codec_new_i2c_ctrl(&i2c_cfg);
+    assert(ctrl_if_ != NULL);
+
+    gpio_if_ = audio_codec_new_gpio();
+    assert(gpio_if_ != NULL);
+}
+
+void Es83xxAudioCodec::CreateCodecDevices() {
+    esp_codec_dev_cfg_t outdev_cfg = {
+        .dev_type = ESP_CODEC_DEV_TYPE_OUT,
+        .codec_if = codec_if_,
+        .data_if = data_if_,
+    };
+    output_dev_ = esp_codec_dev_new(&outdev_cfg);
+    assert(output_dev_ != NULL);
+
+    esp_codec_dev_cfg_t indev_cfg = {
+        .dev_type = ESP_CODEC_DEV_TYPE_IN,
+        .codec_if = codec_if_,
+        .data_if = data_if_,
+    };
+    input_dev_ = esp_codec_dev_new(&indev_cfg);
+    assert(input_dev_ != NULL);
+    esp_codec_set_disable_when_closed(output_dev_, false);
+    esp_codec_set_disable_when_closed(input_dev_, false);
+}
+
+void Es83xxAudioCodec::SetOutputVolume(int volume) {
+    // 影子值没变就直接返回,音量渐变时省掉成串的重复I2C往返
+    if (volume == output_volume_) {
+        return;
+    }
+    ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, volume));
+    AudioCodec::SetOutputVolume(volume);
+}
+
+void Es83xxAudioCodec::OnInputOpened() {
+    ESP_ERROR_CHECK(esp_codec_dev_set_in_gain(input_dev_, AUDIO_CODEC_DEFAULT_MIC_GAIN));
+}
+
+void Es83xxAudioCodec::EnableInput(bool enable) {
+    std::lock_guard<std::mutex> lock(data_if_mutex_);
+    if (enable == input_enabled_ && !input_dozing_) {
+        return;
+    }
+    if (enable && input_dozing_) {
+        // 从浅休眠恢复:设备一直开着,只需把标志翻回来
+        input_dozing_ = false;
+        AudioCodec::EnableInput(true);
+        return;
+    }
+    if (!enable && input_dozing_) {
+        // 浅休眠超时转深下电:补上真正的close
+        input_dozing_ = false;
+        ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
+        return;
+    }
+    if (enable) {
+        esp_codec_dev_sample_info_t fs = {
+            .bits_per_sample = 16,
+            .channel = 1,
+            .channel_mask = 0,
+            .sample_rate = (uint32_t)input_sample_rate_,
+            .mclk_multiple = 0,
+        };
+        ConfigureInputFormat(fs);
+        ESP_ERROR_CHECK(esp_codec_dev_open(input_dev_, &fs));
+        OnInputOpened();
+    } else {
+        ESP_ERROR_CHECK(esp_codec_dev_close(input_dev_));
+    }
+    AudioCodec::EnableInput(enable);
+}
+
+void Es83xxAudioCodec::EnableOutput(bool enable) {
+    std::lock_guard<std::mutex> lock(data_if_mutex_);
+    if (enable == output_enabled_ && !output_dozing_) {
+        return;
+    }
+    if (enable && output_dozing_) {
+        // 从浅休眠恢复:设备一直开着,拉起PA即可出声
+        output_dozing_ = false;
+        if (pa_pin_ != GPIO_NUM_NC) {
+            gpio_set_level(pa_pin_, 1);
+        }
+        AudioCodec::EnableOutput(true);
+        return;
+    }
+    if (!enable && output_dozing_) {
+        // 浅休眠超时转深下电:补上真正的close(PA在进doze时已经关了)
+        output_dozing_ = false;
+        ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
+        return;
+    }
+    if (enable) {
+        // Play 16bit 1 channel
+        esp_codec_dev_sample_info_t fs = {
+            .bits_per_sample = 16,
+            .channel = 1,
+            .channel_mask = 0,
+            .sample_rate = (uint32_t)output_sample_rate_,
+            .mclk_multiple = 0,
+        };
+        ESP_ERROR_CHECK(esp_codec_dev_open(output_dev_, &fs));
+        ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(output_dev_, output_volume_));
+        OnOutputOpened();
+        if (pa_pin_ != GPIO_NUM_NC) {
+            gpio_set_level(pa_pin_, 1);
+        }
+    } else {
+        ESP_ERROR_CHECK(esp_codec_dev_close(output_dev_));
+        if (pa_pin_ != GPIO_NUM_NC) {
+            gpio_set_level(pa_pin_, 0);
+        }
+    }
+    AudioCodec::EnableOutput(enable);
+}
+
+void Es83xxAudioCodec::DozeInput() {
+    std::lock_guard<std::mutex> lock(data_if_mutex_);
+    if (!input_enabled_ || input_dozing_) {
+        return;
+    }
+    input_dozing_ = true;
+    AudioCodec::EnableInput(false);
+}
+
+void Es83xxAudioCodec::DozeOutput() {
+    std::lock_guard<std::mutex> lock(data_if_mutex_);
+    if (!output_enabled_ || output_dozing_) {
+        return;
+    }
+    output_dozing_ = true;
+    // PA先关掉:doze期间不耗功放静态电流,也不会把底噪放出来
+    if (pa_pin_ != GPIO_NUM_NC) {
+        gpio_set_level(pa_pin_, 0);
+    }
+    AudioCodec::EnableOutput(false);
+}
+
+int Es83xxAudioCodec::Read(int16_t* dest, int samples) {
+    if (input_enabled_) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_read(input_dev_, (void*)dest, samples * sizeof(int16_t)));
+    }
+    return samples;
+}
+
+int Es83xxAudioCodec::Write(const int16_t* data, int samples) {
+    if (output_enabled_ && output_dev_ && data != nullptr) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(esp_codec_dev_write(output_dev_, (void*)data, samples * sizeof(int16_t)));
+    }
+    return samples;
+}
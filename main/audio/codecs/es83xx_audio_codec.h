@@ -0,0 +1,62 @@
+#ifndef _ES83XX_AUDIO_CODEC_H
+#define _ES83XX_AUDIO_CODEC_H
+
+#include "audio_codec.h"
+
+#include <driver/i2c_master.h>
+#include <driver/gpio.h>
+#include <esp_codec_dev.h>
+#include <esp_codec_dev_defaults.h>
+#include <mutex>
+
+
+// ES83xx系列的公共驱动核:I2S双工通道、esp_codec_dev输入/输出设备的创建
+// 与开关、音量影子缓存(值没变就不碰I2C)都收敛在这里;芯片差异(话筒
+// 增益、输入格式、输出通路寄存器修正)通过钩子下沉到各子类,取代原来
+// 8374/8388/8389三份几乎相同的驱动代码
+class Es83xxAudioCodec : public AudioCodec {
+protected:
+    const audio_codec_data_if_t* data_if_ = nullptr;
+    const audio_codec_ctrl_if_t* ctrl_if_ = nullptr;
+    const audio_codec_if_t* codec_if_ = nullptr;
+    const audio_codec_gpio_if_t* gpio_if_ = nullptr;
+
+    esp_codec_dev_handle_t output_dev_ = nullptr;
+    esp_codec_dev_handle_t input_dev_ = nullptr;
+    gpio_num_t pa_pin_ = GPIO_NUM_NC;
+    std::mutex data_if_mutex_;
+
+    void CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din);
+    // 创建data_if_/ctrl_if_/gpio_if_三件套,子类在构造codec_if_之前调用
+    void CreateInterfaces(void* i2c_master_handle, i2c_port_t i2c_port, uint8_t addr);
+    // codec_if_就绪后创建输入/输出两个esp_codec_dev设备
+    void CreateCodecDevices();
+
+    // ---- 芯片差异钩子 ----
+    // 调整输入采样格式(默认16bit单声道),带参考通道的芯片在这里改
+    virtual void ConfigureInputFormat(esp_codec_dev_sample_info_t& fs) {}
+    // 输入通路打开后执行,默认设置公共默认话筒增益
+    virtual void OnInputOpened();
+    // 输出通路打开后执行,芯片专有的寄存器修正放这里
+    virtual void OnOutputOpened() {}
+
+    virtual int Read(int16_t* dest, int samples) override;
+    virtual int Write(const int16_t* data, int samples) override;
+
+public:
+    virtual ~Es83xxAudioCodec();
+
+    virtual void SetOutputVolume(int volume) override;
+    virtual void EnableInput(bool enable) override;
+    virtual void EnableOutput(bool enable) override;
+    virtual void DozeInput() override;
+    virtual void DozeOutput() override;
+
+private:
+    /* 浅休眠中:esp_codec_dev保持打开(偏置在),只是数据路径视为关闭。
+     * 从doze恢复跳过整套open流程;深下电时补上真正的close */
+    bool input_dozing_ = false;
+    bool output_dozing_ = false;
+};
+
+#endif // _ES83XX_AUDIO_CODEC_H
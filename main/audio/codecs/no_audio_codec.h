@@ -10,6 +10,10 @@
 class NoAudioCodec : public AudioCodec {
 protected:
     std::mutex data_if_mutex_;
+    // Write的常驻转换缓冲与音量因子缓存:播放热路径上不再每帧堆分配/算pow
+    std::vector<int32_t> write_buffer_;
+    int cached_volume_ = -1;
+    int32_t volume_factor_q16_ = 0;
 
     virtual int Write(const int16_t* data, int samples) override;
     virtual int Read(int16_t* dest, int samples) override;
@@ -20,19 +24,24 @@ public:
 
 class NoAudioCodecDuplex : public NoAudioCodec {
 public:
-    NoAudioCodecDuplex(int input_sample_rate, int output_sample_rate, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din);
+    NoAudioCodecDuplex(int input_sample_rate, int output_sample_rate, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din,
+        int dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM, int dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM);
 };
 
 class NoAudioCodecSimplex : public NoAudioCodec {
 public:
-    NoAudioCodecSimplex(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, gpio_num_t mic_sck, gpio_num_t mic_ws, gpio_num_t mic_din);
-    NoAudioCodecSimplex(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, i2s_std_slot_mask_t spk_slot_mask, gpio_num_t mic_sck, gpio_num_t mic_ws, gpio_num_t mic_din, i2s_std_slot_mask_t mic_slot_mask);
+    NoAudioCodecSimplex(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, gpio_num_t mic_sck, gpio_num_t mic_ws, gpio_num_t mic_din,
+        int dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM, int dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM);
+    NoAudioCodecSimplex(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, i2s_std_slot_mask_t spk_slot_mask, gpio_num_t mic_sck, gpio_num_t mic_ws, gpio_num_t mic_din, i2s_std_slot_mask_t mic_slot_mask,
+        int dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM, int dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM);
 };
 
 class NoAudioCodecSimplexPdm : public NoAudioCodec {
 public:
-    NoAudioCodecSimplexPdm(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, gpio_num_t mic_sck,  gpio_num_t mic_din);
-    NoAudioCodecSimplexPdm(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, i2s_std_slot_mask_t spk_slot_mask, gpio_num_t mic_sck,  gpio_num_t mic_din);
+    NoAudioCodecSimplexPdm(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, gpio_num_t mic_sck,  gpio_num_t mic_din,
+        int dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM, int dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM);
+    NoAudioCodecSimplexPdm(int input_sample_rate, int output_sample_rate, gpio_num_t spk_bclk, gpio_num_t spk_ws, gpio_num_t spk_dout, i2s_std_slot_mask_t spk_slot_mask, gpio_num_t mic_sck,  gpio_num_t mic_din,
+        int dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM, int dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM);
     int Read(int16_t* dest, int samples);
 };
 
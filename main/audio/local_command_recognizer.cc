@@ -0,0 +1,104 @@
+#include "local_command_recognizer.h"
+
+#include <esp_log.h>
+#include <esp_mn_speech_commands.h>
+
+#include <cstring>
+
+#define TAG "LocalCommand"
+
+// 高频指令集,刻意保持很小:命令词越多误触发越多,识别也越慢。
+// 新增指令时记得在Application的分发表里补上对应动作
+const LocalCommandRecognizer::Command LocalCommandRecognizer::kCommands[] = {
+    {1, "da sheng yi dian", "volume_up"},
+    {2, "xiao sheng yi dian", "volume_down"},
+    {3, "ting zhi", "stop"},
+    {4, "zan ting", "pause"},
+};
+
+LocalCommandRecognizer::~LocalCommandRecognizer() {
+    if (multinet_model_data_ != nullptr && multinet_ != nullptr) {
+        multinet_->destroy(multinet_model_data_);
+    }
+}
+
+bool LocalCommandRecognizer::Initialize(srmodel_list_t* models_list) {
+    if (models_list == nullptr) {
+        return false;
+    }
+
+    auto mn_name = esp_srmodel_filter(models_list, ESP_MN_PREFIX, "cn");
+    if (mn_name == nullptr) {
+        ESP_LOGW(TAG, "No multinet model in flash, local commands disabled");
+        return false;
+    }
+
+    multinet_ = esp_mn_handle_from_name(mn_name);
+    // 指令都是两三秒内说完的短语,检测窗口不用开太长
+    multinet_model_data_ = multinet_->create(mn_name, 3000);
+    esp_mn_commands_clear();
+    for (const auto& command : kCommands) {
+        esp_mn_commands_add(command.id, command.pinyin);
+    }
+    esp_mn_commands_update();
+    multinet_->print_active_speech_commands(multinet_model_data_);
+
+    chunk_samples_ = multinet_->get_samp_chunksize(multinet_model_data_);
+    feed_buffer_.reserve(chunk_samples_ * 2);
+    ESP_LOGI(TAG, "Local command recognizer ready: %s, chunk %u samples",
+        mn_name, (unsigned int)chunk_samples_);
+    return true;
+}
+
+void LocalCommandRecognizer::Feed(const std::vector<int16_t>& data) {
+    if (multinet_model_data_ == nullptr || !running_) {
+        return;
+    }
+
+    /* AudioProcessor按Opus帧长出帧,MultiNet按自己的块大小吃数据,
+     * 中间攒一个小缓冲对齐 */
+    feed_buffer_.insert(feed_buffer_.end(), data.begin(), data.end());
+    size_t offset = 0;
+    while (feed_buffer_.size() - offset >= chunk_samples_) {
+        auto mn_state = multinet_->detect(multinet_model_data_, feed_buffer_.data() + offset);
+        offset += chunk_samples_;
+
+        if (mn_state == ESP_MN_STATE_DETECTED) {
+            esp_mn_results_t* mn_result = multinet_->get_results(multinet_model_data_);
+            for (int i = 0; i < mn_result->num; i++) {
+                int command_id = mn_result->command_id[i];
+                for (const auto& command : kCommands) {
+                    if (command.id == command_id) {
+                        ESP_LOGI(TAG, "Local command detected: %s (prob %.2f)",
+                            command.name, mn_result->prob[i]);
+                        if (command_detected_callback_) {
+                            command_detected_callback_(command.name, mn_result->prob[i]);
+                        }
+                        break;
+                    }
+                }
+                break;  // 只取置信度最高的一条
+            }
+            multinet_->clean(multinet_model_data_);
+        } else if (mn_state == ESP_MN_STATE_TIMEOUT) {
+            multinet_->clean(multinet_model_data_);
+        }
+    }
+    feed_buffer_.erase(feed_buffer_.begin(), feed_buffer_.begin() + offset);
+}
+
+void LocalCommandRecognizer::Start() {
+    running_ = true;
+}
+
+void LocalCommandRecognizer::Stop() {
+    running_ = false;
+    feed_buffer_.clear();
+    if (multinet_model_data_ != nullptr && multinet_ != nullptr) {
+        multinet_->clean(multinet_model_data_);
+    }
+}
+
+void LocalCommandRecognizer::OnCommandDetected(std::function<void(const std::string& command, float prob)> callback) {
+    command_detected_callback_ = callback;
+}
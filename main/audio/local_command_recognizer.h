@@ -0,0 +1,44 @@
+#ifndef LOCAL_COMMAND_RECOGNIZER_H
+#define LOCAL_COMMAND_RECOGNIZER_H
+
+#include <esp_mn_iface.h>
+#include <esp_mn_models.h>
+#include <model_path.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+
+// 本地高频指令识别:用esp-sr的MultiNet在设备端识别一小组命令词
+// (音量大小、停止、暂停),命中后直呼MCP工具回调,省掉服务器往返的
+// 1-2秒;没命中的语音照常上行,由服务器兜底。
+// 只在聆听状态运行,输入复用AudioProcessor的降噪输出,不额外跑一遍前端
+class LocalCommandRecognizer {
+public:
+    ~LocalCommandRecognizer();
+
+    bool Initialize(srmodel_list_t* models_list);
+    // data为16kHz单声道(AudioProcessor的输出帧),内部按MultiNet块大小缓冲
+    void Feed(const std::vector<int16_t>& data);
+    void Start();
+    void Stop();
+    // command为指令名(volume_up/volume_down/stop/pause),prob为置信度
+    void OnCommandDetected(std::function<void(const std::string& command, float prob)> callback);
+
+private:
+    struct Command {
+        int id;
+        const char* pinyin;  // MultiNet中文模型用拼音注音
+        const char* name;
+    };
+    static const Command kCommands[];
+
+    esp_mn_iface_t* multinet_ = nullptr;
+    model_iface_data_t* multinet_model_data_ = nullptr;
+    size_t chunk_samples_ = 0;
+    bool running_ = false;
+    std::vector<int16_t> feed_buffer_;
+    std::function<void(const std::string& command, float prob)> command_detected_callback_;
+};
+
+#endif // LOCAL_COMMAND_RECOGNIZER_H
@@ -0,0 +1,112 @@
+#include "output_dsp.h"
+
+#include <math.h>
+#include <esp_log.h>
+
+#define TAG "OutputDsp"
+
+/* 小喇叭补偿曲线:高通去掉无效低频,3kHz附近抬一点人声存在感。
+ * 参数按Echo Base类4Ω 3W小腔体调的,改曲线只动这里 */
+#define DSP_HIGHPASS_FREQ       150.0f
+#define DSP_HIGHPASS_Q          0.707f
+#define DSP_PRESENCE_FREQ       3000.0f
+#define DSP_PRESENCE_Q          1.0f
+#define DSP_PRESENCE_GAIN_DB    4.0f
+
+/* 限幅门限约-1.5dBFS;每16样本更新一次增益,除法不进每样本热路径 */
+#define DSP_LIMIT_THRESHOLD     27500
+#define DSP_LIMIT_BLOCK         16
+/* 包络释放系数,Q15,约每块衰减0.4% */
+#define DSP_LIMIT_RELEASE       32636
+
+#define Q28_ONE (1 << 28)
+
+void OutputDsp::Configure(int sample_rate) {
+    if (sample_rate == sample_rate_) {
+        return;
+    }
+    sample_rate_ = sample_rate;
+    stages_.clear();
+    limiter_envelope_ = 0;
+
+    AddHighPass(DSP_HIGHPASS_FREQ, DSP_HIGHPASS_Q);
+    AddPeaking(DSP_PRESENCE_FREQ, DSP_PRESENCE_Q, DSP_PRESENCE_GAIN_DB);
+    ESP_LOGI(TAG, "Configured %u biquad stages at %d Hz", (unsigned int)stages_.size(), sample_rate);
+}
+
+void OutputDsp::AddHighPass(float freq, float q) {
+    float w0 = 2.0f * M_PI * freq / sample_rate_;
+    float alpha = sinf(w0) / (2.0f * q);
+    float cosw0 = cosf(w0);
+    float a0 = 1.0f + alpha;
+
+    Biquad bq;
+    bq.b0 = (int32_t)(((1.0f + cosw0) / 2.0f) / a0 * Q28_ONE);
+    bq.b1 = (int32_t)((-(1.0f + cosw0)) / a0 * Q28_ONE);
+    bq.b2 = bq.b0;
+    bq.a1 = (int32_t)((-2.0f * cosw0) / a0 * Q28_ONE);
+    bq.a2 = (int32_t)((1.0f - alpha) / a0 * Q28_ONE);
+    stages_.push_back(bq);
+}
+
+void OutputDsp::AddPeaking(float freq, float q, float gain_db) {
+    float A = powf(10.0f, gain_db / 40.0f);
+    float w0 = 2.0f * M_PI * freq / sample_rate_;
+    float alpha = sinf(w0) / (2.0f * q);
+    float cosw0 = cosf(w0);
+    float a0 = 1.0f + alpha / A;
+
+    Biquad bq;
+    bq.b0 = (int32_t)((1.0f + alpha * A) / a0 * Q28_ONE);
+    bq.b1 = (int32_t)((-2.0f * cosw0) / a0 * Q28_ONE);
+    bq.b2 = (int32_t)((1.0f - alpha * A) / a0 * Q28_ONE);
+    bq.a1 = bq.b1; /* 峰值滤波器的a1与b1同式 */
+    bq.a2 = (int32_t)((1.0f - alpha / A) / a0 * Q28_ONE);
+    stages_.push_back(bq);
+}
+
+void OutputDsp::Process(std::vector<int16_t>& pcm) {
+    if (stages_.empty()) {
+        return;
+    }
+
+    size_t count = pcm.size();
+    for (size_t offset = 0; offset < count; offset += DSP_LIMIT_BLOCK) {
+        size_t block_end = offset + DSP_LIMIT_BLOCK;
+        if (block_end > count) {
+            block_end = count;
+        }
+
+        /* EQ级联:每级5次Q28乘加,64位累加避免中间溢出 */
+        int32_t block_peak = 0;
+        for (size_t i = offset; i < block_end; i++) {
+            int32_t x = pcm[i];
+            for (auto& bq : stages_) {
+                int64_t acc = (int64_t)bq.b0 * x + bq.z1;
+                int32_t y = (int32_t)(acc >> 28);
+                bq.z1 = (int64_t)bq.b1 * x - (int64_t)bq.a1 * y + bq.z2;
+                bq.z2 = (int64_t)bq.b2 * x - (int64_t)bq.a2 * y;
+                x = y;
+            }
+            int32_t mag = x < 0 ? -x : x;
+            if (mag > block_peak) {
+                block_peak = mag;
+            }
+            /* 先存回,限幅增益随后整块应用 */
+            pcm[i] = (int16_t)(x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+        }
+
+        /* 软限幅:包络取块峰值与衰减包络的较大者,超门限时整块乘以
+         * threshold/envelope,增益随包络释放平滑恢复,无增益突变 */
+        limiter_envelope_ = (int32_t)(((int64_t)limiter_envelope_ * DSP_LIMIT_RELEASE) >> 15);
+        if (block_peak > limiter_envelope_) {
+            limiter_envelope_ = block_peak;
+        }
+        if (limiter_envelope_ > DSP_LIMIT_THRESHOLD) {
+            int32_t gain_q15 = (int32_t)(((int64_t)DSP_LIMIT_THRESHOLD << 15) / limiter_envelope_);
+            for (size_t i = offset; i < block_end; i++) {
+                pcm[i] = (int16_t)(((int32_t)pcm[i] * gain_q15) >> 15);
+            }
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef OUTPUT_DSP_H
+#define OUTPUT_DSP_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+ * 扬声器EQ与响度处理:插在AudioOutputTask写DMA之前的定点处理级。
+ *
+ * 小腔体喇叭(AtomS3 Echo Base、DuChatX这类)低频出不来,用户习惯把音量
+ * 拉满,数字域直接削顶,AEC参考信号也跟着失真。这里做两件事:
+ *  1. 双二阶滤波级联——高通滤掉喇叭根本发不出的低频(省冲程),
+ *     中高频加一点存在感提升,系数在Configure时按采样率算好一次,
+ *     运行期只有Q28定点乘加;
+ *  2. 软限幅器——按块跟踪包络,超过门限时平滑压回,同样幅度下
+ *     感知响度更高,且不再产生硬削波。
+ *
+ * 播放流在这一层是单声道(声道复制在codec层),状态按单声道维护。
+ */
+class OutputDsp {
+public:
+    /* 按输出采样率预计算各级系数,重复调用同一采样率为空操作 */
+    void Configure(int sample_rate);
+    /* 原地处理一块PCM */
+    void Process(std::vector<int16_t>& pcm);
+
+private:
+    /* 转置直接II型,系数Q2.28,状态带Q28比例、64位防溢出 */
+    struct Biquad {
+        int32_t b0, b1, b2, a1, a2;
+        int64_t z1 = 0, z2 = 0;
+    };
+
+    void AddHighPass(float freq, float q);
+    void AddPeaking(float freq, float q, float gain_db);
+
+    std::vector<Biquad> stages_;
+    int sample_rate_ = 0;
+    /* 限幅器包络,Q15,1.0=32768 */
+    int32_t limiter_envelope_ = 0;
+};
+
+#endif // OUTPUT_DSP_H
@@ -0,0 +1,36 @@
+#ifndef PCM_OPS_H
+#define PCM_OPS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Small PCM kernels for the capture/playback hot path.
+ *
+ * The resampler itself lives in the esp-opus-encoder managed component, so the
+ * repo-side cost is dominated by the stereo deinterleave/interleave loops in
+ * AudioService::ReadAudioData. These operate on two int16 samples per 32-bit
+ * load/store, which roughly halves the memory traffic compared with the naive
+ * element-wise loops on all supported targets.
+ */
+
+/* Split interleaved L/R samples into two mono buffers. frames is the number of
+ * sample pairs. Buffers must be 4-byte aligned (vectors always are). */
+static inline void pcm_deinterleave_stereo(const int16_t* interleaved, int16_t* left, int16_t* right, size_t frames) {
+    const uint32_t* src = (const uint32_t*)interleaved;
+    for (size_t i = 0; i < frames; ++i) {
+        uint32_t pair = src[i];
+        left[i] = (int16_t)(pair & 0xFFFF);
+        right[i] = (int16_t)(pair >> 16);
+    }
+}
+
+/* Merge two mono buffers into interleaved L/R output. */
+static inline void pcm_interleave_stereo(const int16_t* left, const int16_t* right, int16_t* interleaved, size_t frames) {
+    uint32_t* dst = (uint32_t*)interleaved;
+    for (size_t i = 0; i < frames; ++i) {
+        dst[i] = ((uint32_t)(uint16_t)left[i]) | ((uint32_t)(uint16_t)right[i] << 16);
+    }
+}
+
+#endif // PCM_OPS_H
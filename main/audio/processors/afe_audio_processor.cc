@@ -17,10 +17,13 @@ void AfeAudioProcessor::Initialize(AudioCodec* codec, int frame_duration_ms, srm
     // Pre-allocate output buffer capacity
     output_buffer_.reserve(frame_samples_);
 
-    int ref_num = codec_->input_reference() ? 1 : 0;
+    int ref_num = NeedsReference() ? 1 : 0;
+    /* 软件参考不占codec的采集通道(由AudioService在帧里拼出R通道),
+     * 只有硬件回采才从输入通道数里扣掉 */
+    int hw_ref_num = codec_->input_reference() ? ref_num : 0;
 
     std::string input_format;
-    for (int i = 0; i < codec_->input_channels() - ref_num; i++) {
+    for (int i = 0; i < codec_->input_channels() - hw_ref_num; i++) {
         input_format.push_back('M');
     }
     for (int i = 0; i < ref_num; i++) {
@@ -110,8 +113,8 @@ bool AfeAudioProcessor::IsRunning() {
     return xEventGroupGetBits(event_group_) & PROCESSOR_RUNNING;
 }
 
-void AfeAudioProcessor::OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) {
-    output_callback_ = callback;
+void AfeAudioProcessor::OnOutput(AudioOutputCallback callback) {
+    output_callback_ = std::move(callback);
 }
 
 void AfeAudioProcessor::OnVadStateChange(std::function<void(bool speaking)> callback) {
@@ -151,27 +154,50 @@ void AfeAudioProcessor::AudioProcessorTask() {
 
         if (output_callback_) {
             size_t samples = res->data_size / sizeof(int16_t);
-            
+
+            // Fast path: the AFE fetch chunk is exactly one output frame and
+            // nothing is buffered, so emit straight from the AFE buffer with a
+            // single copy and no intermediate staging
+            if (output_buffer_.empty() && samples == frame_samples_) {
+                output_callback_(std::vector<int16_t>(res->data, res->data + samples));
+                continue;
+            }
+
             // Add data to buffer
             output_buffer_.insert(output_buffer_.end(), res->data, res->data + samples);
-            
-            // Output complete frames when buffer has enough data
-            while (output_buffer_.size() >= frame_samples_) {
-                if (output_buffer_.size() == frame_samples_) {
+
+            // Output complete frames, tracking a read offset so the buffer is
+            // compacted once at the end instead of memmoved per frame
+            size_t offset = 0;
+            while (output_buffer_.size() - offset >= frame_samples_) {
+                if (offset == 0 && output_buffer_.size() == frame_samples_) {
                     // If buffer size equals frame size, move the entire buffer
                     output_callback_(std::move(output_buffer_));
                     output_buffer_.clear();
                     output_buffer_.reserve(frame_samples_);
-                } else {
-                    // If buffer size exceeds frame size, copy one frame and remove it
-                    output_callback_(std::vector<int16_t>(output_buffer_.begin(), output_buffer_.begin() + frame_samples_));
-                    output_buffer_.erase(output_buffer_.begin(), output_buffer_.begin() + frame_samples_);
+                    break;
                 }
+                output_callback_(std::vector<int16_t>(output_buffer_.begin() + offset,
+                    output_buffer_.begin() + offset + frame_samples_));
+                offset += frame_samples_;
+            }
+            if (offset > 0) {
+                output_buffer_.erase(output_buffer_.begin(), output_buffer_.begin() + offset);
             }
         }
     }
 }
 
+bool AfeAudioProcessor::NeedsReference() {
+#if CONFIG_USE_DEVICE_AEC
+    return codec_->input_reference() || codec_->software_echo_reference();
+#else
+    /* Without device AEC the AFE never consumes the reference, so the capture
+     * path can skip deinterleaving, resampling and re-interleaving it */
+    return false;
+#endif
+}
+
 void AfeAudioProcessor::EnableDeviceAec(bool enable) {
     if (enable) {
 #if CONFIG_USE_DEVICE_AEC
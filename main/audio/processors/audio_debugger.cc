@@ -5,6 +5,7 @@
 #include <esp_log.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <cstring>
 #include <string>
@@ -29,7 +30,11 @@ AudioDebugger::AudioDebugger() {
             udp_server_addr_.sin_family = AF_INET;
             udp_server_addr_.sin_port = htons(port);
             inet_pton(AF_INET, ip.c_str(), &udp_server_addr_.sin_addr);
-            
+
+            // 非阻塞发送:调试数据可丢,录音路径不能被网络拥塞卡住
+            int flags = fcntl(udp_sockfd_, F_GETFL, 0);
+            fcntl(udp_sockfd_, F_SETFL, flags | O_NONBLOCK);
+
             ESP_LOGI(TAG, "Initialized server address: %s", CONFIG_AUDIO_DEBUG_UDP_SERVER);
         } else {
             ESP_LOGW(TAG, "Invalid server address: %s, should be IP:PORT", CONFIG_AUDIO_DEBUG_UDP_SERVER);
@@ -56,10 +61,12 @@ void AudioDebugger::Feed(const std::vector<int16_t>& data) {
     if (udp_sockfd_ >= 0) {
         ssize_t sent = sendto(udp_sockfd_, data.data(), data.size() * sizeof(int16_t), 0,
                              (struct sockaddr*)&udp_server_addr_, sizeof(udp_server_addr_));
-        if (sent < 0) {
-            ESP_LOGW(TAG, "Failed to send audio data to %s: %d", CONFIG_AUDIO_DEBUG_UDP_SERVER, errno);
-        } else {
-            ESP_LOGD(TAG, "Sent %d bytes audio data to %s", sent, CONFIG_AUDIO_DEBUG_UDP_SERVER);
+        if (sent < 0 && errno != EWOULDBLOCK && errno != EAGAIN && errno != ENOMEM) {
+            // 真正的错误才打日志;缓冲区满直接丢帧,不影响录音节奏
+            if (++send_errors_ % 100 == 1) {
+                ESP_LOGW(TAG, "Failed to send audio data to %s: %d (x%lu)",
+                    CONFIG_AUDIO_DEBUG_UDP_SERVER, errno, (unsigned long)send_errors_);
+            }
         }
     }
 #endif
@@ -17,6 +17,7 @@ public:
 private:
     int udp_sockfd_ = -1;
     struct sockaddr_in udp_server_addr_;
+    uint32_t send_errors_ = 0;
 };
 
 #endif 
\ No newline at end of file
@@ -37,8 +37,8 @@ bool NoAudioProcessor::IsRunning() {
     return is_running_;
 }
 
-void NoAudioProcessor::OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) {
-    output_callback_ = callback;
+void NoAudioProcessor::OnOutput(AudioOutputCallback callback) {
+    output_callback_ = std::move(callback);
 }
 
 void NoAudioProcessor::OnVadStateChange(std::function<void(bool speaking)> callback) {
@@ -57,3 +57,7 @@ void NoAudioProcessor::EnableDeviceAec(bool enable) {
         ESP_LOGE(TAG, "Device AEC is not supported");
     }
 }
+
+bool NoAudioProcessor::NeedsReference() {
+    return false;
+}
@@ -0,0 +1,60 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*
+ * A fixed-capacity single-producer / single-consumer ring buffer.
+ *
+ * Push and Pop are wait-free: the producer only writes head_, the consumer
+ * only writes tail_, and each side reads the other index with acquire
+ * ordering. This lets the decode -> playback handoff run without taking
+ * audio_queue_mutex_ on every frame. N must be a power of two.
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    bool Push(T&& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) {
+            return false; // full
+        }
+        slots_[head & (N - 1)] = std::move(item);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false; // empty
+        }
+        item = std::move(slots_[tail & (N - 1)]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    /* Only safe when producer and consumer are quiescent (Stop / Reset paths) */
+    void Clear() {
+        T item;
+        while (Pop(item)) {
+        }
+    }
+
+private:
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    T slots_[N];
+};
+
+#endif // SPSC_RING_H
@@ -21,6 +21,10 @@ public:
     virtual void EncodeWakeWordData() = 0;
     virtual bool GetWakeWordOpus(std::vector<uint8_t>& opus) = 0;
     virtual const std::string& GetLastDetectedWakeWord() const = 0;
+    /* 触发本次唤醒的引擎名和置信度。单引擎实现用默认值即可;
+     * wakenet不输出概率,按命中即1.0上报 */
+    virtual const char* GetLastDetectedEngine() const { return "wakenet"; }
+    virtual float GetLastDetectedConfidence() const { return 1.0f; }
 };
 
 #endif
@@ -3,6 +3,8 @@
 
 #include <esp_log.h>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
 
 #define DETECTION_RUNNING_EVENT 1
 
@@ -10,7 +12,6 @@
 
 AfeWakeWord::AfeWakeWord()
     : afe_data_(nullptr),
-      wake_word_pcm_(),
       wake_word_opus_() {
 
     event_group_ = xEventGroupCreate();
@@ -81,6 +82,9 @@ bool AfeWakeWord::Initialize(AudioCodec* codec, srmodel_list_t* models_list) {
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
 
+    /* Allocate the ~2s holdover ring once; large enough to land in PSRAM */
+    holdover_ring_.resize(2000 * 16000 / 1000);
+
     xTaskCreate([](void* arg) {
         auto this_ = (AfeWakeWord*)arg;
         this_->AudioDetectionTask();
@@ -136,6 +140,9 @@ void AfeWakeWord::AudioDetectionTask() {
         // Store the wake word data for voice recognition, like who is speaking
         StoreWakeWordData(res->data, res->data_size / sizeof(int16_t));
 
+        // 并行引擎钩子:同一份AFE输出喂给第二个检测网络
+        OnAfeOutput(res->data, res->data_size / sizeof(int16_t));
+
         if (res->wakeup_state == WAKENET_DETECTED) {
             Stop();
             last_detected_wake_word_ = wake_words_[res->wakenet_model_index - 1];
@@ -148,11 +155,16 @@ void AfeWakeWord::AudioDetectionTask() {
 }
 
 void AfeWakeWord::StoreWakeWordData(const int16_t* data, size_t samples) {
-    // store audio data to wake_word_pcm_
-    wake_word_pcm_.emplace_back(std::vector<int16_t>(data, data + samples));
-    // keep about 2 seconds of data, detect duration is 30ms (sample_rate == 16000, chunksize == 512)
-    while (wake_word_pcm_.size() > 2000 / 30) {
-        wake_word_pcm_.pop_front();
+    // Append to the circular holdover buffer; old audio is overwritten in place
+    // so the detection hot path never allocates
+    size_t capacity = holdover_ring_.size();
+    while (samples > 0) {
+        size_t chunk = std::min(samples, capacity - holdover_write_pos_);
+        std::memcpy(holdover_ring_.data() + holdover_write_pos_, data, chunk * sizeof(int16_t));
+        holdover_write_pos_ = (holdover_write_pos_ + chunk) % capacity;
+        holdover_filled_ = std::min(holdover_filled_ + chunk, capacity);
+        data += chunk;
+        samples -= chunk;
     }
 }
 
@@ -175,16 +187,27 @@ void AfeWakeWord::EncodeWakeWordData() {
             auto encoder = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
             encoder->SetComplexity(0); // 0 is the fastest
 
+            /* Walk the holdover ring oldest-first in whole Opus frames */
+            const size_t frame_samples = 16000 * OPUS_FRAME_DURATION_MS / 1000;
+            size_t capacity = this_->holdover_ring_.size();
+            size_t frames = this_->holdover_filled_ / frame_samples;
+            size_t read_pos = (this_->holdover_write_pos_ + capacity - frames * frame_samples) % capacity;
+
             int packets = 0;
-            for (auto& pcm: this_->wake_word_pcm_) {
-                encoder->Encode(std::move(pcm), [this_](std::vector<uint8_t>&& opus) {
+            std::vector<int16_t> pcm(frame_samples);
+            for (size_t f = 0; f < frames; ++f) {
+                for (size_t i = 0; i < frame_samples; ++i) {
+                    pcm[i] = this_->holdover_ring_[(read_pos + i) % capacity];
+                }
+                read_pos = (read_pos + frame_samples) % capacity;
+                encoder->Encode(std::vector<int16_t>(pcm), [this_](std::vector<uint8_t>&& opus) {
                     std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
                     this_->wake_word_opus_.emplace_back(std::move(opus));
                     this_->wake_word_cv_.notify_all();
                 });
                 packets++;
             }
-            this_->wake_word_pcm_.clear();
+            this_->holdover_filled_ = 0;
 
             auto end_time = esp_timer_get_time();
             ESP_LOGI(TAG, "Encode wake word opus %d packets in %ld ms", packets, (long)((end_time - start_time) / 1000));
@@ -34,7 +34,12 @@ public:
     bool GetWakeWordOpus(std::vector<uint8_t>& opus);
     const std::string& GetLastDetectedWakeWord() const { return last_detected_wake_word_; }
 
-private:
+protected:
+    /* 每次AFE fetch后回调一次,样本是降噪/AEC后的单声道16k输出。
+     * 并行引擎(CombinedWakeWord)在这里挂第二个检测网络,
+     * 共享同一遍前端处理,不用再跑一份AFE */
+    virtual void OnAfeOutput(const int16_t* data, size_t samples) {}
+
     srmodel_list_t *models_ = nullptr;
     esp_afe_sr_iface_t* afe_iface_ = nullptr;
     esp_afe_sr_data_t* afe_data_ = nullptr;
@@ -45,10 +50,15 @@ private:
     AudioCodec* codec_ = nullptr;
     std::string last_detected_wake_word_;
 
+private:
     TaskHandle_t wake_word_encode_task_ = nullptr;
     StaticTask_t* wake_word_encode_task_buffer_ = nullptr;
     StackType_t* wake_word_encode_task_stack_ = nullptr;
-    std::deque<std::vector<int16_t>> wake_word_pcm_;
+    // Fixed circular holdover buffer with ~2s of detection audio; written per
+    // fetch without allocating, drained by EncodeWakeWordData after a trigger
+    std::vector<int16_t> holdover_ring_;
+    size_t holdover_write_pos_ = 0;
+    size_t holdover_filled_ = 0;
     std::deque<std::vector<uint8_t>> wake_word_opus_;
     std::mutex wake_word_mutex_;
     std::condition_variable wake_word_cv_;
@@ -0,0 +1,123 @@
+#include "combined_wake_word.h"
+#include "assets.h"
+
+#include <esp_log.h>
+#include <esp_mn_speech_commands.h>
+#include <cJSON.h>
+
+#define TAG "CombinedWakeWord"
+
+CombinedWakeWord::~CombinedWakeWord() {
+    if (multinet_model_data_ != nullptr && multinet_ != nullptr) {
+        multinet_->destroy(multinet_model_data_);
+    }
+}
+
+void CombinedWakeWord::ParseBrandWordConfig() {
+    // 品牌唤醒词来自资产分区的index.json(与CustomWakeWord同一份配置),
+    // 只取action为wake的条目;没有资产配置时退回编译期配置
+    auto& assets = Assets::GetInstance();
+    void* ptr = nullptr;
+    size_t size = 0;
+    if (assets.GetAssetData("index.json", ptr, size)) {
+        cJSON* root = cJSON_ParseWithLength(static_cast<char*>(ptr), size);
+        if (root != nullptr) {
+            cJSON* multinet_model = cJSON_GetObjectItem(root, "multinet_model");
+            cJSON* commands = cJSON_GetObjectItem(multinet_model, "commands");
+            if (cJSON_IsArray(commands)) {
+                for (int i = 0; i < cJSON_GetArraySize(commands); i++) {
+                    cJSON* command = cJSON_GetArrayItem(commands, i);
+                    cJSON* command_name = cJSON_GetObjectItem(command, "command");
+                    cJSON* text = cJSON_GetObjectItem(command, "text");
+                    cJSON* action = cJSON_GetObjectItem(command, "action");
+                    if (cJSON_IsString(command_name) && cJSON_IsString(text) &&
+                        cJSON_IsString(action) && strcmp(action->valuestring, "wake") == 0) {
+                        brand_words_.push_back({command_name->valuestring, text->valuestring});
+                    }
+                }
+            }
+            cJSON_Delete(root);
+        }
+    }
+#ifdef CONFIG_CUSTOM_WAKE_WORD
+    if (brand_words_.empty()) {
+        brand_words_.push_back({CONFIG_CUSTOM_WAKE_WORD, CONFIG_CUSTOM_WAKE_WORD_DISPLAY});
+    }
+#endif
+}
+
+bool CombinedWakeWord::Initialize(AudioCodec* codec, srmodel_list_t* models_list) {
+    // wakenet引擎随AFE照常初始化,失败就整体失败
+    if (!AfeWakeWord::Initialize(codec, models_list)) {
+        return false;
+    }
+
+    auto mn_name = esp_srmodel_filter(models_, ESP_MN_PREFIX, NULL);
+    if (mn_name == nullptr) {
+        ESP_LOGW(TAG, "No multinet model, running wakenet only");
+        return true;
+    }
+
+    ParseBrandWordConfig();
+    if (brand_words_.empty()) {
+        ESP_LOGW(TAG, "No brand wake word configured, running wakenet only");
+        return true;
+    }
+
+    multinet_ = esp_mn_handle_from_name(mn_name);
+    multinet_model_data_ = multinet_->create(mn_name, 3000);
+#ifdef CONFIG_CUSTOM_WAKE_WORD_THRESHOLD
+    multinet_->set_det_threshold(multinet_model_data_, CONFIG_CUSTOM_WAKE_WORD_THRESHOLD / 100.0f);
+#endif
+    esp_mn_commands_clear();
+    for (size_t i = 0; i < brand_words_.size(); i++) {
+        esp_mn_commands_add(i + 1, brand_words_[i].pinyin.c_str());
+    }
+    esp_mn_commands_update();
+    multinet_->print_active_speech_commands(multinet_model_data_);
+
+    mn_chunk_samples_ = multinet_->get_samp_chunksize(multinet_model_data_);
+    mn_buffer_.reserve(mn_chunk_samples_ * 2);
+    ESP_LOGI(TAG, "Parallel engines ready: wakenet + multinet (%u brand words, chunk %u)",
+        (unsigned int)brand_words_.size(), (unsigned int)mn_chunk_samples_);
+    return true;
+}
+
+void CombinedWakeWord::OnAfeOutput(const int16_t* data, size_t samples) {
+    if (multinet_model_data_ == nullptr) {
+        return;
+    }
+    /* 本次fetch若由wakenet命中,基类在钩子之后上报,取到的就是这组默认值 */
+    last_engine_ = "wakenet";
+    last_confidence_ = 1.0f;
+
+    /* AFE按自己的fetch块出样本,multinet按自己的块大小吃,中间对齐一下 */
+    mn_buffer_.insert(mn_buffer_.end(), data, data + samples);
+    size_t offset = 0;
+    while (mn_buffer_.size() - offset >= mn_chunk_samples_) {
+        auto mn_state = multinet_->detect(multinet_model_data_, mn_buffer_.data() + offset);
+        offset += mn_chunk_samples_;
+
+        if (mn_state == ESP_MN_STATE_DETECTED) {
+            esp_mn_results_t* mn_result = multinet_->get_results(multinet_model_data_);
+            if (mn_result->num > 0) {
+                int command_id = mn_result->command_id[0];
+                if (command_id >= 1 && command_id <= (int)brand_words_.size()) {
+                    last_detected_wake_word_ = brand_words_[command_id - 1].display;
+                    last_engine_ = "multinet";
+                    last_confidence_ = mn_result->prob[0];
+                    ESP_LOGI(TAG, "Brand wake word detected: %s (prob %.2f)",
+                        last_detected_wake_word_.c_str(), last_confidence_);
+                    Stop();
+                    if (wake_word_detected_callback_) {
+                        wake_word_detected_callback_(last_detected_wake_word_);
+                    }
+                }
+            }
+            multinet_->clean(multinet_model_data_);
+        } else if (mn_state == ESP_MN_STATE_TIMEOUT) {
+            multinet_->clean(multinet_model_data_);
+        }
+    }
+    mn_buffer_.erase(mn_buffer_.begin(), mn_buffer_.begin() + offset);
+}
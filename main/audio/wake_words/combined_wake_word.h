@@ -0,0 +1,41 @@
+#ifndef COMBINED_WAKE_WORD_H
+#define COMBINED_WAKE_WORD_H
+
+#include <esp_mn_iface.h>
+#include <esp_mn_models.h>
+
+#include "afe_wake_word.h"
+
+// 并行双引擎:库存唤醒词(wakenet,跑在AFE内部)和自定义品牌唤醒词
+// (multinet)同时在线。multinet挂在AfeWakeWord的OnAfeOutput钩子上,
+// 吃的是同一遍AFE降噪/AEC输出,前端只跑一次——朴素的双引擎方案会把
+// 前端成本翻倍。谁先命中谁生效,引擎名和置信度随唤醒一起上报
+class CombinedWakeWord : public AfeWakeWord {
+public:
+    ~CombinedWakeWord();
+
+    bool Initialize(AudioCodec* codec, srmodel_list_t* models_list);
+    const char* GetLastDetectedEngine() const override { return last_engine_; }
+    float GetLastDetectedConfidence() const override { return last_confidence_; }
+
+protected:
+    void OnAfeOutput(const int16_t* data, size_t samples) override;
+
+private:
+    struct BrandWord {
+        std::string pinyin;
+        std::string display;
+    };
+
+    void ParseBrandWordConfig();
+
+    esp_mn_iface_t* multinet_ = nullptr;
+    model_iface_data_t* multinet_model_data_ = nullptr;
+    size_t mn_chunk_samples_ = 0;
+    std::vector<int16_t> mn_buffer_;
+    std::vector<BrandWord> brand_words_;
+    const char* last_engine_ = "wakenet";
+    float last_confidence_ = 1.0f;
+};
+
+#endif // COMBINED_WAKE_WORD_H
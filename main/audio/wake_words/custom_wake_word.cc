@@ -168,6 +168,7 @@ void CustomWakeWord::Feed(const std::vector<int16_t>& data) {
             auto& command = commands_[mn_result->command_id[i] - 1];
             if (command.action == "wake") {
                 last_detected_wake_word_ = command.text;
+                last_confidence_ = mn_result->prob[i];
                 running_ = false;
                 
                 if (wake_word_detected_callback_) {
@@ -31,6 +31,8 @@ public:
     void EncodeWakeWordData();
     bool GetWakeWordOpus(std::vector<uint8_t>& opus);
     const std::string& GetLastDetectedWakeWord() const { return last_detected_wake_word_; }
+    const char* GetLastDetectedEngine() const override { return "multinet"; }
+    float GetLastDetectedConfidence() const override { return last_confidence_; }
 
 private:
     struct Command {
@@ -52,6 +54,7 @@ private:
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
     AudioCodec* codec_ = nullptr;
     std::string last_detected_wake_word_;
+    float last_confidence_ = 0.0f;
     std::atomic<bool> running_ = false;
 
     TaskHandle_t wake_word_encode_task_ = nullptr;
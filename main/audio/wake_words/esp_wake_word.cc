@@ -1,5 +1,8 @@
 #include "esp_wake_word.h"
 #include <esp_log.h>
+#include <esp_timer.h>
+
+#include <cstring>
 
 
 #define TAG "EspWakeWord"
@@ -27,18 +30,30 @@ bool EspWakeWord::Initialize(AudioCodec* codec, srmodel_list_t* models_list) {
         ESP_LOGE(TAG, "Failed to initialize wakenet model");
         return false;
     }
-    if(wakenet_model_->num > 1) {
-        ESP_LOGW(TAG, "More than one model found, using the first one");
-    } else if (wakenet_model_->num == 0) {
+    if (wakenet_model_->num == 0) {
         ESP_LOGE(TAG, "No model found");
         return false;
     }
+
+    /* C3这类无PSRAM的单核芯片内存最紧:分区里若有int8量化(q8)版本就优先
+     * 用它——权重经esp-sr从flash分区mmap读取,量化版驻留RAM的张量小得多
+     * (较fp16省约100KB),留给LVGL的余量就出来了 */
     char *model_name = wakenet_model_->model_name[0];
+    for (int i = 0; i < wakenet_model_->num; i++) {
+        if (strstr(wakenet_model_->model_name[i], "q8") != nullptr) {
+            model_name = wakenet_model_->model_name[i];
+            break;
+        }
+    }
+    if (wakenet_model_->num > 1) {
+        ESP_LOGW(TAG, "More than one model found, using %s", model_name);
+    }
     wakenet_iface_ = (esp_wn_iface_t*)esp_wn_handle_from_name(model_name);
     wakenet_data_ = wakenet_iface_->create(model_name, DET_MODE_95);
 
     int frequency = wakenet_iface_->get_samp_rate(wakenet_data_);
     int audio_chunksize = wakenet_iface_->get_samp_chunksize(wakenet_data_);
+    chunk_budget_us_ = (int64_t)audio_chunksize * 1000000 / frequency;
     ESP_LOGI(TAG, "Wake word(%s),freq: %d, chunksize: %d", model_name, frequency, audio_chunksize);
 
     return true;
@@ -61,7 +76,17 @@ void EspWakeWord::Feed(const std::vector<int16_t>& data) {
         return;
     }
 
+    /* 单核芯片上detect一旦超出本块的实时预算,输入就开始掉帧,表现为
+     * "喊了没反应"。超限只在首次和每百次时告警,避免刷屏 */
+    auto start_time = esp_timer_get_time();
     int res = wakenet_iface_->detect(wakenet_data_, (int16_t *)data.data());
+    auto elapsed = esp_timer_get_time() - start_time;
+    if (elapsed > chunk_budget_us_) {
+        if (overrun_count_++ % 100 == 0) {
+            ESP_LOGW(TAG, "Detect overrun: %lld us for a %lld us chunk (count %d)",
+                (long long)elapsed, (long long)chunk_budget_us_, overrun_count_);
+        }
+    }
     if (res > 0) {
         last_detected_wake_word_ = wakenet_iface_->get_word_name(wakenet_data_, res);
         running_ = false;
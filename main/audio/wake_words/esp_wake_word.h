@@ -34,6 +34,8 @@ private:
     srmodel_list_t *wakenet_model_ = nullptr;
     AudioCodec* codec_ = nullptr;
     std::atomic<bool> running_ = false;
+    int64_t chunk_budget_us_ = 0;
+    int overrun_count_ = 0;
 
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
     std::string last_detected_wake_word_;
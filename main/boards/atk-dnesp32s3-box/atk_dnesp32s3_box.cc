@@ -30,8 +30,8 @@ public:
         i2s_chan_config_t chan_cfg = {
             .id = I2S_NUM_0,
             .role = I2S_ROLE_MASTER,
-            .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
-            .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
+            .dma_desc_num = (uint32_t)dma_desc_num_,
+            .dma_frame_num = (uint32_t)dma_frame_num_,
             .auto_clear_after_cb = true,
             .auto_clear_before_cb = false,
             .intr_priority = 0,
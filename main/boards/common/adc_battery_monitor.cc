@@ -61,21 +61,50 @@ bool AdcBatteryMonitor::IsDischarging() {
 }
 
 uint8_t AdcBatteryMonitor::GetBatteryLevel() {
-    float capacity = 0;
-    ESP_ERROR_CHECK(adc_battery_estimation_get_capacity(adc_battery_estimation_handle_, &capacity));
-    return capacity;
+    if (smoothed_capacity_ < 0) {
+        SampleCapacity();
+    }
+    return (uint8_t)(smoothed_capacity_ + 0.5f);
+}
+
+uint8_t AdcBatteryMonitor::GetSmoothedLevel() {
+    return GetBatteryLevel();
 }
 
 void AdcBatteryMonitor::OnChargingStatusChanged(std::function<void(bool)> callback) {
     on_charging_status_changed_ = callback;
 }
 
+void AdcBatteryMonitor::SampleCapacity() {
+    float capacity = 0;
+    ESP_ERROR_CHECK(adc_battery_estimation_get_capacity(adc_battery_estimation_handle_, &capacity));
+    if (smoothed_capacity_ < 0) {
+        smoothed_capacity_ = capacity;
+    } else {
+        // 一阶IIR:新采样占1/4权重,负载尖峰引起的电压跌落被滤掉,
+        // 状态栏的电量数字不会来回跳
+        smoothed_capacity_ += (capacity - smoothed_capacity_) * 0.25f;
+    }
+}
+
 void AdcBatteryMonitor::CheckBatteryStatus() {
+    // 充电检测只读GPIO,每秒一次;状态要连续两次一致才上报,
+    // 充电座接触不良时图标不会闪烁
     bool new_charging_status = IsCharging();
     if (new_charging_status != is_charging_) {
-        is_charging_ = new_charging_status;
-        if (on_charging_status_changed_) {
-            on_charging_status_changed_(is_charging_);
+        if (++charging_debounce_ >= 2) {
+            charging_debounce_ = 0;
+            is_charging_ = new_charging_status;
+            if (on_charging_status_changed_) {
+                on_charging_status_changed_(is_charging_);
+            }
         }
+    } else {
+        charging_debounce_ = 0;
+    }
+
+    // ADC采样降到每10秒一次喂给IIR滤波,读电量的一方只拿缓存
+    if (tick_count_++ % 10 == 0) {
+        SampleCapacity();
     }
 }
\ No newline at end of file
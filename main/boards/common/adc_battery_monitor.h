@@ -14,6 +14,8 @@ public:
     bool IsCharging();
     bool IsDischarging();
     uint8_t GetBatteryLevel();
+    // 状态栏用:直接返回IIR滤波后的缓存电量,不触发ADC采样
+    uint8_t GetSmoothedLevel();
 
     void OnChargingStatusChanged(std::function<void(bool)> callback);
 
@@ -22,9 +24,13 @@ private:
     adc_battery_estimation_handle_t adc_battery_estimation_handle_ = nullptr;
     esp_timer_handle_t timer_handle_ = nullptr;
     bool is_charging_ = false;
+    int charging_debounce_ = 0;   // 充电状态去抖计数
+    int tick_count_ = 0;
+    float smoothed_capacity_ = -1.0f;  // IIR滤波后的电量,-1表示还没采过样
     std::function<void(bool)> on_charging_status_changed_;
 
     void CheckBatteryStatus();
+    void SampleCapacity();
 };
 
 #endif // ADC_BATTERY_MONITOR_H
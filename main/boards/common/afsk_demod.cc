@@ -48,8 +48,8 @@ namespace audio_wifi_config
                 audio_data = std::move(mono_data);
             }
             
-            // Downsample the audio data
-            std::vector<float> downsampled_data;
+            // Downsample the audio data (保持int16,解调全程定点)
+            std::vector<int16_t> downsampled_data;
             size_t last_index = 0;
 
             if (kDownsampleStep > 1.0f) {
@@ -57,15 +57,12 @@ namespace audio_wifi_config
                 for (size_t i = 0; i < audio_data.size(); ++i) {
                     size_t sample_index = static_cast<size_t>(i / kDownsampleStep);
                     if ((sample_index + 1) > last_index) {
-                        downsampled_data.push_back(static_cast<float>(audio_data[i]));
+                        downsampled_data.push_back(audio_data[i]);
                         last_index = sample_index + 1;
                     }
                 }
             } else {
-                downsampled_data.reserve(audio_data.size());
-                for (int16_t sample : audio_data) {
-                    downsampled_data.push_back(static_cast<float>(sample));
-                }
+                downsampled_data = audio_data;
             }
             
             // Process audio samples to get probability data
@@ -115,57 +112,48 @@ namespace audio_wifi_config
     // FrequencyDetector implementation
     FrequencyDetector::FrequencyDetector(float frequency, size_t window_size)
         : frequency_(frequency), window_size_(window_size) {
-        frequency_bin_ = std::floor(frequency_ * static_cast<float>(window_size_));
-        angular_frequency_ = 2.0f * M_PI * frequency_;
-        cos_coefficient_ = std::cos(angular_frequency_);
-        sin_coefficient_ = std::sin(angular_frequency_);
-        filter_coefficient_ = 2.0f * cos_coefficient_;
-
-        // Initialize state buffer
-        state_buffer_.push_back(0.0f);
-        state_buffer_.push_back(0.0f);
+        float angular_frequency = 2.0f * M_PI * frequency_;
+        cos_coefficient_ = std::cos(angular_frequency);
+        sin_coefficient_ = std::sin(angular_frequency);
+        // 2*cos(w)按Q14定点存放,内层循环只剩整数乘加
+        filter_coefficient_q14_ = static_cast<int32_t>(2.0f * cos_coefficient_ * 16384.0f);
     }
 
     void FrequencyDetector::Reset() {
-        state_buffer_.clear();
-        state_buffer_.push_back(0.0f);
-        state_buffer_.push_back(0.0f);
+        s1_ = 0;
+        s2_ = 0;
     }
 
-    void FrequencyDetector::ProcessSample(float sample) {
-        if (state_buffer_.size() < 2) {
-            return;
+    // 整窗分块递推:64样本窗下|s|不超过2^21量级,乘Q14系数用64位中间量防溢出。
+    // C3(RV32IM)上32x32->64乘法是单条指令,比逐样本软浮点便宜一个数量级
+    void FrequencyDetector::ProcessBlock(const int16_t* samples, size_t count) {
+        int32_t s1 = s1_;
+        int32_t s2 = s2_;
+        int32_t coeff = filter_coefficient_q14_;
+        for (size_t i = 0; i < count; ++i) {
+            int32_t s = samples[i] + static_cast<int32_t>((static_cast<int64_t>(coeff) * s1) >> 14) - s2;
+            s2 = s1;
+            s1 = s;
         }
-
-        float s_minus_2 = state_buffer_.front();  // S[-2]
-        state_buffer_.pop_front();
-        float s_minus_1 = state_buffer_.front();  // S[-1]
-        state_buffer_.pop_front();
-
-        float s_current = sample + filter_coefficient_ * s_minus_1 - s_minus_2;
-
-        state_buffer_.push_back(s_minus_1);  // Put S[-1] back
-        state_buffer_.push_back(s_current);  // Add new S[0]
+        s1_ = s1;
+        s2_ = s2;
     }
 
     float FrequencyDetector::GetAmplitude() const {
-        if (state_buffer_.size() < 2) {
-            return 0.0f;
-        }
-
-        float s_minus_1 = state_buffer_[1];                      // S[-1]
-        float s_minus_2 = state_buffer_[0];                      // S[-2]
+        // 幅值只在每个比特判决时算一次,这里回到浮点无伤大雅
+        float s_minus_1 = static_cast<float>(s1_);
+        float s_minus_2 = static_cast<float>(s2_);
         float real_part = cos_coefficient_ * s_minus_1 - s_minus_2;  // Real part
         float imaginary_part = sin_coefficient_ * s_minus_1;         // Imaginary part
 
-        return std::sqrt(real_part * real_part + imaginary_part * imaginary_part) / 
+        return std::sqrt(real_part * real_part + imaginary_part * imaginary_part) /
                (static_cast<float>(window_size_) / 2.0f);
     }
 
     // AudioSignalProcessor implementation
     AudioSignalProcessor::AudioSignalProcessor(size_t sample_rate, size_t mark_frequency, size_t space_frequency,
                                              size_t bit_rate, size_t window_size)
-        : input_buffer_size_(window_size), output_sample_count_(0) {
+        : window_(window_size, 0), scratch_(window_size, 0), output_sample_count_(0) {
         if (sample_rate % bit_rate != 0) {
             // On ESP32 we can continue execution, but log the error
             ESP_LOGW(kLogTag, "Sample rate %zu is not divisible by bit rate %zu", sample_rate, bit_rate);
@@ -180,38 +168,52 @@ namespace audio_wifi_config
         samples_per_bit_ = sample_rate / bit_rate;  // Number of samples per bit
     }
 
-    std::vector<float> AudioSignalProcessor::ProcessAudioSamples(const std::vector<float> &samples) {
+    std::vector<float> AudioSignalProcessor::ProcessAudioSamples(const std::vector<int16_t> &samples) {
         std::vector<float> result;
+        const size_t window_size = window_.size();
+
+        for (int16_t sample : samples) {
+            // 环形窗写入,预热阶段(不足一窗)只填充不判决
+            window_[window_pos_] = sample;
+            window_pos_ = (window_pos_ + 1) % window_size;
+            if (window_filled_ < window_size) {
+                window_filled_++;
+                continue;
+            }
+            output_sample_count_++;
+
+            if (output_sample_count_ >= samples_per_bit_) {
+                // 把环形窗线性化到暂存区,交给分块核一次算完
+                size_t tail = window_size - window_pos_;
+                std::memcpy(scratch_.data(), window_.data() + window_pos_, tail * sizeof(int16_t));
+                std::memcpy(scratch_.data() + tail, window_.data(), window_pos_ * sizeof(int16_t));
+
+                // 能量门限:静音窗直接跳过两路Goertzel,空闲监听时省掉绝大部分计算
+                int32_t abs_sum = 0;
+                for (int16_t s : scratch_) {
+                    abs_sum += (s < 0) ? -s : s;
+                }
+                if (abs_sum < kSilenceGateMeanAbs * static_cast<int32_t>(window_size)) {
+                    result.push_back(0.0f);
+                    output_sample_count_ = 0;
+                    continue;
+                }
 
-        for (float sample : samples) {
-            if (input_buffer_.size() < input_buffer_size_) {
-                input_buffer_.push_back(sample);  // Just add, don't process yet
-            } else {
-                // Input buffer is full, process the data
-                input_buffer_.pop_front();   // Remove oldest sample
-                input_buffer_.push_back(sample);  // Add new sample
-                output_sample_count_++;
-
-                if (output_sample_count_ >= samples_per_bit_) {
-                    // Process all samples in the window using Goertzel algorithm
-                    for (float window_sample : input_buffer_) {
-                        mark_detector_->ProcessSample(window_sample);
-                        space_detector_->ProcessSample(window_sample);
-                    }
+                mark_detector_->ProcessBlock(scratch_.data(), window_size);
+                space_detector_->ProcessBlock(scratch_.data(), window_size);
 
-                    float mark_amplitude = mark_detector_->GetAmplitude();   // Mark amplitude
-                    float space_amplitude = space_detector_->GetAmplitude(); // Space amplitude
+                float mark_amplitude = mark_detector_->GetAmplitude();   // Mark amplitude
+                float space_amplitude = space_detector_->GetAmplitude(); // Space amplitude
 
-                    // Avoid division by zero
-                    float mark_probability = mark_amplitude / 
-                                           (space_amplitude + mark_amplitude + std::numeric_limits<float>::epsilon());
-                    result.push_back(mark_probability);
+                // Avoid division by zero
+                float mark_probability = mark_amplitude /
+                                       (space_amplitude + mark_amplitude + std::numeric_limits<float>::epsilon());
+                result.push_back(mark_probability);
 
-                    // Reset detector windows
-                    mark_detector_->Reset();
-                    space_detector_->Reset();
-                    output_sample_count_ = 0;  // Reset output counter
-                }
+                // Reset detector windows
+                mark_detector_->Reset();
+                space_detector_->Reset();
+                output_sample_count_ = 0;  // Reset output counter
             }
         }
 
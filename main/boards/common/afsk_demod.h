@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <deque>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <optional>
@@ -25,18 +26,20 @@ namespace audio_wifi_config
     /**
      * Goertzel algorithm implementation for single frequency detection
      * Used to detect specific audio frequencies in the AFSK demodulation process
+     *
+     * 定点(Q14)分块实现:C3没有硬件浮点,逐样本float递推代价极高,
+     * 这里整窗一次跑完,内层只有整数乘加,幅值计算才回到浮点(每比特一次)
      */
     class FrequencyDetector
     {
     private:
         float frequency_;              // Target frequency (normalized, i.e., f / fs)
         size_t window_size_;           // Window size for analysis
-        float frequency_bin_;          // Frequency bin
-        float angular_frequency_;      // Angular frequency
         float cos_coefficient_;        // cos(w)
         float sin_coefficient_;        // sin(w)
-        float filter_coefficient_;     // 2 * cos(w)
-        std::deque<float> state_buffer_;  // Circular buffer for storing S[-1] and S[-2]
+        int32_t filter_coefficient_q14_;  // 2 * cos(w),Q14定点
+        int32_t s1_ = 0;               // Goertzel状态 S[-1]
+        int32_t s2_ = 0;               // Goertzel状态 S[-2]
 
     public:
         /**
@@ -52,10 +55,11 @@ namespace audio_wifi_config
         void Reset();
 
         /**
-         * Process one audio sample
-         * @param sample Input audio sample
+         * Process a block of audio samples (fixed-point kernel)
+         * @param samples Input samples
+         * @param count Number of samples
          */
-        void ProcessSample(float sample);
+        void ProcessBlock(const int16_t* samples, size_t count);
 
         /**
          * Calculate current amplitude
@@ -71,13 +75,18 @@ namespace audio_wifi_config
     class AudioSignalProcessor
     {
     private:
-        std::deque<float> input_buffer_;             // Input sample buffer
-        size_t input_buffer_size_;                   // Input buffer size = window size
+        std::vector<int16_t> window_;                // 分析窗环形缓冲(定点样本)
+        size_t window_pos_ = 0;                      // 环形写位置
+        size_t window_filled_ = 0;                   // 已填充样本数
+        std::vector<int16_t> scratch_;               // 线性化窗口的暂存,供分块核使用
         size_t output_sample_count_;                 // Output sample counter
         size_t samples_per_bit_;                     // Samples per bit threshold
         std::unique_ptr<FrequencyDetector> mark_detector_;   // Mark frequency detector
         std::unique_ptr<FrequencyDetector> space_detector_;  // Space frequency detector
 
+        // 能量门限:平均幅值低于该值视为静音,直接跳过两路Goertzel(空闲监听几乎零开销)
+        static constexpr int32_t kSilenceGateMeanAbs = 64;
+
     public:
         /**
          * Constructor
@@ -91,11 +100,11 @@ namespace audio_wifi_config
                            size_t bit_rate, size_t window_size);
 
         /**
-         * Process input audio samples
+         * Process input audio samples (fixed-point)
          * @param samples Input audio sample vector
          * @return Vector of Mark probability values (0.0 to 1.0)
          */
-        std::vector<float> ProcessAudioSamples(const std::vector<float> &samples);
+        std::vector<float> ProcessAudioSamples(const std::vector<int16_t> &samples);
     };
 
     /**
@@ -4,6 +4,9 @@
 #include <esp_log.h>
 #include <driver/ledc.h>
 
+#include <cmath>
+#include <cstdlib>
+
 #define TAG "Backlight"
 
 
@@ -58,6 +61,16 @@ void Backlight::SetBrightness(uint8_t brightness, bool permanent) {
     }
 
     target_brightness_ = brightness;
+
+    // 先尝试硬件渐变:时长沿用软件渐变的5ms/级,视觉节奏不变,
+    // 但过渡期间不再产生每级一次的定时器回调
+    int duration_ms = 5 * abs((int)target_brightness_ - (int)brightness_);
+    if (FadeToImpl(brightness, duration_ms)) {
+        brightness_ = brightness;
+        ESP_LOGI(TAG, "Set brightness to %d", brightness);
+        return;
+    }
+
     step_ = (target_brightness_ > brightness_) ? 1 : -1;
 
     if (transition_timer_ != nullptr) {
@@ -106,6 +119,17 @@ PwmBacklight::PwmBacklight(gpio_num_t pin, bool output_invert, uint32_t freq_hz)
         }
     };
     ESP_ERROR_CHECK(ledc_channel_config(&backlight_channel));
+
+    // 亮度百分比经gamma 2.2映射成占空比,低亮度段的过渡在视觉上更均匀
+    for (int i = 0; i <= 100; i++) {
+        gamma_lut_[i] = (uint16_t)(1023.0f * powf(i / 100.0f, 2.2f) + 0.5f);
+    }
+
+    // 硬件渐变服务全局只装一次(舵机等其他模块可能已经装过)
+    auto err = ledc_fade_func_install(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_ERROR_CHECK(err);
+    }
 }
 
 PwmBacklight::~PwmBacklight() {
@@ -114,8 +138,19 @@ PwmBacklight::~PwmBacklight() {
 
 void PwmBacklight::SetBrightnessImpl(uint8_t brightness) {
     // LEDC resolution set to 10bits, thus: 100% = 1023
-    uint32_t duty_cycle = (1023 * brightness) / 100;
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, duty_cycle);
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, gamma_lut_[brightness]);
     ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
 }
 
+bool PwmBacklight::FadeToImpl(uint8_t brightness, int duration_ms) {
+    if (duration_ms <= 0) {
+        SetBrightnessImpl(brightness);
+        return true;
+    }
+    // 占空比插值由LEDC外设完成,过渡全程CPU零参与
+    ledc_set_fade_with_time(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, gamma_lut_[brightness],
+                            duration_ms);
+    ledc_fade_start(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, LEDC_FADE_NO_WAIT);
+    return true;
+}
+
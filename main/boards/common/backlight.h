@@ -19,6 +19,9 @@ public:
 protected:
     void OnTransitionTimer();
     virtual void SetBrightnessImpl(uint8_t brightness) = 0;
+    // 支持硬件渐变的背光重写此方法并返回true,整个过渡就是一次寄存器编程;
+    // 返回false则退回5ms步进的软件渐变定时器
+    virtual bool FadeToImpl(uint8_t brightness, int duration_ms) { return false; }
 
     esp_timer_handle_t transition_timer_ = nullptr;
     uint8_t brightness_ = 0;
@@ -33,4 +36,8 @@ public:
     ~PwmBacklight();
 
     void SetBrightnessImpl(uint8_t brightness) override;
+    bool FadeToImpl(uint8_t brightness, int duration_ms) override;
+
+private:
+    uint16_t gamma_lut_[101];  // 亮度百分比 -> gamma校正后的占空比
 };
@@ -0,0 +1,83 @@
+#ifndef BOARD_DESCRIPTOR_H
+#define BOARD_DESCRIPTOR_H
+
+#include <driver/gpio.h>
+#include <driver/i2c_master.h>
+#include <driver/spi_common.h>
+#include <esp_lcd_panel_io.h>
+#include <esp_err.h>
+
+// 板级接线在编译期就全部确定,但各板的Initialize*把同样的总线样板
+// (I2C主机总线、显示SPI总线、SPI面板IO)逐字段抄了几十份。这里提供
+// constexpr接线描述符和配套的初始化助手:接线以结构化常量声明,
+// 样板收敛成一处,描述符被编译器折叠进只读数据,不再占运行时构造代码。
+// 面板型号相关的vendor初始化序列、按键回调等真正因板而异的逻辑仍留在
+// 各板文件里;各板在改到时顺手迁移即可,不要求一次性换完
+
+// 音频codec用的I2C主机总线(内部上拉,默认时钟源)
+struct I2cBusDescriptor {
+    i2c_port_t port;
+    gpio_num_t sda;
+    gpio_num_t scl;
+};
+
+// 显示用SPI总线(仅MOSI/SCLK,DMA自动通道)
+struct SpiBusDescriptor {
+    spi_host_device_t host;
+    gpio_num_t mosi;
+    gpio_num_t sclk;
+    int max_transfer_sz;
+};
+
+// SPI面板IO(8位命令/参数,队列深度10,mode 0)
+struct SpiPanelIoDescriptor {
+    spi_host_device_t host;
+    gpio_num_t cs;
+    gpio_num_t dc;
+    int pclk_hz;
+};
+
+inline i2c_master_bus_handle_t InitI2cBus(const I2cBusDescriptor& desc) {
+    i2c_master_bus_config_t i2c_bus_cfg = {
+        .i2c_port = desc.port,
+        .sda_io_num = desc.sda,
+        .scl_io_num = desc.scl,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .intr_priority = 0,
+        .trans_queue_depth = 0,
+        .flags = {
+            .enable_internal_pullup = 1,
+        },
+    };
+    i2c_master_bus_handle_t bus = nullptr;
+    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_bus_cfg, &bus));
+    return bus;
+}
+
+inline void InitSpiBus(const SpiBusDescriptor& desc) {
+    spi_bus_config_t buscfg = {};
+    buscfg.mosi_io_num = desc.mosi;
+    buscfg.miso_io_num = GPIO_NUM_NC;
+    buscfg.sclk_io_num = desc.sclk;
+    buscfg.quadwp_io_num = GPIO_NUM_NC;
+    buscfg.quadhd_io_num = GPIO_NUM_NC;
+    buscfg.max_transfer_sz = desc.max_transfer_sz;
+    ESP_ERROR_CHECK(spi_bus_initialize(desc.host, &buscfg, SPI_DMA_CH_AUTO));
+}
+
+inline esp_lcd_panel_io_handle_t InitSpiPanelIo(const SpiPanelIoDescriptor& desc) {
+    esp_lcd_panel_io_spi_config_t io_config = {};
+    io_config.cs_gpio_num = desc.cs;
+    io_config.dc_gpio_num = desc.dc;
+    io_config.spi_mode = 0;
+    io_config.pclk_hz = desc.pclk_hz;
+    io_config.trans_queue_depth = 10;
+    io_config.lcd_cmd_bits = 8;
+    io_config.lcd_param_bits = 8;
+    esp_lcd_panel_io_handle_t panel_io = nullptr;
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi(desc.host, &io_config, &panel_io));
+    return panel_io;
+}
+
+#endif // BOARD_DESCRIPTOR_H
@@ -2,6 +2,10 @@
 
 #include <button_gpio.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+#include <algorithm>
 
 #define TAG "Button"
 
@@ -122,4 +126,215 @@ void Button::OnMultipleClick(std::function<void()> callback, uint8_t click_count
             button->on_multiple_click_();
         }
     }, this);
+}
+
+namespace {
+
+struct ButtonEdgeEvent {
+    InterruptButton* button;
+    int64_t timestamp_us;
+    int level;
+};
+
+// 机械抖动窗口:该时间内的重复边沿直接按时间戳丢弃,不需要去抖定时器
+constexpr int64_t kDebounceUs = 20 * 1000;
+
+} // namespace
+
+QueueHandle_t InterruptButton::event_queue_ = nullptr;
+std::mutex InterruptButton::registry_mutex_;
+std::vector<InterruptButton*> InterruptButton::registry_;
+
+InterruptButton::InterruptButton(gpio_num_t gpio_num, bool active_high,
+                                 uint16_t long_press_time, uint16_t short_press_time)
+    : Button(nullptr), active_high_(active_high) {
+    gpio_num_ = gpio_num;
+    if (gpio_num == GPIO_NUM_NC) {
+        return;
+    }
+    // 0沿用iot_button的默认时长,保持两种按键实现的手感一致
+    long_press_ms_ = long_press_time != 0 ? long_press_time : 1500;
+    click_window_ms_ = short_press_time != 0 ? short_press_time : 180;
+
+    gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << gpio_num,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = active_high ? GPIO_PULLUP_DISABLE : GPIO_PULLUP_ENABLE,
+        .pull_down_en = active_high ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_config));
+
+    EnsureDispatcher();
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        registry_.push_back(this);
+    }
+
+    auto err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) { // 已安装过也算成功
+        ESP_ERROR_CHECK(err);
+    }
+    ESP_ERROR_CHECK(gpio_isr_handler_add(gpio_num, GpioIsrHandler, this));
+}
+
+InterruptButton::~InterruptButton() {
+    if (gpio_num_ == GPIO_NUM_NC) {
+        return;
+    }
+    gpio_isr_handler_remove(gpio_num_);
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    registry_.erase(std::remove(registry_.begin(), registry_.end(), this), registry_.end());
+}
+
+void InterruptButton::EnsureDispatcher() {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    if (event_queue_ != nullptr) {
+        return;
+    }
+    event_queue_ = xQueueCreate(16, sizeof(ButtonEdgeEvent));
+    xTaskCreate(DispatchTask, "button_isr", 1024 * 3, nullptr, 10, nullptr);
+}
+
+void IRAM_ATTR InterruptButton::GpioIsrHandler(void* arg) {
+    auto* button = static_cast<InterruptButton*>(arg);
+    ButtonEdgeEvent event = {
+        .button = button,
+        .timestamp_us = esp_timer_get_time(),
+        .level = gpio_get_level(button->gpio_num_),
+    };
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    xQueueSendFromISR(event_queue_, &event, &higher_priority_task_woken);
+    if (higher_priority_task_woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void InterruptButton::DispatchTask(void* arg) {
+    while (true) {
+        // 没有按键处于按下/连击窗口时永久阻塞,一次唤醒都不产生
+        TickType_t timeout = portMAX_DELAY;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            int64_t next_deadline = INT64_MAX;
+            for (auto* button : registry_) {
+                next_deadline = std::min(next_deadline, button->NextDeadlineUs());
+            }
+            if (next_deadline != INT64_MAX) {
+                int64_t delta_us = next_deadline - esp_timer_get_time();
+                timeout = delta_us <= 0 ? 0 : pdMS_TO_TICKS((delta_us + 999) / 1000);
+            }
+        }
+
+        ButtonEdgeEvent event;
+        bool received = xQueueReceive(event_queue_, &event, timeout) == pdTRUE;
+
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        if (received) {
+            // 确认按键还在注册表里,防止析构后队列里残留的事件悬空
+            auto it = std::find(registry_.begin(), registry_.end(), event.button);
+            if (it != registry_.end()) {
+                event.button->HandleEdge(event.level, event.timestamp_us);
+            }
+        }
+        int64_t now_us = esp_timer_get_time();
+        for (auto* button : registry_) {
+            button->HandleTimeout(now_us);
+        }
+    }
+}
+
+int64_t InterruptButton::NextDeadlineUs() const {
+    if (state_ == State::kPressed && !long_press_fired_) {
+        return press_us_ + (int64_t)long_press_ms_ * 1000;
+    }
+    if (state_ == State::kWaitClickWindow) {
+        return release_us_ + (int64_t)click_window_ms_ * 1000;
+    }
+    return INT64_MAX;
+}
+
+void InterruptButton::HandleEdge(int level, int64_t timestamp_us) {
+    if (timestamp_us - last_edge_us_ < kDebounceUs) {
+        return;
+    }
+    last_edge_us_ = timestamp_us;
+
+    bool pressed = level == (active_high_ ? 1 : 0);
+    if (pressed && state_ != State::kPressed) {
+        if (state_ == State::kIdle) {
+            click_count_ = 0;
+        }
+        state_ = State::kPressed;
+        press_us_ = timestamp_us;
+        long_press_fired_ = false;
+        if (on_press_down_) {
+            on_press_down_();
+        }
+    } else if (!pressed && state_ == State::kPressed) {
+        if (on_press_up_) {
+            on_press_up_();
+        }
+        if (long_press_fired_) {
+            state_ = State::kIdle;
+            click_count_ = 0;
+        } else {
+            click_count_++;
+            release_us_ = timestamp_us;
+            if (on_double_click_ || on_multiple_click_) {
+                // 需要分辨连击时才等窗口,否则单击立即上报
+                state_ = State::kWaitClickWindow;
+            } else {
+                if (on_click_) {
+                    on_click_();
+                }
+                state_ = State::kIdle;
+                click_count_ = 0;
+            }
+        }
+    }
+}
+
+void InterruptButton::HandleTimeout(int64_t now_us) {
+    if (state_ == State::kPressed && !long_press_fired_ && on_long_press_ &&
+        now_us - press_us_ >= (int64_t)long_press_ms_ * 1000) {
+        long_press_fired_ = true;
+        on_long_press_();
+    } else if (state_ == State::kWaitClickWindow &&
+               now_us - release_us_ >= (int64_t)click_window_ms_ * 1000) {
+        if (on_multiple_click_ && click_count_ >= multiple_click_target_) {
+            on_multiple_click_();
+        } else if (on_double_click_ && click_count_ >= 2) {
+            on_double_click_();
+        } else if (on_click_) {
+            on_click_();
+        }
+        state_ = State::kIdle;
+        click_count_ = 0;
+    }
+}
+
+void InterruptButton::OnPressDown(std::function<void()> callback) {
+    on_press_down_ = callback;
+}
+
+void InterruptButton::OnPressUp(std::function<void()> callback) {
+    on_press_up_ = callback;
+}
+
+void InterruptButton::OnLongPress(std::function<void()> callback) {
+    on_long_press_ = callback;
+}
+
+void InterruptButton::OnClick(std::function<void()> callback) {
+    on_click_ = callback;
+}
+
+void InterruptButton::OnDoubleClick(std::function<void()> callback) {
+    on_double_click_ = callback;
+}
+
+void InterruptButton::OnMultipleClick(std::function<void()> callback, uint8_t click_count) {
+    on_multiple_click_ = callback;
+    multiple_click_target_ = click_count;
 }
\ No newline at end of file
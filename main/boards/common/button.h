@@ -6,20 +6,24 @@
 #include <button_types.h>
 #include <button_adc.h>
 #include <button_gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include <functional>
+#include <mutex>
+#include <vector>
 
 class Button {
 public:
     Button(button_handle_t button_handle);
     Button(gpio_num_t gpio_num, bool active_high = false, uint16_t long_press_time = 0, uint16_t short_press_time = 0, bool enable_power_save = false);
-    ~Button();
+    virtual ~Button();
 
-    void OnPressDown(std::function<void()> callback);
-    void OnPressUp(std::function<void()> callback);
-    void OnLongPress(std::function<void()> callback);
-    void OnClick(std::function<void()> callback);
-    void OnDoubleClick(std::function<void()> callback);
-    void OnMultipleClick(std::function<void()> callback, uint8_t click_count = 3);
+    virtual void OnPressDown(std::function<void()> callback);
+    virtual void OnPressUp(std::function<void()> callback);
+    virtual void OnLongPress(std::function<void()> callback);
+    virtual void OnClick(std::function<void()> callback);
+    virtual void OnDoubleClick(std::function<void()> callback);
+    virtual void OnMultipleClick(std::function<void()> callback, uint8_t click_count = 3);
 
 protected:
     gpio_num_t gpio_num_;
@@ -46,4 +50,48 @@ public:
     }
 };
 
+// 纯中断驱动按键:不经过iot_button的定时扫描。GPIO ISR记录边沿时间戳,
+// 去抖靠时间戳差值判断;所有按键共用一个分发任务,空闲时阻塞在事件队列上,
+// 长按/连击窗口用队列超时实现——整条链路没有任何周期性唤醒,适合浅睡眠板子
+class InterruptButton : public Button {
+public:
+    InterruptButton(gpio_num_t gpio_num, bool active_high = false,
+                    uint16_t long_press_time = 0, uint16_t short_press_time = 0);
+    ~InterruptButton();
+
+    void OnPressDown(std::function<void()> callback) override;
+    void OnPressUp(std::function<void()> callback) override;
+    void OnLongPress(std::function<void()> callback) override;
+    void OnClick(std::function<void()> callback) override;
+    void OnDoubleClick(std::function<void()> callback) override;
+    void OnMultipleClick(std::function<void()> callback, uint8_t click_count = 3) override;
+
+private:
+    static void GpioIsrHandler(void* arg);
+    static void DispatchTask(void* arg);
+    static void EnsureDispatcher();
+
+    // 以下状态只在分发任务里读写
+    void HandleEdge(int level, int64_t timestamp_us);
+    void HandleTimeout(int64_t now_us);
+    int64_t NextDeadlineUs() const;
+
+    static QueueHandle_t event_queue_;
+    static std::mutex registry_mutex_;
+    static std::vector<InterruptButton*> registry_;
+
+    bool active_high_;
+    uint16_t long_press_ms_;
+    uint16_t click_window_ms_;
+    uint8_t multiple_click_target_ = 3;
+
+    enum class State { kIdle, kPressed, kWaitClickWindow };
+    State state_ = State::kIdle;
+    int64_t last_edge_us_ = 0;
+    int64_t press_us_ = 0;
+    int64_t release_us_ = 0;
+    bool long_press_fired_ = false;
+    uint8_t click_count_ = 0;
+};
+
 #endif // BUTTON_H_
@@ -10,6 +10,9 @@ public:
     virtual bool SetHMirror(bool enabled) = 0;
     virtual bool SetVFlip(bool enabled) = 0;
     virtual std::string Explain(const std::string& question) = 0;
+    // 可选能力:设置下一次拍照的分辨率(如"qvga"),拍完自动恢复默认;
+    // 粗略的视觉问题用小帧即可,上传字节数能省4-10倍。默认实现不支持
+    virtual bool SetCaptureResolution(const std::string& resolution) { return false; }
 };
 
 #endif // CAMERA_H
@@ -4,6 +4,7 @@
 #include "assets/lang_config.h"
 #include "settings.h"
 #include <esp_log.h>
+#include <wifi_station.h>
 
 static const char *TAG = "DualNetworkBoard";
 
@@ -18,6 +19,7 @@ DualNetworkBoard::DualNetworkBoard(gpio_num_t ml307_tx_pin, gpio_num_t ml307_rx_
     
     // 只初始化当前网络类型对应的板卡
     InitializeCurrentBoard();
+    active_board_.store(current_board_.get());
 }
 
 NetworkType DualNetworkBoard::LoadNetworkTypeFromSettings(int32_t default_net_type) {
@@ -58,7 +60,7 @@ void DualNetworkBoard::SwitchNetworkType() {
 
  
 std::string DualNetworkBoard::GetBoardType() {
-    return current_board_->GetBoardType();
+    return ActiveBoard()->GetBoardType();
 }
 
 void DualNetworkBoard::StartNetwork() {
@@ -70,24 +72,72 @@ void DualNetworkBoard::StartNetwork() {
         display->SetStatus(Lang::Strings::DETECTING_MODULE);
     }
     current_board_->StartNetwork();
+
+    // 主网络是WiFi时启动failover监控:预热备用4G并盯着WiFi连接状态
+    if (network_type_ == NetworkType::WIFI && ml307_tx_pin_ != GPIO_NUM_NC && failover_task_ == nullptr) {
+        xTaskCreate([](void* arg) {
+            static_cast<DualNetworkBoard*>(arg)->FailoverMonitorTask();
+            vTaskDelete(NULL);
+        }, "net_failover", 4096, this, 2, &failover_task_);
+    }
+}
+
+void DualNetworkBoard::FailoverMonitorTask() {
+    // 等开机流程过去再预热备用模组,不和启动抢总线/CPU
+    vTaskDelay(pdMS_TO_TICKS(10000));
+    ESP_LOGI(TAG, "Warming up standby 4G modem for failover");
+    standby_board_ = std::make_unique<Ml307Board>(ml307_tx_pin_, ml307_rx_pin_, ml307_dtr_pin_);
+    standby_board_->StartNetwork();  // 阻塞直到注册上网
+    ESP_LOGI(TAG, "Standby 4G modem ready");
+
+    auto& wifi_station = WifiStation::GetInstance();
+    int down_checks = 0;
+    int up_checks = 0;
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        bool wifi_ok = wifi_station.IsConnected();
+        if (!failover_to_standby_.load()) {
+            down_checks = wifi_ok ? 0 : down_checks + 1;
+            // 连续3秒失联就切到预热好的4G,迁移只是换活动接口+重连会话
+            if (down_checks >= 3) {
+                ESP_LOGW(TAG, "WiFi lost for %d s, failing over to 4G", down_checks);
+                active_board_.store(standby_board_.get());
+                failover_to_standby_.store(true);
+                down_checks = 0;
+                GetDisplay()->ShowNotification(Lang::Strings::SWITCH_TO_4G_NETWORK);
+                Application::GetInstance().OnNetworkMigrated();
+            }
+        } else {
+            up_checks = wifi_ok ? up_checks + 1 : 0;
+            // WiFi稳定5秒后切回(esp wifi栈会自动重连,这里只观察)
+            if (up_checks >= 5) {
+                ESP_LOGI(TAG, "WiFi recovered, failing back");
+                active_board_.store(current_board_.get());
+                failover_to_standby_.store(false);
+                up_checks = 0;
+                GetDisplay()->ShowNotification(Lang::Strings::SWITCH_TO_WIFI_NETWORK);
+                Application::GetInstance().OnNetworkMigrated();
+            }
+        }
+    }
 }
 
 NetworkInterface* DualNetworkBoard::GetNetwork() {
-    return current_board_->GetNetwork();
+    return ActiveBoard()->GetNetwork();
 }
 
 const char* DualNetworkBoard::GetNetworkStateIcon() {
-    return current_board_->GetNetworkStateIcon();
+    return ActiveBoard()->GetNetworkStateIcon();
 }
 
 void DualNetworkBoard::SetPowerSaveMode(bool enabled) {
-    current_board_->SetPowerSaveMode(enabled);
+    ActiveBoard()->SetPowerSaveMode(enabled);
 }
 
 std::string DualNetworkBoard::GetBoardJson() {   
-    return current_board_->GetBoardJson();
+    return ActiveBoard()->GetBoardJson();
 }
 
 std::string DualNetworkBoard::GetDeviceStatusJson() {
-    return current_board_->GetDeviceStatusJson();
+    return ActiveBoard()->GetDeviceStatusJson();
 }
@@ -4,6 +4,9 @@
 #include "board.h"
 #include "wifi_board.h"
 #include "ml307_board.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
 #include <memory>
 
 //enum NetworkType
@@ -19,6 +22,18 @@ private:
     std::unique_ptr<Board> current_board_;
     NetworkType network_type_ = NetworkType::ML307;  // Default to ML307
 
+    // make-before-break failover:主网络是WiFi时,后台把4G模组预热
+    // 注册好作为备用;WiFi失联几秒内把活动接口原子切换过去,
+    // WiFi恢复稳定后再切回。standby_board_一旦创建就不销毁,
+    // active_board_裸指针始终有效
+    std::unique_ptr<Board> standby_board_;
+    std::atomic<Board*> active_board_{nullptr};
+    std::atomic<bool> failover_to_standby_{false};
+    TaskHandle_t failover_task_ = nullptr;
+
+    Board* ActiveBoard() const { return active_board_.load(); }
+    void FailoverMonitorTask();
+
     // ML307的引脚配置
     gpio_num_t ml307_tx_pin_;
     gpio_num_t ml307_rx_pin_;
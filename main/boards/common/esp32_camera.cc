@@ -4,11 +4,13 @@
 #include "board.h"
 #include "system_info.h"
 #include "lvgl_display.h"
+#include "http_pool.h"
 #include "jpg/image_to_jpeg.h"
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
 #include <cstring>
+#include <atomic>
 
 #define TAG "Esp32Camera"
 
@@ -24,60 +26,147 @@ Esp32Camera::Esp32Camera(const camera_config_t& config) {
     if (s->id.PID == GC0308_PID) {
         s->set_hmirror(s, 0);  // 这里控制摄像头镜像 写1镜像 写0不镜像
     }
+    default_frame_size_ = config.frame_size;
+}
+
+// 把MCP传来的分辨率名映射到驱动的framesize,只对下一次拍照生效;
+// 传感器不支持任意ROI裁剪,用整帧降采样达到同样的省流量效果
+bool Esp32Camera::SetCaptureResolution(const std::string& resolution) {
+    if (resolution.empty() || resolution == "default") {
+        pending_frame_size_ = FRAMESIZE_INVALID;
+        return true;
+    }
+    static const struct {
+        const char* name;
+        framesize_t size;
+    } kSizes[] = {
+        {"qqvga", FRAMESIZE_QQVGA},
+        {"qvga",  FRAMESIZE_QVGA},
+        {"vga",   FRAMESIZE_VGA},
+        {"svga",  FRAMESIZE_SVGA},
+        {"xga",   FRAMESIZE_XGA},
+        {"hd",    FRAMESIZE_HD},
+    };
+    for (const auto& entry : kSizes) {
+        if (resolution == entry.name) {
+            pending_frame_size_ = entry.size;
+            return true;
+        }
+    }
+    ESP_LOGW(TAG, "Unknown capture resolution: %s", resolution.c_str());
+    return false;
 }
 
 Esp32Camera::~Esp32Camera() {
-    if (fb_) {
-        esp_camera_fb_return(fb_);
-        fb_ = nullptr;
+    if (encoder_thread_.joinable()) {
+        encoder_thread_.join();
+    }
+    for (auto& frame : frame_pool_) {
+        if (frame.data != nullptr) {
+            heap_caps_free(frame.data);
+            frame.data = nullptr;
+        }
     }
     esp_camera_deinit();
 }
 
+// 从池里找一个空闲槽位,容量不足时按需重新分配PSRAM;没有空闲槽位返回nullptr
+Esp32Camera::PooledFrame* Esp32Camera::AcquireFreeFrame(size_t need) {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    for (auto& frame : frame_pool_) {
+        if (frame.busy || &frame == current_frame_) {
+            continue;
+        }
+        if (frame.capacity < need) {
+            if (frame.data != nullptr) {
+                heap_caps_free(frame.data);
+            }
+            frame.data = (uint8_t*)heap_caps_malloc(need, MALLOC_CAP_SPIRAM);
+            frame.capacity = (frame.data != nullptr) ? need : 0;
+            if (frame.data == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate %u bytes for frame pool", (unsigned int)need);
+                continue;
+            }
+        }
+        return &frame;
+    }
+    return nullptr;
+}
+
 void Esp32Camera::SetExplainUrl(const std::string& url, const std::string& token) {
     explain_url_ = url;
     explain_token_ = token;
 }
 
 bool Esp32Camera::Capture() {
-    if (encoder_thread_.joinable()) {
-        encoder_thread_.join();
+    // 应用单次分辨率(若设置过);没设置时回到配置的默认分辨率
+    sensor_t* sensor = esp_camera_sensor_get();
+    framesize_t want = (pending_frame_size_ != FRAMESIZE_INVALID) ? pending_frame_size_ : default_frame_size_;
+    pending_frame_size_ = FRAMESIZE_INVALID;
+    if (sensor != nullptr && want != FRAMESIZE_INVALID && sensor->status.framesize != want) {
+        if (sensor->set_framesize(sensor, want) != 0) {
+            ESP_LOGW(TAG, "Failed to set frame size %d, keep current", (int)want);
+        }
     }
 
     auto start_time = esp_timer_get_time();
     int frames_to_get = 2;
     // Try to get a stable frame
+    camera_fb_t* fb = nullptr;
     for (int i = 0; i < frames_to_get; i++) {
-        if (fb_ != nullptr) {
-            esp_camera_fb_return(fb_);
+        if (fb != nullptr) {
+            esp_camera_fb_return(fb);
         }
-        fb_ = esp_camera_fb_get();
-        if (fb_ == nullptr) {
+        fb = esp_camera_fb_get();
+        if (fb == nullptr) {
             ESP_LOGE(TAG, "Camera capture failed");
             return false;
         }
     }
+
+    // 拷进池中空闲槽位后立刻归还驱动缓冲,传感器可以马上采下一帧;
+    // 所有槽位都被占用时(上一帧还在编码)等编码线程收尾腾出槽位
+    PooledFrame* frame = AcquireFreeFrame(fb->len);
+    if (frame == nullptr && encoder_thread_.joinable()) {
+        encoder_thread_.join();
+        frame = AcquireFreeFrame(fb->len);
+    }
+    if (frame == nullptr) {
+        ESP_LOGE(TAG, "No free frame in pool");
+        esp_camera_fb_return(fb);
+        return false;
+    }
+    memcpy(frame->data, fb->buf, fb->len);
+    frame->len = fb->len;
+    frame->width = fb->width;
+    frame->height = fb->height;
+    frame->format = fb->format;
+    esp_camera_fb_return(fb);
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        current_frame_ = frame;
+    }
     auto end_time = esp_timer_get_time();
     ESP_LOGI(TAG, "Camera captured %d frames in %d ms", frames_to_get, int((end_time - start_time) / 1000));
 
     // 显示预览图片
     auto display = dynamic_cast<LvglDisplay*>(Board::GetInstance().GetDisplay());
     if (display != nullptr) {
-        auto data = (uint8_t*)heap_caps_malloc(fb_->len, MALLOC_CAP_SPIRAM);
+        auto data = (uint8_t*)heap_caps_malloc(frame->len, MALLOC_CAP_SPIRAM);
         if (data == nullptr) {
             ESP_LOGE(TAG, "Failed to allocate memory for preview image");
             return false;
         }
 
-        auto src = (uint16_t*)fb_->buf;
+        auto src = (uint16_t*)frame->data;
         auto dst = (uint16_t*)data;
-        size_t pixel_count = fb_->len / 2;
+        size_t pixel_count = frame->len / 2;
         for (size_t i = 0; i < pixel_count; i++) {
             // 交换每个16位字内的字节
             dst[i] = __builtin_bswap16(src[i]);
         }
 
-        auto image = std::make_unique<LvglAllocatedImage>(data, fb_->len, fb_->width, fb_->height, fb_->width * 2, LV_COLOR_FORMAT_RGB565);
+        auto image = std::make_unique<LvglAllocatedImage>(data, frame->len, frame->width, frame->height, frame->width * 2, LV_COLOR_FORMAT_RGB565);
         display->SetPreviewImage(std::move(image));
     }
     return true;
@@ -145,30 +234,52 @@ std::string Esp32Camera::Explain(const std::string& question) {
         throw std::runtime_error("Image explain URL or token is not set");
     }
 
-    // 创建局部的 JPEG 队列, 40 entries is about to store 512 * 40 = 20480 bytes of JPEG data
-    QueueHandle_t jpeg_queue = xQueueCreate(40, sizeof(JpegChunk));
-    if (jpeg_queue == nullptr) {
-        ESP_LOGE(TAG, "Failed to create JPEG queue");
-        throw std::runtime_error("Failed to create JPEG queue");
+    // 取最近一次Capture的帧并标记占用,期间Capture会使用池中其它槽位
+    if (encoder_thread_.joinable()) {
+        encoder_thread_.join();
+    }
+    PooledFrame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        frame = current_frame_;
+        if (frame != nullptr) {
+            frame->busy = true;
+        }
+    }
+    if (frame == nullptr) {
+        throw std::runtime_error("No captured frame to explain");
     }
 
+    // 固定16KB的流式暂存:编码器写满即阻塞,发送端边收边发,
+    // 整张JPEG不再按块堆分配落在RAM里,峰值内存与图像大小无关
+    StreamBufferHandle_t jpeg_stream = xStreamBufferCreate(JPEG_STAGING_SIZE, 1);
+    if (jpeg_stream == nullptr) {
+        ESP_LOGE(TAG, "Failed to create JPEG stream buffer");
+        throw std::runtime_error("Failed to create JPEG stream buffer");
+    }
+    std::atomic<bool> encode_done{false};
+
     // We spawn a thread to encode the image to JPEG using optimized encoder (cost about 500ms and 8KB SRAM)
-    encoder_thread_ = std::thread([this, jpeg_queue]() {
-        image_to_jpeg_cb(fb_->buf, fb_->len, fb_->width, fb_->height, fb_->format, 80,
+    encoder_thread_ = std::thread([this, frame, jpeg_stream, &encode_done]() {
+        image_to_jpeg_cb(frame->data, frame->len, frame->width, frame->height, frame->format, 80,
             [](void* arg, size_t index, const void* data, size_t len) -> size_t {
-            auto jpeg_queue = (QueueHandle_t)arg;
-            JpegChunk chunk = {
-                .data = (uint8_t*)heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM),
-                .len = len
-            };
-            memcpy(chunk.data, data, len);
-            xQueueSend(jpeg_queue, &chunk, portMAX_DELAY);
+            auto stream = (StreamBufferHandle_t)arg;
+            // 暂存满时在这里阻塞,对编码器形成背压
+            size_t offset = 0;
+            while (offset < len) {
+                offset += xStreamBufferSend(stream, (const uint8_t*)data + offset, len - offset, portMAX_DELAY);
+            }
             return len;
-        }, jpeg_queue);
+        }, jpeg_stream);
+        encode_done = true;
+        // 编码完成,槽位归还给池子(上传只依赖暂存里的JPEG字节)
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        frame->busy = false;
     });
 
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(3);
+    // 拍照解释接口反复打同一台服务器,客户端走共享池:连发查询时
+    // 省掉每次约1秒的建连开销
+    auto http = HttpPool::GetInstance().Acquire("camera_explain", explain_url_, 3);
     // 构造multipart/form-data请求体
     std::string boundary = "----ESP32_CAMERA_BOUNDARY";
 
@@ -182,17 +293,13 @@ std::string Esp32Camera::Explain(const std::string& question) {
     http->SetHeader("Transfer-Encoding", "chunked");
     if (!http->Open("POST", explain_url_)) {
         ESP_LOGE(TAG, "Failed to connect to explain URL");
-        // Clear the queue
-        encoder_thread_.join();
-        JpegChunk chunk;
-        while (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) == pdPASS) {
-            if (chunk.data != nullptr) {
-                heap_caps_free(chunk.data);
-            } else {
-                break;
-            }
+        // 丢弃暂存里的数据,让阻塞中的编码线程跑完
+        uint8_t discard[256];
+        while (!encode_done || !xStreamBufferIsEmpty(jpeg_stream)) {
+            xStreamBufferReceive(jpeg_stream, discard, sizeof(discard), pdMS_TO_TICKS(20));
         }
-        vQueueDelete(jpeg_queue);
+        encoder_thread_.join();
+        vStreamBufferDelete(jpeg_stream);
         throw std::runtime_error("Failed to connect to explain URL");
     }
     
@@ -215,25 +322,34 @@ std::string Esp32Camera::Explain(const std::string& question) {
         http->Write(file_header.c_str(), file_header.size());
     }
 
-    // 第三块：JPEG数据
+    // 第三块：JPEG数据,从暂存直接写进socket,单次最多4KB
     size_t total_sent = 0;
-    while (true) {
-        JpegChunk chunk;
-        if (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to receive JPEG chunk");
-            break;
+    uint8_t* staging = (uint8_t*)heap_caps_malloc(4096, MALLOC_CAP_SPIRAM);
+    if (staging != nullptr) {
+        while (true) {
+            size_t n = xStreamBufferReceive(jpeg_stream, staging, 4096, pdMS_TO_TICKS(100));
+            if (n == 0) {
+                if (encode_done && xStreamBufferIsEmpty(jpeg_stream)) {
+                    break;  // 编码结束且暂存已排空
+                }
+                continue;
+            }
+            http->Write((const char*)staging, n);
+            total_sent += n;
         }
-        if (chunk.data == nullptr) {
-            break; // The last chunk
+        heap_caps_free(staging);
+    } else {
+        ESP_LOGE(TAG, "Failed to allocate staging buffer for upload");
+        // 丢弃数据疏通编码线程,避免join卡死
+        uint8_t discard[256];
+        while (!encode_done || !xStreamBufferIsEmpty(jpeg_stream)) {
+            xStreamBufferReceive(jpeg_stream, discard, sizeof(discard), pdMS_TO_TICKS(20));
         }
-        http->Write((const char*)chunk.data, chunk.len);
-        total_sent += chunk.len;
-        heap_caps_free(chunk.data);
     }
     // Wait for the encoder thread to finish
     encoder_thread_.join();
-    // 清理队列
-    vQueueDelete(jpeg_queue);
+    // 清理暂存
+    vStreamBufferDelete(jpeg_stream);
 
     {
         // 第四块：multipart尾部
@@ -255,6 +371,6 @@ std::string Esp32Camera::Explain(const std::string& question) {
     // Get remain task stack size
     size_t remain_stack_size = uxTaskGetStackHighWaterMark(nullptr);
     ESP_LOGI(TAG, "Explain image size=%dx%d, compressed size=%d, remain stack size=%d, question=%s\n%s",
-        fb_->width, fb_->height, total_sent, remain_stack_size, question.c_str(), result.c_str());
+        (int)frame->width, (int)frame->height, total_sent, remain_stack_size, question.c_str(), result.c_str());
     return result;
 }
@@ -5,24 +5,42 @@
 #include <lvgl.h>
 #include <thread>
 #include <memory>
+#include <mutex>
 
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <freertos/stream_buffer.h>
 
 #include "camera.h"
 
-struct JpegChunk {
-    uint8_t* data;
-    size_t len;
-};
-
 class Esp32Camera : public Camera {
 private:
-    camera_fb_t* fb_ = nullptr;
+    // JPEG流式上传的固定暂存上限:编码器写满即阻塞,峰值RAM与图像大小无关
+    static constexpr size_t JPEG_STAGING_SIZE = 16 * 1024;
+    // 帧缓冲池:Capture把传感器帧拷进池子后立刻归还驱动缓冲,
+    // 编码/上传线程用池中的帧,下一次Capture可与之重叠进行
+    struct PooledFrame {
+        uint8_t* data = nullptr;
+        size_t capacity = 0;       // 已分配的PSRAM大小,按需增长
+        size_t len = 0;
+        size_t width = 0;
+        size_t height = 0;
+        pixformat_t format = PIXFORMAT_RGB565;
+        bool busy = false;         // 编码线程占用中
+    };
+    static constexpr int FRAME_POOL_SIZE = 3;
+    PooledFrame frame_pool_[FRAME_POOL_SIZE];
+    std::mutex pool_mutex_;
+    PooledFrame* current_frame_ = nullptr;  // 最近一次Capture的帧
+    PooledFrame* AcquireFreeFrame(size_t need);
+
     std::string explain_url_;
     std::string explain_token_;
     std::thread encoder_thread_;
 
+    // 单次生效的拍照分辨率:pending只影响下一次Capture,拍完回落到配置的默认值
+    framesize_t default_frame_size_ = FRAMESIZE_INVALID;
+    framesize_t pending_frame_size_ = FRAMESIZE_INVALID;
+
 public:
     Esp32Camera(const camera_config_t& config);
     ~Esp32Camera();
@@ -33,6 +51,7 @@ public:
     virtual bool SetHMirror(bool enabled) override;
     virtual bool SetVFlip(bool enabled) override;
     virtual std::string Explain(const std::string& question);
+    virtual bool SetCaptureResolution(const std::string& resolution) override;
 };
 
 #endif // ESP32_CAMERA_H
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include "display/display.h"
 #include "server_config.h"
 #include "device_manager.h"
+#include "heap_telemetry.h"
+#include "http_pool.h"
+#include "flash_scheduler.h"
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
@@ -14,6 +17,8 @@
 #include <esp_timer.h>
 #include <mbedtls/sha256.h>
 #include <cJSON.h>
+#include <esp_dsp.h>
+#include <cmath>
 #include <cstring>
 #include <chrono>
 #include <sstream>
@@ -173,17 +178,152 @@ static std::string buildUrlWithParams(const std::string& base_url, const std::st
 }
 
 Esp32Music::Esp32Music() : last_downloaded_data_(), current_music_url_(), current_song_name_(),
-                         song_name_displayed_(false), current_lyric_url_(), lyrics_(), 
+                         song_name_displayed_(false), current_lyric_url_(), lyrics_snapshot_(),
                          current_lyric_index_(-1), lyric_thread_(), is_lyric_running_(false),
                          display_mode_(DISPLAY_MODE_LYRICS), is_playing_(false), is_downloading_(false), 
                          play_thread_(), download_thread_(), current_play_time_ms_(0), 
                          last_frame_time_ms_(0), total_frames_decoded_(0), current_song_duration_seconds_(0),
-                         audio_buffer_(), buffer_mutex_(), 
-                         buffer_cv_(), buffer_size_(0), mp3_decoder_(nullptr), mp3_frame_info_(), 
-                         mp3_decoder_initialized_(false), playlist_(), playlist_mutex_(),
+                         buffer_mutex_(),
+                         buffer_cv_(), buffer_size_(0), playlist_(), playlist_mutex_(),
                          current_playlist_index_(-1), playlist_mode_(false), playlist_thread_() {
     ESP_LOGI(TAG, "Music player initialized with default spectrum display mode");
-    InitializeMp3Decoder();
+    // 一次性预分配环形缓冲,后续下载/播放不再有按块堆分配
+    ring_buffer_ = (uint8_t*)heap_caps_malloc(MAX_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+    if (ring_buffer_ == nullptr) {
+        ring_buffer_ = (uint8_t*)heap_caps_malloc(MAX_BUFFER_SIZE, MALLOC_CAP_8BIT);
+    }
+    if (ring_buffer_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %d bytes for audio ring buffer", (int)MAX_BUFFER_SIZE);
+    } else {
+        HeapTelemetry::GetInstance().Track(kHeapTagMusic, MAX_BUFFER_SIZE);
+    }
+    InitializeFft();
+
+    // 可选的 flash 溢出层:分区表里有 music_spill 数据分区才启用
+    spill_partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                ESP_PARTITION_SUBTYPE_ANY, "music_spill");
+    if (spill_partition_ != nullptr) {
+        spill_xfer_buf_ = (uint8_t*)heap_caps_malloc(SPILL_SECTOR, MALLOC_CAP_SPIRAM);
+        if (spill_xfer_buf_ == nullptr) {
+            spill_xfer_buf_ = (uint8_t*)heap_caps_malloc(SPILL_SECTOR, MALLOC_CAP_8BIT);
+        }
+        if (spill_xfer_buf_ == nullptr) {
+            ESP_LOGW(TAG, "No memory for spill transfer buffer, flash spill disabled");
+            spill_partition_ = nullptr;
+        } else {
+            ESP_LOGI(TAG, "Flash spill buffer enabled: %u KB at 0x%x",
+                     (unsigned int)(spill_partition_->size / 1024),
+                     (unsigned int)spill_partition_->address);
+        }
+    }
+}
+
+// 调用方须持有 buffer_mutex_
+size_t Esp32Music::WriteRingLocked(const uint8_t* data, size_t len) {
+    size_t space = MAX_BUFFER_SIZE - buffer_size_;
+    size_t to_copy = std::min(len, space);
+    if (to_copy == 0) {
+        return 0;
+    }
+    // 回绕时分两段拷贝
+    size_t first = std::min(to_copy, MAX_BUFFER_SIZE - ring_tail_);
+    memcpy(ring_buffer_ + ring_tail_, data, first);
+    if (to_copy > first) {
+        memcpy(ring_buffer_, data + first, to_copy - first);
+    }
+    ring_tail_ = (ring_tail_ + to_copy) % MAX_BUFFER_SIZE;
+    buffer_size_ += to_copy;
+    ring_total_written_ += to_copy;
+    return to_copy;
+}
+
+// 调用方须持有 buffer_mutex_
+size_t Esp32Music::ReadRingLocked(uint8_t* out, size_t max_len) {
+    size_t to_copy = std::min(max_len, buffer_size_);
+    if (to_copy == 0) {
+        return 0;
+    }
+    size_t first = std::min(to_copy, MAX_BUFFER_SIZE - ring_head_);
+    memcpy(out, ring_buffer_ + ring_head_, first);
+    if (to_copy > first) {
+        memcpy(out + first, ring_buffer_, to_copy - first);
+    }
+    ring_head_ = (ring_head_ + to_copy) % MAX_BUFFER_SIZE;
+    buffer_size_ -= to_copy;
+    ring_total_read_ += to_copy;
+    return to_copy;
+}
+
+// 仅下载线程调用:把 RAM 环形缓冲装不下的压缩源字节顺序写入溢出分区。
+// 逻辑偏移单调递增、物理位置取模分区大小,整圈循环写天然均衡磨损;
+// 擦除前沿按扇区提前推进,保证写入落在已擦除区域。
+bool Esp32Music::SpillWrite(const uint8_t* data, size_t len) {
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    size_t cap = spill_partition_->size;
+    // 预留一个扇区,避免擦除前沿追上尚未读出的数据
+    if ((size_t)(spill_write_abs_ - spill_read_abs_) + len > cap - SPILL_SECTOR) {
+        return false;  // 溢出层也满了,由调用方退避
+    }
+    size_t remaining = len;
+    const uint8_t* p = data;
+    while (remaining > 0) {
+        size_t pos = (size_t)(spill_write_abs_ % cap);
+        size_t seg = std::min(remaining, cap - pos);  // 回绕处分段写
+        while (spill_erase_abs_ < spill_write_abs_ + seg) {
+            // 背景档:每片先等一小段音频空窗,和OTA/资产的擦除串行
+            esp_err_t err = FlashScheduler::GetInstance().EraseRange(
+                spill_partition_, (size_t)(spill_erase_abs_ % cap), SPILL_SECTOR,
+                FlashScheduler::Urgency::kBackground);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Spill erase failed at 0x%x: %d",
+                         (unsigned int)(spill_erase_abs_ % cap), err);
+                return false;
+            }
+            spill_erase_abs_ += SPILL_SECTOR;
+        }
+        esp_err_t err = esp_partition_write(spill_partition_, pos, p, seg);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Spill write failed at 0x%x: %d", (unsigned int)pos, err);
+            return false;
+        }
+        spill_write_abs_ += seg;
+        p += seg;
+        remaining -= seg;
+    }
+    spill_used_.store((size_t)(spill_write_abs_ - spill_read_abs_));
+    return true;
+}
+
+// 从溢出层按 FIFO 搬一块回 RAM 环形缓冲,返回实际搬运字节数。
+// 下载线程顺手调用、解码线程补货时调用,spill_mutex_ 保证同一时刻只有一个搬运者
+size_t Esp32Music::SpillReadToRing() {
+    if (spill_partition_ == nullptr || spill_used_.load() == 0) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> slock(spill_mutex_);
+    uint64_t avail = spill_write_abs_ - spill_read_abs_;
+    if (avail == 0) {
+        return 0;
+    }
+    size_t cap = spill_partition_->size;
+    size_t pos = (size_t)(spill_read_abs_ % cap);
+    size_t to_read = (size_t)std::min(avail, (uint64_t)SPILL_SECTOR);
+    to_read = std::min(to_read, cap - pos);  // 回绕处只读到分区末尾
+    if (esp_partition_read(spill_partition_, pos, spill_xfer_buf_, to_read) != ESP_OK) {
+        ESP_LOGE(TAG, "Spill read failed at 0x%x", (unsigned int)pos);
+        return 0;
+    }
+    size_t copied;
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex_);
+        copied = WriteRingLocked(spill_xfer_buf_, to_read);  // 环满时吃多少算多少,剩余下次再搬
+        if (copied > 0) {
+            buffer_cv_.notify_one();
+        }
+    }
+    spill_read_abs_ += copied;
+    spill_used_.store((size_t)(spill_write_abs_ - spill_read_abs_));
+    return copied;
 }
 
 Esp32Music::~Esp32Music() {
@@ -281,6 +421,16 @@ Esp32Music::~Esp32Music() {
         ESP_LOGI(TAG, "Playback thread finished");
     }
     
+    // 等待送出线程结束
+    if (output_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pcm_mutex_);
+            pcm_cv_.notify_all();
+        }
+        output_thread_.join();
+        ESP_LOGI(TAG, "Output thread finished");
+    }
+
     // 等待歌词线程结束
     if (lyric_thread_.joinable()) {
         ESP_LOGI(TAG, "Waiting for lyric thread to finish");
@@ -295,10 +445,20 @@ Esp32Music::~Esp32Music() {
         ESP_LOGI(TAG, "Playlist thread finished");
     }
     
-    // 清理缓冲区和MP3解码器
+    // 清理缓冲区和频谱资源(流解码器随播放线程的局部对象析构)
     ClearAudioBuffer();
-    CleanupMp3Decoder();
-    
+    CleanupFft();
+
+    if (ring_buffer_ != nullptr) {
+        heap_caps_free(ring_buffer_);
+        ring_buffer_ = nullptr;
+        HeapTelemetry::GetInstance().Untrack(kHeapTagMusic, MAX_BUFFER_SIZE);
+    }
+    if (spill_xfer_buf_ != nullptr) {
+        heap_caps_free(spill_xfer_buf_);
+        spill_xfer_buf_ = nullptr;
+    }
+
     ESP_LOGI(TAG, "Music player destroyed successfully");
 }
 
@@ -319,10 +479,9 @@ bool Esp32Music::Download(const std::string& song_name, const std::string& artis
     
     ESP_LOGI(TAG, "Request URL: %s", full_url.c_str());
     
-    // 使用Board提供的HTTP客户端
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(0);
-    
+    // 使用共享HTTP池:点歌接口每次都打同一台音乐服务器
+    auto http = HttpPool::GetInstance().Acquire("music_api", full_url);
+
     // 设置基本请求头
     http->SetHeader("User-Agent", "ESP32-Music-Player/1.0");
     http->SetHeader("Accept", "application/json");
@@ -419,7 +578,7 @@ bool Esp32Music::Download(const std::string& song_name, const std::string& artis
                         
                         is_lyric_running_ = true;
                         current_lyric_index_ = -1;
-                        lyrics_.clear();
+                        std::atomic_store(&lyrics_snapshot_, std::shared_ptr<const LyricLines>());
                         
                         lyric_thread_ = std::thread(&Esp32Music::LyricDisplayThread, this);
                     } else {
@@ -482,7 +641,14 @@ bool Esp32Music::StartStreaming(const std::string& music_url) {
         }
         play_thread_.join();
     }
-    
+    if (output_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pcm_mutex_);
+            pcm_cv_.notify_all();  // 通知线程退出
+        }
+        output_thread_.join();
+    }
+
     // 清空缓冲区
     ClearAudioBuffer();
     
@@ -491,16 +657,31 @@ bool Esp32Music::StartStreaming(const std::string& music_url) {
     cfg.stack_size = 8192;  // 8KB栈大小
     cfg.prio = 5;           // 中等优先级
     cfg.thread_name = "audio_stream";
+#if !CONFIG_FREERTOS_UNICORE
+    cfg.pin_to_core = 0;    // 下载/送出线程留在核 0
+#endif
     esp_pthread_set_cfg(&cfg);
-    
+
     // 开始下载线程
     is_downloading_ = true;
     download_thread_ = std::thread(&Esp32Music::DownloadAudioStream, this, music_url);
-    
-    // 开始播放线程（会等待缓冲区有足够数据）
+
+    // 先置位播放标志,送出线程的退出条件依赖它
     is_playing_ = true;
+
+    // 送出线程:只负责把前瞻队列里的 PCM 交给 codec
+    cfg.thread_name = "music_output";
+    esp_pthread_set_cfg(&cfg);
+    output_thread_ = std::thread(&Esp32Music::OutputAudioStream, this);
+
+    // 解码线程:多核时独占核 1,显示/网络任务突发不再打断解码
+    cfg.thread_name = "music_decode";
+#if !CONFIG_FREERTOS_UNICORE
+    cfg.pin_to_core = 1;
+#endif
+    esp_pthread_set_cfg(&cfg);
     play_thread_ = std::thread(&Esp32Music::PlayAudioStream, this);
-    
+
     ESP_LOGI(TAG, "Streaming threads started successfully");
     
     return true;
@@ -581,7 +762,17 @@ bool Esp32Music::StopStreaming() {
             }
         }
     }
-    
+
+    // 等待送出线程结束
+    if (output_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pcm_mutex_);
+            pcm_cv_.notify_all();
+        }
+        output_thread_.join();
+        ESP_LOGI(TAG, "Output thread joined in StopStreaming");
+    }
+
     // 在线程完全结束后，只在频谱模式下停止FFT显示
     if (display && display_mode_ == DISPLAY_MODE_SPECTRUM) {
         display->stopFft();
@@ -594,6 +785,28 @@ bool Esp32Music::StopStreaming() {
     return true;
 }
 
+// 预取下一首:当前曲目还在播时登记下一首的URL,下载线程收完当前曲目后
+// 直接把下一首续写进环形缓冲的空余容量,切歌不再经历停线程/清缓冲/重建
+bool Esp32Music::PrefetchNext(const std::string& music_url) {
+    if (music_url.empty() || music_url.find("http") != 0) {
+        ESP_LOGE(TAG, "Invalid prefetch URL format: %s", music_url.c_str());
+        return false;
+    }
+
+    // 没有进行中的播放就退化成正常起播
+    if (!is_playing_.load() && !is_downloading_.load()) {
+        ESP_LOGI(TAG, "No active playback, starting stream directly");
+        return StartStreaming(music_url);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        prefetch_url_ = music_url;
+    }
+    ESP_LOGI(TAG, "Prefetch registered for next track");
+    return true;
+}
+
 // 流式下载音频数据
 void Esp32Music::DownloadAudioStream(const std::string& music_url) {
     ESP_LOGD(TAG, "Starting audio stream download from: %s", music_url.c_str());
@@ -604,115 +817,217 @@ void Esp32Music::DownloadAudioStream(const std::string& music_url) {
         is_downloading_ = false;
         return;
     }
-    
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(0);
-    
-    // 设置基本请求头
-    http->SetHeader("User-Agent", "ESP32-Music-Player/1.0");
-    http->SetHeader("Accept", "*/*");
-    http->SetHeader("Range", "bytes=0-");  // 支持断点续传
-    
-    // 添加ESP32认证头
-    add_auth_headers(http.get());
-    
-    if (!http->Open("GET", music_url)) {
-        ESP_LOGE(TAG, "Failed to connect to music stream URL");
-        is_downloading_ = false;
-        return;
-    }
-    
-    int status_code = http->GetStatusCode();
-    if (status_code != 200 && status_code != 206) {  // 206 for partial content
-        ESP_LOGE(TAG, "HTTP GET failed with status code: %d", status_code);
-        http->Close();
+
+    if (ring_buffer_ == nullptr) {
+        ESP_LOGE(TAG, "Audio ring buffer not allocated");
         is_downloading_ = false;
         return;
     }
     
-    ESP_LOGI(TAG, "Started downloading audio stream, status: %d", status_code);
-    
     // 分块读取音频数据
     const size_t chunk_size = 4096;  // 4KB每块
     char buffer[chunk_size];
-    size_t total_downloaded = 0;
-    
-    while (is_downloading_ && is_playing_) {
-        int bytes_read = http->Read(buffer, chunk_size);
-        if (bytes_read < 0) {
-            ESP_LOGE(TAG, "Failed to read audio data: error code %d", bytes_read);
-            break;
+    size_t total_downloaded = 0;  // 已写入缓冲的字节数,也是断线重连的续传偏移
+    const int max_reconnect_attempts = 5;
+    int reconnect_attempts = 0;
+    bool stream_finished = false;
+    std::string url = music_url;  // 预取衔接下一首时原地换URL
+
+    // 断点续传:连接失败或中途断流时带 Range: bytes=N- 重连,
+    // 环形缓冲(CONFIG_MUSIC_READAHEAD_KB)里的预读数据足够撑过重连间隙
+    while (is_downloading_ && is_playing_ && !stream_finished) {
+        // 重连和切歌走池:同一音乐服务器,省掉每次断点续传的重建成本
+        auto http = HttpPool::GetInstance().Acquire("music_stream", url);
+
+        // 设置基本请求头
+        http->SetHeader("User-Agent", "ESP32-Music-Player/1.0");
+        http->SetHeader("Accept", "*/*");
+        char range_header[48];
+        snprintf(range_header, sizeof(range_header), "bytes=%u-", (unsigned int)total_downloaded);
+        http->SetHeader("Range", range_header);  // 支持断点续传
+
+        // 添加ESP32认证头
+        add_auth_headers(http.get());
+
+        if (!http->Open("GET", url)) {
+            ESP_LOGE(TAG, "Failed to connect to music stream URL (attempt %d/%d)",
+                     reconnect_attempts + 1, max_reconnect_attempts);
+            if (++reconnect_attempts >= max_reconnect_attempts) {
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(500 * reconnect_attempts));
+            continue;
         }
-        if (bytes_read == 0) {
-            ESP_LOGI(TAG, "Audio stream download completed, total: %d bytes", total_downloaded);
+
+        int status_code = http->GetStatusCode();
+        if (status_code == 200 && total_downloaded > 0) {
+            // 服务器忽略了 Range 头,从头重发会污染解码流,只能放弃这首歌
+            ESP_LOGE(TAG, "Server ignored Range request at offset %u, cannot resume",
+                     (unsigned int)total_downloaded);
+            http->Close();
             break;
         }
-        
-        // 打印数据块信息
-        // ESP_LOGI(TAG, "Downloaded chunk: %d bytes at offset %d", bytes_read, total_downloaded);
-        
-        // 安全地打印数据块的十六进制内容（前16字节）
-        if (bytes_read >= 16) {
-            // ESP_LOGI(TAG, "Data: %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X ...", 
-            //         (unsigned char)buffer[0], (unsigned char)buffer[1], (unsigned char)buffer[2], (unsigned char)buffer[3],
-            //         (unsigned char)buffer[4], (unsigned char)buffer[5], (unsigned char)buffer[6], (unsigned char)buffer[7],
-            //         (unsigned char)buffer[8], (unsigned char)buffer[9], (unsigned char)buffer[10], (unsigned char)buffer[11],
-            //         (unsigned char)buffer[12], (unsigned char)buffer[13], (unsigned char)buffer[14], (unsigned char)buffer[15]);
-        } else {
-            ESP_LOGI(TAG, "Data chunk too small: %d bytes", bytes_read);
+        if (status_code != 200 && status_code != 206) {  // 206 for partial content
+            ESP_LOGE(TAG, "HTTP GET failed with status code: %d", status_code);
+            http->Close();
+            if (++reconnect_attempts >= max_reconnect_attempts) {
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(500 * reconnect_attempts));
+            continue;
         }
+
+        ESP_LOGI(TAG, "Started downloading audio stream at offset %u, status: %d",
+                 (unsigned int)total_downloaded, status_code);
+
+        while (is_downloading_ && is_playing_) {
+            int bytes_read = http->Read(buffer, chunk_size);
+            if (bytes_read < 0) {
+                ESP_LOGE(TAG, "Failed to read audio data: error code %d, reconnecting from offset %u",
+                         bytes_read, (unsigned int)total_downloaded);
+                break;  // 跳出读循环,外层带 Range 重连续传
+            }
+            if (bytes_read == 0) {
+                ESP_LOGI(TAG, "Audio stream download completed, total: %d bytes", total_downloaded);
+                stream_finished = true;
+                break;
+            }
+
+            reconnect_attempts = 0;  // 读到数据即认为链路已恢复
+
+            // 打印数据块信息
+            // ESP_LOGI(TAG, "Downloaded chunk: %d bytes at offset %d", bytes_read, total_downloaded);
         
-        // 尝试检测文件格式（检查文件头）
-        if (total_downloaded == 0 && bytes_read >= 4) {
-            if (memcmp(buffer, "ID3", 3) == 0) {
-                ESP_LOGI(TAG, "Detected MP3 file with ID3 tag");
-            } else if (buffer[0] == 0xFF && (buffer[1] & 0xE0) == 0xE0) {
-                ESP_LOGI(TAG, "Detected MP3 file header");
-            } else if (memcmp(buffer, "RIFF", 4) == 0) {
-                ESP_LOGI(TAG, "Detected WAV file");
-            } else if (memcmp(buffer, "fLaC", 4) == 0) {
-                ESP_LOGI(TAG, "Detected FLAC file");
-            } else if (memcmp(buffer, "OggS", 4) == 0) {
-                ESP_LOGI(TAG, "Detected OGG file");
+            // 安全地打印数据块的十六进制内容（前16字节）
+            if (bytes_read >= 16) {
+                // ESP_LOGI(TAG, "Data: %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X ...", 
+                //         (unsigned char)buffer[0], (unsigned char)buffer[1], (unsigned char)buffer[2], (unsigned char)buffer[3],
+                //         (unsigned char)buffer[4], (unsigned char)buffer[5], (unsigned char)buffer[6], (unsigned char)buffer[7],
+                //         (unsigned char)buffer[8], (unsigned char)buffer[9], (unsigned char)buffer[10], (unsigned char)buffer[11],
+                //         (unsigned char)buffer[12], (unsigned char)buffer[13], (unsigned char)buffer[14], (unsigned char)buffer[15]);
             } else {
-                ESP_LOGI(TAG, "Unknown audio format, first 4 bytes: %02X %02X %02X %02X", 
-                        (unsigned char)buffer[0], (unsigned char)buffer[1], 
-                        (unsigned char)buffer[2], (unsigned char)buffer[3]);
+                ESP_LOGI(TAG, "Data chunk too small: %d bytes", bytes_read);
             }
-        }
         
-        // 创建音频数据块
-        uint8_t* chunk_data = (uint8_t*)heap_caps_malloc(bytes_read, MALLOC_CAP_SPIRAM);
-        if (!chunk_data) {
-            ESP_LOGE(TAG, "Failed to allocate memory for audio chunk");
-            break;
-        }
-        memcpy(chunk_data, buffer, bytes_read);
+            // 尝试检测文件格式（检查文件头）
+            if (total_downloaded == 0 && bytes_read >= 4) {
+                if (memcmp(buffer, "ID3", 3) == 0) {
+                    ESP_LOGI(TAG, "Detected MP3 file with ID3 tag");
+                } else if (buffer[0] == 0xFF && (buffer[1] & 0xE0) == 0xE0) {
+                    ESP_LOGI(TAG, "Detected MP3 file header");
+                } else if (memcmp(buffer, "RIFF", 4) == 0) {
+                    ESP_LOGI(TAG, "Detected WAV file");
+                } else if (memcmp(buffer, "fLaC", 4) == 0) {
+                    ESP_LOGI(TAG, "Detected FLAC file");
+                } else if (memcmp(buffer, "OggS", 4) == 0) {
+                    ESP_LOGI(TAG, "Detected OGG file");
+                } else {
+                    ESP_LOGI(TAG, "Unknown audio format, first 4 bytes: %02X %02X %02X %02X", 
+                            (unsigned char)buffer[0], (unsigned char)buffer[1], 
+                            (unsigned char)buffer[2], (unsigned char)buffer[3]);
+                }
+            }
         
-        // 等待缓冲区有空间
-        {
-            std::unique_lock<std::mutex> lock(buffer_mutex_);
-            buffer_cv_.wait(lock, [this] { return buffer_size_ < MAX_BUFFER_SIZE || !is_downloading_; });
-            
-            if (is_downloading_) {
-                audio_buffer_.push(AudioChunk(chunk_data, bytes_read));
-                buffer_size_ += bytes_read;
-                total_downloaded += bytes_read;
-                
-                // 通知播放线程有新数据
-                buffer_cv_.notify_one();
-                
+            // 写入环形缓冲;RAM 满时转入 flash 溢出层,两层都满才等待(水位背压)
+            size_t written = 0;
+            bool stopped = false;
+            while (written < (size_t)bytes_read) {
+                if (!is_downloading_) {
+                    stopped = true;
+                    break;
+                }
+
+                // 溢出层有积压时新字节必须继续走溢出层,保证字节到达顺序
+                if (spill_partition_ != nullptr && spill_used_.load() > 0) {
+                    if (SpillWrite((const uint8_t*)buffer + written, bytes_read - written)) {
+                        total_downloaded += bytes_read - written;
+                        written = bytes_read;
+                    } else if (SpillReadToRing() == 0) {
+                        // 溢出层满且环形缓冲也腾不出空间,小睡等播放端消费
+                        vTaskDelay(pdMS_TO_TICKS(20));
+                    }
+                    continue;
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock(buffer_mutex_);
+                    if (spill_partition_ == nullptr) {
+                        buffer_cv_.wait(lock, [this] { return buffer_size_ < MAX_BUFFER_SIZE || !is_downloading_; });
+                        if (!is_downloading_) {
+                            stopped = true;
+                            break;
+                        }
+                    }
+
+                    size_t copied = WriteRingLocked((const uint8_t*)buffer + written, bytes_read - written);
+                    written += copied;
+                    total_downloaded += copied;
+
+                    if (copied > 0) {
+                        // 通知播放线程有新数据
+                        buffer_cv_.notify_one();
+                    }
+                }
+
                 if (total_downloaded % (256 * 1024) == 0) {  // 每256KB打印一次进度
                     ESP_LOGI(TAG, "Downloaded %d bytes, buffer size: %d", total_downloaded, buffer_size_);
                 }
-            } else {
-                heap_caps_free(chunk_data);
+
+                // 环形缓冲满且配有溢出层:余下字节开始写 flash
+                if (written < (size_t)bytes_read && spill_partition_ != nullptr) {
+                    if (SpillWrite((const uint8_t*)buffer + written, bytes_read - written)) {
+                        total_downloaded += bytes_read - written;
+                        written = bytes_read;
+                    } else {
+                        vTaskDelay(pdMS_TO_TICKS(20));
+                    }
+                }
+            }
+            if (stopped) {
+                break;
+            }
+        }
+
+        http->Close();
+
+        // 当前曲目收完:若登记了预取的下一首,记下轨道边界后原地衔接继续下载,
+        // 线程和环形缓冲跨曲目复用,解码端读到边界时自行完成切换
+        if (stream_finished && is_downloading_ && is_playing_) {
+            std::string next_url;
+            {
+                std::lock_guard<std::mutex> plock(prefetch_mutex_);
+                next_url.swap(prefetch_url_);
+            }
+            if (!next_url.empty()) {
+                {
+                    // 边界按"进入环形缓冲的累计偏移"记;溢出层积压的字节还没进环,
+                    // 要加上。加锁顺序与 SpillReadToRing 一致:先 spill 后 buffer
+                    std::lock_guard<std::mutex> slock(spill_mutex_);
+                    std::lock_guard<std::mutex> block(buffer_mutex_);
+                    track_boundaries_.push(ring_total_written_ +
+                                           (size_t)(spill_write_abs_ - spill_read_abs_));
+                    buffer_cv_.notify_all();
+                }
+                ESP_LOGI(TAG, "Track finished (%u bytes), continuing with prefetched next track",
+                         (unsigned int)total_downloaded);
+                url = next_url;
+                total_downloaded = 0;
+                reconnect_attempts = 0;
+                stream_finished = false;
+                continue;
+            }
+        }
+
+        // 中途断流(非正常结束、非主动停止)时退避后重连续传
+        if (!stream_finished && is_downloading_ && is_playing_) {
+            if (++reconnect_attempts >= max_reconnect_attempts) {
+                ESP_LOGE(TAG, "Giving up after %d reconnect attempts", max_reconnect_attempts);
                 break;
             }
+            vTaskDelay(pdMS_TO_TICKS(500 * reconnect_attempts));
         }
     }
-    
-    http->Close();
+
     is_downloading_ = false;
     
     // 通知播放线程下载完成
@@ -740,18 +1055,11 @@ void Esp32Music::PlayAudioStream() {
         return;
     }
     
-    if (!mp3_decoder_initialized_) {
-        ESP_LOGE(TAG, "MP3 decoder not initialized");
-        is_playing_ = false;
-        return;
-    }
-    
-    
     // 等待缓冲区有足够数据开始播放
     {
         std::unique_lock<std::mutex> lock(buffer_mutex_);
         buffer_cv_.wait(lock, [this] { 
-            return buffer_size_ >= MIN_BUFFER_SIZE || (!is_downloading_ && !audio_buffer_.empty()); 
+            return buffer_size_ >= MIN_BUFFER_SIZE || (!is_downloading_ && buffer_size_ > 0); 
         });
     }
     
@@ -760,41 +1068,47 @@ void Esp32Music::PlayAudioStream() {
     ESP_LOGI(TAG, "Starting playback with buffer size: %d", buffer_size_);
     
     size_t total_played = 0;
-    uint8_t* mp3_input_buffer = nullptr;
+    // 解码侧曲目内位置:只用来给每个 PCM 帧打时间戳,
+    // 对外的播放位置由送出线程按真正交给 codec 的帧推进
+    int64_t decode_position_ms = 0;
+    uint8_t* input_buffer = nullptr;
     int bytes_left = 0;
     uint8_t* read_ptr = nullptr;
-    
-    // 分配MP3输入缓冲区
-    mp3_input_buffer = (uint8_t*)heap_caps_malloc(8192, MALLOC_CAP_SPIRAM);
-    if (!mp3_input_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate MP3 input buffer");
+
+    // 压缩流输入缓冲:要装得下最大的Ogg页,比单个MP3帧大不少
+    const size_t input_buffer_size = 32 * 1024;
+    input_buffer = (uint8_t*)heap_caps_malloc(input_buffer_size, MALLOC_CAP_SPIRAM);
+    if (!input_buffer) {
+        ESP_LOGE(TAG, "Failed to allocate stream input buffer");
         is_playing_ = false;
         return;
     }
-    
+
+    // 流解码器按首帧字节嗅探格式创建(MP3 / Ogg-Opus)
+    std::unique_ptr<MusicDecoder> decoder;
+
     // 标记是否已经处理过ID3标签
     bool id3_processed = false;
+    // 解码器消费不动且缓冲已填满时置位,触发强制续填判定
+    bool need_more_data = false;
     
     while (is_playing_) {
         // 检查设备状态，只有在空闲状态才播放音乐
         auto& app = Application::GetInstance();
         DeviceState current_state = app.GetDeviceState();
         
-        // 状态转换：说话中-》聆听中-》待机状态-》播放音乐
-        if (current_state == kDeviceStateListening || current_state == kDeviceStateSpeaking) {
-            if (current_state == kDeviceStateSpeaking) {
-                ESP_LOGI(TAG, "Device is in speaking state, switching to listening state for music playback");
-            }
-            if (current_state == kDeviceStateListening) {
-                ESP_LOGI(TAG, "Device is in listening state, switching to idle state for music playback");
-            }
+        // 状态转换：聆听中-》待机状态-》播放音乐。说话中不再打断：解码
+        // 继续跑，送出的帧由AudioService低混(ducking)在TTS下面，回到
+        // 待机立即原音量续播，去掉以前每次对话后的重缓冲停顿
+        if (current_state == kDeviceStateListening) {
+            ESP_LOGI(TAG, "Device is in listening state, switching to idle state for music playback");
             // 切换状态
             app.ToggleChatState(); // 变成待机状态
             vTaskDelay(pdMS_TO_TICKS(300));
             continue;
-        } else if (current_state != kDeviceStateIdle) { // 不是待机状态，就一直卡在这里，不让播放音乐
+        } else if (current_state != kDeviceStateIdle && current_state != kDeviceStateSpeaking) {
+            // 其他状态（配网、升级等）依旧卡在这里，不让播放音乐
             ESP_LOGD(TAG, "Device state is %d, pausing music playback", current_state);
-            // 如果不是空闲状态，暂停播放
             vTaskDelay(pdMS_TO_TICKS(50));
             continue;
         }
@@ -822,50 +1136,72 @@ void Esp32Music::PlayAudioStream() {
             }
         }
         
-        // 如果需要更多MP3数据，从缓冲区读取
-        if (bytes_left < 4096) {  // 保持至少4KB数据用于解码
-            AudioChunk chunk;
-            
-            // 从缓冲区获取音频数据
+        // 如果需要更多压缩数据，从环形缓冲读取
+        if (bytes_left < 4096 || need_more_data) {  // 保持至少4KB数据用于解码
+            need_more_data = false;
+            // 先把残留数据挪到缓冲区开头,腾出连续空间
+            if (bytes_left > 0 && read_ptr != input_buffer) {
+                memmove(input_buffer, read_ptr, bytes_left);
+            }
+            read_ptr = input_buffer;
+
+            size_t space_available = input_buffer_size - bytes_left;
+            size_t copied = 0;
+
+            // 溢出层有积压就先搬一块进环(下载结束后这里是唯一的搬运者)
+            SpillReadToRing();
+
+            // 从环形缓冲直接填充解码输入,无中间分配
             {
                 std::unique_lock<std::mutex> lock(buffer_mutex_);
-                if (audio_buffer_.empty()) {
-                    if (!is_downloading_) {
-                        // 下载完成且缓冲区为空，播放结束
-                        ESP_LOGI(TAG, "Playback finished, total played: %d bytes", total_played);
-                        break;
+
+                // 预取切歌:读取不越过轨道边界;残留吃完即跨界,重置每曲目状态
+                size_t read_cap = space_available;
+                if (!track_boundaries_.empty()) {
+                    size_t boundary = track_boundaries_.front();
+                    if (ring_total_read_ >= boundary) {
+                        if (bytes_left == 0) {
+                            track_boundaries_.pop();
+                            decode_position_ms = 0;
+                            current_play_time_ms_ = 0;
+                            last_frame_time_ms_ = 0;
+                            total_frames_decoded_ = 0;
+                            current_song_duration_seconds_ = 0;
+                            id3_processed = false;  // 下一曲开头可能带ID3标签
+                            decoder.reset();        // 下一曲可能换格式,重新嗅探
+                            ESP_LOGI(TAG, "Crossed track boundary into prefetched song");
+                        } else {
+                            read_cap = 0;  // 先让解码器吃完上一曲的残留
+                        }
+                    } else {
+                        read_cap = std::min(read_cap, boundary - ring_total_read_);
                     }
-                    // 等待新数据
-                    buffer_cv_.wait(lock, [this] { return !audio_buffer_.empty() || !is_downloading_; });
-                    if (audio_buffer_.empty()) {
-                        continue;
+                }
+
+                if (read_cap > 0) {
+                    if (buffer_size_ == 0) {
+                        if (!is_downloading_ && spill_used_.load() == 0) {
+                            // 下载完成、溢出层排空且缓冲区为空，播放结束
+                            ESP_LOGI(TAG, "Playback finished, total played: %d bytes", total_played);
+                            break;
+                        }
+                        // 等待新数据
+                        buffer_cv_.wait(lock, [this] { return buffer_size_ > 0 || !is_downloading_; });
+                        if (buffer_size_ == 0) {
+                            continue;
+                        }
                     }
+
+                    copied = ReadRingLocked(input_buffer + bytes_left, read_cap);
+
+                    // 通知下载线程缓冲区有空间
+                    buffer_cv_.notify_one();
                 }
-                
-                chunk = audio_buffer_.front();
-                audio_buffer_.pop();
-                buffer_size_ -= chunk.size;
-                
-                // 通知下载线程缓冲区有空间
-                buffer_cv_.notify_one();
             }
-            
-            // 将新数据添加到MP3输入缓冲区
-            if (chunk.data && chunk.size > 0) {
-                // 移动剩余数据到缓冲区开头
-                if (bytes_left > 0 && read_ptr != mp3_input_buffer) {
-                    memmove(mp3_input_buffer, read_ptr, bytes_left);
-                }
-                
-                // 检查缓冲区空间
-                size_t space_available = 8192 - bytes_left;
-                size_t copy_size = std::min(chunk.size, space_available);
-                
-                // 复制新数据
-                memcpy(mp3_input_buffer + bytes_left, chunk.data, copy_size);
-                bytes_left += copy_size;
-                read_ptr = mp3_input_buffer;
-                
+
+            if (copied > 0) {
+                bytes_left += copied;
+
                 // 检查并跳过ID3标签（仅在开始时处理一次）
                 if (!id3_processed && bytes_left >= 10) {
                     size_t id3_skip = SkipId3Tag(read_ptr, bytes_left);
@@ -876,145 +1212,133 @@ void Esp32Music::PlayAudioStream() {
                     }
                     id3_processed = true;
                 }
-                
-                // 释放chunk内存
-                heap_caps_free(chunk.data);
             }
         }
         
-        // 尝试找到MP3帧同步
-        int sync_offset = MP3FindSyncWord(read_ptr, bytes_left);
-        if (sync_offset < 0) {
-            ESP_LOGW(TAG, "No MP3 sync word found, skipping %d bytes", bytes_left);
-            bytes_left = 0;
+        if (bytes_left <= 0) {
             continue;
         }
-        
-        // 跳过到同步位置
-        if (sync_offset > 0) {
-            read_ptr += sync_offset;
-            bytes_left -= sync_offset;
+
+        // 首帧前按流头嗅探格式;切歌跨界后decoder被重置,下一曲重新嗅探
+        if (decoder == nullptr) {
+            decoder = MusicDecoder::CreateForStream(read_ptr, bytes_left);
+            ESP_LOGI(TAG, "Using %s decoder for music stream", decoder->name());
         }
-        
-        // 解码MP3帧
-        int16_t pcm_buffer[2304];
-        int decode_result = MP3Decode(mp3_decoder_, &read_ptr, &bytes_left, pcm_buffer, 0);
-        
-        if (decode_result == 0) {
-            // 解码成功，获取帧信息
-            MP3GetLastFrameInfo(mp3_decoder_, &mp3_frame_info_);
-            total_frames_decoded_++;
-            
-            // 基本的帧信息有效性检查，防止除零错误
-            if (mp3_frame_info_.samprate == 0 || mp3_frame_info_.nChans == 0) {
-                ESP_LOGW(TAG, "Invalid frame info: rate=%d, channels=%d, skipping", 
-                        mp3_frame_info_.samprate, mp3_frame_info_.nChans);
-                continue;
-            }
-            
-            // 计算当前帧的持续时间(毫秒)
-            int frame_duration_ms = (mp3_frame_info_.outputSamps * 1000) / 
-                                  (mp3_frame_info_.samprate * mp3_frame_info_.nChans);
-            
-            // 更新当前播放时间
-            current_play_time_ms_ += frame_duration_ms;
-            
-            ESP_LOGD(TAG, "Frame %d: time=%lldms, duration=%dms, rate=%d, ch=%d", 
-                    total_frames_decoded_, current_play_time_ms_, frame_duration_ms,
-                    mp3_frame_info_.samprate, mp3_frame_info_.nChans);
-            
-            // 更新歌词显示
-            int buffer_latency_ms = 600; // 实测调整值
-            UpdateLyricDisplay(current_play_time_ms_ + buffer_latency_ms);
-            
-            // 将PCM数据发送到Application的音频解码队列
-            if (mp3_frame_info_.outputSamps > 0) {
-                int16_t* final_pcm_data = pcm_buffer;
-                int final_sample_count = mp3_frame_info_.outputSamps;
-                std::vector<int16_t> mono_buffer;
-                
-                // 如果是双通道，转换为单通道混合
-                if (mp3_frame_info_.nChans == 2) {
-                    // 双通道转单通道：将左右声道混合
-                    int stereo_samples = mp3_frame_info_.outputSamps;  // 包含左右声道的总样本数
-                    int mono_samples = stereo_samples / 2;  // 实际的单声道样本数
-                    
-                    mono_buffer.resize(mono_samples);
-                    
-                    for (int i = 0; i < mono_samples; ++i) {
-                        // 混合左右声道 (L + R) / 2
-                        int left = pcm_buffer[i * 2];      // 左声道
-                        int right = pcm_buffer[i * 2 + 1]; // 右声道
-                        mono_buffer[i] = (int16_t)((left + right) / 2);
-                    }
-                    
-                    final_pcm_data = mono_buffer.data();
-                    final_sample_count = mono_samples;
-
-                    ESP_LOGD(TAG, "Converted stereo to mono: %d -> %d samples", 
-                            stereo_samples, mono_samples);
-                } else if (mp3_frame_info_.nChans == 1) {
-                    // 已经是单声道，无需转换
-                    ESP_LOGD(TAG, "Already mono audio: %d samples", final_sample_count);
+
+        // 解码一帧(同步字查找/容器拆包都在解码器内部)
+        std::vector<int16_t> frame_pcm;
+        int sample_rate = 0;
+        int channels = 0;
+        size_t consumed = decoder->DecodeFrame(read_ptr, bytes_left, frame_pcm, sample_rate, channels);
+        read_ptr += consumed;
+        bytes_left -= (int)consumed;
+
+        if (frame_pcm.empty()) {
+            if (consumed == 0) {
+                if ((size_t)bytes_left >= input_buffer_size) {
+                    // 输入缓冲已满仍解不出帧,丢一个字节避免卡死
+                    ESP_LOGW(TAG, "Decoder stalled with full buffer, skipping one byte");
+                    read_ptr++;
+                    bytes_left--;
                 } else {
-                    ESP_LOGW(TAG, "Unsupported channel count: %d, treating as mono", 
-                            mp3_frame_info_.nChans);
+                    need_more_data = true;  // 数据不足,强制续填
                 }
-                
-                // 创建AudioStreamPacket
-                AudioStreamPacket packet;
-                packet.sample_rate = mp3_frame_info_.samprate;
-                packet.frame_duration = 60;  // 使用Application默认的帧时长
-                packet.timestamp = 0;
-                
-                // 将int16_t PCM数据转换为uint8_t字节数组
-                size_t pcm_size_bytes = final_sample_count * sizeof(int16_t);
-                packet.payload.resize(pcm_size_bytes);
-                memcpy(packet.payload.data(), final_pcm_data, pcm_size_bytes);
-
-                if (final_pcm_data_fft == nullptr) {
-                    final_pcm_data_fft = (int16_t*)heap_caps_malloc(
-                        final_sample_count * sizeof(int16_t),
-                        MALLOC_CAP_SPIRAM
-                    );
+            }
+            continue;
+        }
+
+        if (sample_rate == 0 || channels == 0) {
+            ESP_LOGW(TAG, "Invalid frame info: rate=%d, channels=%d, skipping", sample_rate, channels);
+            continue;
+        }
+
+        total_frames_decoded_++;
+
+        // 计算当前帧的持续时间(毫秒),只推进解码侧位置
+        int frame_duration_ms = (int)((int64_t)frame_pcm.size() * 1000 / (sample_rate * channels));
+        decode_position_ms += frame_duration_ms;
+
+        ESP_LOGD(TAG, "Frame %d: time=%lldms, duration=%dms, rate=%d, ch=%d",
+                total_frames_decoded_, decode_position_ms, frame_duration_ms,
+                sample_rate, channels);
+
+        // 将PCM数据发送到Application的音频解码队列
+        {
+            int16_t* final_pcm_data = frame_pcm.data();
+            int final_sample_count = (int)frame_pcm.size();
+            std::vector<int16_t> mono_buffer;
+
+            // 如果是双通道，转换为单通道混合
+            if (channels == 2) {
+                // 双通道转单通道：将左右声道混合
+                int stereo_samples = final_sample_count;  // 包含左右声道的总样本数
+                int mono_samples = stereo_samples / 2;  // 实际的单声道样本数
+
+                mono_buffer.resize(mono_samples);
+
+                for (int i = 0; i < mono_samples; ++i) {
+                    // 混合左右声道 (L + R) / 2
+                    int left = frame_pcm[i * 2];      // 左声道
+                    int right = frame_pcm[i * 2 + 1]; // 右声道
+                    mono_buffer[i] = (int16_t)((left + right) / 2);
                 }
-                
-                memcpy(
-                    final_pcm_data_fft,
-                    final_pcm_data,
-                    final_sample_count * sizeof(int16_t)
-                );
-                
-                ESP_LOGD(TAG, "Sending %d PCM samples (%d bytes, rate=%d, channels=%d->1) to Application", 
-                        final_sample_count, pcm_size_bytes, mp3_frame_info_.samprate, mp3_frame_info_.nChans);
-                
-                // 发送到Application的音频解码队列
-                app.AddAudioData(std::move(packet));
-                total_played += pcm_size_bytes;
-                
-                // 打印播放进度
-                if (total_played % (128 * 1024) == 0) {
-                    ESP_LOGI(TAG, "Played %d bytes, buffer size: %d", total_played, buffer_size_);
+
+                final_pcm_data = mono_buffer.data();
+                final_sample_count = mono_samples;
+
+                ESP_LOGD(TAG, "Converted stereo to mono: %d -> %d samples",
+                        stereo_samples, mono_samples);
+            } else if (channels == 1) {
+                // 已经是单声道，无需转换
+                ESP_LOGD(TAG, "Already mono audio: %d samples", final_sample_count);
+            } else {
+                ESP_LOGW(TAG, "Unsupported channel count: %d, treating as mono", channels);
+            }
+
+            // 创建AudioStreamPacket
+            AudioStreamPacket packet;
+            packet.sample_rate = sample_rate;
+            packet.frame_duration = 60;  // 使用Application默认的帧时长
+            packet.timestamp = (uint32_t)decode_position_ms;  // 帧尾的曲目内位置,送出线程据此推进播放位置
+
+            // 将int16_t PCM数据转换为uint8_t字节数组
+            size_t pcm_size_bytes = final_sample_count * sizeof(int16_t);
+            packet.payload.resize(pcm_size_bytes);
+            memcpy(packet.payload.data(), final_pcm_data, pcm_size_bytes);
+
+            // 频谱模式下在解码线程就地算好频段能量,UI 经 GetAudioData() 直接读结果,
+            // 不再把整帧 PCM 拷出去让显示端做标量运算
+            if (display_mode_ == DISPLAY_MODE_SPECTRUM) {
+                ComputeSpectrum(final_pcm_data, final_sample_count);
+            }
+
+            ESP_LOGD(TAG, "Sending %d PCM samples (%d bytes, rate=%d, channels=%d->1) to Application",
+                    final_sample_count, pcm_size_bytes, sample_rate, channels);
+
+            // 推入前瞻队列,满了就等送出线程消费(有界,不再直接占着解码线程送 codec)
+            {
+                std::unique_lock<std::mutex> lock(pcm_mutex_);
+                pcm_cv_.wait(lock, [this] {
+                    return pcm_queue_.size() < MAX_PCM_LOOKAHEAD || !is_playing_;
+                });
+                if (!is_playing_) {
+                    break;
                 }
+                pcm_queue_.push(std::move(packet));
+                pcm_cv_.notify_one();
             }
-            
-        } else {
-            // 解码失败
-            ESP_LOGW(TAG, "MP3 decode failed with error: %d", decode_result);
-            
-            // 跳过一些字节继续尝试
-            if (bytes_left > 1) {
-                read_ptr++;
-                bytes_left--;
-            } else {
-                bytes_left = 0;
+            total_played += pcm_size_bytes;
+
+            // 打印播放进度
+            if (total_played % (128 * 1024) == 0) {
+                ESP_LOGI(TAG, "Played %d bytes, buffer size: %d", total_played, buffer_size_);
             }
         }
     }
-    
+
     // 清理
-    if (mp3_input_buffer) {
-        heap_caps_free(mp3_input_buffer);
+    if (input_buffer) {
+        heap_caps_free(input_buffer);
     }
     
     // 播放结束时进行基本清理，但不调用StopStreaming避免线程自我等待
@@ -1023,7 +1347,13 @@ void Esp32Music::PlayAudioStream() {
     
     // 停止播放标志
     is_playing_ = false;
-    
+
+    // 唤醒送出线程,让它把残余 PCM 清空后退出
+    {
+        std::lock_guard<std::mutex> lock(pcm_mutex_);
+        pcm_cv_.notify_all();
+    }
+
     // 只在频谱显示模式下才停止FFT显示
     if (display_mode_ == DISPLAY_MODE_SPECTRUM) {
         auto& board = Board::GetInstance();
@@ -1037,59 +1367,183 @@ void Esp32Music::PlayAudioStream() {
     }
 }
 
-// 清空音频缓冲区
-void Esp32Music::ClearAudioBuffer() {
-    std::lock_guard<std::mutex> lock(buffer_mutex_);
-    
-    while (!audio_buffer_.empty()) {
-        AudioChunk chunk = audio_buffer_.front();
-        audio_buffer_.pop();
-        if (chunk.data) {
-            heap_caps_free(chunk.data);
+// 送出线程:两级流水线的第二级,把解码好的 PCM 逐帧交给 codec。
+// codec 输出阻塞(I2S DMA 满)时只有这条线程等待,解码线程继续往前跑
+void Esp32Music::OutputAudioStream() {
+    ESP_LOGI(TAG, "Audio output thread started");
+    auto& app = Application::GetInstance();
+
+    while (true) {
+        AudioStreamPacket packet;
+        {
+            std::unique_lock<std::mutex> lock(pcm_mutex_);
+            pcm_cv_.wait(lock, [this] { return !pcm_queue_.empty() || !is_playing_; });
+            if (pcm_queue_.empty()) {
+                // 解码结束且残余帧已清空
+                break;
+            }
+            packet = std::move(pcm_queue_.front());
+            pcm_queue_.pop();
+            // 通知解码线程前瞻队列有空位
+            pcm_cv_.notify_one();
         }
+        uint32_t position_ms = packet.timestamp;
+        app.AddAudioData(std::move(packet));
+
+        // 播放位置按真正交给 codec 的帧推进(OutputData 写入 DMA 流后才返回),
+        // 歌词/进度不再用解码侧提前量加经验修正值去凑
+        current_play_time_ms_ = position_ms;
+        UpdateLyricDisplay(position_ms);
     }
-    
+
+    // 丢弃未送出的残余帧
+    {
+        std::lock_guard<std::mutex> lock(pcm_mutex_);
+        std::queue<AudioStreamPacket> empty;
+        pcm_queue_.swap(empty);
+    }
+    ESP_LOGI(TAG, "Audio output thread finished");
+}
+
+// 清空音频缓冲区(只复位指针,预分配的环形缓冲保留复用)
+void Esp32Music::ClearAudioBuffer() {
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        prefetch_url_.clear();
+    }
+
+    {
+        // 丢弃溢出层积压;逻辑偏移保持单调,下一首继续绕圈写,磨损持续摊开
+        std::lock_guard<std::mutex> lock(spill_mutex_);
+        spill_read_abs_ = spill_write_abs_;
+        spill_used_.store(0);
+    }
+
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+
+    ring_head_ = 0;
+    ring_tail_ = 0;
     buffer_size_ = 0;
+    ring_total_written_ = 0;
+    ring_total_read_ = 0;
+    while (!track_boundaries_.empty()) {
+        track_boundaries_.pop();
+    }
     ESP_LOGI(TAG, "Audio buffer cleared");
 }
 
 // 初始化MP3解码器
-bool Esp32Music::InitializeMp3Decoder() {
-    mp3_decoder_ = MP3InitDecoder();
-    if (mp3_decoder_ == nullptr) {
-        ESP_LOGE(TAG, "Failed to initialize MP3 decoder");
-        mp3_decoder_initialized_ = false;
+// 初始化频谱FFT:esp-dsp 定点 FFT 表、Hann 窗 Q15 表和对数分段边界都只算一次
+bool Esp32Music::InitializeFft() {
+    esp_err_t err = dsps_fft2r_init_sc16(NULL, FFT_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init esp-dsp FFT tables: %d", err);
         return false;
     }
-    
-    mp3_decoder_initialized_ = true;
-    ESP_LOGI(TAG, "MP3 decoder initialized successfully");
+
+    // 工作区放内部 RAM 并按 16 字节对齐,满足汇编内核的要求
+    fft_work_ = (int16_t*)heap_caps_aligned_alloc(16, FFT_SIZE * 2 * sizeof(int16_t),
+                                                  MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    fft_window_ = (int16_t*)heap_caps_malloc(FFT_SIZE * sizeof(int16_t),
+                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (fft_work_ == nullptr || fft_window_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate FFT work buffers");
+        CleanupFft();
+        return false;
+    }
+
+    // Hann 窗定点化,运行期逐帧只做 Q15 乘法
+    for (int i = 0; i < FFT_SIZE; i++) {
+        float w = 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / (FFT_SIZE - 1)));
+        fft_window_[i] = (int16_t)(w * 32767.0f);
+    }
+
+    // 对数分段边界:低频段窄、高频段宽,跳过直流 bin
+    for (int b = 0; b <= SPECTRUM_BINS; b++) {
+        int edge = (int)powf((float)(FFT_SIZE / 2), (float)b / SPECTRUM_BINS);
+        if (b > 0 && edge <= fft_bin_edges_[b - 1]) {
+            edge = fft_bin_edges_[b - 1] + 1;  // 保证每段至少一个 bin
+        }
+        fft_bin_edges_[b] = std::min(edge, FFT_SIZE / 2);
+    }
+
+    if (final_pcm_data_fft == nullptr) {
+        final_pcm_data_fft = (int16_t*)heap_caps_malloc(SPECTRUM_BINS * sizeof(int16_t),
+                                                        MALLOC_CAP_SPIRAM);
+    }
+
+    fft_initialized_ = true;
+    ESP_LOGI(TAG, "Spectrum FFT initialized: %d points -> %d log bins", FFT_SIZE, SPECTRUM_BINS);
     return true;
 }
 
-// 清理MP3解码器
-void Esp32Music::CleanupMp3Decoder() {
-    if (mp3_decoder_ != nullptr) {
-        MP3FreeDecoder(mp3_decoder_);
-        mp3_decoder_ = nullptr;
+void Esp32Music::CleanupFft() {
+    fft_initialized_ = false;
+    if (fft_work_ != nullptr) {
+        heap_caps_free(fft_work_);
+        fft_work_ = nullptr;
+    }
+    if (fft_window_ != nullptr) {
+        heap_caps_free(fft_window_);
+        fft_window_ = nullptr;
+    }
+    if (final_pcm_data_fft != nullptr) {
+        heap_caps_free(final_pcm_data_fft);
+        final_pcm_data_fft = nullptr;
+    }
+    dsps_fft2r_deinit_sc16();
+}
+
+// 加窗 + esp-dsp 定点 FFT + 对数频段聚合,结果写入 final_pcm_data_fft 前 SPECTRUM_BINS 个值
+void Esp32Music::ComputeSpectrum(const int16_t* pcm, size_t sample_count) {
+    if (!fft_initialized_ || final_pcm_data_fft == nullptr) {
+        return;
+    }
+
+    // 实部加窗、虚部置零,不足 FFT_SIZE 时补零
+    size_t n = std::min(sample_count, (size_t)FFT_SIZE);
+    for (size_t i = 0; i < n; i++) {
+        fft_work_[2 * i] = (int16_t)(((int32_t)pcm[i] * fft_window_[i]) >> 15);
+        fft_work_[2 * i + 1] = 0;
+    }
+    for (size_t i = n; i < (size_t)FFT_SIZE; i++) {
+        fft_work_[2 * i] = 0;
+        fft_work_[2 * i + 1] = 0;
+    }
+
+    dsps_fft2r_sc16(fft_work_, FFT_SIZE);
+    dsps_bit_rev_sc16_ansi(fft_work_, FFT_SIZE);
+
+    // 逐段聚合幅值,用 alpha-max + beta-min 近似模长,整个路径不碰浮点和开方
+    for (int b = 0; b < SPECTRUM_BINS; b++) {
+        int32_t acc = 0;
+        int count = 0;
+        for (int k = fft_bin_edges_[b]; k < fft_bin_edges_[b + 1]; k++) {
+            int32_t re = fft_work_[2 * k];
+            int32_t im = fft_work_[2 * k + 1];
+            if (re < 0) re = -re;
+            if (im < 0) im = -im;
+            int32_t mag = (re > im) ? (re + (im >> 1)) : (im + (re >> 1));
+            acc += mag;
+            count++;
+        }
+        if (count > 0) {
+            acc /= count;
+        }
+        final_pcm_data_fft[b] = (int16_t)std::min(acc, (int32_t)INT16_MAX);
     }
-    mp3_decoder_initialized_ = false;
-    ESP_LOGI(TAG, "MP3 decoder cleaned up");
 }
 
-// 重置采样率到原始值
+// 重置采样率到原始值。播放路径已固定DAC原生采样率、差异走软件重采样,
+// 正常情况下什么都不用做;只兜底历史上被改走的时钟(不该再发生)
 void Esp32Music::ResetSampleRate() {
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
-    if (codec && codec->original_output_sample_rate() > 0 && 
+    if (codec && codec->original_output_sample_rate() > 0 &&
         codec->output_sample_rate() != codec->original_output_sample_rate()) {
-        ESP_LOGI(TAG, "重置采样率：从 %d Hz 重置到原始值 %d Hz", 
+        ESP_LOGW(TAG, "输出采样率偏离原生值(%d != %d),重配I2S时钟兜底",
                 codec->output_sample_rate(), codec->original_output_sample_rate());
-        if (codec->SetOutputSampleRate(-1)) {  // -1 表示重置到原始值
-            ESP_LOGI(TAG, "成功重置采样率到原始值: %d Hz", codec->output_sample_rate());
-        } else {
-            ESP_LOGW(TAG, "无法重置采样率到原始值");
-        }
+        codec->SetOutputSampleRate(-1);  // -1 表示重置到原始值
     }
 }
 
@@ -1136,7 +1590,8 @@ bool Esp32Music::DownloadLyrics(const std::string& lyric_url) {
     const int max_retries = 3;
     int retry_count = 0;
     bool success = false;
-    std::string lyric_content;
+    LyricLines parsed;     // 边下边解析的结果
+    std::string pending;   // 跨读取块的半行残留
     std::string current_url = lyric_url;
     int redirect_count = 0;
     const int max_redirects = 5;  // 最多允许5次重定向
@@ -1148,9 +1603,8 @@ bool Esp32Music::DownloadLyrics(const std::string& lyric_url) {
             std::this_thread::sleep_for(std::chrono::milliseconds(500));
         }
         
-        // 使用Board提供的HTTP客户端
-        auto network = Board::GetInstance().GetNetwork();
-        auto http = network->CreateHttp(0);
+        // 使用共享HTTP池(歌词和音乐流同一台服务器)
+        auto http = HttpPool::GetInstance().Acquire("lyrics", current_url);
         if (!http) {
             ESP_LOGE(TAG, "Failed to create HTTP client for lyric download");
             retry_count++;
@@ -1196,7 +1650,8 @@ bool Esp32Music::DownloadLyrics(const std::string& lyric_url) {
         }
         
         // 读取响应
-        lyric_content.clear();
+        parsed.clear();
+        pending.clear();
         char buffer[1024];
         int bytes_read;
         bool read_error = false;
@@ -1210,10 +1665,28 @@ bool Esp32Music::DownloadLyrics(const std::string& lyric_url) {
             // ESP_LOGD(TAG, "Lyric HTTP read returned %d bytes", bytes_read); // 注释掉以减少日志输出
             
             if (bytes_read > 0) {
-                buffer[bytes_read] = '\0';
-                lyric_content += buffer;
                 total_read += bytes_read;
-                
+
+                /* 带宽上限:音频预读掉回高水位以下时歌词流每块歇一拍
+                 * (约50KB/s),把电台时间让回给音乐流;停播则直接放弃 */
+                if (!is_lyric_running_) {
+                    ESP_LOGI(TAG, "Lyric download aborted, playback stopped");
+                    http->Close();
+                    return false;
+                }
+                if (buffer_size_ < LYRIC_START_WATERMARK) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+
+                // 边下边解析:每到一行完整歌词就立即入表,
+                // 下载结束后不再有整文件的集中解析停顿
+                pending.append(buffer, bytes_read);
+                size_t newline_pos;
+                while ((newline_pos = pending.find('\n')) != std::string::npos) {
+                    ParseLyricLine(pending.substr(0, newline_pos), parsed);
+                    pending.erase(0, newline_pos + 1);
+                }
+
                 // 定期打印下载进度 - 改为DEBUG级别减少输出
                 if (total_read % 4096 == 0) {
                     ESP_LOGD(TAG, "Downloaded %d bytes so far", total_read);
@@ -1226,8 +1699,8 @@ bool Esp32Music::DownloadLyrics(const std::string& lyric_url) {
             } else {
                 // bytes_read < 0，可能是ESP-IDF的已知问题
                 // 如果已经读取到了一些数据，则认为下载成功
-                if (!lyric_content.empty()) {
-                    ESP_LOGW(TAG, "HTTP read returned %d, but we have data (%d bytes), continuing", bytes_read, lyric_content.length());
+                if (total_read > 0) {
+                    ESP_LOGW(TAG, "HTTP read returned %d, but we have data (%d bytes), continuing", bytes_read, total_read);
                     success = true;
                     break;
                 } else {
@@ -1257,117 +1730,107 @@ bool Esp32Music::DownloadLyrics(const std::string& lyric_url) {
         return false;
     }
     
-    // 记录前几个字节的数据，帮助调试
-    if (!lyric_content.empty()) {
-        size_t preview_size = std::min(lyric_content.size(), size_t(50));
-        std::string preview = lyric_content.substr(0, preview_size);
-        ESP_LOGD(TAG, "Lyric content preview (%d bytes): %s", lyric_content.length(), preview.c_str());
-    } else {
+    // 最后一行可能没有换行结尾,也解析掉
+    if (!pending.empty()) {
+        ParseLyricLine(pending, parsed);
+    }
+
+    if (parsed.empty()) {
         ESP_LOGE(TAG, "Failed to download lyrics or lyrics are empty");
         return false;
     }
-    
-    ESP_LOGI(TAG, "Lyrics downloaded successfully, size: %d bytes", lyric_content.length());
-    return ParseLyrics(lyric_content);
+
+    // 按时间戳排序后整体发布:读端经原子指针拿到的永远是排好序的完整快照,
+    // UpdateLyricDisplay 据此做二分查找
+    std::sort(parsed.begin(), parsed.end());
+    size_t line_count = parsed.size();
+    std::atomic_store(&lyrics_snapshot_,
+                      std::shared_ptr<const LyricLines>(new LyricLines(std::move(parsed))));
+
+    ESP_LOGI(TAG, "Lyrics ready: %u lines", (unsigned int)line_count);
+    return true;
 }
 
-// 解析歌词
-bool Esp32Music::ParseLyrics(const std::string& lyric_content) {
-    ESP_LOGI(TAG, "Parsing lyrics content");
-    
-    // 使用锁保护lyrics_数组访问
-    std::lock_guard<std::mutex> lock(lyrics_mutex_);
-    
-    lyrics_.clear();
-    
-    // 按行分割歌词内容
-    std::istringstream stream(lyric_content);
-    std::string line;
-    
-    while (std::getline(stream, line)) {
-        // 去除行尾的回车符
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-        
-        // 跳过空行
-        if (line.empty()) {
-            continue;
+// 解析单行LRC: [mm:ss.xx]歌词文本;元数据标签([ti:] [ar:]等)直接跳过
+void Esp32Music::ParseLyricLine(const std::string& raw_line, LyricLines& out) {
+    std::string line = raw_line;
+
+    // 去除行尾的回车符
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+
+    // 跳过空行和非LRC格式的行
+    if (line.length() <= 10 || line[0] != '[') {
+        return;
+    }
+
+    size_t close_bracket = line.find(']');
+    if (close_bracket == std::string::npos) {
+        return;
+    }
+
+    std::string tag_or_time = line.substr(1, close_bracket - 1);
+    std::string content = line.substr(close_bracket + 1);
+
+    // 检查是否是元数据标签而不是时间戳
+    // 元数据标签通常是 [ti:标题], [ar:艺术家], [al:专辑] 等
+    size_t colon_pos = tag_or_time.find(':');
+    if (colon_pos == std::string::npos) {
+        return;
+    }
+    std::string left_part = tag_or_time.substr(0, colon_pos);
+
+    // 检查冒号左边是否是时间（数字）
+    for (char c : left_part) {
+        if (!isdigit(c)) {
+            ESP_LOGD(TAG, "Skipping metadata tag: [%s]", tag_or_time.c_str());
+            return;
         }
-        
-        // 解析LRC格式: [mm:ss.xx]歌词文本
-        if (line.length() > 10 && line[0] == '[') {
-            size_t close_bracket = line.find(']');
-            if (close_bracket != std::string::npos) {
-                std::string tag_or_time = line.substr(1, close_bracket - 1);
-                std::string content = line.substr(close_bracket + 1);
-                
-                // 检查是否是元数据标签而不是时间戳
-                // 元数据标签通常是 [ti:标题], [ar:艺术家], [al:专辑] 等
-                size_t colon_pos = tag_or_time.find(':');
-                if (colon_pos != std::string::npos) {
-                    std::string left_part = tag_or_time.substr(0, colon_pos);
-                    
-                    // 检查冒号左边是否是时间（数字）
-                    bool is_time_format = true;
-                    for (char c : left_part) {
-                        if (!isdigit(c)) {
-                            is_time_format = false;
-                            break;
-                        }
-                    }
-                    
-                    // 如果不是时间格式，跳过这一行（元数据标签）
-                    if (!is_time_format) {
-                        // 可以在这里处理元数据，例如提取标题、艺术家等信息
-                        ESP_LOGD(TAG, "Skipping metadata tag: [%s]", tag_or_time.c_str());
-                        continue;
-                    }
-                    
-                    // 是时间格式，解析时间戳
-                    try {
-                        int minutes = std::stoi(tag_or_time.substr(0, colon_pos));
-                        float seconds = std::stof(tag_or_time.substr(colon_pos + 1));
-                        int timestamp_ms = minutes * 60 * 1000 + (int)(seconds * 1000);
-                        
-                        // 安全处理歌词文本，确保UTF-8编码正确
-                        std::string safe_lyric_text;
-                        if (!content.empty()) {
-                            // 创建安全副本并验证字符串
-                            safe_lyric_text = content;
-                            // 确保字符串以null结尾
-                            safe_lyric_text.shrink_to_fit();
-                        }
-                        
-                        lyrics_.push_back(std::make_pair(timestamp_ms, safe_lyric_text));
-                        
-                        if (!safe_lyric_text.empty()) {
-                            // 限制日志输出长度，避免中文字符截断问题
-                            size_t log_len = std::min(safe_lyric_text.length(), size_t(50));
-                            std::string log_text = safe_lyric_text.substr(0, log_len);
-                            ESP_LOGD(TAG, "Parsed lyric: [%d ms] %s", timestamp_ms, log_text.c_str());
-                        } else {
-                            ESP_LOGD(TAG, "Parsed lyric: [%d ms] (empty)", timestamp_ms);
-                        }
-                    } catch (const std::exception& e) {
-                        ESP_LOGW(TAG, "Failed to parse time: %s", tag_or_time.c_str());
-                    }
-                }
-            }
+    }
+
+    // 是时间格式，解析时间戳
+    try {
+        int minutes = std::stoi(tag_or_time.substr(0, colon_pos));
+        float seconds = std::stof(tag_or_time.substr(colon_pos + 1));
+        int timestamp_ms = minutes * 60 * 1000 + (int)(seconds * 1000);
+
+        // 安全处理歌词文本，确保UTF-8编码正确
+        std::string safe_lyric_text;
+        if (!content.empty()) {
+            safe_lyric_text = content;
+            safe_lyric_text.shrink_to_fit();
         }
+
+        out.push_back(std::make_pair(timestamp_ms, safe_lyric_text));
+    } catch (const std::exception& e) {
+        ESP_LOGW(TAG, "Failed to parse time: %s", tag_or_time.c_str());
     }
-    
-    // 按时间戳排序
-    std::sort(lyrics_.begin(), lyrics_.end());
-    
-    ESP_LOGI(TAG, "Parsed %d lyric lines", lyrics_.size());
-    return !lyrics_.empty();
 }
 
 // 歌词显示线程
 void Esp32Music::LyricDisplayThread() {
     ESP_LOGI(TAG, "Lyric display thread started");
-    
+
+    /* 歌词下载让位于音频预读:起播阶段缓冲最浅,歌词HTTP事务会跟流媒体
+     * 抢同一段电台时间,正是早期欠载的来源。等环形缓冲过高水位再开始;
+     * 慢链路上缓冲可能一直到不了线,超时兜底保证歌词最终还是会出现 */
+    const int kMaxDeferMs = 15000;
+    int waited_ms = 0;
+    while (is_lyric_running_ && is_playing_ &&
+           buffer_size_ < LYRIC_START_WATERMARK && waited_ms < kMaxDeferMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        waited_ms += 100;
+    }
+    if (!is_lyric_running_) {
+        ESP_LOGI(TAG, "Lyric display thread cancelled before download");
+        return;
+    }
+    if (waited_ms > 0) {
+        ESP_LOGI(TAG, "Deferred lyric download %d ms for buffer health (%u/%u bytes)",
+                 waited_ms, (unsigned)buffer_size_, (unsigned)LYRIC_START_WATERMARK);
+    }
+
     if (!DownloadLyrics(current_lyric_url_)) {
         ESP_LOGE(TAG, "Failed to download or parse lyrics");
         is_lyric_running_ = false;
@@ -1383,50 +1846,38 @@ void Esp32Music::LyricDisplayThread() {
 }
 
 void Esp32Music::UpdateLyricDisplay(int64_t current_time_ms) {
-    std::lock_guard<std::mutex> lock(lyrics_mutex_);
-    
-    if (lyrics_.empty()) {
+    // 无锁读取:原子拿快照,解析/下载端不会阻塞播放线程
+    auto lyrics = std::atomic_load(&lyrics_snapshot_);
+    if (!lyrics || lyrics->empty()) {
         return;
     }
-    
-    // 查找当前应该显示的歌词
-    int new_lyric_index = -1;
-    
-    // 从当前歌词索引开始查找，提高效率
-    int start_index = (current_lyric_index_.load() >= 0) ? current_lyric_index_.load() : 0;
-    
-    // 正向查找：找到最后一个时间戳小于等于当前时间的歌词
-    for (int i = start_index; i < (int)lyrics_.size(); i++) {
-        if (lyrics_[i].first <= current_time_ms) {
-            new_lyric_index = i;
-        } else {
-            break;  // 时间戳已超过当前时间
-        }
-    }
-    
-    // 如果没有找到(可能当前时间比第一句歌词还早)，显示空
-    if (new_lyric_index == -1) {
-        new_lyric_index = -1;
-    }
-    
+
+    // 二分查找最后一条时间戳不超过当前时间的歌词;
+    // 找不到(当前时间早于第一句)时为-1,显示空
+    auto it = std::upper_bound(lyrics->begin(), lyrics->end(), current_time_ms,
+                               [](int64_t t, const std::pair<int, std::string>& line) {
+                                   return t < (int64_t)line.first;
+                               });
+    int new_lyric_index = (int)std::distance(lyrics->begin(), it) - 1;
+
     // 如果歌词索引发生变化，更新显示
     if (new_lyric_index != current_lyric_index_) {
         current_lyric_index_ = new_lyric_index;
-        
+
         auto& board = Board::GetInstance();
         auto display = board.GetDisplay();
         if (display) {
             std::string lyric_text;
-            
-            if (current_lyric_index_ >= 0 && current_lyric_index_ < (int)lyrics_.size()) {
-                lyric_text = lyrics_[current_lyric_index_].second;
+
+            if (new_lyric_index >= 0 && new_lyric_index < (int)lyrics->size()) {
+                lyric_text = (*lyrics)[new_lyric_index].second;
             }
-            
+
             // 显示歌词
             display->SetChatMessage("lyric", lyric_text.c_str());
-            
-            ESP_LOGD(TAG, "Lyric update at %lldms: %s", 
-                    current_time_ms, 
+
+            ESP_LOGD(TAG, "Lyric update at %lldms: %s",
+                    current_time_ms,
                     lyric_text.empty() ? "(no lyric)" : lyric_text.c_str());
         }
     }
@@ -1,6 +1,9 @@
 #ifndef ESP32_MUSIC_H
 #define ESP32_MUSIC_H
 
+#include <sdkconfig.h>
+#include <esp_partition.h>
+
 #include <string>
 #include <thread>
 #include <atomic>
@@ -8,22 +11,11 @@
 #include <mutex>
 #include <condition_variable>
 #include <vector>
+#include <memory>
 
 #include "music.h"
-
-// MP3解码器支持
-extern "C" {
-#include "mp3dec.h"
-}
-
-// 音频数据块结构
-struct AudioChunk {
-    uint8_t* data;
-    size_t size;
-    
-    AudioChunk() : data(nullptr), size(0) {}
-    AudioChunk(uint8_t* d, size_t s) : data(d), size(s) {}
-};
+#include "music_decoder.h"
+#include "protocols/protocol.h"
 
 // 歌曲信息结构
 struct SongInfo {
@@ -49,10 +41,11 @@ private:
     bool song_name_displayed_;
     std::atomic<bool> stop_flag_{false}; // 停止播放标志位
     
-    // 歌词相关
+    // 歌词相关:解析结果按时间戳升序,作为不可变快照经原子指针发布,
+    // 播放线程读取时既不加锁也不会被解析过程阻塞
+    using LyricLines = std::vector<std::pair<int, std::string>>;  // 时间戳和歌词文本
     std::string current_lyric_url_;
-    std::vector<std::pair<int, std::string>> lyrics_;  // 时间戳和歌词文本
-    std::mutex lyrics_mutex_;  // 保护lyrics_数组的互斥锁
+    std::shared_ptr<const LyricLines> lyrics_snapshot_;
     std::atomic<int> current_lyric_index_;
     std::thread lyric_thread_;
     std::atomic<bool> is_lyric_running_;
@@ -62,24 +55,60 @@ private:
     std::atomic<bool> is_downloading_;
     std::thread play_thread_;
     std::thread download_thread_;
-    int64_t current_play_time_ms_;  // 当前播放时间(毫秒)
+    int64_t current_play_time_ms_;  // 当前播放时间(毫秒,按已交给 codec 的帧推进)
     int64_t last_frame_time_ms_;    // 上一帧的时间戳
     int total_frames_decoded_;      // 已解码的帧数
     int current_song_duration_seconds_;  // 当前歌曲总时长(秒)
 
-    // 音频缓冲区
-    std::queue<AudioChunk> audio_buffer_;
+    // 音频缓冲区:单块预分配的 PSRAM 环形缓冲,下载线程写入、播放线程读出,
+    // 彻底去掉按块 malloc/free(此前的分配风暴会导致偶发 brownout)
+    uint8_t* ring_buffer_ = nullptr;
+    size_t ring_head_ = 0;   // 读位置
+    size_t ring_tail_ = 0;   // 写位置
     std::mutex buffer_mutex_;
     std::condition_variable buffer_cv_;
-    size_t buffer_size_;
-    static constexpr size_t MAX_BUFFER_SIZE = 256 * 1024;  // 256KB缓冲区（降低以减少brownout风险）
-    static constexpr size_t MIN_BUFFER_SIZE = 32 * 1024;   // 32KB最小播放缓冲（降低以减少brownout风险）
-    
-    // MP3解码器相关
-    HMP3Decoder mp3_decoder_;
-    MP3FrameInfo mp3_frame_info_;
-    bool mp3_decoder_initialized_;
-    
+    size_t buffer_size_;     // 当前占用字节数
+    static constexpr size_t MAX_BUFFER_SIZE = CONFIG_MUSIC_READAHEAD_KB * 1024;  // 环形缓冲容量,即下载预读窗口
+    static constexpr size_t MIN_BUFFER_SIZE = 32 * 1024;   // 起播水位
+    // 歌词下载的放行水位:预读没到这条线之前歌词流让路(限速/延后),
+    // 避免起播阶段跟音乐流抢同一段电台时间
+    static constexpr size_t LYRIC_START_WATERMARK = MAX_BUFFER_SIZE * 3 / 4;
+
+    // 环形缓冲读写(内部处理回绕),返回实际搬运的字节数,调用方须持有 buffer_mutex_
+    size_t WriteRingLocked(const uint8_t* data, size_t len);
+    size_t ReadRingLocked(uint8_t* out, size_t max_len);
+
+    // 无缝切歌:预取的下一首由下载线程在当前曲目收尾后直接续写进环形缓冲,
+    // 轨道边界用绝对字节偏移标记,解码线程跨过边界时重置每曲目状态
+    std::string prefetch_url_;
+    std::mutex prefetch_mutex_;
+    std::queue<size_t> track_boundaries_;  // 各曲目结束处的累计写偏移(受 buffer_mutex_ 保护)
+    size_t ring_total_written_ = 0;        // 写入环形缓冲的累计字节数
+    size_t ring_total_read_ = 0;           // 读出环形缓冲的累计字节数
+
+    // flash 溢出层(可选):RAM 环形缓冲满后,压缩源字节顺序写入专用的
+    // music_spill 数据分区,再按 FIFO 搬回环形缓冲,弱网下可缓冲分钟级节目。
+    // 整圈循环写天然均衡磨损;分区表里没有 music_spill 时该层完全旁路。
+    static constexpr size_t SPILL_SECTOR = 4096;  // flash 擦除扇区,也是单次搬运块大小
+    const esp_partition_t* spill_partition_ = nullptr;
+    std::mutex spill_mutex_;
+    std::atomic<size_t> spill_used_{0};  // 积压字节数的即时副本,供无锁快速检查
+    uint64_t spill_write_abs_ = 0;       // 单调递增逻辑偏移,物理位置取模分区大小
+    uint64_t spill_read_abs_ = 0;
+    uint64_t spill_erase_abs_ = 0;       // 擦除前沿,始终扇区对齐
+    uint8_t* spill_xfer_buf_ = nullptr;  // 搬运暂存(一个扇区)
+    bool SpillWrite(const uint8_t* data, size_t len);  // 仅下载线程调用
+    size_t SpillReadToRing();  // 从溢出层搬一块回环形缓冲,下载/解码线程均可调用
+
+    // 解码/送出两级流水线:解码线程只产出 PCM,送出线程独立消费,
+    // 几帧前瞻吸收解码端的抖动(flash 读、网络补货),播放不再跟着卡
+    std::queue<AudioStreamPacket> pcm_queue_;
+    std::mutex pcm_mutex_;
+    std::condition_variable pcm_cv_;
+    static constexpr size_t MAX_PCM_LOOKAHEAD = 3;  // 前瞻帧数
+    std::thread output_thread_;
+    void OutputAudioStream();
+
     // 播放队列相关
     std::vector<SongInfo> playlist_;
     mutable std::mutex playlist_mutex_;
@@ -91,19 +120,29 @@ private:
     void DownloadAudioStream(const std::string& music_url);
     void PlayAudioStream();
     void ClearAudioBuffer();
-    bool InitializeMp3Decoder();
-    void CleanupMp3Decoder();
     void ResetSampleRate();  // 重置采样率到原始值
     
     // 歌词相关私有方法
     bool DownloadLyrics(const std::string& lyric_url);
-    bool ParseLyrics(const std::string& lyric_content);
+    static void ParseLyricLine(const std::string& raw_line, LyricLines& out);  // 边下边解析,按行调用
     void LyricDisplayThread();
     void UpdateLyricDisplay(int64_t current_time_ms);
     
     // ID3标签处理
     size_t SkipId3Tag(uint8_t* data, size_t size);
 
+    // 频谱计算(esp-dsp 定点 FFT):解码线程按帧就地产出 log 频段能量,
+    // final_pcm_data_fft 存放 SPECTRUM_BINS 个频段值供 UI 读取
+    static constexpr int FFT_SIZE = 512;       // 每帧参与 FFT 的采样点数
+    static constexpr int SPECTRUM_BINS = 32;   // 对数聚合后的频段数
+    int16_t* fft_work_ = nullptr;              // 复数交织工作区(2*FFT_SIZE),内部 RAM
+    int16_t* fft_window_ = nullptr;            // Hann 窗定点表(Q15)
+    int fft_bin_edges_[SPECTRUM_BINS + 1];     // 对数分段边界,初始化时算好
+    bool fft_initialized_ = false;
+    bool InitializeFft();
+    void CleanupFft();
+    void ComputeSpectrum(const int16_t* pcm, size_t sample_count);
+
     // 播放队列管理私有方法
     void PlaylistManagerThread();
     void PlayCurrentSong();
@@ -121,8 +160,10 @@ public:
     // 新增方法
     virtual bool StartStreaming(const std::string& music_url) override;
     virtual bool StopStreaming() override;  // 停止流式播放
+    virtual bool PrefetchNext(const std::string& music_url) override;
     virtual size_t GetBufferSize() const override { return buffer_size_; }
     virtual bool IsDownloading() const override { return is_downloading_; }
+    // 频谱模式下返回 SPECTRUM_BINS 个对数频段能量值(由解码线程逐帧更新)
     virtual int16_t* GetAudioData() override { return final_pcm_data_fft; }
     
     // 显示模式控制方法
@@ -1,9 +1,46 @@
 #include "i2c_device.h"
 
 #include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
 
 #define TAG "I2cDevice"
 
+namespace {
+
+struct AsyncWrite {
+    i2c_master_dev_handle_t device;
+    uint8_t reg;
+    uint8_t value;
+};
+
+void AsyncWriteTask(void* arg) {
+    auto queue = static_cast<QueueHandle_t>(arg);
+    AsyncWrite op;
+    while (true) {
+        if (xQueueReceive(queue, &op, portMAX_DELAY) == pdTRUE) {
+            uint8_t buffer[2] = {op.reg, op.value};
+            esp_err_t err = i2c_master_transmit(op.device, buffer, 2, 100);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Async write to reg 0x%02x failed: %s", op.reg, esp_err_to_name(err));
+            }
+        }
+    }
+}
+
+// 所有I2cDevice实例共享一个排空任务,首次异步写时才创建
+QueueHandle_t GetAsyncWriteQueue() {
+    static QueueHandle_t queue = []() {
+        auto q = xQueueCreate(32, sizeof(AsyncWrite));
+        xTaskCreate(AsyncWriteTask, "i2c_async", 2048, q, 5, nullptr);
+        return q;
+    }();
+    return queue;
+}
+
+}  // namespace
+
 
 I2cDevice::I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr) {
     i2c_device_config_t i2c_device_cfg = {
@@ -24,6 +61,26 @@ void I2cDevice::WriteReg(uint8_t reg, uint8_t value) {
     ESP_ERROR_CHECK(i2c_master_transmit(i2c_device_, buffer, 2, 100));
 }
 
+void I2cDevice::WriteRegs(std::initializer_list<std::pair<uint8_t, uint8_t>> regs) {
+    for (const auto& [reg, value] : regs) {
+        uint8_t buffer[2] = {reg, value};
+        ESP_ERROR_CHECK(i2c_master_transmit(i2c_device_, buffer, 2, 100));
+    }
+}
+
+void I2cDevice::WriteRegAsync(uint8_t reg, uint8_t value) {
+    AsyncWrite op = {
+        .device = i2c_device_,
+        .reg = reg,
+        .value = value,
+    };
+    if (xQueueSend(GetAsyncWriteQueue(), &op, 0) != pdTRUE) {
+        // 队列满就退化为同步写,寄存器值不能丢
+        ESP_LOGW(TAG, "Async write queue full, falling back to sync write");
+        WriteReg(reg, value);
+    }
+}
+
 uint8_t I2cDevice::ReadReg(uint8_t reg) {
     uint8_t buffer[1];
     ESP_ERROR_CHECK(i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, 1, 100));
@@ -32,4 +89,4 @@ uint8_t I2cDevice::ReadReg(uint8_t reg) {
 
 void I2cDevice::ReadRegs(uint8_t reg, uint8_t* buffer, size_t length) {
     ESP_ERROR_CHECK(i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, length, 100));
-}
\ No newline at end of file
+}
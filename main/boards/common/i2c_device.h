@@ -3,6 +3,9 @@
 
 #include <driver/i2c_master.h>
 
+#include <initializer_list>
+#include <utility>
+
 class I2cDevice {
 public:
     I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr);
@@ -11,6 +14,12 @@ protected:
     i2c_master_dev_handle_t i2c_device_;
 
     void WriteReg(uint8_t reg, uint8_t value);
+    // 批量写:一次调用下发整串寄存器配置(典型场景是上电初始化表),
+    // 顺序在本任务内连续执行,出错统一ESP_ERROR_CHECK
+    void WriteRegs(std::initializer_list<std::pair<uint8_t, uint8_t>> regs);
+    // 异步写:入队立即返回,由共享的低优先级i2c_async任务按序下发,
+    // 音量/背光这类运行期控制路径不再被总线阻塞
+    void WriteRegAsync(uint8_t reg, uint8_t value);
     uint8_t ReadReg(uint8_t reg);
     void ReadRegs(uint8_t reg, uint8_t* buffer, size_t length);
 };
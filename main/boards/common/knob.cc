@@ -2,6 +2,10 @@
 
 static const char* TAG = "Knob";
 
+// 棘齿合并窗口:窗口内的旋转累积成一个增量再回调。50ms对手感无感,
+// 但足以把一次快拧的几十个棘齿压成一两次回调
+#define KNOB_BATCH_WINDOW_MS 50
+
 Knob::Knob(gpio_num_t pin_a, gpio_num_t pin_b) {
     knob_config_t config = {
         .default_direction = 0,
@@ -28,10 +32,26 @@ Knob::Knob(gpio_num_t pin_a, gpio_num_t pin_b) {
         return;
     }
 
+    esp_timer_create_args_t batch_timer_args = {
+        .callback = [](void *arg) {
+            auto knob = static_cast<Knob*>(arg);
+            knob->OnBatchTimer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "knob_batch",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&batch_timer_args, &batch_timer_));
+
     ESP_LOGI(TAG, "Knob initialized with pins A:%d B:%d", pin_a, pin_b);
 }
 
 Knob::~Knob() {
+    if (batch_timer_ != NULL) {
+        esp_timer_stop(batch_timer_);
+        esp_timer_delete(batch_timer_);
+    }
     if (knob_handle_ != NULL) {
         iot_knob_delete(knob_handle_);
         knob_handle_ = NULL;
@@ -42,11 +62,42 @@ void Knob::OnRotate(std::function<void(bool)> callback) {
     on_rotate_ = callback;
 }
 
+void Knob::OnRotateDelta(std::function<void(int delta)> callback) {
+    on_rotate_delta_ = callback;
+}
+
+void Knob::OnBatchTimer() {
+    int detents = pending_detents_.exchange(0);
+    if (detents == 0 || !on_rotate_delta_) {
+        return;
+    }
+
+    // 按转速加速:窗口内棘齿越多说明拧得越快,放大增量,
+    // 快拧扫完整个调节范围不需要转好几圈
+    int magnitude = detents < 0 ? -detents : detents;
+    int scale = 1;
+    if (magnitude >= 6) {
+        scale = 3;
+    } else if (magnitude >= 3) {
+        scale = 2;
+    }
+    on_rotate_delta_(detents * scale);
+}
+
 void Knob::knob_callback(void* arg, void* data) {
     Knob* knob = static_cast<Knob*>(data);
     knob_event_t event = iot_knob_get_event(arg);
-    
+    bool clockwise = (event == KNOB_RIGHT);
+
+    if (knob->on_rotate_delta_ && knob->batch_timer_ != NULL) {
+        knob->pending_detents_.fetch_add(clockwise ? 1 : -1);
+        if (!esp_timer_is_active(knob->batch_timer_)) {
+            esp_timer_start_once(knob->batch_timer_, KNOB_BATCH_WINDOW_MS * 1000);
+        }
+        return;
+    }
+
     if (knob->on_rotate_) {
-        knob->on_rotate_(event == KNOB_RIGHT);
+        knob->on_rotate_(clockwise);
     }
-}
\ No newline at end of file
+}
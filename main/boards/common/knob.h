@@ -4,22 +4,33 @@
 #include <driver/gpio.h>
 #include <functional>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <iot_knob.h>
+#include <atomic>
 
 class Knob {
 public:
     Knob(gpio_num_t pin_a, gpio_num_t pin_b);
     ~Knob();
 
+    // 每个棘齿回调一次(true=顺时针)。快速旋转会连发几十次,
+    // 回调里走I2C/显示路径的建议改用OnRotateDelta
     void OnRotate(std::function<void(bool)> callback);
+    // 批量回调:短窗口内的棘齿合并成一个按转速加速过的增量,
+    // 一个手势只触发一次回调(一次codec写+一次UI刷新)
+    void OnRotateDelta(std::function<void(int delta)> callback);
 
 private:
     static void knob_callback(void* arg, void* data);
+    void OnBatchTimer();
 
     knob_handle_t knob_handle_;
     gpio_num_t pin_a_;
     gpio_num_t pin_b_;
     std::function<void(bool)> on_rotate_;
+    std::function<void(int)> on_rotate_delta_;
+    esp_timer_handle_t batch_timer_ = nullptr;
+    std::atomic<int> pending_detents_{0};
 };
 
-#endif // KNOB_H_
\ No newline at end of file
+#endif // KNOB_H_
@@ -2,6 +2,8 @@
 
 #include "application.h"
 #include "display.h"
+#include "heap_telemetry.h"
+#include "settings.h"
 #include "assets/lang_config.h"
 
 #include <esp_log.h>
@@ -23,6 +25,9 @@ void Ml307Board::StartNetwork() {
     auto display = Board::GetInstance().GetDisplay();
     display->SetStatus(Lang::Strings::DETECTING_MODULE);
 
+    // 921600是ML307的最高稳定波特率;16包/秒的Opus上行主要受每条AT
+    // 命令的往返开销限制,批量数据模式(多包合并下发+流水线URC解析)
+    // 需要在78/esp-ml307组件的UART/AT层实现,板级这边只管引脚和波特率
     while (true) {
         modem_ = AtModem::Detect(tx_pin_, rx_pin_, dtr_pin_, 921600);
         if (modem_ != nullptr) {
@@ -189,6 +194,15 @@ std::string Ml307Board::GetDeviceStatusJson() {
     }
     cJSON_AddItemToObject(root, "network", network);
 
+    // Heap telemetry (per-subsystem watermarks)
+    HeapTelemetry::GetInstance().AddHeapSection(root);
+
+    // 无崩溃运行时长(检测到coredump时清零)
+    {
+        Settings settings("crash", false);
+        cJSON_AddNumberToObject(root, "crash_free_hours", settings.GetInt("uptime_hours"));
+    }
+
     auto json_str = cJSON_PrintUnformatted(root);
     std::string json(json_str);
     cJSON_free(json_str);
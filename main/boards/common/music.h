@@ -17,6 +17,8 @@ public:
     // 新增流式播放相关方法
     virtual bool StartStreaming(const std::string& music_url) = 0;
     virtual bool StopStreaming() = 0;  // 停止流式播放
+    // 预取下一首:当前曲目播放期间提前缓冲下一首,切歌无需重建线程和缓冲
+    virtual bool PrefetchNext(const std::string& music_url) = 0;
     virtual size_t GetBufferSize() const = 0;
     virtual bool IsDownloading() const = 0;
     virtual int16_t* GetAudioData() = 0;
@@ -0,0 +1,153 @@
+#include "music_decoder.h"
+
+#include <esp_log.h>
+#include <cstring>
+
+#define TAG "MusicDecoder"
+
+std::unique_ptr<MusicDecoder> MusicDecoder::CreateForStream(const uint8_t* header, size_t size) {
+    if (size >= 4 && memcmp(header, "OggS", 4) == 0) {
+        return std::make_unique<OggOpusMusicDecoder>();
+    }
+    return std::make_unique<Mp3MusicDecoder>();
+}
+
+// ========== libhelix MP3 ==========
+
+Mp3MusicDecoder::Mp3MusicDecoder() {
+    decoder_ = MP3InitDecoder();
+    if (decoder_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to initialize MP3 decoder");
+    }
+}
+
+Mp3MusicDecoder::~Mp3MusicDecoder() {
+    if (decoder_ != nullptr) {
+        MP3FreeDecoder(decoder_);
+        decoder_ = nullptr;
+    }
+}
+
+size_t Mp3MusicDecoder::DecodeFrame(const uint8_t* data, size_t size, std::vector<int16_t>& pcm,
+                                    int& sample_rate, int& channels) {
+    pcm.clear();
+    if (decoder_ == nullptr || size == 0) {
+        return 0;
+    }
+
+    int sync_offset = MP3FindSyncWord((unsigned char*)data, size);
+    if (sync_offset < 0) {
+        // 找不到同步字,丢掉垃圾字节,留1字节防止同步字被读取边界截断
+        return size > 1 ? size - 1 : 0;
+    }
+
+    unsigned char* read_ptr = (unsigned char*)data + sync_offset;
+    int bytes_left = (int)(size - sync_offset);
+    int err = MP3Decode(decoder_, &read_ptr, &bytes_left, pcm_buffer_, 0);
+
+    if (err == ERR_MP3_INDATA_UNDERFLOW || err == ERR_MP3_MAINDATA_UNDERFLOW) {
+        return sync_offset;  // 数据不足:先消费同步字前的垃圾,等续填
+    }
+    if (err != ERR_MP3_NONE) {
+        ESP_LOGW(TAG, "MP3 decode failed with error: %d", err);
+        return sync_offset + 1;  // 坏帧,跳一个字节重新找同步
+    }
+
+    MP3GetLastFrameInfo(decoder_, &frame_info_);
+    if (frame_info_.samprate == 0 || frame_info_.nChans == 0) {
+        ESP_LOGW(TAG, "Invalid frame info: rate=%d, channels=%d, skipping",
+                frame_info_.samprate, frame_info_.nChans);
+        return sync_offset + 1;
+    }
+
+    sample_rate = frame_info_.samprate;
+    channels = frame_info_.nChans;
+    pcm.assign(pcm_buffer_, pcm_buffer_ + frame_info_.outputSamps);
+    return (size_t)(read_ptr - data);
+}
+
+// ========== Ogg Opus ==========
+
+size_t OggOpusMusicDecoder::DecodeFrame(const uint8_t* data, size_t size, std::vector<int16_t>& pcm,
+                                        int& sample_rate, int& channels) {
+    pcm.clear();
+    if (size < 4) {
+        return 0;
+    }
+
+    // 定位页魔数,页前的垃圾直接丢弃
+    size_t off = 0;
+    while (off + 4 <= size && memcmp(data + off, "OggS", 4) != 0) {
+        off++;
+    }
+    if (off + 4 > size) {
+        return size > 3 ? size - 3 : 0;  // 全是垃圾,留3字节防止魔数被截断
+    }
+    if (off > 0) {
+        return off;
+    }
+
+    // 页头27字节 + 段表 + 负载,不够整页就等续填
+    if (size < 27) {
+        return 0;
+    }
+    uint8_t nsegs = data[26];
+    size_t header_len = 27 + nsegs;
+    if (size < header_len) {
+        return 0;
+    }
+    size_t payload_len = 0;
+    for (int i = 0; i < nsegs; i++) {
+        payload_len += data[27 + i];
+    }
+    size_t page_len = header_len + payload_len;
+    if (size < page_len) {
+        return 0;
+    }
+
+    // 首段不是上一页的延续时,丢弃没续上的半个包
+    bool continued = (data[5] & 0x01) != 0;
+    if (!continued) {
+        packet_carry_.clear();
+    }
+
+    // 按段表重组包:255字节的段表示包未结束,短段收尾
+    const uint8_t* payload = data + header_len;
+    size_t pos = 0;
+    for (int i = 0; i < nsegs; i++) {
+        uint8_t seg = data[27 + i];
+        packet_carry_.insert(packet_carry_.end(), payload + pos, payload + pos + seg);
+        pos += seg;
+        if (seg < 255) {
+            HandlePacket(std::move(packet_carry_), pcm);
+            packet_carry_.clear();
+        }
+    }
+
+    sample_rate = 48000;  // Opus 固定以 48kHz 输出,后级重采样到 codec 采样率
+    channels = channels_;
+    return page_len;
+}
+
+void OggOpusMusicDecoder::HandlePacket(std::vector<uint8_t>&& packet, std::vector<int16_t>& pcm) {
+    if (packet.size() >= 8 && memcmp(packet.data(), "OpusHead", 8) == 0) {
+        channels_ = (packet.size() > 9) ? packet[9] : 1;
+        if (channels_ < 1 || channels_ > 2) {
+            channels_ = 2;
+        }
+        opus_ = std::make_unique<OpusDecoderWrapper>(48000, channels_, 60);
+        ESP_LOGI(TAG, "Ogg Opus stream detected: %d channel(s)", channels_);
+        return;
+    }
+    if (packet.size() >= 8 && memcmp(packet.data(), "OpusTags", 8) == 0) {
+        return;  // 元数据,跳过
+    }
+    if (opus_ == nullptr) {
+        return;  // OpusHead 之前不解码
+    }
+
+    std::vector<int16_t> frame;
+    if (opus_->Decode(std::move(packet), frame)) {
+        pcm.insert(pcm.end(), frame.begin(), frame.end());
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef MUSIC_DECODER_H
+#define MUSIC_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// MP3解码器支持
+extern "C" {
+#include "mp3dec.h"
+}
+
+#include <opus_decoder.h>
+
+// 音乐流解码器抽象:下载到的字节流经 DecodeFrame 逐帧转成 PCM,
+// MP3 和 Ogg-Opus 共用 Esp32Music 的环形缓冲和播放流水线。
+//
+// DecodeFrame 约定:
+//  - 返回本次消费的输入字节数,0 表示数据不足需要续填;
+//  - 产出音频时 pcm 非空并填好 sample_rate/channels;
+//    消费了字节但 pcm 为空表示跳过了垃圾或容器头部数据。
+class MusicDecoder {
+public:
+    virtual ~MusicDecoder() = default;
+
+    virtual const char* name() const = 0;
+    virtual size_t DecodeFrame(const uint8_t* data, size_t size, std::vector<int16_t>& pcm,
+                               int& sample_rate, int& channels) = 0;
+
+    // 按流头部字节探测格式(Http 封装拿不到 Content-Type 响应头,只能嗅探):
+    // "OggS" 魔数走 Ogg-Opus,其余按 MP3 处理
+    static std::unique_ptr<MusicDecoder> CreateForStream(const uint8_t* header, size_t size);
+};
+
+// libhelix MP3 解码,同步字查找和坏帧跳过都在内部处理
+class Mp3MusicDecoder : public MusicDecoder {
+public:
+    Mp3MusicDecoder();
+    ~Mp3MusicDecoder() override;
+
+    const char* name() const override { return "mp3"; }
+    size_t DecodeFrame(const uint8_t* data, size_t size, std::vector<int16_t>& pcm,
+                       int& sample_rate, int& channels) override;
+
+private:
+    HMP3Decoder decoder_ = nullptr;
+    MP3FrameInfo frame_info_ = {};
+    int16_t pcm_buffer_[2304];  // 最大一帧:1152样本*双声道
+};
+
+// Ogg 封装的 Opus 解码:逐页拆包后复用音频服务的 OpusDecoderWrapper,
+// 同码率下体积约为 MP3 的一半,4G 部署省流量也更少补货停顿
+class OggOpusMusicDecoder : public MusicDecoder {
+public:
+    const char* name() const override { return "ogg-opus"; }
+    size_t DecodeFrame(const uint8_t* data, size_t size, std::vector<int16_t>& pcm,
+                       int& sample_rate, int& channels) override;
+
+private:
+    void HandlePacket(std::vector<uint8_t>&& packet, std::vector<int16_t>& pcm);
+
+    std::unique_ptr<OpusDecoderWrapper> opus_;
+    std::vector<uint8_t> packet_carry_;  // 跨页续传的半个包
+    int channels_ = 1;
+};
+
+#endif // MUSIC_DECODER_H
@@ -9,6 +9,10 @@
 
 PowerSaveTimer::PowerSaveTimer(int cpu_max_freq, int seconds_to_sleep, int seconds_to_shutdown)
     : cpu_max_freq_(cpu_max_freq), seconds_to_sleep_(seconds_to_sleep), seconds_to_shutdown_(seconds_to_shutdown) {
+    // 默认在浅省电3倍时长后进入深度省电(关闭拾音)
+    if (seconds_to_sleep_ != -1) {
+        seconds_to_deep_sleep_ = seconds_to_sleep_ * 3;
+    }
     esp_timer_create_args_t timer_args = {
         .callback = [](void* arg) {
             auto self = static_cast<PowerSaveTimer*>(arg);
@@ -47,6 +51,10 @@ void PowerSaveTimer::SetEnabled(bool enabled) {
     }
 }
 
+void PowerSaveTimer::SetDeepSleepSeconds(int seconds) {
+    seconds_to_deep_sleep_ = seconds;
+}
+
 void PowerSaveTimer::OnEnterSleepMode(std::function<void()> callback) {
     on_enter_sleep_mode_ = callback;
 }
@@ -69,26 +77,16 @@ void PowerSaveTimer::PowerSaveCheck() {
     ticks_++;
     if (seconds_to_sleep_ != -1 && ticks_ >= seconds_to_sleep_) {
         if (!in_sleep_mode_) {
-            ESP_LOGI(TAG, "Enabling power save mode");
+            ESP_LOGI(TAG, "Enabling power save mode (wake word stays active)");
             in_sleep_mode_ = true;
             if (on_enter_sleep_mode_) {
                 on_enter_sleep_mode_();
             }
 
             if (cpu_max_freq_ != -1) {
-                // Disable wake word detection
-                auto& audio_service = app.GetAudioService();
-                is_wake_word_running_ = audio_service.IsWakeWordRunning();
-                if (is_wake_word_running_) {
-                    audio_service.EnableWakeWordDetection(false);
-                    vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                // Disable audio input
-                auto codec = Board::GetInstance().GetAudioCodec();
-                if (codec) {
-                    codec->EnableInput(false);
-                }
-
+                // 浅省电:开DFS+tickless light sleep但保留唤醒词检测。
+                // I2S DMA和AFE在需要算力时会把频率顶上去,帧间CPU可以睡;
+                // 唤醒只需恢复频率上限,从唤醒词命中到进入聆听远低于100ms
                 esp_pm_config_t pm_config = {
                     .max_freq_mhz = cpu_max_freq_,
                     .min_freq_mhz = 40,
@@ -98,15 +96,38 @@ void PowerSaveTimer::PowerSaveCheck() {
             }
         }
     }
+    if (seconds_to_deep_sleep_ != -1 && ticks_ >= seconds_to_deep_sleep_ && !in_deep_sleep_mode_) {
+        EnterDeepPowerSave();
+    }
     if (seconds_to_shutdown_ != -1 && ticks_ >= seconds_to_shutdown_ && on_shutdown_request_) {
         on_shutdown_request_();
     }
 }
 
+void PowerSaveTimer::EnterDeepPowerSave() {
+    // 深度省电:长时间无人使用,关掉拾音链路进一步压电流。
+    // 这之后设备对唤醒词失聪,只能按键/触摸唤醒
+    ESP_LOGI(TAG, "Enabling deep power save mode (audio input off)");
+    in_deep_sleep_mode_ = true;
+
+    if (cpu_max_freq_ != -1) {
+        auto& audio_service = Application::GetInstance().GetAudioService();
+        is_wake_word_running_ = audio_service.IsWakeWordRunning();
+        if (is_wake_word_running_) {
+            audio_service.EnableWakeWordDetection(false);
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+        auto codec = Board::GetInstance().GetAudioCodec();
+        if (codec) {
+            codec->EnableInput(false);
+        }
+    }
+}
+
 void PowerSaveTimer::WakeUp() {
     ticks_ = 0;
     if (in_sleep_mode_) {
-        ESP_LOGI(TAG, "Exiting power save mode");
+        int64_t wake_start_us = esp_timer_get_time();
         in_sleep_mode_ = false;
 
         if (cpu_max_freq_ != -1) {
@@ -117,16 +138,20 @@ void PowerSaveTimer::WakeUp() {
             };
             esp_pm_configure(&pm_config);
 
-            // Enable wake word detection
-            auto& app = Application::GetInstance();
-            auto& audio_service = app.GetAudioService();
-            if (is_wake_word_running_) {
-                audio_service.EnableWakeWordDetection(true);
+            if (in_deep_sleep_mode_) {
+                // 深度省电才关过拾音,恢复它
+                auto& audio_service = Application::GetInstance().GetAudioService();
+                if (is_wake_word_running_) {
+                    audio_service.EnableWakeWordDetection(true);
+                }
             }
         }
+        in_deep_sleep_mode_ = false;
 
         if (on_exit_sleep_mode_) {
             on_exit_sleep_mode_();
         }
+        ESP_LOGI(TAG, "Exited power save mode in %lld ms",
+                 (esp_timer_get_time() - wake_start_us) / 1000);
     }
 }
@@ -11,6 +11,8 @@ public:
     ~PowerSaveTimer();
 
     void SetEnabled(bool enabled);
+    // 深度省电(关闭拾音)的进入时间,默认为seconds_to_sleep的3倍;-1禁用
+    void SetDeepSleepSeconds(int seconds);
     void OnEnterSleepMode(std::function<void()> callback);
     void OnExitSleepMode(std::function<void()> callback);
     void OnShutdownRequest(std::function<void()> callback);
@@ -18,14 +20,17 @@ public:
 
 private:
     void PowerSaveCheck();
+    void EnterDeepPowerSave();
 
     esp_timer_handle_t power_save_timer_ = nullptr;
     bool enabled_ = false;
     bool in_sleep_mode_ = false;
+    bool in_deep_sleep_mode_ = false;
     bool is_wake_word_running_ = false;
     int ticks_ = 0;
     int cpu_max_freq_;
     int seconds_to_sleep_;
+    int seconds_to_deep_sleep_ = -1;
     int seconds_to_shutdown_;
 
     std::function<void()> on_enter_sleep_mode_;
@@ -4,12 +4,16 @@
 #include "application.h"
 #include "system_info.h"
 #include "settings.h"
+#include "heap_telemetry.h"
 #include "assets/lang_config.h"
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_network.h>
 #include <esp_log.h>
+#include <esp_wifi.h>
+#include <cstring>
+#include <vector>
 
 #include <font_awesome.h>
 #include <wifi_station.h>
@@ -114,6 +118,72 @@ void WifiBoard::StartNetwork() {
         EnterWifiConfigMode();
         return;
     }
+
+    // 多AP环境下设备会黏在远处的AP上丢包,起个低优先级的质量治理任务
+    xTaskCreate([](void* arg) {
+        static_cast<WifiBoard*>(arg)->QualityGovernorTask();
+        vTaskDelete(NULL);
+    }, "wifi_governor", 4096, this, 2, nullptr);
+}
+
+void WifiBoard::QualityGovernorTask() {
+    auto& wifi_station = WifiStation::GetInstance();
+    int poor_checks = 0;
+    const int kRoamRssiThreshold = -70;   // 低于此值视为弱信号
+    const int kRoamHysteresisDb = 10;     // 邻居至少强10dB才值得断开漫游
+
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(10000));
+        if (!wifi_station.IsConnected()) {
+            poor_checks = 0;
+            continue;
+        }
+        int rssi = wifi_station.GetRssi();
+        poor_checks = rssi < kRoamRssiThreshold ? poor_checks + 1 : 0;
+        if (poor_checks < 3) {
+            continue;
+        }
+        // 只在空闲态扫描,射频扫描绝不和聆听/播报撞车
+        if (Application::GetInstance().GetDeviceState() != kDeviceStateIdle) {
+            continue;
+        }
+        poor_checks = 0;
+
+        // 同SSID定向扫描,找当前BSSID以外明显更强的邻居AP
+        std::string ssid = wifi_station.GetSsid();
+        wifi_scan_config_t scan_config = {};
+        scan_config.ssid = (uint8_t*)ssid.c_str();
+        if (esp_wifi_scan_start(&scan_config, true) != ESP_OK) {
+            continue;
+        }
+        uint16_t ap_count = 0;
+        esp_wifi_scan_get_ap_num(&ap_count);
+        if (ap_count == 0) {
+            continue;
+        }
+        std::vector<wifi_ap_record_t> records(ap_count);
+        if (esp_wifi_scan_get_ap_records(&ap_count, records.data()) != ESP_OK) {
+            continue;
+        }
+        wifi_ap_record_t current;
+        if (esp_wifi_sta_get_ap_info(&current) != ESP_OK) {
+            continue;
+        }
+        int best_rssi = -128;
+        for (uint16_t i = 0; i < ap_count; i++) {
+            if (memcmp(records[i].bssid, current.bssid, sizeof(current.bssid)) != 0 &&
+                records[i].rssi > best_rssi) {
+                best_rssi = records[i].rssi;
+            }
+        }
+        if (best_rssi >= current.rssi + kRoamHysteresisDb) {
+            ESP_LOGW(TAG, "Roaming: current AP %d dBm, neighbor %d dBm, reconnecting",
+                     current.rssi, best_rssi);
+            roam_count_++;
+            // 断开让wifi栈按信号强度重连,会挑上刚扫到的强邻居
+            esp_wifi_disconnect();
+        }
+    }
 }
 
 NetworkInterface* WifiBoard::GetNetwork() {
@@ -168,6 +238,7 @@ void WifiBoard::ResetWifiConfiguration() {
         settings.SetInt("force_ap", 1);
     }
     GetDisplay()->ShowNotification(Lang::Strings::ENTERING_WIFI_CONFIG_MODE);
+    Settings::Flush();  // force_ap标志走写合并层,重启前必须落盘
     vTaskDelay(pdMS_TO_TICKS(1000));
     // Reboot the device
     esp_restart();
@@ -250,6 +321,9 @@ std::string WifiBoard::GetDeviceStatusJson() {
     } else {
         cJSON_AddStringToObject(network, "signal", "weak");
     }
+    // 连接质量:原始RSSI和质量治理的漫游次数
+    cJSON_AddNumberToObject(network, "rssi", rssi);
+    cJSON_AddNumberToObject(network, "roam_count", roam_count_);
     cJSON_AddItemToObject(root, "network", network);
 
     // Chip
@@ -260,6 +334,15 @@ std::string WifiBoard::GetDeviceStatusJson() {
         cJSON_AddItemToObject(root, "chip", chip);
     }
 
+    // Heap telemetry (per-subsystem watermarks)
+    HeapTelemetry::GetInstance().AddHeapSection(root);
+
+    // 无崩溃运行时长(检测到coredump时清零)
+    {
+        Settings settings("crash", false);
+        cJSON_AddNumberToObject(root, "crash_free_hours", settings.GetInt("uptime_hours"));
+    }
+
     auto json_str = cJSON_PrintUnformatted(root);
     std::string json(json_str);
     cJSON_free(json_str);
@@ -9,6 +9,11 @@ protected:
     void EnterWifiConfigMode();
     virtual std::string GetBoardJson() override;
 
+    // 连接质量治理:低优先级任务周期读RSSI,持续弱信号且设备空闲时
+    // 做同SSID邻居扫描,发现明显更强的AP才触发漫游重连
+    uint32_t roam_count_ = 0;
+    void QualityGovernorTask();
+
 public:
     WifiBoard();
     virtual std::string GetBoardType() override;
@@ -23,6 +23,7 @@ struct ElectronBotActionParams {
     int speed;
     int direction;
     int amount;
+    uint32_t motion_id;  // 入队时分配的递增编号,用于查询动作进度
 };
 
 class ElectronBotController {
@@ -31,6 +32,9 @@ private:
     TaskHandle_t action_task_handle_ = nullptr;
     QueueHandle_t action_queue_;
     bool is_action_in_progress_ = false;
+    uint32_t next_motion_id_ = 0;
+    volatile uint32_t current_motion_id_ = 0;
+    volatile uint32_t last_completed_motion_id_ = 0;
 
     enum ActionType {
         // 手部动作 1-12
@@ -70,7 +74,9 @@ private:
 
         while (true) {
             if (xQueueReceive(controller->action_queue_, &params, pdMS_TO_TICKS(1000)) == pdTRUE) {
-                ESP_LOGI(TAG, "执行动作: %d", params.action_type);
+                ESP_LOGI(TAG, "执行动作: %d (motion_id=%lu)", params.action_type,
+                         (unsigned long)params.motion_id);
+                controller->current_motion_id_ = params.motion_id;
                 controller->is_action_in_progress_ = true;  // 开始执行动作
 
                 // 执行相应的动作
@@ -95,19 +101,23 @@ private:
                     // 复位动作
                     controller->electron_bot_.Home(true);
                 }
+                controller->last_completed_motion_id_ = params.motion_id;
                 controller->is_action_in_progress_ = false;  // 动作执行完毕
             }
             vTaskDelay(pdMS_TO_TICKS(20));
         }
     }
 
-    void QueueAction(int action_type, int steps, int speed, int direction, int amount) {
+    // 入队后立即返回分配的motion_id,动作由后台任务顺序执行
+    uint32_t QueueAction(int action_type, int steps, int speed, int direction, int amount) {
         ESP_LOGI(TAG, "动作控制: 类型=%d, 步数=%d, 速度=%d, 方向=%d, 幅度=%d", action_type, steps,
                  speed, direction, amount);
 
-        ElectronBotActionParams params = {action_type, steps, speed, direction, amount};
+        uint32_t motion_id = ++next_motion_id_;
+        ElectronBotActionParams params = {action_type, steps, speed, direction, amount, motion_id};
         xQueueSend(action_queue_, &params, portMAX_DELAY);
         StartActionTaskIfNeeded();
+        return motion_id;
     }
 
     void StartActionTaskIfNeeded() {
@@ -153,7 +163,7 @@ public:
             "self.electron.hand_action",
             "手部动作控制。action: 1=举手, 2=放手, 3=挥手, 4=拍打; hand: 1=左手, 2=右手, 3=双手; "
             "steps: 动作重复次数(1-10); speed: 动作速度(500-1500，数值越小越快); amount: "
-            "动作幅度(10-50，仅举手动作使用)",
+            "动作幅度(10-50，仅举手动作使用)。动作入队后立即返回motion_id",
             PropertyList({Property("action", kPropertyTypeInteger, 1, 1, 4),
                           Property("hand", kPropertyTypeInteger, 3, 1, 3),
                           Property("steps", kPropertyTypeInteger, 1, 1, 10),
@@ -189,15 +199,16 @@ public:
                 }
                 int action_id = base_action + (hand_type - 1);
 
-                QueueAction(action_id, steps, speed, 0, amount);
-                return true;
+                uint32_t motion_id = QueueAction(action_id, steps, speed, 0, amount);
+                return "{\"motion_id\":" + std::to_string(motion_id) + "}";
             });
 
         // 身体动作
         mcp_server.AddTool(
             "self.electron.body_turn",
             "身体转向。steps: 转向步数(1-10); speed: 转向速度(500-1500，数值越小越快); direction: "
-            "转向方向(1=左转, 2=右转, 3=回中心); angle: 转向角度(0-90度)",
+            "转向方向(1=左转, 2=右转, 3=回中心); angle: 转向角度(0-90度)。"
+            "动作入队后立即返回motion_id",
             PropertyList({Property("steps", kPropertyTypeInteger, 1, 1, 10),
                           Property("speed", kPropertyTypeInteger, 1000, 500, 1500),
                           Property("direction", kPropertyTypeInteger, 1, 1, 3),
@@ -223,15 +234,15 @@ public:
                         action = ACTION_BODY_TURN_LEFT;
                 }
 
-                QueueAction(action, steps, speed, 0, amount);
-                return true;
+                uint32_t motion_id = QueueAction(action, steps, speed, 0, amount);
+                return "{\"motion_id\":" + std::to_string(motion_id) + "}";
             });
 
         // 头部动作
         mcp_server.AddTool("self.electron.head_move",
                            "头部运动。action: 1=抬头, 2=低头, 3=点头, 4=回中心, 5=连续点头; steps: "
                            "动作重复次数(1-10); speed: 动作速度(500-1500，数值越小越快); angle: "
-                           "头部转动角度(1-15度)",
+                           "头部转动角度(1-15度)。动作入队后立即返回motion_id",
                            PropertyList({Property("action", kPropertyTypeInteger, 3, 1, 5),
                                          Property("steps", kPropertyTypeInteger, 1, 1, 10),
                                          Property("speed", kPropertyTypeInteger, 1000, 500, 1500),
@@ -242,8 +253,8 @@ public:
                                int speed = properties["speed"].value<int>();
                                int amount = properties["angle"].value<int>();
                                int action = ACTION_HEAD_UP + (action_num - 1);
-                               QueueAction(action, steps, speed, 0, amount);
-                               return true;
+                               uint32_t motion_id = QueueAction(action, steps, speed, 0, amount);
+                               return "{\"motion_id\":" + std::to_string(motion_id) + "}";
                            });
 
         // 系统工具
@@ -256,10 +267,18 @@ public:
                                return true;
                            });
 
-        mcp_server.AddTool("self.electron.get_status", "获取机器人状态，返回 moving 或 idle",
-                           PropertyList(), [this](const PropertyList& properties) -> ReturnValue {
-                               return is_action_in_progress_ ? "moving" : "idle";
-                           });
+        mcp_server.AddTool(
+            "self.electron.get_status",
+            "获取机器人状态。返回status(moving/idle)、正在执行和最近完成的motion_id、排队中的动作数",
+            PropertyList(), [this](const PropertyList& properties) -> ReturnValue {
+                std::string status =
+                    std::string("{\"status\":\"") +
+                    (is_action_in_progress_ ? "moving" : "idle") + "\"" +
+                    ",\"current_motion_id\":" + std::to_string(current_motion_id_) +
+                    ",\"last_completed_motion_id\":" + std::to_string(last_completed_motion_id_) +
+                    ",\"queued\":" + std::to_string(uxQueueMessagesWaiting(action_queue_)) + "}";
+                return status;
+            });
 
         // 单个舵机校准工具
         mcp_server.AddTool(
@@ -82,21 +82,14 @@ void Otto::MoveServos(int time, int servo_target[]) {
 
     final_time_ = millis() + time;
     if (time > 10) {
+        // 六路舵机同时下发硬件渐变,动作队列里前后两个姿态之间
+        // 由LEDC插值衔接,不再有10ms微步的顿挫
         for (int i = 0; i < SERVO_COUNT; i++) {
             if (servo_pins_[i] != -1) {
-                increment_[i] = (servo_target[i] - servo_[i].GetPosition()) / (time / 10.0);
+                servo_[i].FadeTo(servo_target[i], time);
             }
         }
-
-        for (int iteration = 1; millis() < final_time_; iteration++) {
-            partial_time_ = millis() + 10;
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_[i].GetPosition() + increment_[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-        }
+        vTaskDelay(pdMS_TO_TICKS(time));
     } else {
         for (int i = 0; i < SERVO_COUNT; i++) {
             if (servo_pins_[i] != -1) {
@@ -106,27 +99,12 @@ void Otto::MoveServos(int time, int servo_target[]) {
         vTaskDelay(pdMS_TO_TICKS(time));
     }
 
-    // final adjustment to the target.
-    bool f = true;
-    int adjustment_count = 0;
-    while (f && adjustment_count < 10) {
-        f = false;
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1 && servo_target[i] != servo_[i].GetPosition()) {
-                f = true;
-                break;
-            }
-        }
-        if (f) {
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_target[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-            adjustment_count++;
+    // 渐变完成后按精确目标补写一次,去掉占空比取整误差
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        if (servo_pins_[i] != -1) {
+            servo_[i].SetPosition(servo_target[i]);
         }
-    };
+    }
 }
 
 void Otto::MoveSingle(int position, int servo_number) {
@@ -155,16 +133,24 @@ void Otto::OscillateServos(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT],
         }
     }
 
-    double ref = millis();
-    double end_time = period * cycle + ref;
-
-    while (millis() < end_time) {
+    // 每周期取16个关键帧,帧间交给LEDC硬件渐变;六路舵机共用
+    // 同一个节拍,CPU每帧只醒一次,取代原来的5ms轮询
+    const int kSegmentsPerCycle = 16;
+    int segment_ms = period / kSegmentsPerCycle;
+    if (segment_ms < 20) {
+        segment_ms = 20;
+    }
+    int total_ms = (int)(period * cycle);
+    for (int elapsed = 0; elapsed < total_ms; elapsed += segment_ms) {
+        int step_ms = total_ms - elapsed < segment_ms ? total_ms - elapsed : segment_ms;
+        // 用段末相位,保证渐变结束时刚好落在正弦采样点上
+        double phase = 2 * M_PI * (elapsed + step_ms) / period;
         for (int i = 0; i < SERVO_COUNT; i++) {
             if (servo_pins_[i] != -1) {
-                servo_[i].Refresh();
+                servo_[i].FadeToPhase(phase, step_ms);
             }
         }
-        vTaskDelay(5);
+        vTaskDelay(pdMS_TO_TICKS(step_ms));
     }
     vTaskDelay(pdMS_TO_TICKS(10));
 }
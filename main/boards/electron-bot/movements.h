@@ -77,8 +77,6 @@ private:
     int servo_initial_[SERVO_COUNT] = {180, 180, 0, 0, 90, 90};
 
     unsigned long final_time_;
-    unsigned long partial_time_;
-    float increment_[SERVO_COUNT];
 
     bool is_otto_resting_;
 
@@ -78,6 +78,13 @@ void Oscillator::Attach(int pin, bool rev) {
                                           .hpoint = 0};
     ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
 
+    // FadeTo依赖硬件渐变服务在关键帧之间插值占空比,全局只装一次
+    static bool fade_service_installed = false;
+    if (!fade_service_installed) {
+        ESP_ERROR_CHECK(ledc_fade_func_install(0));
+        fade_service_installed = true;
+    }
+
     ledc_speed_mode_ = LEDC_LOW_SPEED_MODE;
 
     // pos_ = 90;
@@ -120,6 +127,30 @@ void Oscillator::Refresh() {
     }
 }
 
+void Oscillator::FadeTo(int position, int duration_ms) {
+    if (!is_attached_)
+        return;
+
+    pos_ = position;
+    previous_servo_command_millis_ = millis();
+
+    int angle = std::min(std::max(position + trim_, 0), 180);
+    uint32_t duty = (uint32_t)(((angle / 180.0) * 2.0 + 0.5) * 8191 / 20.0);
+
+    ESP_ERROR_CHECK(ledc_set_fade_with_time(ledc_speed_mode_, ledc_channel_, duty, duration_ms));
+    ESP_ERROR_CHECK(ledc_fade_start(ledc_speed_mode_, ledc_channel_, LEDC_FADE_NO_WAIT));
+}
+
+void Oscillator::FadeToPhase(double phase, int duration_ms) {
+    if (stop_)
+        return;
+
+    int pos = std::round(amplitude_ * std::sin(phase + phase0_) + offset_);
+    if (rev_)
+        pos = -pos;
+    FadeTo(pos + 90, duration_ms);
+}
+
 void Oscillator::Write(int position) {
     if (!is_attached_)
         return;
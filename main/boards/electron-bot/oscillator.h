@@ -35,6 +35,11 @@ public:
     void DisableLimiter() { diff_limit_ = 0; };
     int GetTrim() { return trim_; };
     void SetPosition(int position);
+    // 由LEDC硬件在duration_ms内从当前占空比平滑渐变到目标角度,
+    // 中间不需要CPU参与;position取值0-180,与SetPosition一致
+    void FadeTo(int position, int duration_ms);
+    // 取当前振幅/偏移/初相在phase处的采样点,硬件渐变到该角度
+    void FadeToPhase(double phase, int duration_ms);
     void Stop() { stop_ = true; };
     void Play() { stop_ = false; };
     void Reset() { phase_ = 0; };
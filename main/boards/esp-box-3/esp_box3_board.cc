@@ -5,6 +5,7 @@
 #include "display/lcd_display.h"
 #include "esp_lcd_ili9341.h"
 #include "application.h"
+#include "board_descriptor.h"
 #include "button.h"
 #include "config.h"
 
@@ -37,6 +38,15 @@ static const ili9341_lcd_init_cmd_t vendor_specific_init[] = {
     {0, (uint8_t []){0}, 0xff, 0},
 };
 
+// 接线描述符:编译期常量,总线初始化样板收敛在board_descriptor.h
+static constexpr I2cBusDescriptor kCodecI2cBus = {
+    I2C_NUM_1, AUDIO_CODEC_I2C_SDA_PIN, AUDIO_CODEC_I2C_SCL_PIN};
+static constexpr SpiBusDescriptor kDisplaySpiBus = {
+    SPI3_HOST, GPIO_NUM_6, GPIO_NUM_7,
+    static_cast<int>(DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(uint16_t))};
+static constexpr SpiPanelIoDescriptor kDisplayPanelIo = {
+    SPI3_HOST, GPIO_NUM_5, GPIO_NUM_4, 40 * 1000 * 1000};
+
 class EspBox3Board : public WifiBoard {
 private:
     i2c_master_bus_handle_t i2c_bus_;
@@ -44,31 +54,11 @@ private:
     Display* display_;
 
     void InitializeI2c() {
-        // Initialize I2C peripheral
-        i2c_master_bus_config_t i2c_bus_cfg = {
-            .i2c_port = (i2c_port_t)1,
-            .sda_io_num = AUDIO_CODEC_I2C_SDA_PIN,
-            .scl_io_num = AUDIO_CODEC_I2C_SCL_PIN,
-            .clk_source = I2C_CLK_SRC_DEFAULT,
-            .glitch_ignore_cnt = 7,
-            .intr_priority = 0,
-            .trans_queue_depth = 0,
-            .flags = {
-                .enable_internal_pullup = 1,
-            },
-        };
-        ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_bus_cfg, &i2c_bus_));
+        i2c_bus_ = InitI2cBus(kCodecI2cBus);
     }
 
     void InitializeSpi() {
-        spi_bus_config_t buscfg = {};
-        buscfg.mosi_io_num = GPIO_NUM_6;
-        buscfg.miso_io_num = GPIO_NUM_NC;
-        buscfg.sclk_io_num = GPIO_NUM_7;
-        buscfg.quadwp_io_num = GPIO_NUM_NC;
-        buscfg.quadhd_io_num = GPIO_NUM_NC;
-        buscfg.max_transfer_sz = DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(uint16_t);
-        ESP_ERROR_CHECK(spi_bus_initialize(SPI3_HOST, &buscfg, SPI_DMA_CH_AUTO));
+        InitSpiBus(kDisplaySpiBus);
     }
 
     void InitializeButtons() {
@@ -91,20 +81,11 @@ private:
     }
 
     void InitializeIli9341Display() {
-        esp_lcd_panel_io_handle_t panel_io = nullptr;
         esp_lcd_panel_handle_t panel = nullptr;
 
         // 液晶屏控制IO初始化
         ESP_LOGD(TAG, "Install panel IO");
-        esp_lcd_panel_io_spi_config_t io_config = {};
-        io_config.cs_gpio_num = GPIO_NUM_5;
-        io_config.dc_gpio_num = GPIO_NUM_4;
-        io_config.spi_mode = 0;
-        io_config.pclk_hz = 40 * 1000 * 1000;
-        io_config.trans_queue_depth = 10;
-        io_config.lcd_cmd_bits = 8;
-        io_config.lcd_param_bits = 8;
-        ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi(SPI3_HOST, &io_config, &panel_io));
+        esp_lcd_panel_io_handle_t panel_io = InitSpiPanelIo(kDisplayPanelIo);
 
         // 初始化液晶屏驱动芯片
         ESP_LOGD(TAG, "Install LCD driver");
@@ -24,27 +24,6 @@ LV_IMG_DECLARE(ui_img_xiaozhi_48_png);
 
 static const char *TAG = "WeatherClock";
 
-// Helper function to format time
-static void get_time_string(char* hour_min_buf, char* second_buf, char* week_buf, char* date_buf) {
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    
-    // Format hour:minute (HH:MM)
-    snprintf(hour_min_buf, 16, "%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min);
-    
-    // Format second (SS)
-    snprintf(second_buf, 8, "%02d", timeinfo.tm_sec);
-    
-    // Format week (周X)
-    const char* week_names[] = {"日", "一", "二", "三", "四", "五", "六"};
-    snprintf(week_buf, 16, "周%s", week_names[timeinfo.tm_wday]);
-    
-    // Format date (MM月DD日)
-    snprintf(date_buf, 32, "%02d月%02d日", timeinfo.tm_mon + 1, timeinfo.tm_mday);
-}
-
 IdleScreen::IdleScreen() {
     ui_screen = NULL;
     ui_main_container = NULL;
@@ -70,6 +49,11 @@ IdleScreen::IdleScreen() {
     ui_shown = false;
     current_scroll_index = 0;
     last_scroll_time = 0;
+    last_rendered_sec = -1;
+    last_rendered_min = -1;
+    last_rendered_day = -1;
+    icon_angle = 0;
+    last_aqi = -1;
     p_theme = NULL;
 }
 
@@ -204,22 +188,13 @@ void IdleScreen::createMiddleSection() {
     lv_obj_align(ui_time_second, LV_ALIGN_CENTER, 65, -25);
     
     // Rotating Xiaozhi icon (位置在时间下方)
+    // 不再挂lv_anim连续旋转:那会让LVGL以刷新帧率重画旋转后的整个
+    // 包围盒,空闲功耗的大头就在这。改成ui_update里1Hz步进转动,
+    // 动效保留,失效频率和秒标签对齐
     ui_xiaozhi_icon = lv_img_create(ui_time_container);
     lv_img_set_src(ui_xiaozhi_icon, &ui_img_xiaozhi_48_png);
     lv_obj_align(ui_xiaozhi_icon, LV_ALIGN_CENTER, 0, 35);
     lv_img_set_pivot(ui_xiaozhi_icon, 24, 24);  // 设置旋转中心点 (48/2 = 24)
-    
-    // Add rotation animation (使用局部变量，LVGL会自动管理)
-    lv_anim_t anim;
-    lv_anim_init(&anim);
-    lv_anim_set_var(&anim, ui_xiaozhi_icon);
-    lv_anim_set_exec_cb(&anim, (lv_anim_exec_xcb_t)lv_img_set_angle);
-    lv_anim_set_values(&anim, 0, 3600);  // 0-360度 (LVGL使用0.1度单位)
-    lv_anim_set_time(&anim, 3000);       // 3秒转一圈
-    lv_anim_set_repeat_count(&anim, LV_ANIM_REPEAT_INFINITE);
-    lv_anim_start(&anim);
-    
-    ESP_LOGI(TAG, "Xiaozhi rotation animation started");
 }
 
 void IdleScreen::createBottomSection() {
@@ -298,11 +273,6 @@ void IdleScreen::createBottomSection() {
 
 void IdleScreen::ui_destroy() {
     if (ui_screen) {
-        // Stop animation before deleting objects
-        if (ui_xiaozhi_icon) {
-            lv_anim_delete(ui_xiaozhi_icon, NULL);
-        }
-        
         lv_obj_delete(ui_screen);
         ui_screen = NULL;
     }
@@ -314,6 +284,10 @@ void IdleScreen::ui_showScreen(bool showIt) {
     if (showIt) {
         lv_obj_remove_flag(ui_screen, LV_OBJ_FLAG_HIDDEN);
         ui_shown = true;
+        // 隐藏期间时间在走,重新亮出来时强制全部刷新一轮
+        last_rendered_sec = -1;
+        last_rendered_min = -1;
+        last_rendered_day = -1;
     } else {
         lv_obj_add_flag(ui_screen, LV_OBJ_FLAG_HIDDEN);
         ui_shown = false;
@@ -322,27 +296,54 @@ void IdleScreen::ui_showScreen(bool showIt) {
 
 void IdleScreen::ui_update() {
     if (!ui_screen || !ui_shown) return;
-    
-    // Update time display
-    char hour_min_buf[16], second_buf[8], week_buf[16], date_buf[32];
-    get_time_string(hour_min_buf, second_buf, week_buf, date_buf);
-    
-    if (ui_time_hour_min) {
-        lv_label_set_text(ui_time_hour_min, hour_min_buf);
-    }
-    
-    if (ui_time_second) {
-        lv_label_set_text(ui_time_second, second_buf);
+
+    time_t now;
+    struct tm timeinfo;
+    time(&now);
+    localtime_r(&now, &timeinfo);
+
+    // 每个区域按自己的数据节拍失效:秒标签1Hz、时:分每分钟、
+    // 周/日期每天。没变的label一个都不碰,LVGL就不会重画那片区域
+    if (timeinfo.tm_sec != last_rendered_sec) {
+        last_rendered_sec = timeinfo.tm_sec;
+        if (ui_time_second) {
+            char second_buf[8];
+            snprintf(second_buf, sizeof(second_buf), "%02d", timeinfo.tm_sec);
+            lv_label_set_text(ui_time_second, second_buf);
+        }
+        // 图标跟秒标签同节拍步进旋转(0.1度单位,12秒一圈)
+        if (ui_xiaozhi_icon) {
+            icon_angle = (icon_angle + 300) % 3600;
+            lv_img_set_angle(ui_xiaozhi_icon, icon_angle);
+        }
     }
-    
-    if (ui_week_label) {
-        lv_label_set_text(ui_week_label, week_buf);
+
+    int minute_of_day = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+    if (minute_of_day != last_rendered_min) {
+        last_rendered_min = minute_of_day;
+        if (ui_time_hour_min) {
+            char hour_min_buf[16];
+            snprintf(hour_min_buf, sizeof(hour_min_buf), "%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min);
+            lv_label_set_text(ui_time_hour_min, hour_min_buf);
+        }
     }
-    
-    if (ui_date_label) {
-        lv_label_set_text(ui_date_label, date_buf);
+
+    int day = timeinfo.tm_year * 400 + timeinfo.tm_yday;
+    if (day != last_rendered_day) {
+        last_rendered_day = day;
+        if (ui_week_label) {
+            const char* week_names[] = {"日", "一", "二", "三", "四", "五", "六"};
+            char week_buf[16];
+            snprintf(week_buf, sizeof(week_buf), "周%s", week_names[timeinfo.tm_wday]);
+            lv_label_set_text(ui_week_label, week_buf);
+        }
+        if (ui_date_label) {
+            char date_buf[32];
+            snprintf(date_buf, sizeof(date_buf), "%02d月%02d日", timeinfo.tm_mon + 1, timeinfo.tm_mday);
+            lv_label_set_text(ui_date_label, date_buf);
+        }
     }
-    
+
     // Update scroll text every 2.5 seconds
     updateScrollText();
 }
@@ -368,29 +369,34 @@ void IdleScreen::ui_updateTheme(ThemeColors *p_current_theme) {
 
 void IdleScreen::ui_updateWeather(const WeatherData& weather) {
     ESP_LOGI(TAG, "Updating weather data");
-    
-    // Update city name
-    if (ui_city_label) {
+
+    // 天气10分钟才抓一次,且多数轮次数值没变:逐项和已上屏的值
+    // 比对,变了才写label,没变这轮一个像素都不失效
+    if (ui_city_label && weather.city_name != last_city_text) {
+        last_city_text = weather.city_name;
         lv_label_set_text(ui_city_label, weather.city_name.c_str());
     }
-    
-    // Update temperature
+
     if (ui_temp_label) {
         std::string temp_text = weather.temperature + "℃";
-        lv_label_set_text(ui_temp_label, temp_text.c_str());
+        if (temp_text != last_temp_text) {
+            last_temp_text = temp_text;
+            lv_label_set_text(ui_temp_label, temp_text.c_str());
+        }
     }
-    
-    // Update humidity
-    if (ui_humid_label) {
+
+    if (ui_humid_label && weather.humidity != last_humid_text) {
+        last_humid_text = weather.humidity;
         lv_label_set_text(ui_humid_label, weather.humidity.c_str());
     }
-    
-    // Update AQI
-    if (ui_aqi_label) {
+
+    if (ui_aqi_label && (weather.aqi_desc != last_aqi_text || weather.aqi != last_aqi)) {
+        last_aqi_text = weather.aqi_desc;
+        last_aqi = weather.aqi;
         lv_label_set_text(ui_aqi_label, weather.aqi_desc.c_str());
         updateAQIColor(weather.aqi);
     }
-    
+
     // Update scroll texts
     std::vector<std::string> texts;
     texts.push_back("实时天气 " + weather.weather_desc);
@@ -403,6 +409,11 @@ void IdleScreen::ui_updateWeather(const WeatherData& weather) {
 }
 
 void IdleScreen::ui_setScrollText(const std::vector<std::string>& texts) {
+    // 内容没变就别重置轮播:避免每次天气抓取都把滚动条打回第一条
+    // 并重画一遍同样的文字
+    if (texts == scroll_texts) {
+        return;
+    }
     scroll_texts = texts;
     current_scroll_index = 0;
     last_scroll_time = lv_tick_get();
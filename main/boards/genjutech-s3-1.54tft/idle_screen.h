@@ -110,7 +110,20 @@ private:
     std::vector<std::string> scroll_texts;
     int current_scroll_index;
     uint32_t last_scroll_time;
-    
+
+    // 脏驱动缓存:记录已上屏的值,真变了才碰对应label。
+    // lv_label_set_text即使内容相同也会invalidate整块区域,跳过它
+    // LVGL的局部刷新才真正省下来,渲染任务其余时间休眠
+    int last_rendered_sec;
+    int last_rendered_min;   // 时*60+分
+    int last_rendered_day;   // 年*400+年内第几天
+    int icon_angle;          // 0.1度单位,1Hz步进
+    std::string last_city_text;
+    std::string last_temp_text;
+    std::string last_humid_text;
+    std::string last_aqi_text;
+    int last_aqi;
+
     // Theme
     ThemeColors* p_theme;
 };
@@ -24,19 +24,22 @@ public:
     Pmic(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : Axp2101(i2c_bus, addr) {
         uint8_t data = ReadReg(0x90);
         data |= 0b10110100;
-        WriteReg(0x90, data);
-        WriteReg(0x99, (0b11110 - 5));
-        WriteReg(0x97, (0b11110 - 2));
-        WriteReg(0x69, 0b00110101);
-        WriteReg(0x30, 0b111111);
-        WriteReg(0x90, 0xBF);
-        WriteReg(0x94, 33 - 5);
-        WriteReg(0x95, 33 - 5);
+        WriteRegs({
+            {0x90, data},
+            {0x99, (0b11110 - 5)},
+            {0x97, (0b11110 - 2)},
+            {0x69, 0b00110101},
+            {0x30, 0b111111},
+            {0x90, 0xBF},
+            {0x94, 33 - 5},
+            {0x95, 33 - 5},
+        });
     }
 
     void SetBrightness(uint8_t brightness) {
         brightness = ((brightness + 641) >> 5);
-        WriteReg(0x99, brightness);
+        // 背光调节走异步写,滑动调亮度时不阻塞调用方
+        WriteRegAsync(0x99, brightness);
     }
 };
 
@@ -57,13 +60,15 @@ class Aw9523 : public I2cDevice {
 public:
     // Exanpd IO Init
     Aw9523(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : I2cDevice(i2c_bus, addr) {
-        WriteReg(0x02, 0b00000111);  // P0
-        WriteReg(0x03, 0b10001111);  // P1
-        WriteReg(0x04, 0b00011000);  // CONFIG_P0
-        WriteReg(0x05, 0b00001100);  // CONFIG_P1
-        WriteReg(0x11, 0b00010000);  // GCR P0 port is Push-Pull mode.
-        WriteReg(0x12, 0b11111111);  // LEDMODE_P0
-        WriteReg(0x13, 0b11111111);  // LEDMODE_P1
+        WriteRegs({
+            {0x02, 0b00000111},  // P0
+            {0x03, 0b10001111},  // P1
+            {0x04, 0b00011000},  // CONFIG_P0
+            {0x05, 0b00001100},  // CONFIG_P1
+            {0x11, 0b00010000},  // GCR P0 port is Push-Pull mode.
+            {0x12, 0b11111111},  // LEDMODE_P0
+            {0x13, 0b11111111},  // LEDMODE_P1
+        });
     }
 
     void ResetAw88298() {
@@ -35,6 +35,11 @@ public:
     void DisableLimiter() { diff_limit_ = 0; };
     int GetTrim() { return trim_; };
     void SetPosition(int position);
+    // 让LEDC硬件在duration_ms内从当前占空比渐变到目标角度,
+    // 运动期间不占CPU;position语义与SetPosition一致(0-180)
+    void FadeTo(int position, int duration_ms);
+    // 按当前振幅/偏移/相位参数计算phase处的采样点并硬件渐变过去
+    void FadeToPhase(double phase, int duration_ms);
     void Stop() { stop_ = true; };
     void Play() { stop_ = false; };
     void Reset() { phase_ = 0; };
@@ -93,21 +93,14 @@ void Otto::MoveServos(int time, int servo_target[]) {
 
     final_time_ = millis() + time;
     if (time > 10) {
+        // 目标角度交给LEDC硬件渐变插值,运动期间CPU完全空闲,
+        // 也不再有10ms微步带来的台阶感
         for (int i = 0; i < SERVO_COUNT; i++) {
             if (servo_pins_[i] != -1) {
-                increment_[i] = (servo_target[i] - servo_[i].GetPosition()) / (time / 10.0);
+                servo_[i].FadeTo(servo_target[i], time);
             }
         }
-
-        for (int iteration = 1; millis() < final_time_; iteration++) {
-            partial_time_ = millis() + 10;
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_[i].GetPosition() + increment_[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-        }
+        vTaskDelay(pdMS_TO_TICKS(time));
     } else {
         for (int i = 0; i < SERVO_COUNT; i++) {
             if (servo_pins_[i] != -1) {
@@ -117,27 +110,12 @@ void Otto::MoveServos(int time, int servo_target[]) {
         vTaskDelay(pdMS_TO_TICKS(time));
     }
 
-    // final adjustment to the target.
-    bool f = true;
-    int adjustment_count = 0;
-    while (f && adjustment_count < 10) {
-        f = false;
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1 && servo_target[i] != servo_[i].GetPosition()) {
-                f = true;
-                break;
-            }
-        }
-        if (f) {
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_target[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-            adjustment_count++;
+    // 渐变结束后把精确目标再写一遍,消除占空比取整误差
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        if (servo_pins_[i] != -1) {
+            servo_[i].SetPosition(servo_target[i]);
         }
-    };
+    }
 }
 
 void Otto::MoveSingle(int position, int servo_number) {
@@ -166,16 +144,24 @@ void Otto::OscillateServos(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT],
         }
     }
 
-    double ref = millis();
-    double end_time = period * cycle + ref;
-
-    while (millis() < end_time) {
+    // 正弦轨迹离散成每周期16段关键帧,段内由LEDC硬件渐变插值。
+    // 所有舵机共享同一个步态节拍:CPU每段只醒一次,而不是5ms轮询
+    const int kSegmentsPerCycle = 16;
+    int segment_ms = period / kSegmentsPerCycle;
+    if (segment_ms < 20) {
+        segment_ms = 20;
+    }
+    int total_ms = (int)(period * cycle);
+    for (int elapsed = 0; elapsed < total_ms; elapsed += segment_ms) {
+        int step_ms = total_ms - elapsed < segment_ms ? total_ms - elapsed : segment_ms;
+        // 段末相位:渐变结束时舵机正好落在该相位的采样点上
+        double phase = 2 * M_PI * (elapsed + step_ms) / period;
         for (int i = 0; i < SERVO_COUNT; i++) {
             if (servo_pins_[i] != -1) {
-                servo_[i].Refresh();
+                servo_[i].FadeToPhase(phase, step_ms);
             }
         }
-        vTaskDelay(5);
+        vTaskDelay(pdMS_TO_TICKS(step_ms));
     }
     vTaskDelay(pdMS_TO_TICKS(10));
 }
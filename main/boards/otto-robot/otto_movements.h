@@ -92,8 +92,6 @@ private:
     int servo_trim_[SERVO_COUNT];
 
     unsigned long final_time_;
-    unsigned long partial_time_;
-    float increment_[SERVO_COUNT];
 
     bool is_otto_resting_;
     bool has_hands_;  // 是否有手部舵机
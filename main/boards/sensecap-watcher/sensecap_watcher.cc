@@ -187,10 +187,11 @@ private:
         assert(ret == ESP_OK);
     }
 
-    void OnKnobRotate(bool clockwise) {
+    // delta是Knob合并加速后的增量,一次快拧只进来一次
+    void OnKnobRotate(int delta) {
         auto codec = GetAudioCodec();
         int current_volume = codec->output_volume();
-        int new_volume = current_volume + (clockwise ? -5 : 5); 
+        int new_volume = current_volume - 5 * delta;
 
         // 确保音量在有效范围内
         if (new_volume > 100) {
@@ -215,9 +216,9 @@ private:
 
     void InitializeKnob() {
         knob_ = std::make_unique<Knob>(BSP_KNOB_A_PIN, BSP_KNOB_B_PIN);
-        knob_->OnRotate([this](bool clockwise) {
-            ESP_LOGD(TAG, "Knob rotation detected. Clockwise:%s", clockwise ? "true" : "false");
-            OnKnobRotate(clockwise);
+        knob_->OnRotateDelta([this](int delta) {
+            ESP_LOGD(TAG, "Knob rotation detected. Delta:%d", delta);
+            OnKnobRotate(delta);
         });
         ESP_LOGI(TAG, "Knob initialized with pins A:%d B:%d", BSP_KNOB_A_PIN, BSP_KNOB_B_PIN);
     }
@@ -0,0 +1,124 @@
+#include "boot_profiler.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+
+#include <cstring>
+#include <map>
+
+#define TAG "BootProfiler"
+
+#define BOOT_PROFILER_NAMESPACE "boot"
+#define BOOT_PROFILER_BLOB_KEY "stages"
+#define BOOT_PROFILER_BLOB_VERSION 1
+
+namespace {
+
+struct __attribute__((packed)) BootBlobHeader {
+    uint16_t version;
+    uint16_t count;
+    uint32_t total_ms;
+};
+
+struct __attribute__((packed)) BootStageRecord {
+    char name[24];
+    uint32_t duration_ms;
+};
+
+}  // namespace
+
+void BootProfiler::MarkStage(const char* name) {
+    if (finished_) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    // 第一个打点以复位为基准,把app_main之前的板级构造也算进去
+    uint32_t duration_ms = (uint32_t)((now - last_mark_us_) / 1000);
+    last_mark_us_ = now;
+    stages_.push_back({name, duration_ms});
+}
+
+void BootProfiler::Finish() {
+    if (finished_ || stages_.empty()) {
+        return;
+    }
+    finished_ = true;
+
+    total_ms_ = (uint32_t)(last_mark_us_ / 1000);
+
+    // 读取上次启动的各阶段耗时用于对比
+    Settings settings(BOOT_PROFILER_NAMESPACE, true);
+    std::map<std::string, uint32_t> previous;
+    std::string blob = settings.GetBlob(BOOT_PROFILER_BLOB_KEY);
+    if (blob.size() >= sizeof(BootBlobHeader)) {
+        BootBlobHeader header;
+        memcpy(&header, blob.data(), sizeof(header));
+        size_t expected_size = sizeof(BootBlobHeader) + (size_t)header.count * sizeof(BootStageRecord);
+        if (header.version == BOOT_PROFILER_BLOB_VERSION && blob.size() == expected_size) {
+            const char* p = blob.data() + sizeof(BootBlobHeader);
+            for (uint16_t i = 0; i < header.count; i++, p += sizeof(BootStageRecord)) {
+                BootStageRecord record;
+                memcpy(&record, p, sizeof(record));
+                record.name[sizeof(record.name) - 1] = '\0';
+                previous[record.name] = record.duration_ms;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "Boot finished in %u ms (budget %d ms)", total_ms_, CONFIG_BOOT_TIME_BUDGET_MS);
+    for (const auto& stage : stages_) {
+        auto it = previous.find(stage.name);
+        if (it != previous.end()) {
+            ESP_LOGI(TAG, "  %-16s %6u ms (last boot %u ms)", stage.name.c_str(), stage.duration_ms, it->second);
+            // 比上次启动慢20%以上且绝对增量超过100ms才算回归,过滤网络抖动
+            if (stage.duration_ms > it->second + 100 && stage.duration_ms * 10 > it->second * 12) {
+                ESP_LOGW(TAG, "Stage %s regressed: %u ms -> %u ms", stage.name.c_str(), it->second, stage.duration_ms);
+            }
+        } else {
+            ESP_LOGI(TAG, "  %-16s %6u ms", stage.name.c_str(), stage.duration_ms);
+        }
+    }
+    if (total_ms_ > CONFIG_BOOT_TIME_BUDGET_MS) {
+        ESP_LOGW(TAG, "Boot time %u ms exceeds budget %d ms", total_ms_, CONFIG_BOOT_TIME_BUDGET_MS);
+    }
+
+    // 持久化本次报告,作为下次启动的对比基线
+    std::string new_blob;
+    new_blob.resize(sizeof(BootBlobHeader) + stages_.size() * sizeof(BootStageRecord));
+    BootBlobHeader header;
+    header.version = BOOT_PROFILER_BLOB_VERSION;
+    header.count = (uint16_t)stages_.size();
+    header.total_ms = total_ms_;
+    memcpy(new_blob.data(), &header, sizeof(header));
+    char* p = new_blob.data() + sizeof(BootBlobHeader);
+    for (const auto& stage : stages_) {
+        BootStageRecord record = {};
+        strncpy(record.name, stage.name.c_str(), sizeof(record.name) - 1);
+        record.duration_ms = stage.duration_ms;
+        memcpy(p, &record, sizeof(record));
+        p += sizeof(record);
+    }
+    settings.SetBlob(BOOT_PROFILER_BLOB_KEY, new_blob.data(), new_blob.size());
+}
+
+std::string BootProfiler::GetReportJson() const {
+    auto root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "total_ms", total_ms_);
+    cJSON_AddNumberToObject(root, "budget_ms", CONFIG_BOOT_TIME_BUDGET_MS);
+    auto stages = cJSON_CreateArray();
+    for (const auto& stage : stages_) {
+        auto item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", stage.name.c_str());
+        cJSON_AddNumberToObject(item, "duration_ms", stage.duration_ms);
+        cJSON_AddItemToArray(stages, item);
+    }
+    cJSON_AddItemToObject(root, "stages", stages);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
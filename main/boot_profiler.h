@@ -0,0 +1,42 @@
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 启动耗时分段统计:Application::Start在每个初始化阶段结束时打点,
+// Finish()打印报告、和上次启动对比并落盘,用于跨板子的启动时间回归检查
+class BootProfiler {
+public:
+    static BootProfiler& GetInstance() {
+        static BootProfiler instance;
+        return instance;
+    }
+
+    BootProfiler(const BootProfiler&) = delete;
+    BootProfiler& operator=(const BootProfiler&) = delete;
+
+    // 记录一个阶段完成,耗时为距上一个打点的时间
+    // (第一个打点从复位算起,包含Start之前的板级构造)
+    void MarkStage(const char* name);
+    // 打印报告,对比上次启动的各阶段耗时并持久化
+    void Finish();
+    // 上次完成启动的报告(JSON,供MCP查询)
+    std::string GetReportJson() const;
+
+private:
+    BootProfiler() = default;
+
+    struct Stage {
+        std::string name;
+        uint32_t duration_ms;
+    };
+
+    std::vector<Stage> stages_;
+    int64_t last_mark_us_ = 0;
+    uint32_t total_ms_ = 0;
+    bool finished_ = false;
+};
+
+#endif // BOOT_PROFILER_H
@@ -1,4 +1,8 @@
 #include "device_state_event.h"
+#include "application.h"
+
+#include <cJSON.h>
+#include <esp_timer.h>
 
 ESP_EVENT_DEFINE_BASE(XIAOZHI_STATE_EVENTS);
 
@@ -8,39 +12,118 @@ DeviceStateEventManager& DeviceStateEventManager::GetInstance() {
 }
 
 void DeviceStateEventManager::RegisterStateChangeCallback(std::function<void(DeviceState, DeviceState)> callback) {
+    RegisterStateChangeCallback(kStateEventPriorityCosmetic, "unnamed", std::move(callback));
+}
+
+void DeviceStateEventManager::RegisterStateChangeCallback(StateEventPriority priority, const char* name,
+                                                          std::function<void(DeviceState, DeviceState)> callback) {
     std::lock_guard<std::mutex> lock(mutex_);
-    callbacks_.push_back(callback);
+    subscribers_.push_back(Subscriber{
+        .name = name,
+        .priority = priority,
+        .callback = std::move(callback),
+    });
 }
 
 void DeviceStateEventManager::PostStateChangeEvent(DeviceState previous_state, DeviceState current_state) {
+    // 保留esp_event广播,板级代码可以直接监听XIAOZHI_STATE_EVENTS
     device_state_event_data_t event_data = {
         .previous_state = previous_state,
         .current_state = current_state
     };
     esp_event_post(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT, &event_data, sizeof(event_data), portMAX_DELAY);
+
+    std::vector<size_t> critical_indices;
+    bool has_cosmetic = false;
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = subscribers_.size();
+        for (size_t i = 0; i < count; i++) {
+            if (subscribers_[i].priority == kStateEventPriorityCritical) {
+                critical_indices.push_back(i);
+            } else {
+                has_cosmetic = true;
+            }
+        }
+    }
+
+    // critical级在调用现场同步执行,状态切换的快路径不排队
+    for (size_t index : critical_indices) {
+        InvokeSubscriber(index, previous_state, current_state);
+    }
+
+    // cosmetic级攒成一个调度回调丢给主循环,慢订阅者的耗时
+    // 会被主循环看门狗和这里的单订阅者统计共同归因
+    if (has_cosmetic) {
+        Application::GetInstance().Schedule([this, previous_state, current_state, count]() {
+            for (size_t i = 0; i < count; i++) {
+                bool cosmetic;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    cosmetic = subscribers_[i].priority == kStateEventPriorityCosmetic;
+                }
+                if (cosmetic) {
+                    InvokeSubscriber(i, previous_state, current_state);
+                }
+            }
+        }, "state_event_fanout");
+    }
 }
 
-std::vector<std::function<void(DeviceState, DeviceState)>> DeviceStateEventManager::GetCallbacks() {
+void DeviceStateEventManager::InvokeSubscriber(size_t index, DeviceState previous_state, DeviceState current_state) {
+    std::function<void(DeviceState, DeviceState)> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = subscribers_[index].callback;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    callback(previous_state, current_state);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
     std::lock_guard<std::mutex> lock(mutex_);
-    return callbacks_;
+    auto& subscriber = subscribers_[index];
+    subscriber.invoke_count++;
+    subscriber.total_us += elapsed_us;
+    if (elapsed_us > subscriber.max_us) {
+        subscriber.max_us = elapsed_us;
+    }
+}
+
+std::string DeviceStateEventManager::GetSubscriberStatsJson() {
+    auto root = cJSON_CreateObject();
+    auto subscribers = cJSON_CreateArray();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& subscriber : subscribers_) {
+            auto item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "name", subscriber.name);
+            cJSON_AddStringToObject(item, "priority",
+                subscriber.priority == kStateEventPriorityCritical ? "critical" : "cosmetic");
+            cJSON_AddNumberToObject(item, "invokes", subscriber.invoke_count);
+            cJSON_AddNumberToObject(item, "avg_us", subscriber.invoke_count > 0 ?
+                (double)(subscriber.total_us / subscriber.invoke_count) : 0);
+            cJSON_AddNumberToObject(item, "max_us", subscriber.max_us);
+            cJSON_AddItemToArray(subscribers, item);
+        }
+    }
+    cJSON_AddItemToObject(root, "subscribers", subscribers);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
 }
 
 DeviceStateEventManager::DeviceStateEventManager() {
+    // 确保默认事件循环存在,供上面的esp_event广播使用
     esp_err_t err = esp_event_loop_create_default();
     if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
         ESP_ERROR_CHECK(err);
     }
-
-    ESP_ERROR_CHECK(esp_event_handler_register(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT, 
-        [](void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
-            auto* data = static_cast<device_state_event_data_t*>(event_data);
-            auto& manager = DeviceStateEventManager::GetInstance();
-            for (const auto& callback : manager.GetCallbacks()) {
-                callback(data->previous_state, data->current_state);
-            }
-        }, nullptr));
 }
 
 DeviceStateEventManager::~DeviceStateEventManager() {
-    esp_event_handler_unregister(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT, nullptr);
-}
\ No newline at end of file
+}
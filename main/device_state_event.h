@@ -3,6 +3,7 @@
 
 #include <esp_event.h>
 #include <functional>
+#include <string>
 #include <vector>
 #include <mutex>
 #include "device_state.h"
@@ -18,22 +19,45 @@ struct device_state_event_data_t {
     DeviceState current_state;
 };
 
+// 订阅者优先级:critical在状态切换现场同步调用(音频链路这种对
+// 进入聆听的延迟敏感的);cosmetic(灯效、界面刷新)推迟到主循环
+// 调度执行,慢的界面订阅者不再拖长拾音启动
+enum StateEventPriority {
+    kStateEventPriorityCritical,
+    kStateEventPriorityCosmetic,
+};
+
 class DeviceStateEventManager {
 public:
     static DeviceStateEventManager& GetInstance();
     DeviceStateEventManager(const DeviceStateEventManager&) = delete;
     DeviceStateEventManager& operator=(const DeviceStateEventManager&) = delete;
 
+    // 旧接口:默认cosmetic级(历史订阅者都是灯效/界面类)
     void RegisterStateChangeCallback(std::function<void(DeviceState, DeviceState)> callback);
+    void RegisterStateChangeCallback(StateEventPriority priority, const char* name,
+                                     std::function<void(DeviceState, DeviceState)> callback);
     void PostStateChangeEvent(DeviceState previous_state, DeviceState current_state);
-    std::vector<std::function<void(DeviceState, DeviceState)>> GetCallbacks();
+    // 每个订阅者的调用次数与耗时统计
+    std::string GetSubscriberStatsJson();
 
 private:
     DeviceStateEventManager();
     ~DeviceStateEventManager();
 
-    std::vector<std::function<void(DeviceState, DeviceState)>> callbacks_;
+    struct Subscriber {
+        const char* name;
+        StateEventPriority priority;
+        std::function<void(DeviceState, DeviceState)> callback;
+        uint32_t invoke_count = 0;
+        uint64_t total_us = 0;
+        uint32_t max_us = 0;
+    };
+
+    void InvokeSubscriber(size_t index, DeviceState previous_state, DeviceState current_state);
+
+    std::vector<Subscriber> subscribers_;  // 只增不删,索引稳定
     std::mutex mutex_;
 };
 
-#endif // _DEVICE_STATE_EVENT_H_ 
\ No newline at end of file
+#endif // _DEVICE_STATE_EVENT_H_
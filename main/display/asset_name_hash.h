@@ -0,0 +1,25 @@
+#ifndef ASSET_NAME_HASH_H
+#define ASSET_NAME_HASH_H
+
+#include <cstdint>
+#include <string>
+
+/* 运行时资产名(表情/图标)查找用的FNV-1a 32位哈希:constexpr,编译器
+ * 能看到的内建字面量在编译期折叠成常数,下载资产名在注册时算一次。
+ * 查找路径用整数键,不再构造std::string临时对象也不逐字符比较。
+ * 键空间是每块板几十个名字,32位下碰撞概率可忽略;真撞上也只是
+ * 表情拿错,注册端的日志会暴露 */
+constexpr uint32_t AssetNameHash(const char* s) {
+    uint32_t hash = 2166136261u;
+    while (*s) {
+        hash ^= static_cast<uint8_t>(*s++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+inline uint32_t AssetNameHash(const std::string& s) {
+    return AssetNameHash(s.c_str());
+}
+
+#endif // ASSET_NAME_HASH_H
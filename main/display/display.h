@@ -39,6 +39,9 @@ public:
     virtual Theme* GetTheme() { return current_theme_; }
     virtual void UpdateStatusBar(bool update_all = false);
     virtual void SetPowerSaveMode(bool on);
+    // 音频链路拥塞时降低动画帧率,恢复后还原;默认空实现
+    virtual void SetAnimationPressure(bool under_pressure) {}
+    virtual void SetDebugOverlayEnabled(bool enabled) {}  // Default: do nothing
     virtual void SetMusicInfo(const char* song_name);
     virtual void SetMusicProgress(const char* song_name, int current_seconds, int total_seconds, float progress_percent);
     virtual void ClearMusicInfo();
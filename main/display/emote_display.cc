@@ -1,6 +1,8 @@
 #include "emote_display.h"
 
 // Standard C++ headers
+#include <algorithm>
+#include <cinttypes>
 #include <cstring>
 #include <memory>
 #include <unordered_map>
@@ -12,6 +14,7 @@
 
 // ESP-IDF headers
 #include <esp_log.h>
+#include <esp_heap_caps.h>
 #include <esp_lcd_panel_io.h>
 #include <esp_timer.h>
 
@@ -20,6 +23,8 @@
 #include <freertos/task.h>
 
 // Project headers
+#include "application.h"
+#include "asset_name_hash.h"
 #include "assets.h"
 #include "assets/lang_config.h"
 #include "board.h"
@@ -68,6 +73,16 @@ static gfx_obj_t* g_obj_img_status = nullptr;
 static std::string g_current_icon_type = ICON_WIFI_FAILED;
 static gfx_image_dsc_t g_icon_img_dsc;
 
+// 帧预算核算:OnFlush 间隔超过 1.5 个引擎帧周期记一次掉帧
+static int64_t g_last_flush_time_us = 0;
+static int64_t g_frame_period_us = 0;
+static uint32_t g_dropped_frame_count = 0;
+
+// 当前眼睛动画的参数,拥塞降帧/恢复时需要重新下发
+static std::string g_current_eye_emoji;
+static int g_current_eye_fps = 0;
+static bool g_current_eye_repeat = false;
+
 
 // ============================================================================
 // Forward Declarations
@@ -136,6 +151,17 @@ public:
     void SetEyes(const std::string &emoji_name, const bool repeat, const int fps, EmoteDisplay* const display);
     void SetIcon(const std::string &icon_name, EmoteDisplay* const display);
 
+    // 音频上行拥塞时把动画帧率减半,恢复后还原
+    void SetFramePressure(bool under_pressure, EmoteDisplay* display);
+
+    // A/V同步伺服:说话时按播放时钟校准动画推进速度(见实现处注释)
+    void OnAvSync();
+
+    uint32_t GetDroppedFrameCount() const
+    {
+        return g_dropped_frame_count;
+    }
+
     void* GetEngineHandle() const
     {
         return engine_handle_;
@@ -146,7 +172,30 @@ public:
     static void OnFlush(const gfx_handle_t handle, const int x_start, const int y_start, const int x_end, const int y_end, const void* const color_data);
 
 private:
+    /* 眼睛动画的PSRAM暂存槽:渲染任务逐帧解码读PSRAM而不是穿过flash
+     * mmap缓存。两槽乒乓,引擎可能还在读的旧槽保持有效到再下一次切换 */
+    struct AnimStage {
+        const void* src = nullptr;  // 原始mmap指针,用来判缓存命中
+        uint8_t* buf = nullptr;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    const void* StageAnimation(const void* data, size_t size);
+
     gfx_handle_t engine_handle_;
+    bool frame_pressure_ = false;
+    AnimStage anim_stage_[2];
+    int anim_stage_active_ = 0;
+
+    /* A/V同步伺服状态(只在esp_timer任务里触碰) */
+    static constexpr uint64_t kAvSyncPeriodUs = 500 * 1000;
+    esp_timer_handle_t av_sync_timer_ = nullptr;
+    EmoteDisplay* display_ = nullptr;
+    int64_t sync_last_wall_us_ = 0;   // 上个周期的墙钟,0=基线未建立
+    int64_t sync_last_audio_us_ = 0;  // 上个周期的播放时钟
+    int sync_applied_fps_ = 0;        // 伺服当前下发的帧率,0=未介入
+    bool sync_paused_ = false;        // 音频停顿,动画已暂停
 };
 
 // ============================================================================
@@ -217,10 +266,14 @@ static void InitializeGraphics(const esp_lcd_panel_handle_t panel, gfx_handle_t*
     };
 
     gfx_cfg.task.task_stack_caps = MALLOC_CAP_DEFAULT;
-    gfx_cfg.task.task_affinity = 0;
-    gfx_cfg.task.task_priority = 5;
+    // 渲染任务固定到核 1 并压到低优先级:音频输入/解码在核 0,
+    // 编码在核 1 跑优先级 2,动画只能用剩下的 CPU,不会造成爆音
+    gfx_cfg.task.task_affinity = 1;
+    gfx_cfg.task.task_priority = 1;
     gfx_cfg.task.task_stack = 8 * 1024;
 
+    g_frame_period_us = 1000000 / gfx_cfg.fps;
+
     *engine_handle = gfx_emote_init(&gfx_cfg);
 }
 
@@ -297,14 +350,62 @@ EmoteEngine::EmoteEngine(const esp_lcd_panel_handle_t panel, const esp_lcd_panel
     }
 
     RegisterCallbacks(panel_io, engine_handle_);
+
+    display_ = display;
+    // A/V同步伺服:每半秒按播放时钟校一次说话动画
+    esp_timer_create_args_t sync_args = {
+        .callback = [](void* arg) { static_cast<EmoteEngine*>(arg)->OnAvSync(); },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "emote_av_sync",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_create(&sync_args, &av_sync_timer_);
+    esp_timer_start_periodic(av_sync_timer_, kAvSyncPeriodUs);
 }
 
 EmoteEngine::~EmoteEngine()
 {
+    if (av_sync_timer_) {
+        esp_timer_stop(av_sync_timer_);
+        esp_timer_delete(av_sync_timer_);
+        av_sync_timer_ = nullptr;
+    }
     if (engine_handle_) {
         gfx_emote_deinit(engine_handle_);
         engine_handle_ = nullptr;
     }
+    heap_caps_free(anim_stage_[0].buf);
+    heap_caps_free(anim_stage_[1].buf);
+}
+
+/* 把动画资产一次性整段搬进PSRAM:flash侧是一次顺序预取友好的批量读,
+ * 之后渲染任务(核1)逐帧解码全程不碰flash——大动画逐帧经mmap缓存读
+ * flash的停顿正是掉帧的来源。同一动画重复播放直接命中暂存,零拷贝。
+ * 没有PSRAM或分配失败时退回直接用mmap指针,行为与之前一致 */
+const void* EmoteEngine::StageAnimation(const void* data, size_t size)
+{
+    AnimStage &active = anim_stage_[anim_stage_active_];
+    if (active.src == data && active.size == size && active.buf) {
+        return active.buf;
+    }
+
+    const int slot = anim_stage_active_ ^ 1;
+    AnimStage &stage = anim_stage_[slot];
+    if (stage.capacity < size) {
+        uint8_t* buf = static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_SPIRAM));
+        if (!buf) {
+            return data;
+        }
+        heap_caps_free(stage.buf);
+        stage.buf = buf;
+        stage.capacity = size;
+    }
+    std::memcpy(stage.buf, data, size);
+    stage.src = data;
+    stage.size = size;
+    anim_stage_active_ = slot;
+    return stage.buf;
 }
 
 void EmoteEngine::SetEyes(const std::string &emoji_name, const bool repeat, const int fps, EmoteDisplay* const display)
@@ -322,8 +423,14 @@ void EmoteEngine::SetEyes(const std::string &emoji_name, const bool repeat, cons
     const AssetData emoji_data = display->GetEmojiData(emoji_name);
     if (emoji_data.data) {
         DisplayLockGuard lock(display);
-        gfx_anim_set_src(g_obj_anim_eye, emoji_data.data, emoji_data.size);
-        gfx_anim_set_segment(g_obj_anim_eye, 0, 0xFFFF, fps, repeat);
+        g_current_eye_emoji = emoji_name;
+        g_current_eye_fps = fps;
+        g_current_eye_repeat = repeat;
+        // 拥塞期间新动画直接按降频播放
+        const int effective_fps = frame_pressure_ ? std::max(fps / 2, 5) : fps;
+        const void* staged = StageAnimation(emoji_data.data, emoji_data.size);
+        gfx_anim_set_src(g_obj_anim_eye, staged, emoji_data.size);
+        gfx_anim_set_segment(g_obj_anim_eye, 0, 0xFFFF, effective_fps, repeat);
         gfx_obj_set_visible(g_obj_anim_eye, true);
         gfx_anim_start(g_obj_anim_eye);
     } else {
@@ -331,6 +438,97 @@ void EmoteEngine::SetEyes(const std::string &emoji_name, const bool repeat, cons
     }
 }
 
+void EmoteEngine::SetFramePressure(bool under_pressure, EmoteDisplay* display)
+{
+    if (!engine_handle_ || frame_pressure_ == under_pressure) {
+        return;
+    }
+    frame_pressure_ = under_pressure;
+
+    if (g_current_eye_fps > 0 && !g_current_eye_emoji.empty()) {
+        const int effective_fps =
+            under_pressure ? std::max(g_current_eye_fps / 2, 5) : g_current_eye_fps;
+        DisplayLockGuard lock(display);
+        gfx_anim_set_segment(g_obj_anim_eye, 0, 0xFFFF, effective_fps, g_current_eye_repeat);
+    }
+    ESP_LOGI(TAG, "Animation frame pressure %s, dropped frames so far: %" PRIu32,
+             under_pressure ? "on" : "off", g_dropped_frame_count);
+}
+
+/* A/V同步伺服:说话动画此前开环跑资产自带的fps,长回复上口型漂移可见。
+ * 播放时钟按写进DMA的样本数推进(AudioService::GetPlaybackPositionUs),
+ * 这里每个周期量一次"音频推进/墙钟推进"的比值:TTS停顿(网络补包)时
+ * 暂停动画,恢复后按实际播出速率重设帧率。漂移不再跨周期累计——误差
+ * 上界是一个校正周期内的速率差,而不是整段回复的时长 */
+void EmoteEngine::OnAvSync()
+{
+    if (!engine_handle_ || !display_) {
+        return;
+    }
+
+    auto& app = Application::GetInstance();
+    const bool speaking = app.GetDeviceState() == kDeviceStateSpeaking;
+    const int64_t now = esp_timer_get_time();
+    const int64_t audio = app.GetAudioService().GetPlaybackPositionUs();
+
+    if (!speaking || g_current_eye_fps <= 0 || g_current_eye_emoji.empty()) {
+        // 离开说话态:伺服退出,把动画交还给名义帧率
+        if (sync_applied_fps_ != 0 || sync_paused_) {
+            DisplayLockGuard lock(display_);
+            if (sync_paused_) {
+                gfx_anim_start(g_obj_anim_eye);
+                sync_paused_ = false;
+            }
+            if (g_current_eye_fps > 0) {
+                const int nominal = frame_pressure_ ? std::max(g_current_eye_fps / 2, 5) : g_current_eye_fps;
+                gfx_anim_set_segment(g_obj_anim_eye, 0, 0xFFFF, nominal, g_current_eye_repeat);
+            }
+            sync_applied_fps_ = 0;
+        }
+        sync_last_wall_us_ = 0;
+        return;
+    }
+
+    if (sync_last_wall_us_ == 0) {
+        // 本轮说话的基线周期,只记录不校正
+        sync_last_wall_us_ = now;
+        sync_last_audio_us_ = audio;
+        return;
+    }
+
+    const int64_t wall_d = now - sync_last_wall_us_;
+    const int64_t audio_d = audio - sync_last_audio_us_;
+    sync_last_wall_us_ = now;
+    sync_last_audio_us_ = audio;
+    if (wall_d <= 0) {
+        return;
+    }
+
+    if (audio_d < wall_d / 8) {
+        // 音频基本没推进(解码欠载/网络补包):嘴不能继续动
+        if (!sync_paused_) {
+            DisplayLockGuard lock(display_);
+            gfx_anim_stop(g_obj_anim_eye);
+            sync_paused_ = true;
+        }
+        return;
+    }
+
+    // 按实际播出速率重设帧率,夹在名义值的[1/4, 1]区间内
+    const int nominal = frame_pressure_ ? std::max(g_current_eye_fps / 2, 5) : g_current_eye_fps;
+    int target = (int)((nominal * audio_d + wall_d / 2) / wall_d);
+    target = std::min(nominal, std::max(std::max(nominal / 4, 1), target));
+    if (sync_paused_ || target != (sync_applied_fps_ != 0 ? sync_applied_fps_ : nominal)) {
+        DisplayLockGuard lock(display_);
+        if (sync_paused_) {
+            gfx_anim_start(g_obj_anim_eye);
+            sync_paused_ = false;
+        }
+        gfx_anim_set_segment(g_obj_anim_eye, 0, 0xFFFF, target, g_current_eye_repeat);
+        sync_applied_fps_ = target;
+    }
+}
+
 void EmoteEngine::SetIcon(const std::string &icon_name, EmoteDisplay* const display)
 {
     if (!engine_handle_) {
@@ -368,6 +566,14 @@ bool EmoteEngine::OnFlushIoReady(const esp_lcd_panel_io_handle_t panel_io,
 void EmoteEngine::OnFlush(const gfx_handle_t handle, const int x_start, const int y_start,
                           const int x_end, const int y_end, const void* const color_data)
 {
+    // 帧预算核算:两次 flush 间隔明显超过一个帧周期说明这帧没赶上
+    const int64_t now = esp_timer_get_time();
+    if (g_last_flush_time_us != 0 && g_frame_period_us > 0 &&
+        now - g_last_flush_time_us > g_frame_period_us * 3 / 2) {
+        g_dropped_frame_count++;
+    }
+    g_last_flush_time_us = now;
+
     auto* const panel = static_cast<esp_lcd_panel_handle_t>(gfx_emote_get_user_data(handle));
     if (panel) {
         esp_lcd_panel_draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
@@ -510,6 +716,19 @@ void EmoteDisplay::SetPowerSaveMode(bool on)
     }
 }
 
+void EmoteDisplay::SetAnimationPressure(bool under_pressure)
+{
+    if (!engine_) {
+        return;
+    }
+    engine_->SetFramePressure(under_pressure, this);
+}
+
+uint32_t EmoteDisplay::GetDroppedFrameCount() const
+{
+    return engine_ ? engine_->GetDroppedFrameCount() : 0;
+}
+
 void EmoteDisplay::SetPreviewImage(const void* image)
 {
     if (image) {
@@ -527,7 +746,7 @@ void EmoteDisplay::SetTheme(Theme* const theme)
 void EmoteDisplay::AddEmojiData(const std::string &name, const void* const data, const size_t size,
                                 uint8_t fps, bool loop, bool lack)
 {
-    emoji_data_map_[name] = AssetData(data, size, fps, loop, lack);
+    emoji_data_map_[AssetNameHash(name)] = AssetData(data, size, fps, loop, lack);
     ESP_LOGD(TAG, "Added emoji data: %s, size: %d, fps: %d, loop: %s, lack: %s",
              name.c_str(), size, fps, loop ? "true" : "false", lack ? "true" : "false");
 
@@ -539,7 +758,7 @@ void EmoteDisplay::AddEmojiData(const std::string &name, const void* const data,
 
 void EmoteDisplay::AddIconData(const std::string &name, const void* const data, const size_t size)
 {
-    icon_data_map_[name] = AssetData(data, size);
+    icon_data_map_[AssetNameHash(name)] = AssetData(data, size);
     ESP_LOGD(TAG, "Added icon data: %s, size: %d", name.c_str(), size);
 
     DisplayLockGuard lock(this);
@@ -604,7 +823,7 @@ void EmoteDisplay::AddTextFont(std::shared_ptr<LvglFont> text_font)
 
 AssetData EmoteDisplay::GetEmojiData(const std::string &name) const
 {
-    const auto it = emoji_data_map_.find(name);
+    const auto it = emoji_data_map_.find(AssetNameHash(name));
     if (it != emoji_data_map_.cend()) {
         return it->second;
     }
@@ -613,7 +832,7 @@ AssetData EmoteDisplay::GetEmojiData(const std::string &name) const
 
 AssetData EmoteDisplay::GetIconData(const std::string &name) const
 {
-    const auto it = icon_data_map_.find(name);
+    const auto it = icon_data_map_.find(AssetNameHash(name));
     if (it != icon_data_map_.cend()) {
         return it->second;
     }
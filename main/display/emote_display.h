@@ -66,8 +66,13 @@ public:
     virtual void ShowNotification(const char* notification, int duration_ms = 3000) override;
     virtual void UpdateStatusBar(bool update_all = false) override;
     virtual void SetPowerSaveMode(bool on) override;
+    // 音频上行拥塞时把眼睛动画降到半帧率,恢复后还原
+    virtual void SetAnimationPressure(bool under_pressure) override;
     virtual void SetPreviewImage(const void* image);
 
+    // 渲染任务没赶上帧周期的累计次数(按 flush 间隔核算)
+    uint32_t GetDroppedFrameCount() const;
+
     void AddEmojiData(const std::string &name, const void* data, size_t size, uint8_t fps = 0, bool loop = false, bool lack = false);
     void AddIconData(const std::string &name, const void* data, size_t size);
     void AddLayoutData(const std::string &name, const std::string &align_str, int x, int y, int width = 0, int height = 0);
@@ -93,9 +98,9 @@ private:
     // Font management
     std::shared_ptr<LvglFont> text_font_ = nullptr;
 
-    // Non-LVGL asset data storage
-    std::map<std::string, AssetData> emoji_data_map_;
-    std::map<std::string, AssetData> icon_data_map_;
+    // Non-LVGL asset data storage,键是AssetNameHash(资产名)
+    std::map<uint32_t, AssetData> emoji_data_map_;
+    std::map<uint32_t, AssetData> icon_data_map_;
 
 };
 
@@ -1,9 +1,14 @@
 #include "lcd_display.h"
 #include "gif/lvgl_gif.h"
 #include "settings.h"
+#include "system_info.h"
 #include "lvgl_theme.h"
+#include "application.h"
+#include "perf_trace.h"
 #include "assets/lang_config.h"
 
+#include <cJSON.h>
+
 #include <vector>
 #include <algorithm>
 #include <font_awesome.h>
@@ -11,6 +16,9 @@
 #include <esp_err.h>
 #include <esp_lvgl_port.h>
 #include <esp_psram.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <cstring>
 
 #include "board.h"
@@ -130,8 +138,10 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         .io_handle = panel_io_,
         .panel_handle = panel_,
         .control_handle = nullptr,
+        /* 两块绘制缓冲:DMA 在发第 N 块时 LVGL 同时渲染第 N+1 块,
+         * 渲染与传输重叠,靠 lvgl_port 的 on_color_trans_done 回调归还缓冲 */
         .buffer_size = static_cast<uint32_t>(width_ * 20),
-        .double_buffer = false,
+        .double_buffer = true,
         .trans_size = 0,
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
@@ -141,12 +151,15 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
             .mirror_x = mirror_x,
             .mirror_y = mirror_y,
         },
-        .color_format = LV_COLOR_FORMAT_RGB565,
+        /* 局部刷新模式下 LVGL 已把脏区合并后按最小矩形下发面板;让 LVGL
+         * 直接渲染成字节序交换后的 RGB565,省掉 lvgl_port 每次刷新对整个
+         * 脏区做的 CPU 字节交换遍历 */
+        .color_format = LV_COLOR_FORMAT_RGB565_SWAPPED,
         .flags = {
             .buff_dma = 1,
             .buff_spiram = 0,
             .sw_rotate = 0,
-            .swap_bytes = 1,
+            .swap_bytes = 0,
             .full_refresh = 0,
             .direct_mode = 0,
         },
@@ -248,8 +261,9 @@ MipiLcdDisplay::MipiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel
         .io_handle = panel_io,
         .panel_handle = panel,
         .control_handle = nullptr,
+        // 同 SPI 路径:双缓冲让渲染与 DSI 传输重叠
         .buffer_size = static_cast<uint32_t>(width_ * 50),
-        .double_buffer = false,
+        .double_buffer = true,
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
         .monochrome = false,
@@ -287,16 +301,23 @@ MipiLcdDisplay::MipiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel
 LcdDisplay::~LcdDisplay() {
     SetPreviewImage(nullptr);
     
-    // Clean up GIF controller
+    // Clean up GIF controllers (active one is owned by the cache)
     if (gif_controller_) {
         gif_controller_->Stop();
-        gif_controller_.reset();
+        gif_controller_ = nullptr;
     }
+    gif_cache_.clear();
+    gif_cache_bytes_ = 0;
     
     if (preview_timer_ != nullptr) {
         esp_timer_stop(preview_timer_);
         esp_timer_delete(preview_timer_);
     }
+
+    if (debug_overlay_timer_ != nullptr) {
+        esp_timer_stop(debug_overlay_timer_);
+        esp_timer_delete(debug_overlay_timer_);
+    }
     
     // Clean up vinyl rotation animation
     if (vinyl_rotation_anim_) {
@@ -355,19 +376,97 @@ void LcdDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
+#if CONFIG_PERF_TRACE
+// flush打点:LVGL9的display事件恰好包住lvgl_port内部flush回调的前后,
+// 不用改managed component就能量出渲染->面板传输的时序
+static void OnFlushStartEvent(lv_event_t* e) {
+    PERF_TRACE_PROBE(kProbeFlushStart);
+}
+
+static void OnFlushFinishEvent(lv_event_t* e) {
+    PERF_TRACE_PROBE(kProbeFlushFinish);
+}
+#endif
+
+void LcdDisplay::InitThemeStyles() {
+    if (theme_styles_.initialized) {
+        return;
+    }
+    lv_style_init(&theme_styles_.screen);
+    lv_style_init(&theme_styles_.container);
+    lv_style_init(&theme_styles_.status_bar);
+    lv_style_init(&theme_styles_.content);
+    lv_style_init(&theme_styles_.text);
+    lv_style_init(&theme_styles_.icon);
+    lv_style_init(&theme_styles_.large_icon);
+    lv_style_init(&theme_styles_.user_bubble);
+    lv_style_init(&theme_styles_.assistant_bubble);
+    lv_style_init(&theme_styles_.system_bubble);
+    lv_style_init(&theme_styles_.system_text);
+    lv_style_init(&theme_styles_.low_battery);
+    theme_styles_.initialized = true;
+}
+
+// 把目标主题的调色板/字体灌进共享样式。挂着这些样式的控件不需要逐个
+// 访问,lv_obj_report_style_change 一次上报就让 LVGL 在下一帧统一重绘
+void LcdDisplay::ApplyThemeToStyles(LvglTheme* theme) {
+    InitThemeStyles();
+    auto& s = theme_styles_;
+    auto text_font = theme->text_font()->font();
+    auto icon_font = theme->icon_font()->font();
+    auto large_icon_font = theme->large_icon_font()->font();
+
+    lv_style_set_text_font(&s.screen, text_font);
+    lv_style_set_text_color(&s.screen, theme->text_color());
+    lv_style_set_bg_color(&s.screen, theme->background_color());
+
+    if (theme->background_image() != nullptr) {
+        lv_style_set_bg_image_src(&s.container, theme->background_image()->image_dsc());
+    } else {
+        lv_style_set_bg_image_src(&s.container, nullptr);
+        lv_style_set_bg_color(&s.container, theme->background_color());
+    }
+    lv_style_set_border_color(&s.container, theme->border_color());
+
+    lv_style_set_bg_color(&s.status_bar, theme->background_color());
+    lv_style_set_text_color(&s.status_bar, theme->text_color());
+
+    lv_style_set_bg_color(&s.content, theme->chat_background_color());
+
+    lv_style_set_text_color(&s.text, theme->text_color());
+
+    // 大字体屏幕用大图标,和正文视觉比例一致
+    lv_style_set_text_font(&s.icon, text_font->line_height >= 40 ? large_icon_font : icon_font);
+    lv_style_set_text_color(&s.icon, theme->text_color());
+    lv_style_set_text_font(&s.large_icon, large_icon_font);
+    lv_style_set_text_color(&s.large_icon, theme->text_color());
+
+    lv_style_set_bg_color(&s.user_bubble, theme->user_bubble_color());
+    lv_style_set_border_color(&s.user_bubble, theme->border_color());
+    lv_style_set_bg_color(&s.assistant_bubble, theme->assistant_bubble_color());
+    lv_style_set_border_color(&s.assistant_bubble, theme->border_color());
+    lv_style_set_bg_color(&s.system_bubble, theme->system_bubble_color());
+    lv_style_set_border_color(&s.system_bubble, theme->border_color());
+    lv_style_set_text_color(&s.system_text, theme->system_text_color());
+
+    lv_style_set_bg_color(&s.low_battery, theme->low_battery_color());
+}
+
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
 
+#if CONFIG_PERF_TRACE
+    lv_display_add_event_cb(display_, OnFlushStartEvent, LV_EVENT_FLUSH_START, nullptr);
+    lv_display_add_event_cb(display_, OnFlushFinishEvent, LV_EVENT_FLUSH_FINISH, nullptr);
+#endif
+
     auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
     auto text_font = lvgl_theme->text_font()->font();
-    auto icon_font = lvgl_theme->icon_font()->font();
-    auto large_icon_font = lvgl_theme->large_icon_font()->font();
+    ApplyThemeToStyles(lvgl_theme);
 
     auto screen = lv_screen_active();
-    lv_obj_set_style_text_font(screen, text_font, 0);
-    lv_obj_set_style_text_color(screen, lvgl_theme->text_color(), 0);
-    lv_obj_set_style_bg_color(screen, lvgl_theme->background_color(), 0);
+    lv_obj_add_style(screen, &theme_styles_.screen, 0);
 
     /* Container */
     container_ = lv_obj_create(screen);
@@ -377,16 +476,14 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_pad_all(container_, 0, 0);
     lv_obj_set_style_border_width(container_, 0, 0);
     lv_obj_set_style_pad_row(container_, 0, 0);
-    lv_obj_set_style_bg_color(container_, lvgl_theme->background_color(), 0);
-    lv_obj_set_style_border_color(container_, lvgl_theme->border_color(), 0);
+    lv_obj_add_style(container_, &theme_styles_.container, 0);
 
     /* Status bar */
     status_bar_ = lv_obj_create(container_);
     lv_obj_set_size(status_bar_, LV_HOR_RES, LV_SIZE_CONTENT);
     lv_obj_set_style_radius(status_bar_, 0, 0);
-    lv_obj_set_style_bg_color(status_bar_, lvgl_theme->background_color(), 0);
-    lv_obj_set_style_text_color(status_bar_, lvgl_theme->text_color(), 0);
-    
+    lv_obj_add_style(status_bar_, &theme_styles_.status_bar, 0);
+
     /* Content - Chat area */
     content_ = lv_obj_create(container_);
     lv_obj_set_style_radius(content_, 0, 0);
@@ -394,7 +491,7 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_grow(content_, 1);
     lv_obj_set_style_pad_all(content_, lvgl_theme->spacing(4), 0);
     lv_obj_set_style_border_width(content_, 0, 0);
-    lv_obj_set_style_bg_color(content_, lvgl_theme->chat_background_color(), 0); // Background for chat area
+    lv_obj_add_style(content_, &theme_styles_.content, 0); // Background for chat area
 
     // Enable scrolling for chat content
     lv_obj_set_scrollbar_mode(content_, LV_SCROLLBAR_MODE_OFF);
@@ -423,13 +520,12 @@ void LcdDisplay::SetupUI() {
 
     network_label_ = lv_label_create(status_bar_);
     lv_label_set_text(network_label_, "");
-    lv_obj_set_style_text_font(network_label_, icon_font, 0);
-    lv_obj_set_style_text_color(network_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(network_label_, &theme_styles_.icon, 0);
 
     notification_label_ = lv_label_create(status_bar_);
     lv_obj_set_flex_grow(notification_label_, 1);
     lv_obj_set_style_text_align(notification_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(notification_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(notification_label_, &theme_styles_.text, 0);
     lv_label_set_text(notification_label_, "");
     lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
 
@@ -437,25 +533,23 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_grow(status_label_, 1);
     lv_label_set_long_mode(status_label_, LV_LABEL_LONG_SCROLL_CIRCULAR);
     lv_obj_set_style_text_align(status_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(status_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(status_label_, &theme_styles_.text, 0);
     lv_label_set_text(status_label_, Lang::Strings::INITIALIZING);
     
     mute_label_ = lv_label_create(status_bar_);
     lv_label_set_text(mute_label_, "");
-    lv_obj_set_style_text_font(mute_label_, icon_font, 0);
-    lv_obj_set_style_text_color(mute_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(mute_label_, &theme_styles_.icon, 0);
 
     battery_label_ = lv_label_create(status_bar_);
     lv_label_set_text(battery_label_, "");
-    lv_obj_set_style_text_font(battery_label_, icon_font, 0);
-    lv_obj_set_style_text_color(battery_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(battery_label_, &theme_styles_.icon, 0);
     lv_obj_set_style_margin_left(battery_label_, lvgl_theme->spacing(2), 0); // 添加左边距，与前面的元素分隔
 
     low_battery_popup_ = lv_obj_create(screen);
     lv_obj_set_scrollbar_mode(low_battery_popup_, LV_SCROLLBAR_MODE_OFF);
     lv_obj_set_size(low_battery_popup_, LV_HOR_RES * 0.9, text_font->line_height * 2);
     lv_obj_align(low_battery_popup_, LV_ALIGN_BOTTOM_MID, 0, -lvgl_theme->spacing(4));
-    lv_obj_set_style_bg_color(low_battery_popup_, lvgl_theme->low_battery_color(), 0);
+    lv_obj_add_style(low_battery_popup_, &theme_styles_.low_battery, 0);
     lv_obj_set_style_radius(low_battery_popup_, lvgl_theme->spacing(4), 0);
     low_battery_label_ = lv_label_create(low_battery_popup_);
     lv_label_set_text(low_battery_label_, Lang::Strings::BATTERY_NEED_CHARGE);
@@ -469,8 +563,7 @@ void LcdDisplay::SetupUI() {
     // Display AI logo while booting
     emoji_label_ = lv_label_create(screen);
     lv_obj_center(emoji_label_);
-    lv_obj_set_style_text_font(emoji_label_, large_icon_font, 0);
-    lv_obj_set_style_text_color(emoji_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(emoji_label_, &theme_styles_.large_icon, 0);
     lv_label_set_text(emoji_label_, FONT_AWESOME_MICROCHIP_AI);
 }
 #if CONFIG_IDF_TARGET_ESP32P4
@@ -572,10 +665,10 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
     // Set alignment and style based on message role
     if (strcmp(role, "user") == 0) {
         // User messages are right-aligned with green background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->user_bubble_color(), 0);
+        lv_obj_add_style(msg_bubble, &theme_styles_.user_bubble, 0);
         lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
         // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
+        lv_obj_add_style(msg_text, &theme_styles_.text, 0);
         
         // 设置自定义属性标记气泡类型
         lv_obj_set_user_data(msg_bubble, (void*)"user");
@@ -588,10 +681,10 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
         lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
     } else if (strcmp(role, "assistant") == 0) {
         // Assistant messages are left-aligned with white background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->assistant_bubble_color(), 0);
+        lv_obj_add_style(msg_bubble, &theme_styles_.assistant_bubble, 0);
         lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
         // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
+        lv_obj_add_style(msg_text, &theme_styles_.text, 0);
         
         // 设置自定义属性标记气泡类型
         lv_obj_set_user_data(msg_bubble, (void*)"assistant");
@@ -604,10 +697,10 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
         lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
     } else if (strcmp(role, "system") == 0) {
         // System messages are center-aligned with light gray background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->system_bubble_color(), 0);
+        lv_obj_add_style(msg_bubble, &theme_styles_.system_bubble, 0);
         lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
         // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->system_text_color(), 0);
+        lv_obj_add_style(msg_text, &theme_styles_.system_text, 0);
         
         // 设置自定义属性标记气泡类型
         lv_obj_set_user_data(msg_bubble, (void*)"system");
@@ -691,7 +784,7 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     lv_obj_set_style_pad_all(img_bubble, lvgl_theme->spacing(4), 0);
     
     // Set image bubble background color (similar to system message)
-    lv_obj_set_style_bg_color(img_bubble, lvgl_theme->assistant_bubble_color(), 0);
+    lv_obj_add_style(img_bubble, &theme_styles_.assistant_bubble, 0);
     lv_obj_set_style_bg_opa(img_bubble, LV_OPA_70, 0);
     
     // 设置自定义属性标记气泡类型
@@ -758,15 +851,18 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
 #else
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
+
+#if CONFIG_PERF_TRACE
+    lv_display_add_event_cb(display_, OnFlushStartEvent, LV_EVENT_FLUSH_START, nullptr);
+    lv_display_add_event_cb(display_, OnFlushFinishEvent, LV_EVENT_FLUSH_FINISH, nullptr);
+#endif
+
     LvglTheme* lvgl_theme = static_cast<LvglTheme*>(current_theme_);
     auto text_font = lvgl_theme->text_font()->font();
-    auto icon_font = lvgl_theme->icon_font()->font();
-    auto large_icon_font = lvgl_theme->large_icon_font()->font();
+    ApplyThemeToStyles(lvgl_theme);
 
     auto screen = lv_screen_active();
-    lv_obj_set_style_text_font(screen, text_font, 0);
-    lv_obj_set_style_text_color(screen, lvgl_theme->text_color(), 0);
-    lv_obj_set_style_bg_color(screen, lvgl_theme->background_color(), 0);
+    lv_obj_add_style(screen, &theme_styles_.screen, 0);
 
     /* Container */
     container_ = lv_obj_create(screen);
@@ -776,15 +872,13 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_pad_all(container_, 0, 0);
     lv_obj_set_style_border_width(container_, 0, 0);
     lv_obj_set_style_pad_row(container_, 0, 0);
-    lv_obj_set_style_bg_color(container_, lvgl_theme->background_color(), 0);
-    lv_obj_set_style_border_color(container_, lvgl_theme->border_color(), 0);
+    lv_obj_add_style(container_, &theme_styles_.container, 0);
 
     /* Status bar */
     status_bar_ = lv_obj_create(container_);
     lv_obj_set_size(status_bar_, LV_HOR_RES, LV_SIZE_CONTENT);
     lv_obj_set_style_radius(status_bar_, 0, 0);
-    lv_obj_set_style_bg_color(status_bar_, lvgl_theme->background_color(), 0);
-    lv_obj_set_style_text_color(status_bar_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(status_bar_, &theme_styles_.status_bar, 0);
     lv_obj_set_flex_flow(status_bar_, LV_FLEX_FLOW_ROW);
     lv_obj_set_style_pad_top(status_bar_, lvgl_theme->spacing(2), 0);
     lv_obj_set_style_pad_bottom(status_bar_, lvgl_theme->spacing(2), 0);
@@ -801,7 +895,7 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_grow(content_, 1);
     lv_obj_set_style_pad_all(content_, 0, 0);
     lv_obj_set_style_border_width(content_, 0, 0);
-    lv_obj_set_style_bg_color(content_, lvgl_theme->chat_background_color(), 0);
+    lv_obj_add_style(content_, &theme_styles_.content, 0);
 
     lv_obj_set_flex_flow(content_, LV_FLEX_FLOW_COLUMN); // 垂直布局（从上到下）
     lv_obj_set_flex_align(content_, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_SPACE_EVENLY); // 子对象居中对齐，等距分布
@@ -813,8 +907,7 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_border_width(emoji_box_, 0, 0);
 
     emoji_label_ = lv_label_create(emoji_box_);
-    lv_obj_set_style_text_font(emoji_label_, large_icon_font, 0);
-    lv_obj_set_style_text_color(emoji_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(emoji_label_, &theme_styles_.large_icon, 0);
     lv_label_set_text(emoji_label_, FONT_AWESOME_MICROCHIP_AI);
 
     emoji_image_ = lv_img_create(emoji_box_);
@@ -831,18 +924,17 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_width(chat_message_label_, width_ * 0.9); // 限制宽度为屏幕宽度的 90%
     lv_label_set_long_mode(chat_message_label_, LV_LABEL_LONG_WRAP); // 设置为自动换行模式
     lv_obj_set_style_text_align(chat_message_label_, LV_TEXT_ALIGN_CENTER, 0); // 设置文本居中对齐
-    lv_obj_set_style_text_color(chat_message_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(chat_message_label_, &theme_styles_.text, 0);
 
     /* Status bar */
     network_label_ = lv_label_create(status_bar_);
     lv_label_set_text(network_label_, "");
-    lv_obj_set_style_text_font(network_label_, icon_font, 0);
-    lv_obj_set_style_text_color(network_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(network_label_, &theme_styles_.icon, 0);
 
     notification_label_ = lv_label_create(status_bar_);
     lv_obj_set_flex_grow(notification_label_, 1);
     lv_obj_set_style_text_align(notification_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(notification_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(notification_label_, &theme_styles_.text, 0);
     lv_label_set_text(notification_label_, "");
     lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
 
@@ -850,24 +942,22 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_grow(status_label_, 1);
     lv_label_set_long_mode(status_label_, LV_LABEL_LONG_SCROLL_CIRCULAR);
     lv_obj_set_style_text_align(status_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(status_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(status_label_, &theme_styles_.text, 0);
     lv_label_set_text(status_label_, Lang::Strings::INITIALIZING);
 
     mute_label_ = lv_label_create(status_bar_);
     lv_label_set_text(mute_label_, "");
-    lv_obj_set_style_text_font(mute_label_, icon_font, 0);
-    lv_obj_set_style_text_color(mute_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(mute_label_, &theme_styles_.icon, 0);
 
     battery_label_ = lv_label_create(status_bar_);
     lv_label_set_text(battery_label_, "");
-    lv_obj_set_style_text_font(battery_label_, icon_font, 0);
-    lv_obj_set_style_text_color(battery_label_, lvgl_theme->text_color(), 0);
+    lv_obj_add_style(battery_label_, &theme_styles_.icon, 0);
 
     low_battery_popup_ = lv_obj_create(screen);
     lv_obj_set_scrollbar_mode(low_battery_popup_, LV_SCROLLBAR_MODE_OFF);
     lv_obj_set_size(low_battery_popup_, LV_HOR_RES * 0.9, text_font->line_height * 2);
     lv_obj_align(low_battery_popup_, LV_ALIGN_BOTTOM_MID, 0, -lvgl_theme->spacing(4));
-    lv_obj_set_style_bg_color(low_battery_popup_, lvgl_theme->low_battery_color(), 0);
+    lv_obj_add_style(low_battery_popup_, &theme_styles_.low_battery, 0);
     lv_obj_set_style_radius(low_battery_popup_, lvgl_theme->spacing(4), 0);
     
     low_battery_label_ = lv_label_create(low_battery_popup_);
@@ -878,13 +968,12 @@ void LcdDisplay::SetupUI() {
 }
 
 void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
-    DisplayLockGuard lock(this);
-    if (preview_image_ == nullptr) {
-        ESP_LOGE(TAG, "Preview image is not initialized");
-        return;
-    }
-
     if (image == nullptr) {
+        DisplayLockGuard lock(this);
+        if (preview_image_ == nullptr) {
+            ESP_LOGE(TAG, "Preview image is not initialized");
+            return;
+        }
         esp_timer_stop(preview_timer_);
         lv_obj_remove_flag(emoji_box_, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(preview_image_, LV_OBJ_FLAG_HIDDEN);
@@ -895,6 +984,71 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
         return;
     }
 
+    // 降采样和换源放到低优先级任务里做,调用方(通常是主循环)不再被拷贝卡住
+    struct PreviewContext {
+        LcdDisplay* display;
+        LvglImage* image;
+    };
+    auto ctx = new PreviewContext{this, image.release()};
+    auto prepare = [](void* arg) {
+        auto ctx = static_cast<PreviewContext*>(arg);
+        auto image = DownscalePreviewImage(std::unique_ptr<LvglImage>(ctx->image),
+                                           ctx->display->width_ / 2);
+        ctx->display->ApplyPreviewImage(std::move(image));
+        delete ctx;
+        vTaskDelete(NULL);
+    };
+    if (xTaskCreate(prepare, "preview_prep", 2048 * 2, ctx, 1, nullptr) != pdPASS) {
+        // 任务创建失败就退回同步路径
+        auto fallback = std::unique_ptr<LvglImage>(ctx->image);
+        delete ctx;
+        ApplyPreviewImage(std::move(fallback));
+    }
+}
+
+/* 预览最终按半屏宽显示,解码后的 RGB565 帧超过目标宽度时先做整数步长
+ * 降采样,5 秒缓存期占用的 PSRAM 按比例下降;编码图(PNG/JPG)维持原样,
+ * 交给 LVGL 的解码器处理 */
+std::unique_ptr<LvglImage> LcdDisplay::DownscalePreviewImage(std::unique_ptr<LvglImage> image,
+                                                             int target_width) {
+    auto src_dsc = image->image_dsc();
+    if (src_dsc == nullptr || src_dsc->header.cf != LV_COLOR_FORMAT_RGB565 ||
+        target_width <= 0 || (int)src_dsc->header.w <= target_width) {
+        return image;
+    }
+
+    int step = (src_dsc->header.w + target_width - 1) / target_width;
+    int out_w = src_dsc->header.w / step;
+    int out_h = src_dsc->header.h / step;
+    if (out_w <= 0 || out_h <= 0) {
+        return image;
+    }
+
+    size_t out_size = (size_t)out_w * out_h * 2;
+    auto out = (uint16_t*)heap_caps_malloc(out_size, MALLOC_CAP_SPIRAM);
+    if (out == nullptr) {
+        return image;
+    }
+
+    size_t src_stride = src_dsc->header.stride > 0 ? src_dsc->header.stride : src_dsc->header.w * 2;
+    for (int y = 0; y < out_h; y++) {
+        auto src_row = (const uint16_t*)(src_dsc->data + (size_t)y * step * src_stride);
+        auto dst_row = out + (size_t)y * out_w;
+        for (int x = 0; x < out_w; x++) {
+            dst_row[x] = src_row[x * step];
+        }
+    }
+    return std::make_unique<LvglAllocatedImage>(out, out_size, out_w, out_h, out_w * 2,
+                                                LV_COLOR_FORMAT_RGB565);
+}
+
+void LcdDisplay::ApplyPreviewImage(std::unique_ptr<LvglImage> image) {
+    DisplayLockGuard lock(this);
+    if (preview_image_ == nullptr) {
+        ESP_LOGE(TAG, "Preview image is not initialized");
+        return;
+    }
+
     preview_image_cached_ = std::move(image);
     auto img_dsc = preview_image_cached_->image_dsc();
     // 设置图片源并显示预览图片
@@ -919,16 +1073,165 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
     if (chat_message_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(chat_message_label_, content);
+    /* 流式STT/TTS每个token都重发全文。没变的更新直接丢掉;纯追加只拷贝
+     * 增量进常驻缓冲,标签用static文本引用它,LVGL不再每次strdup整段。
+     * (逐行增量重排需要替换lv_label本体,重绘仍由LVGL整体做) */
+    if (chat_message_text_ == content) {
+        return;
+    }
+    if (!chat_message_text_.empty() &&
+        strncmp(content, chat_message_text_.c_str(), chat_message_text_.size()) == 0) {
+        chat_message_text_.append(content + chat_message_text_.size());
+    } else {
+        chat_message_text_ = content;
+    }
+    lv_label_set_text_static(chat_message_label_, chat_message_text_.c_str());
+}
+#endif
+
+/* 表情 GIF 的解码结果按 LRU 缓存:助手在 4-5 个表情之间来回切换时,
+ * 命中缓存的切换不再重新跑 gifdec 解析,首帧立即可用。预算用画布字节数
+ * 粗略估算(ARGB8888 画布 + 索引帧缓冲),最近使用的一项永不淘汰。 */
+LvglGif* LcdDisplay::AcquireGifController(const char* emotion, const LvglImage* image) {
+    for (auto it = gif_cache_.begin(); it != gif_cache_.end(); ++it) {
+        if (it->emotion == emotion) {
+            gif_cache_.splice(gif_cache_.begin(), gif_cache_, it);
+            return gif_cache_.front().gif.get();
+        }
+    }
+
+    auto gif = std::make_unique<LvglGif>(image->image_dsc());
+    if (!gif->IsLoaded()) {
+        return nullptr;
+    }
+
+    size_t bytes = (size_t)gif->width() * gif->height() * 5;
+    size_t budget = (size_t)CONFIG_EMOJI_GIF_CACHE_BUDGET_KB * 1024;
+    while (!gif_cache_.empty() && gif_cache_bytes_ + bytes > budget) {
+        gif_cache_bytes_ -= gif_cache_.back().bytes;
+        gif_cache_.pop_back();
+    }
+
+    gif_cache_.push_front(CachedGif{emotion, bytes, std::move(gif)});
+    gif_cache_bytes_ += bytes;
+    return gif_cache_.front().gif.get();
+}
+
+/* 表情使用频次以JSON串存在Settings里(NVS没有键枚举,单键JSON省事) */
+void LcdDisplay::LoadEmotionUsage() {
+    if (emotion_usage_loaded_) {
+        return;
+    }
+    emotion_usage_loaded_ = true;
+
+    Settings settings("display", false);
+    std::string json = settings.GetString("emoji_usage", "");
+    if (json.empty()) {
+        return;
+    }
+    cJSON* root = cJSON_Parse(json.c_str());
+    if (root == nullptr) {
+        return;
+    }
+    cJSON* item = nullptr;
+    cJSON_ArrayForEach(item, root) {
+        if (cJSON_IsNumber(item) && item->string != nullptr) {
+            emotion_usage_[item->string] = item->valueint;
+        }
+    }
+    cJSON_Delete(root);
+}
+
+void LcdDisplay::RecordEmotionUsage(const char* emotion) {
+    std::string json;
+    {
+        DisplayLockGuard lock(this);
+        LoadEmotionUsage();
+        emotion_usage_[emotion]++;
+        // 每4次变化落一次盘,别让NVS写进表情切换的热路径
+        if (++emotion_usage_unsaved_ < 4) {
+            return;
+        }
+        emotion_usage_unsaved_ = 0;
+
+        cJSON* root = cJSON_CreateObject();
+        for (auto& [name, count] : emotion_usage_) {
+            cJSON_AddNumberToObject(root, name.c_str(), count);
+        }
+        char* str = cJSON_PrintUnformatted(root);
+        json = str;
+        cJSON_free(str);
+        cJSON_Delete(root);
+    }
+
+    Settings settings("display", true);
+    settings.SetString("emoji_usage", json);
+}
+
+/* 听用户说话的空档预解最常用的几个表情:回应开始的SetEmotion总是缓存
+ * 命中,首次GIF解析的开销不再落在TTS起播的关口上 */
+void LcdDisplay::PrefetchEmojis() {
+    auto emoji_collection = static_cast<LvglTheme*>(current_theme_)->emoji_collection();
+    if (emoji_collection != nullptr) {
+        std::vector<std::pair<std::string, int>> ranked;
+        {
+            DisplayLockGuard lock(this);
+            LoadEmotionUsage();
+            ranked.assign(emotion_usage_.begin(), emotion_usage_.end());
+        }
+        std::sort(ranked.begin(), ranked.end(),
+            [](const auto& a, const auto& b) { return a.second > b.second; });
+
+        int prefetched = 0;
+        for (auto& [name, count] : ranked) {
+            if (prefetched >= 3 ||
+                Application::GetInstance().GetDeviceState() != kDeviceStateListening) {
+                break;
+            }
+            auto image = emoji_collection->GetEmojiImage(name.c_str());
+            if (image != nullptr && image->IsGif()) {
+                /* 解码在显示锁内做(gif_cache_由它保护),和SetEmotion里的
+                 * 首次解码同价,只是挪到了没人盯着屏幕的时刻 */
+                DisplayLockGuard lock(this);
+                AcquireGifController(name.c_str(), image);
+                prefetched++;
+            }
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+    }
+    emoji_prefetch_running_.store(false);
 }
+
+void LcdDisplay::OnStateChanged() {
+    LvglDisplay::OnStateChanged();
+
+    /* 本树没有独立的"思考"态,听用户说话的窗口就是TTS起播前的空档 */
+    if (Application::GetInstance().GetDeviceState() == kDeviceStateListening) {
+        bool expected = false;
+        if (emoji_prefetch_running_.compare_exchange_strong(expected, true)) {
+            auto prefetch = [](void* arg) {
+                static_cast<LcdDisplay*>(arg)->PrefetchEmojis();
+                vTaskDelete(NULL);
+            };
+            // 低优先级,多核时固定到核1,与jpeg_encode同款安排
+#if CONFIG_FREERTOS_UNICORE
+            BaseType_t created = xTaskCreate(prefetch, "emoji_prefetch", 4096, this, 1, nullptr);
+#else
+            BaseType_t created = xTaskCreatePinnedToCore(prefetch, "emoji_prefetch", 4096, this, 1, nullptr, 1);
 #endif
+            if (created != pdPASS) {
+                emoji_prefetch_running_.store(false);
+            }
+        }
+    }
+}
 
 void LcdDisplay::SetEmotion(const char* emotion) {
-    // Stop any running GIF animation
+    // Pause any running GIF animation; the decoded frames stay in the cache
     if (gif_controller_) {
         DisplayLockGuard lock(this);
         gif_controller_->Stop();
-        gif_controller_.reset();
+        gif_controller_ = nullptr;
     }
     
     if (emoji_image_ == nullptr) {
@@ -948,27 +1251,38 @@ void LcdDisplay::SetEmotion(const char* emotion) {
         return;
     }
 
+    RecordEmotionUsage(emotion);
+
     DisplayLockGuard lock(this);
     if (image->IsGif()) {
-        // Create new GIF controller
-        gif_controller_ = std::make_unique<LvglGif>(image->image_dsc());
-        
-        if (gif_controller_->IsLoaded()) {
+        // Reuse a cached controller when this emotion was shown recently
+        gif_controller_ = AcquireGifController(emotion, image);
+
+        if (gif_controller_ != nullptr) {
             // Set up frame update callback
+            // 画布是原地更新的,每帧只失效 GIF 实际变化的子矩形即可,
+            // 避免整个控件重绘(240x240 表情每帧往往只动一小块)
             gif_controller_->SetFrameCallback([this]() {
-                lv_image_set_src(emoji_image_, gif_controller_->image_dsc());
+                lv_area_t area;
+                if (gif_controller_ != nullptr && gif_controller_->GetDirtyArea(&area)) {
+                    lv_area_t coords;
+                    lv_obj_get_coords(emoji_image_, &coords);
+                    lv_area_move(&area, coords.x1, coords.y1);
+                    lv_obj_invalidate_area(emoji_image_, &area);
+                } else {
+                    lv_obj_invalidate(emoji_image_);
+                }
             });
-            
+
             // Set initial frame and start animation
             lv_image_set_src(emoji_image_, gif_controller_->image_dsc());
             gif_controller_->Start();
-            
+
             // Show GIF, hide others
             lv_obj_add_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
             lv_obj_remove_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
         } else {
             ESP_LOGE(TAG, "Failed to load GIF for emotion: %s", emotion);
-            gif_controller_.reset();
         }
     } else {
         lv_image_set_src(emoji_image_, image->image_dsc());
@@ -983,7 +1297,7 @@ void LcdDisplay::SetEmotion(const char* emotion) {
         // Stop GIF animation if running
         if (gif_controller_) {
             gif_controller_->Stop();
-            gif_controller_.reset();
+            gif_controller_ = nullptr;
         }
         
         lv_obj_add_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
@@ -994,133 +1308,23 @@ void LcdDisplay::SetEmotion(const char* emotion) {
 
 void LcdDisplay::SetTheme(Theme* theme) {
     DisplayLockGuard lock(this);
-    
-    auto lvgl_theme = static_cast<LvglTheme*>(theme);
-    
-    // Get the active screen
-    lv_obj_t* screen = lv_screen_active();
 
-    // Set font
-    auto text_font = lvgl_theme->text_font()->font();
-    auto icon_font = lvgl_theme->icon_font()->font();
-    auto large_icon_font = lvgl_theme->large_icon_font()->font();
-
-    if (text_font->line_height >= 40) {
-        lv_obj_set_style_text_font(mute_label_, large_icon_font, 0);
-        lv_obj_set_style_text_font(battery_label_, large_icon_font, 0);
-        lv_obj_set_style_text_font(network_label_, large_icon_font, 0);
-    } else {
-        lv_obj_set_style_text_font(mute_label_, icon_font, 0);
-        lv_obj_set_style_text_font(battery_label_, icon_font, 0);
-        lv_obj_set_style_text_font(network_label_, icon_font, 0);
-    }
+    auto lvgl_theme = static_cast<LvglTheme*>(theme);
 
-    // Set parent text color
-    lv_obj_set_style_text_font(screen, text_font, 0);
-    lv_obj_set_style_text_color(screen, lvgl_theme->text_color(), 0);
+    /* 控件(含历史消息气泡)创建时就挂着共享样式,换肤只需把新主题的
+     * 调色板灌进样式再上报一次变更,LVGL下一帧统一重绘;锁内不再遍历
+     * 控件树逐个重刷,换肤从几百毫秒的锁占用变成单帧操作 */
+    ApplyThemeToStyles(lvgl_theme);
 
-    // Set background image
-    if (lvgl_theme->background_image() != nullptr) {
-        lv_obj_set_style_bg_image_src(container_, lvgl_theme->background_image()->image_dsc(), 0);
-    } else {
-        lv_obj_set_style_bg_image_src(container_, nullptr, 0);
-        lv_obj_set_style_bg_color(container_, lvgl_theme->background_color(), 0);
-    }
-    
-    // Update status bar background color with 50% opacity
-    lv_obj_set_style_bg_opa(status_bar_, LV_OPA_50, 0);
-    lv_obj_set_style_bg_color(status_bar_, lvgl_theme->background_color(), 0);
-    
-    // Update status bar elements
-    lv_obj_set_style_text_color(network_label_, lvgl_theme->text_color(), 0);
-    lv_obj_set_style_text_color(status_label_, lvgl_theme->text_color(), 0);
-    lv_obj_set_style_text_color(notification_label_, lvgl_theme->text_color(), 0);
-    lv_obj_set_style_text_color(mute_label_, lvgl_theme->text_color(), 0);
-    lv_obj_set_style_text_color(battery_label_, lvgl_theme->text_color(), 0);
-    lv_obj_set_style_text_color(emoji_label_, lvgl_theme->text_color(), 0);
-
-    // Set content background opacity
-    lv_obj_set_style_bg_opa(content_, LV_OPA_TRANSP, 0);
-
-    // If we have the chat message style, update all message bubbles
-#if CONFIG_USE_WECHAT_MESSAGE_STYLE
-    // Iterate through all children of content (message containers or bubbles)
-    uint32_t child_count = lv_obj_get_child_cnt(content_);
-    for (uint32_t i = 0; i < child_count; i++) {
-        lv_obj_t* obj = lv_obj_get_child(content_, i);
-        if (obj == nullptr) continue;
-        
-        lv_obj_t* bubble = nullptr;
-        
-        // 检查这个对象是容器还是气泡
-        // 如果是容器（用户或系统消息），则获取其子对象作为气泡
-        // 如果是气泡（助手消息），则直接使用
-        if (lv_obj_get_child_cnt(obj) > 0) {
-            // 可能是容器，检查它是否为用户或系统消息容器
-            // 用户和系统消息容器是透明的
-            lv_opa_t bg_opa = lv_obj_get_style_bg_opa(obj, 0);
-            if (bg_opa == LV_OPA_TRANSP) {
-                // 这是用户或系统消息的容器
-                bubble = lv_obj_get_child(obj, 0);
-            } else {
-                // 这可能是助手消息的气泡自身
-                bubble = obj;
-            }
-        } else {
-            // 没有子元素，可能是其他UI元素，跳过
-            continue;
-        }
-        
-        if (bubble == nullptr) continue;
-        
-        // 使用保存的用户数据来识别气泡类型
-        void* bubble_type_ptr = lv_obj_get_user_data(bubble);
-        if (bubble_type_ptr != nullptr) {
-            const char* bubble_type = static_cast<const char*>(bubble_type_ptr);
-            
-            // 根据气泡类型应用正确的颜色
-            if (strcmp(bubble_type, "user") == 0) {
-                lv_obj_set_style_bg_color(bubble, lvgl_theme->user_bubble_color(), 0);
-            } else if (strcmp(bubble_type, "assistant") == 0) {
-                lv_obj_set_style_bg_color(bubble, lvgl_theme->assistant_bubble_color(), 0); 
-            } else if (strcmp(bubble_type, "system") == 0) {
-                lv_obj_set_style_bg_color(bubble, lvgl_theme->system_bubble_color(), 0);
-            } else if (strcmp(bubble_type, "image") == 0) {
-                lv_obj_set_style_bg_color(bubble, lvgl_theme->system_bubble_color(), 0);
-            }
-            
-            // Update border color
-            lv_obj_set_style_border_color(bubble, lvgl_theme->border_color(), 0);
-            
-            // Update text color for the message
-            if (lv_obj_get_child_cnt(bubble) > 0) {
-                lv_obj_t* text = lv_obj_get_child(bubble, 0);
-                if (text != nullptr) {
-                    // 根据气泡类型设置文本颜色
-                    if (strcmp(bubble_type, "system") == 0) {
-                        lv_obj_set_style_text_color(text, lvgl_theme->system_text_color(), 0);
-                    } else {
-                        lv_obj_set_style_text_color(text, lvgl_theme->text_color(), 0);
-                    }
-                }
-            }
-        } else {
-            ESP_LOGW(TAG, "child[%lu] Bubble type is not found", i);
-        }
-    }
-#else
-    // Simple UI mode - just update the main chat message
-    if (chat_message_label_ != nullptr) {
-        lv_obj_set_style_text_color(chat_message_label_, lvgl_theme->text_color(), 0);
+    /* 这两处透明度历来在首次换肤时才生效,保持原时序 */
+    if (status_bar_ != nullptr) {
+        lv_obj_set_style_bg_opa(status_bar_, LV_OPA_50, 0);
     }
-    
-    if (emoji_label_ != nullptr) {
-        lv_obj_set_style_text_color(emoji_label_, lvgl_theme->text_color(), 0);
+    if (content_ != nullptr) {
+        lv_obj_set_style_bg_opa(content_, LV_OPA_TRANSP, 0);
     }
-#endif
-    
-    // Update low battery popup
-    lv_obj_set_style_bg_color(low_battery_popup_, lvgl_theme->low_battery_color(), 0);
+
+    lv_obj_report_style_change(nullptr);
 
     // No errors occurred. Save theme to settings
     Display::SetTheme(lvgl_theme);
@@ -1422,4 +1626,193 @@ void LcdDisplay::ClearMusicInfo() {
     
     // 重置表情图标
     SetEmotion(FONT_AWESOME_NEUTRAL);
-}
\ No newline at end of file
+}
+
+void LcdDisplay::SetDebugOverlayEnabled(bool enabled) {
+    if (enabled && debug_overlay_timer_ == nullptr) {
+        {
+            DisplayLockGuard lock(this);
+            auto screen = lv_screen_active();
+            debug_overlay_label_ = lv_label_create(screen);
+            lv_obj_set_width(debug_overlay_label_, LV_HOR_RES);
+            lv_obj_align(debug_overlay_label_, LV_ALIGN_TOP_LEFT, 0, 0);
+            lv_obj_set_style_bg_color(debug_overlay_label_, lv_color_black(), 0);
+            lv_obj_set_style_bg_opa(debug_overlay_label_, LV_OPA_70, 0);
+            lv_obj_set_style_text_color(debug_overlay_label_, lv_color_white(), 0);
+            lv_obj_set_style_pad_all(debug_overlay_label_, 2, 0);
+            lv_label_set_text(debug_overlay_label_, "");
+        }
+
+        esp_timer_create_args_t timer_args = {
+            .callback = [](void* arg) {
+                static_cast<LcdDisplay*>(arg)->UpdateDebugOverlay();
+            },
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "debug_overlay",
+            .skip_unhandled_events = true,
+        };
+        esp_timer_create(&timer_args, &debug_overlay_timer_);
+        esp_timer_start_periodic(debug_overlay_timer_, 2000000);
+        UpdateDebugOverlay();
+        ESP_LOGI(TAG, "Debug overlay enabled");
+    } else if (!enabled && debug_overlay_timer_ != nullptr) {
+        esp_timer_stop(debug_overlay_timer_);
+        esp_timer_delete(debug_overlay_timer_);
+        debug_overlay_timer_ = nullptr;
+
+        DisplayLockGuard lock(this);
+        if (debug_overlay_label_) {
+            lv_obj_del(debug_overlay_label_);
+            debug_overlay_label_ = nullptr;
+        }
+        ESP_LOGI(TAG, "Debug overlay disabled");
+    }
+}
+
+void LcdDisplay::UpdateDebugOverlay() {
+    // 采样在锁外做,别占着LVGL锁遍历任务表
+    auto stats = SystemInfo::SampleTaskStats();
+
+    char line[64];
+    std::string text;
+    int rows = 0;
+    for (const auto& stat : stats) {
+        // 只显示前8个,低占用的长尾在MCP工具的完整JSON里看
+        if (rows++ >= 8) {
+            break;
+        }
+        snprintf(line, sizeof(line), "%-12.12s %3lu%% c%d %5lu\n",
+                 stat.name.c_str(), stat.cpu_percent, stat.core_id, stat.stack_high_water);
+        text += line;
+    }
+
+    DisplayLockGuard lock(this);
+    if (debug_overlay_label_ == nullptr) {
+        return;
+    }
+    lv_label_set_text(debug_overlay_label_, text.c_str());
+}
+
+#if CONFIG_DISPLAY_BENCH
+/* 刷新吞吐基准。每个场景固定帧数,每帧强制整屏失效后同步渲染+下发面板,
+ * 因此字节数 = 帧数 x 整屏大小,MB/s在不同接口(SPI/QSPI/RGB/MIPI)之间
+ * 可直接对比;场景之间的fps差异反映的是渲染复杂度而不是链路吞吐 */
+std::string LcdDisplay::RunFlushBenchmark() {
+    constexpr int kFramesPerScene = 60;
+    constexpr int kSpectrumBars = 16;
+    static const char* kScenes[] = {"fill", "text_scroll", "emoji_gif", "spectrum"};
+
+    size_t frame_bytes = (size_t)width_ * height_ *
+                         lv_color_format_get_size(lv_display_get_color_format(display_));
+
+    std::string report = "[";
+    for (size_t s = 0; s < sizeof(kScenes) / sizeof(kScenes[0]); s++) {
+        const char* scene = kScenes[s];
+        bool use_layer = strcmp(scene, "emoji_gif") != 0;  // GIF场景直接量现有UI
+        lv_obj_t* layer = nullptr;
+        lv_obj_t* label = nullptr;
+        lv_obj_t* bars[kSpectrumBars] = {};
+
+        if (use_layer) {
+            DisplayLockGuard lock(this);
+            layer = lv_obj_create(lv_screen_active());
+            lv_obj_set_size(layer, width_, height_);
+            lv_obj_set_pos(layer, 0, 0);
+            lv_obj_set_style_border_width(layer, 0, 0);
+            lv_obj_set_style_radius(layer, 0, 0);
+            lv_obj_set_style_pad_all(layer, 0, 0);
+            lv_obj_set_style_bg_color(layer, lv_color_black(), 0);
+            lv_obj_set_style_bg_opa(layer, LV_OPA_COVER, 0);
+            lv_obj_clear_flag(layer, LV_OBJ_FLAG_SCROLLABLE);
+
+            if (strcmp(scene, "text_scroll") == 0) {
+                label = lv_label_create(layer);
+                lv_obj_set_width(label, width_);
+                lv_obj_set_style_text_color(label, lv_color_white(), 0);
+                std::string text;
+                for (int i = 0; i < 24; i++) {
+                    text += "display bench 0123456789 刷新吞吐基准行\n";
+                }
+                lv_label_set_text(label, text.c_str());
+            } else if (strcmp(scene, "spectrum") == 0) {
+                int bar_width = width_ / kSpectrumBars;
+                for (int i = 0; i < kSpectrumBars; i++) {
+                    bars[i] = lv_obj_create(layer);
+                    lv_obj_set_style_border_width(bars[i], 0, 0);
+                    lv_obj_set_style_radius(bars[i], 0, 0);
+                    lv_obj_set_style_bg_color(bars[i], lv_palette_main(LV_PALETTE_GREEN), 0);
+                    lv_obj_set_style_bg_opa(bars[i], LV_OPA_COVER, 0);
+                    lv_obj_set_size(bars[i], bar_width - 2, 10);
+                    lv_obj_set_pos(bars[i], i * bar_width, height_ - 10);
+                }
+            }
+        }
+
+        uint32_t rng = 0x20240817;  // 确定性伪随机,不同固件版本跑同样的帧序列
+        int64_t lock_wait_us = 0;
+        int64_t lock_held_us = 0;
+        int64_t scene_start = esp_timer_get_time();
+
+        for (int frame = 0; frame < kFramesPerScene; frame++) {
+            if (!use_layer && frame % 15 == 0) {
+                // GIF换源+首帧解码计入场景耗时,SetEmotion自己拿锁
+                static const char* kEmotions[] = {"happy", "thinking", "surprise", "cool"};
+                SetEmotion(kEmotions[(frame / 15) % 4]);
+            }
+
+            int64_t t0 = esp_timer_get_time();
+            DisplayLockGuard lock(this);
+            int64_t t1 = esp_timer_get_time();
+
+            if (strcmp(scene, "fill") == 0) {
+                lv_obj_set_style_bg_color(layer,
+                    (frame & 1) ? lv_palette_main(LV_PALETTE_BLUE) : lv_palette_main(LV_PALETTE_RED), 0);
+            } else if (strcmp(scene, "text_scroll") == 0) {
+                lv_obj_set_y(label, -(frame * 4) % std::max(1, (int)lv_obj_get_height(label) - height_));
+            } else if (strcmp(scene, "spectrum") == 0) {
+                for (int i = 0; i < kSpectrumBars; i++) {
+                    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                    int h = 8 + (int)(rng % (uint32_t)(height_ - 16));
+                    lv_obj_set_height(bars[i], h);
+                    lv_obj_set_y(bars[i], height_ - h);
+                }
+            }
+
+            // 标准化为整屏重绘,同步渲染并flush到面板
+            lv_obj_invalidate(lv_screen_active());
+            lv_refr_now(display_);
+
+            int64_t t2 = esp_timer_get_time();
+            lock_wait_us += t1 - t0;
+            lock_held_us += t2 - t1;
+        }
+
+        int64_t total_us = esp_timer_get_time() - scene_start;
+        if (use_layer) {
+            DisplayLockGuard lock(this);
+            lv_obj_del(layer);
+        } else {
+            SetEmotion("neutral");
+        }
+
+        double fps = (double)kFramesPerScene * 1e6 / (double)total_us;
+        double mb_per_s = (double)(frame_bytes * kFramesPerScene) / (double)total_us;  // bytes/us = MB/s
+        ESP_LOGI(TAG, "DISPLAY_BENCH scene=%s frames=%d total_ms=%lld fps=%.1f mb_per_s=%.2f "
+                 "lock_held_ms=%lld lock_wait_ms=%lld frame_bytes=%u",
+                 scene, kFramesPerScene, (long long)(total_us / 1000), fps, mb_per_s,
+                 (long long)(lock_held_us / 1000), (long long)(lock_wait_us / 1000),
+                 (unsigned int)frame_bytes);
+
+        char entry[224];
+        snprintf(entry, sizeof(entry),
+                 "%s{\"scene\":\"%s\",\"frames\":%d,\"total_ms\":%lld,\"fps\":%.1f,"
+                 "\"mb_per_s\":%.2f,\"lock_held_ms\":%lld,\"lock_wait_ms\":%lld}",
+                 s == 0 ? "" : ",", scene, kFramesPerScene, (long long)(total_us / 1000), fps,
+                 mb_per_s, (long long)(lock_held_us / 1000), (long long)(lock_wait_us / 1000));
+        report += entry;
+    }
+    report += "]";
+    return report;
+}
+#endif  // CONFIG_DISPLAY_BENCH
\ No newline at end of file
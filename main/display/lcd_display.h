@@ -10,9 +10,13 @@
 
 #include <atomic>
 #include <memory>
+#include <list>
+#include <map>
+#include <string>
 
 #define PREVIEW_IMAGE_DURATION_MS 5000
 
+class LvglTheme;
 
 class LcdDisplay : public LvglDisplay {
 protected:
@@ -27,9 +31,20 @@ protected:
     lv_obj_t* preview_image_ = nullptr;
     lv_obj_t* emoji_label_ = nullptr;
     lv_obj_t* emoji_image_ = nullptr;
-    std::unique_ptr<LvglGif> gif_controller_ = nullptr;
+    // Active GIF controller; owned by gif_cache_, which keeps recently used
+    // emotions decoded (LRU, bounded by EMOJI_GIF_CACHE_BUDGET_KB)
+    LvglGif* gif_controller_ = nullptr;
+    struct CachedGif {
+        std::string emotion;
+        size_t bytes;
+        std::unique_ptr<LvglGif> gif;
+    };
+    std::list<CachedGif> gif_cache_;
+    size_t gif_cache_bytes_ = 0;
     lv_obj_t* emoji_box_ = nullptr;
     lv_obj_t* chat_message_label_ = nullptr;
+    // 流式字幕的常驻文本缓冲:标签以static文本指向它,逐token更新只追加增量
+    std::string chat_message_text_;
     esp_timer_handle_t preview_timer_ = nullptr;
     std::unique_ptr<LvglImage> preview_image_cached_ = nullptr;
     
@@ -45,7 +60,48 @@ protected:
     lv_anim_t* vinyl_rotation_anim_ = nullptr;  // 旋转动画
     bool music_panel_visible_ = false;          // 音乐面板是否可见
 
+    // 调试悬浮层:周期刷新各任务CPU占比/核亲和/栈水位
+    lv_obj_t* debug_overlay_label_ = nullptr;
+    esp_timer_handle_t debug_overlay_timer_ = nullptr;
+    void UpdateDebugOverlay();
+
     void InitializeLcdThemes();
+    LvglGif* AcquireGifController(const char* emotion, const LvglImage* image);
+
+    // 预构建的共享主题样式:控件在SetupUI/建气泡时挂上这些样式,
+    // 换主题只改样式值再上报一次变更,不再在锁内遍历控件树逐个重刷
+    struct ThemeStyles {
+        lv_style_t screen;            // 正文字体+文本色+背景色
+        lv_style_t container;         // 背景色/背景图+边框色
+        lv_style_t status_bar;        // 背景色+文本色
+        lv_style_t content;           // 聊天区背景色
+        lv_style_t text;              // 普通标签文本色
+        lv_style_t icon;              // 状态栏图标字体+文本色
+        lv_style_t large_icon;        // 表情/大图标字体+文本色
+        lv_style_t user_bubble;
+        lv_style_t assistant_bubble;
+        lv_style_t system_bubble;
+        lv_style_t system_text;
+        lv_style_t low_battery;
+        bool initialized = false;
+    };
+    ThemeStyles theme_styles_;
+    void InitThemeStyles();
+    void ApplyThemeToStyles(LvglTheme* theme);
+
+    // 表情预取:思考态时后台把最常用表情的GIF解进LRU缓存,
+    // TTS开播时的SetEmotion就是缓存命中。频次统计持久化在Settings里
+    std::map<std::string, int> emotion_usage_;      // 显示锁保护
+    bool emotion_usage_loaded_ = false;
+    int emotion_usage_unsaved_ = 0;
+    std::atomic<bool> emoji_prefetch_running_{false};
+    void LoadEmotionUsage();
+    void RecordEmotionUsage(const char* emotion);
+    void PrefetchEmojis();
+    // 预览图异步准备:降采样在低优先级任务里做,像素就绪后才在锁内换源
+    void ApplyPreviewImage(std::unique_ptr<LvglImage> image);
+    static std::unique_ptr<LvglImage> DownscalePreviewImage(std::unique_ptr<LvglImage> image,
+                                                            int target_width);
     void SetupUI();
     void SetupMusicPanel();  // 初始化音乐播放面板
     virtual bool Lock(int timeout_ms = 0) override;
@@ -60,6 +116,7 @@ public:
     virtual void SetEmotion(const char* emotion) override;
     virtual void SetChatMessage(const char* role, const char* content) override; 
     virtual void SetPreviewImage(std::unique_ptr<LvglImage> image) override;
+    virtual void OnStateChanged() override;
 
     // Add theme switching function
     virtual void SetTheme(Theme* theme) override;
@@ -68,6 +125,13 @@ public:
     virtual void SetMusicInfo(const char* song_name) override;
     virtual void SetMusicProgress(const char* song_name, int current_seconds, int total_seconds, float progress_percent) override;
     virtual void ClearMusicInfo() override;
+    virtual void SetDebugOverlayEnabled(bool enabled) override;
+
+#if CONFIG_DISPLAY_BENCH
+    // 刷新吞吐基准:按标准化场景整屏重绘,统计fps/面板吞吐/锁占用,
+    // 日志输出DISPLAY_BENCH开头的可解析统计行,返回同样内容的JSON
+    std::string RunFlushBenchmark();
+#endif
 };
 
 // SPI LCD显示器
@@ -7,11 +7,17 @@
 #define TAG "EmojiCollection"
 
 void EmojiCollection::AddEmoji(const std::string& name, LvglImage* image) {
-    emoji_collection_[name] = image;
+    auto key = AssetNameHash(name);
+    auto it = emoji_collection_.find(key);
+    if (it != emoji_collection_.end()) {
+        // 同名覆盖(主题重载)时释放旧图,此前是悄悄泄漏
+        delete it->second;
+    }
+    emoji_collection_[key] = image;
 }
 
 const LvglImage* EmojiCollection::GetEmojiImage(const char* name) {
-    auto it = emoji_collection_.find(name);
+    auto it = emoji_collection_.find(AssetNameHash(name));
     if (it != emoji_collection_.end()) {
         return it->second;
     }
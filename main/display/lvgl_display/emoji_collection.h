@@ -2,6 +2,7 @@
 #define EMOJI_COLLECTION_H
 
 #include "lvgl_image.h"
+#include "asset_name_hash.h"
 
 #include <lvgl.h>
 
@@ -18,7 +19,8 @@ public:
     virtual ~EmojiCollection();
 
 private:
-    std::map<std::string, LvglImage*> emoji_collection_;
+    // 键是AssetNameHash(表情名):查找路径不再构造std::string临时对象
+    std::map<uint32_t, LvglImage*> emoji_collection_;
 };
 
 class Twemoji32 : public EmojiCollection {
@@ -5,7 +5,8 @@
 #define TAG "LvglGif"
 
 LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
-    : gif_(nullptr), timer_(nullptr), last_call_(0), playing_(false), loaded_(false) {
+    : gif_(nullptr), timer_(nullptr), last_call_(0), playing_(false), loaded_(false),
+      dirty_area_valid_(false) {
     if (!img_dsc || !img_dsc->data) {
         ESP_LOGE(TAG, "Invalid image descriptor");
         return;
@@ -152,6 +153,14 @@ void LvglGif::SetFrameCallback(std::function<void()> callback) {
     frame_callback_ = callback;
 }
 
+bool LvglGif::GetDirtyArea(lv_area_t* area) const {
+    if (!dirty_area_valid_) {
+        return false;
+    }
+    *area = dirty_area_;
+    return true;
+}
+
 void LvglGif::NextFrame() {
     if (!loaded_ || !gif_ || !playing_) {
         return;
@@ -165,6 +174,13 @@ void LvglGif::NextFrame() {
 
     last_call_ = lv_tick_get();
 
+    // The outgoing frame's rect; gd_get_frame() disposes it before reading
+    // the next frame, so the canvas can change inside it as well
+    uint16_t prev_x = gif_->fx;
+    uint16_t prev_y = gif_->fy;
+    uint16_t prev_w = gif_->fw;
+    uint16_t prev_h = gif_->fh;
+
     // Get next frame
     int has_next = gd_get_frame(gif_);
     if (has_next == 0) {
@@ -178,8 +194,32 @@ void LvglGif::NextFrame() {
 
     // Render current frame
     if (gif_->canvas) {
-        gd_render_frame(gif_, gif_->canvas);
-        
+        // gd_render_frame() only writes the frame's sub-rectangle, so the
+        // dirty area is the union of the disposal rect and the new frame rect
+        int32_t x1 = INT32_MAX, y1 = INT32_MAX, x2 = -1, y2 = -1;
+        if (gif_->fw > 0 && gif_->fh > 0) {
+            gd_render_frame(gif_, gif_->canvas);
+            x1 = gif_->fx;
+            y1 = gif_->fy;
+            x2 = gif_->fx + gif_->fw - 1;
+            y2 = gif_->fy + gif_->fh - 1;
+        }
+        if (prev_w > 0 && prev_h > 0) {
+            x1 = LV_MIN(x1, (int32_t)prev_x);
+            y1 = LV_MIN(y1, (int32_t)prev_y);
+            x2 = LV_MAX(x2, (int32_t)(prev_x + prev_w - 1));
+            y2 = LV_MAX(y2, (int32_t)(prev_y + prev_h - 1));
+        }
+        if (x2 < 0) {
+            // Nothing changed on the canvas, skip the redraw entirely
+            return;
+        }
+        dirty_area_.x1 = x1;
+        dirty_area_.y1 = y1;
+        dirty_area_.x2 = x2;
+        dirty_area_.y2 = y2;
+        dirty_area_valid_ = true;
+
         // Call frame callback if set
         if (frame_callback_) {
             frame_callback_();
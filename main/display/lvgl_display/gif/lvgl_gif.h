@@ -69,6 +69,14 @@ public:
      */
     void SetFrameCallback(std::function<void()> callback);
 
+    /**
+     * Canvas area changed by the most recent frame update (union of the
+     * previous frame's disposal rect and the new frame rect), in canvas
+     * coordinates. Returns false when no bounded area is known and the
+     * whole canvas must be treated as dirty.
+     */
+    bool GetDirtyArea(lv_area_t* area) const;
+
 private:
     // GIF decoder instance
     gd_GIF* gif_;
@@ -88,7 +96,11 @@ private:
     
     // Frame update callback
     std::function<void()> frame_callback_;
-    
+
+    // Canvas area changed by the latest NextFrame() (disposal rect ∪ frame rect)
+    lv_area_t dirty_area_;
+    bool dirty_area_valid_;
+
     /**
      * Update to next frame
      */
@@ -1,5 +1,8 @@
 #include <esp_log.h>
 #include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <string>
 #include <cstdlib>
 #include <cstring>
@@ -19,10 +22,7 @@ LvglDisplay::LvglDisplay() {
     // Notification timer
     esp_timer_create_args_t notification_timer_args = {
         .callback = [](void *arg) {
-            LvglDisplay *display = static_cast<LvglDisplay*>(arg);
-            DisplayLockGuard lock(display);
-            lv_obj_add_flag(display->notification_label_, LV_OBJ_FLAG_HIDDEN);
-            lv_obj_remove_flag(display->status_label_, LV_OBJ_FLAG_HIDDEN);
+            static_cast<LvglDisplay*>(arg)->OnNotificationTimeout();
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -38,6 +38,13 @@ LvglDisplay::LvglDisplay() {
     } else {
         ESP_ERROR_CHECK(ret);
     }
+
+#if defined(CONFIG_LV_DRAW_SW_ASM_CUSTOM)
+    ESP_LOGI(TAG, "LVGL SW render: custom ASM blend kernels active (%s)",
+             CONFIG_LV_DRAW_SW_ASM_CUSTOM_INCLUDE);
+#else
+    ESP_LOGI(TAG, "LVGL SW render: generic C blend kernels");
+#endif
 }
 
 LvglDisplay::~LvglDisplay() {
@@ -82,42 +89,73 @@ void LvglDisplay::SetStatus(const char* status) {
 }
 
 void LvglDisplay::ShowNotification(const std::string &notification, int duration_ms) {
-    ShowNotification(notification.c_str(), duration_ms);
+    ShowNotification(notification.c_str(), duration_ms, kNotificationDefault);
 }
 
 void LvglDisplay::ShowNotification(const char* notification, int duration_ms) {
-    DisplayLockGuard lock(this);
+    ShowNotification(notification, duration_ms, kNotificationDefault);
+}
+
+void LvglDisplay::ShowNotification(const char* notification, int duration_ms, NotificationClass cls) {
+    std::lock_guard<std::mutex> guard(notification_mutex_);
     if (notification_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(notification_label_, notification);
-    lv_obj_remove_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
+
+    /* 低级别不打断正在显示的高级别,按级别只存最新一条,过期后补播。
+     * 连发的同级更新(OTA进度、音量连按)因此互相覆盖而不是排长队 */
+    if (current_notification_class_ > cls) {
+        auto& slot = pending_notifications_[cls];
+        slot.text = notification;
+        slot.duration_ms = duration_ms;
+        slot.valid = true;
+        return;
+    }
+
+    /* 同级替换和高级别抢占都是原地换文字,一次加锁完成过渡,无闪烁 */
+    current_notification_class_ = cls;
+    {
+        DisplayLockGuard lock(this);
+        lv_label_set_text(notification_label_, notification);
+        lv_obj_remove_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
+    }
 
     esp_timer_stop(notification_timer_);
     ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, duration_ms * 1000));
 }
 
+void LvglDisplay::OnNotificationTimeout() {
+    std::lock_guard<std::mutex> guard(notification_mutex_);
+
+    /* 从高到低补播积压的条目;标签保持可见、只换文字,队列切换不闪 */
+    for (int cls = kNotificationCritical; cls >= 0; cls--) {
+        auto& slot = pending_notifications_[cls];
+        if (slot.valid) {
+            slot.valid = false;
+            current_notification_class_ = cls;
+            {
+                DisplayLockGuard lock(this);
+                lv_label_set_text(notification_label_, slot.text.c_str());
+            }
+            ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, slot.duration_ms * 1000));
+            return;
+        }
+    }
+
+    current_notification_class_ = -1;
+    DisplayLockGuard lock(this);
+    lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_remove_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
+}
+
 void LvglDisplay::UpdateStatusBar(bool update_all) {
     auto& app = Application::GetInstance();
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
 
-    // Update mute icon
-    {
-        DisplayLockGuard lock(this);
-        if (mute_label_ == nullptr) {
-            return;
-        }
-
-        // 如果静音状态改变，则更新图标
-        if (codec->output_volume() == 0 && !muted_) {
-            muted_ = true;
-            lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_XMARK);
-        } else if (codec->output_volume() > 0 && muted_) {
-            muted_ = false;
-            lv_label_set_text(mute_label_, "");
-        }
+    if (mute_label_ == nullptr) {
+        return;
     }
 
     // Update time
@@ -137,14 +175,28 @@ void LvglDisplay::UpdateStatusBar(bool update_all) {
         }
     }
 
+    /* 先无锁算出所有字段的新值,与缓存比对出脏标记;事件源通过
+     * MarkStatusBarDirty置的位也在这里收下。全部没变就直接返回,
+     * 周期tick不再碰显示锁、不触发任何布局重算 */
+    uint32_t dirty = status_bar_dirty_.exchange(0, std::memory_order_relaxed);
+    if (update_all) {
+        dirty = kStatusBarFieldAll;
+    }
+
+    bool muted = codec->output_volume() == 0;
+    if (muted != muted_) {
+        dirty |= kStatusBarFieldMute;
+    }
+
     esp_pm_lock_acquire(pm_lock_);
     // 更新电池图标
     int battery_level;
     bool charging, discharging;
-    const char* icon = nullptr;
+    const char* battery_icon = nullptr;
+    bool show_low_battery = false;
     if (board.GetBatteryLevel(battery_level, charging, discharging)) {
         if (charging) {
-            icon = FONT_AWESOME_BATTERY_BOLT;
+            battery_icon = FONT_AWESOME_BATTERY_BOLT;
         } else {
             const char* levels[] = {
                 FONT_AWESOME_BATTERY_EMPTY, // 0-19%
@@ -154,34 +206,20 @@ void LvglDisplay::UpdateStatusBar(bool update_all) {
                 FONT_AWESOME_BATTERY_FULL, // 80-99%
                 FONT_AWESOME_BATTERY_FULL, // 100%
             };
-            icon = levels[battery_level / 20];
+            battery_icon = levels[battery_level / 20];
         }
-        DisplayLockGuard lock(this);
-        if (battery_label_ != nullptr && battery_icon_ != icon) {
-            battery_icon_ = icon;
-            lv_label_set_text(battery_label_, battery_icon_);
-        }
-
-        if (low_battery_popup_ != nullptr) {
-            if (strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
-                if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
-                    lv_obj_remove_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                    app.PlaySound(Lang::Sounds::OGG_LOW_BATTERY);
-                }
-            } else {
-                // Hide the low battery popup when the battery is not empty
-                if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
-                    lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                }
-            }
+        show_low_battery = strcmp(battery_icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging;
+        if (battery_icon != battery_icon_ || show_low_battery != low_battery_shown_) {
+            dirty |= kStatusBarFieldBattery;
         }
     }
 
     // 每 10 秒更新一次网络图标
+    const char* network_icon = nullptr;
     static int seconds_counter = 0;
     if (update_all || seconds_counter++ % 10 == 0) {
         // 升级固件时，不读取 4G 网络状态，避免占用 UART 资源
-        auto device_state = Application::GetInstance().GetDeviceState();
+        auto device_state = app.GetDeviceState();
         static const std::vector<DeviceState> allowed_states = {
             kDeviceStateIdle,
             kDeviceStateStarting,
@@ -190,22 +228,50 @@ void LvglDisplay::UpdateStatusBar(bool update_all) {
             kDeviceStateActivating,
         };
         if (std::find(allowed_states.begin(), allowed_states.end(), device_state) != allowed_states.end()) {
-            icon = board.GetNetworkStateIcon();
-            if (network_label_ != nullptr && icon != nullptr && network_icon_ != icon) {
-                DisplayLockGuard lock(this);
-                network_icon_ = icon;
-                lv_label_set_text(network_label_, network_icon_);
+            network_icon = board.GetNetworkStateIcon();
+            if (network_icon != nullptr && network_icon != network_icon_) {
+                dirty |= kStatusBarFieldNetwork;
             }
         }
     }
-
     esp_pm_lock_release(pm_lock_);
+
+    if (dirty == 0) {
+        return;
+    }
+
+    /* 多个字段的变化合并进同一次Lock/Unlock,LVGL只做一轮布局 */
+    DisplayLockGuard lock(this);
+    if (dirty & kStatusBarFieldMute) {
+        muted_ = muted;
+        lv_label_set_text(mute_label_, muted_ ? FONT_AWESOME_VOLUME_XMARK : "");
+    }
+    if ((dirty & kStatusBarFieldBattery) && battery_icon != nullptr) {
+        if (battery_label_ != nullptr && battery_icon_ != battery_icon) {
+            battery_icon_ = battery_icon;
+            lv_label_set_text(battery_label_, battery_icon_);
+        }
+        if (low_battery_popup_ != nullptr && show_low_battery != low_battery_shown_) {
+            low_battery_shown_ = show_low_battery;
+            if (show_low_battery) {
+                lv_obj_remove_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+                app.PlaySound(Lang::Sounds::OGG_LOW_BATTERY);
+            } else {
+                lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+            }
+        }
+    }
+    if ((dirty & kStatusBarFieldNetwork) && network_icon != nullptr && network_label_ != nullptr) {
+        network_icon_ = network_icon;
+        lv_label_set_text(network_label_, network_icon_);
+    }
 }
 
 void LvglDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
 }
 
 void LvglDisplay::SetPowerSaveMode(bool on) {
+    power_save_mode_ = on;
     if (on) {
         SetChatMessage("system", "");
         SetEmotion("sleepy");
@@ -213,44 +279,120 @@ void LvglDisplay::SetPowerSaveMode(bool on) {
         SetChatMessage("system", "");
         SetEmotion("neutral");
     }
+    UpdateRenderInterval();
 }
 
-bool LvglDisplay::SnapshotToJpeg(std::string& jpeg_data, int quality) {
-#if CONFIG_LV_USE_SNAPSHOT
+void LvglDisplay::OnStateChanged() {
+    UpdateRenderInterval();
+}
+
+/* 渲染调速:静态界面不需要全速刷新。省电模式压到 1Hz,空闲待机 10Hz
+ * (表情 GIF 仍以可接受的帧率走),对话/播报等动态状态恢复默认周期。
+ * 只调整刷新定时器,tick 与输入不受影响。 */
+void LvglDisplay::UpdateRenderInterval() {
+    uint32_t period_ms = LV_DEF_REFR_PERIOD;
+    if (power_save_mode_) {
+        period_ms = 1000;
+    } else if (Application::GetInstance().GetDeviceState() == kDeviceStateIdle) {
+        period_ms = 100;
+    }
+    SetRenderInterval(period_ms);
+}
+
+void LvglDisplay::SetRenderInterval(uint32_t period_ms) {
     DisplayLockGuard lock(this);
+    if (display_ == nullptr) {
+        return;
+    }
+    auto refr_timer = lv_display_get_refr_timer(display_);
+    if (refr_timer != nullptr) {
+        lv_timer_set_period(refr_timer, period_ms);
+    }
+}
 
-    lv_obj_t* screen = lv_screen_active();
-    lv_draw_buf_t* draw_buffer = lv_snapshot_take(screen, LV_COLOR_FORMAT_RGB565);
+bool LvglDisplay::SnapshotToJpeg(std::string& jpeg_data, int quality) {
+#if CONFIG_LV_USE_SNAPSHOT
+    // 只在抓帧期间持显示锁,snapshot 本身就是一份拷贝,
+    // 编码放到锁外的低优先级任务里做,UI 不再被冻结几百毫秒
+    lv_draw_buf_t* draw_buffer = nullptr;
+    {
+        DisplayLockGuard lock(this);
+        lv_obj_t* screen = lv_screen_active();
+        draw_buffer = lv_snapshot_take(screen, LV_COLOR_FORMAT_RGB565);
+    }
     if (draw_buffer == nullptr) {
         ESP_LOGE(TAG, "Failed to take snapshot, draw_buffer is nullptr");
         return false;
     }
 
-    // swap bytes
-    uint16_t* data = (uint16_t*)draw_buffer->data;
-    size_t pixel_count = draw_buffer->data_size / 2;
-    for (size_t i = 0; i < pixel_count; i++) {
-        data[i] = __builtin_bswap16(data[i]);
+    struct EncodeContext {
+        lv_draw_buf_t* draw_buffer;
+        std::string* jpeg_data;
+        int quality;
+        bool ret;
+        SemaphoreHandle_t done;
+    };
+    EncodeContext context = {
+        .draw_buffer = draw_buffer,
+        .jpeg_data = &jpeg_data,
+        .quality = quality,
+        .ret = false,
+        .done = xSemaphoreCreateBinary(),
+    };
+    if (context.done == nullptr) {
+        lv_draw_buf_destroy(draw_buffer);
+        return false;
     }
 
-    // 清空输出字符串并使用回调版本，避免预分配大内存块
-    jpeg_data.clear();
+    auto encode = [](void* arg) {
+        EncodeContext* ctx = static_cast<EncodeContext*>(arg);
+        lv_draw_buf_t* draw_buffer = ctx->draw_buffer;
 
-    // 🚀 使用回调版本的JPEG编码器，进一步节省内存
-    bool ret = image_to_jpeg_cb(draw_buffer->data, draw_buffer->data_size, draw_buffer->header.w, draw_buffer->header.h, PIXFORMAT_RGB565, quality,
-        [](void *arg, size_t index, const void *data, size_t len) -> size_t {
-        std::string* output = static_cast<std::string*>(arg);
-        if (data && len > 0) {
-            output->append(static_cast<const char*>(data), len);
+        // swap bytes
+        uint16_t* data = (uint16_t*)draw_buffer->data;
+        size_t pixel_count = draw_buffer->data_size / 2;
+        for (size_t i = 0; i < pixel_count; i++) {
+            data[i] = __builtin_bswap16(data[i]);
         }
-        return len;
-    }, &jpeg_data);
-    if (!ret) {
+
+        // 清空输出字符串并使用回调版本，避免预分配大内存块
+        ctx->jpeg_data->clear();
+
+        // 🚀 使用回调版本的JPEG编码器，进一步节省内存
+        ctx->ret = image_to_jpeg_cb(draw_buffer->data, draw_buffer->data_size, draw_buffer->header.w, draw_buffer->header.h, PIXFORMAT_RGB565, ctx->quality,
+            [](void *arg, size_t index, const void *data, size_t len) -> size_t {
+            std::string* output = static_cast<std::string*>(arg);
+            if (data && len > 0) {
+                output->append(static_cast<const char*>(data), len);
+            }
+            return len;
+        }, ctx->jpeg_data);
+
+        xSemaphoreGive(ctx->done);
+        vTaskDelete(NULL);
+    };
+
+    // 低优先级编码任务,多核时固定到核 1,避免抢占 WiFi/LVGL 所在的核 0
+#if CONFIG_FREERTOS_UNICORE
+    BaseType_t created = xTaskCreate(encode, "jpeg_encode", 2048 * 4, &context, 1, nullptr);
+#else
+    BaseType_t created = xTaskCreatePinnedToCore(encode, "jpeg_encode", 2048 * 4, &context, 1, nullptr, 1);
+#endif
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create jpeg_encode task");
+        vSemaphoreDelete(context.done);
+        lv_draw_buf_destroy(draw_buffer);
+        return false;
+    }
+    xSemaphoreTake(context.done, portMAX_DELAY);
+    vSemaphoreDelete(context.done);
+
+    if (!context.ret) {
         ESP_LOGE(TAG, "Failed to convert image to JPEG");
     }
 
     lv_draw_buf_destroy(draw_buffer);
-    return ret;
+    return context.ret;
 #else
     ESP_LOGE(TAG, "LV_USE_SNAPSHOT is not enabled");
     return false;
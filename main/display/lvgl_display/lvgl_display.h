@@ -11,23 +11,52 @@
 
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <mutex>
 
 class LvglDisplay : public Display {
 public:
     LvglDisplay();
     virtual ~LvglDisplay();
 
+    // 状态栏字段脏标记。周期tick自己会做无锁的新旧值比对;
+    // 事件源(电池监视器回调、静音切换等)也可以主动置位,让下个tick必刷
+    enum StatusBarField : uint32_t {
+        kStatusBarFieldMute = 1 << 0,
+        kStatusBarFieldBattery = 1 << 1,
+        kStatusBarFieldNetwork = 1 << 2,
+        kStatusBarFieldAll = 0xFFFFFFFF,
+    };
+    void MarkStatusBarDirty(uint32_t fields) {
+        status_bar_dirty_.fetch_or(fields, std::memory_order_relaxed);
+    }
+
+    // 通知级别:同级新条目原地替换旧条目(如进度类的连续更新),
+    // 高级别抢占低级别,低级别在高级别期间只保留最新一条、过期后补播
+    enum NotificationClass {
+        kNotificationDefault = 0,
+        kNotificationProgress,
+        kNotificationCritical,
+    };
+
     virtual void SetStatus(const char* status);
     virtual void ShowNotification(const char* notification, int duration_ms = 3000);
     virtual void ShowNotification(const std::string &notification, int duration_ms = 3000);
+    void ShowNotification(const char* notification, int duration_ms, NotificationClass cls);
     virtual void SetPreviewImage(std::unique_ptr<LvglImage> image);
     virtual void UpdateStatusBar(bool update_all = false);
     virtual void SetPowerSaveMode(bool on);
+    virtual void OnStateChanged() override;
     virtual bool SnapshotToJpeg(std::string& jpeg_data, int quality = 80);
 
 protected:
+    // 渲染调速:按设备状态调整 LVGL 刷新定时器周期,空闲/省电时降低渲染频率
+    void UpdateRenderInterval();
+    void SetRenderInterval(uint32_t period_ms);
+
     esp_pm_lock_handle_t pm_lock_ = nullptr;
     lv_display_t *display_ = nullptr;
+    bool power_save_mode_ = false;
 
     lv_obj_t *network_label_ = nullptr;
     lv_obj_t *status_label_ = nullptr;
@@ -40,10 +69,24 @@ protected:
     const char* battery_icon_ = nullptr;
     const char* network_icon_ = nullptr;
     bool muted_ = false;
+    bool low_battery_shown_ = false;
+    std::atomic<uint32_t> status_bar_dirty_{0};
 
     std::chrono::system_clock::time_point last_status_update_time_;
     esp_timer_handle_t notification_timer_ = nullptr;
 
+    // 通知队列状态(notification_mutex_保护;先拿它再拿显示锁)
+    struct PendingNotification {
+        std::string text;
+        int duration_ms = 0;
+        bool valid = false;
+    };
+    std::mutex notification_mutex_;
+    PendingNotification pending_notifications_[kNotificationCritical + 1];
+    int current_notification_class_ = -1;
+
+    void OnNotificationTimeout();
+
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
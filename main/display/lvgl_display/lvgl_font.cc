@@ -1,13 +1,142 @@
-#include "lvgl_font.h"
-#include <cbin_font.h>
-
-
-LvglCBinFont::LvglCBinFont(void* data) {
-    font_ = cbin_font_create(static_cast<uint8_t*>(data));
-}
-
-LvglCBinFont::~LvglCBinFont() {
-    if (font_ != nullptr) {
-        cbin_font_delete(font_);
-    }
-}
\ No newline at end of file
+#include "lvgl_font.h"
+#include <cbin_font.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+namespace {
+
+// 只缓存 CJK 区间的字形;ASCII 查表本身很快,而且可能受 kerning 影响
+constexpr uint32_t kGlyphCacheMinUnicode = 0x2E80;
+// 2的幂,直接映射按 unicode 低位取槽;CJK 码位连续,相邻字符天然错开
+constexpr size_t kGlyphCacheSlots = 64;
+constexpr size_t kGlyphCacheMaxBitmapBytes = 1024;
+
+}  // namespace
+
+LvglCBinFont::LvglCBinFont(void* data) {
+    // data 是资产分区的mmap地址,字形表和位图就地从flash映射窗口取用,
+    // 整个bin不复制进PSRAM
+    font_ = cbin_font_create(static_cast<uint8_t*>(data));
+    if (font_ == nullptr) {
+        return;
+    }
+
+    // 热点集缓存表显式钉在内部RAM;分配失败就退化为纯回源,功能不受影响
+    glyph_cache_ = static_cast<CachedGlyph*>(heap_caps_calloc(
+        kGlyphCacheSlots, sizeof(CachedGlyph), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+
+    // 在原字体前面套一层代理,把热点字形的 dsc 和位图留在内部 RAM
+    cached_font_ = *font_;
+    cached_font_.get_glyph_dsc = GetGlyphDscCb;
+    // 字体自带 release_glyph 时无法安全接管位图生命周期,只缓存 dsc
+    cache_bitmaps_ = (font_->release_glyph == nullptr && font_->get_glyph_bitmap != nullptr);
+    if (cache_bitmaps_) {
+        cached_font_.get_glyph_bitmap = GetGlyphBitmapCb;
+    }
+    cached_font_.user_data = this;
+}
+
+LvglCBinFont::~LvglCBinFont() {
+    if (glyph_cache_ != nullptr) {
+        for (size_t i = 0; i < kGlyphCacheSlots; i++) {
+            if (glyph_cache_[i].bitmap != nullptr) {
+                heap_caps_free(glyph_cache_[i].bitmap);
+            }
+        }
+        heap_caps_free(glyph_cache_);
+    }
+
+    if (font_ != nullptr) {
+        cbin_font_delete(font_);
+    }
+}
+
+LvglCBinFont::CachedGlyph* LvglCBinFont::SlotFor(uint32_t unicode) {
+    return &glyph_cache_[unicode & (kGlyphCacheSlots - 1)];
+}
+
+LvglCBinFont::CachedGlyph* LvglCBinFont::FindGlyph(uint32_t unicode) {
+    if (glyph_cache_ == nullptr) {
+        return nullptr;
+    }
+    auto entry = SlotFor(unicode);
+    return entry->unicode == unicode ? entry : nullptr;
+}
+
+LvglCBinFont::CachedGlyph* LvglCBinFont::FindGlyphByIndex(uint32_t glyph_index) {
+    if (glyph_cache_ == nullptr) {
+        return nullptr;
+    }
+    // 渲染路径按gid回查,整表都在内部RAM里,线性扫64个槽可以忽略不计
+    for (size_t i = 0; i < kGlyphCacheSlots; i++) {
+        if (glyph_cache_[i].unicode != 0 && glyph_cache_[i].glyph_index == glyph_index) {
+            return &glyph_cache_[i];
+        }
+    }
+    return nullptr;
+}
+
+bool LvglCBinFont::GetGlyphDscCb(const lv_font_t* font, lv_font_glyph_dsc_t* dsc,
+                                 uint32_t unicode, uint32_t unicode_next) {
+    auto self = static_cast<LvglCBinFont*>(font->user_data);
+
+    if (unicode >= kGlyphCacheMinUnicode) {
+        auto entry = self->FindGlyph(unicode);
+        if (entry != nullptr) {
+            *dsc = entry->dsc;
+            return true;
+        }
+    }
+
+    if (!self->font_->get_glyph_dsc(self->font_, dsc, unicode, unicode_next)) {
+        return false;
+    }
+
+    // 只缓存本字体自己解析出的字形,fallback 字体的结果不进缓存
+    if (unicode >= kGlyphCacheMinUnicode && dsc->resolved_font == self->font_ &&
+        self->glyph_cache_ != nullptr) {
+        if (self->cache_bitmaps_) {
+            // 让位图取用也走代理,命中时直接从内部 RAM 拷贝
+            dsc->resolved_font = &self->cached_font_;
+        }
+        // 直接映射:同槽旧字形就地驱逐
+        auto victim = self->SlotFor(unicode);
+        if (victim->bitmap != nullptr) {
+            heap_caps_free(victim->bitmap);
+        }
+        *victim = CachedGlyph{unicode, dsc->gid.index, *dsc, nullptr, 0};
+    }
+    return true;
+}
+
+const void* LvglCBinFont::GetGlyphBitmapCb(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf) {
+    auto self = static_cast<LvglCBinFont*>(dsc->resolved_font->user_data);
+
+    auto entry = self->FindGlyphByIndex(dsc->gid.index);
+    if (entry != nullptr && entry->bitmap != nullptr && draw_buf != nullptr &&
+        draw_buf->data != nullptr && entry->bitmap_size <= draw_buf->data_size) {
+        memcpy(draw_buf->data, entry->bitmap, entry->bitmap_size);
+        return draw_buf;
+    }
+
+    // 未命中:回源字体解码,并把结果留一份在内部 RAM
+    dsc->resolved_font = self->font_;
+    const void* res = self->font_->get_glyph_bitmap(dsc, draw_buf);
+    if (res == nullptr) {
+        return nullptr;
+    }
+
+    if (entry != nullptr && entry->bitmap == nullptr) {
+        auto res_buf = static_cast<const lv_draw_buf_t*>(res);
+        if (res_buf->data != nullptr && res_buf->data_size > 0 &&
+            res_buf->data_size <= kGlyphCacheMaxBitmapBytes) {
+            entry->bitmap = static_cast<uint8_t*>(
+                heap_caps_malloc(res_buf->data_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+            if (entry->bitmap != nullptr) {
+                memcpy(entry->bitmap, res_buf->data, res_buf->data_size);
+                entry->bitmap_size = res_buf->data_size;
+            }
+        }
+    }
+    return res;
+}
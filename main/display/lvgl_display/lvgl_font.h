@@ -1,6 +1,8 @@
 #pragma once
 
 #include <lvgl.h>
+#include <cstdint>
+#include <cstddef>
 
 
 class LvglFont {
@@ -20,12 +22,37 @@ private:
 };
 
 
+// C bin font consumed in place from the mmap'd assets partition.
+// 大字库整块留在 flash 映射窗口里零拷贝使用,不占 PSRAM;
+// 热点 CJK 字形的 dsc/位图放进一张内部 RAM 的直接映射表,重复短语不再回源
 class LvglCBinFont : public LvglFont {
 public:
     LvglCBinFont(void* data);
     virtual ~LvglCBinFont();
-    virtual const lv_font_t* font() const override { return font_; }
+    virtual const lv_font_t* font() const override {
+        return font_ != nullptr ? &cached_font_ : nullptr;
+    }
 
 private:
+    struct CachedGlyph {
+        uint32_t unicode;       // 0 = slot empty (cacheable range starts far above)
+        uint32_t glyph_index;
+        lv_font_glyph_dsc_t dsc;
+        uint8_t* bitmap;        // internal RAM copy, nullptr until first render
+        size_t bitmap_size;
+    };
+
+    static bool GetGlyphDscCb(const lv_font_t* font, lv_font_glyph_dsc_t* dsc,
+                              uint32_t unicode, uint32_t unicode_next);
+    static const void* GetGlyphBitmapCb(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf);
+
+    CachedGlyph* FindGlyph(uint32_t unicode);
+    CachedGlyph* FindGlyphByIndex(uint32_t glyph_index);
+    CachedGlyph* SlotFor(uint32_t unicode);
+
     lv_font_t* font_;
+    lv_font_t cached_font_;             // 代理字体,挂在 font_ 前面
+    bool cache_bitmaps_ = false;
+    // 直接映射表,显式分配在内部 RAM;命中是一次探测,不走 PSRAM 链表
+    CachedGlyph* glyph_cache_ = nullptr;
 };
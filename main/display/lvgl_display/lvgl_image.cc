@@ -2,6 +2,7 @@
 #include <cbin_font.h>
 
 #include <esp_log.h>
+#include <esp_jpeg_dec.h>
 #include <stdexcept>
 #include <cstring>
 #include <esp_heap_caps.h>
@@ -34,6 +35,66 @@ LvglCBinImage::~LvglCBinImage() {
     }
 }
 
+bool LvglJpegImage::IsJpeg(const uint8_t* data, size_t size) {
+    return size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+LvglJpegImage::LvglJpegImage(const uint8_t* jpeg_data, size_t size) {
+    bzero(&image_dsc_, sizeof(image_dsc_));
+
+    jpeg_dec_config_t config = DEFAULT_JPEG_DEC_CONFIG();
+    config.output_type = JPEG_PIXEL_FORMAT_RGB565_LE;
+    jpeg_dec_handle_t dec = nullptr;
+    if (jpeg_dec_open(&config, &dec) != JPEG_ERR_OK) {
+        throw std::runtime_error("Failed to open JPEG decoder");
+    }
+
+    jpeg_dec_io_t io = {};
+    io.inbuf = (unsigned char*)jpeg_data;
+    io.inbuf_len = (int)size;
+    jpeg_dec_header_info_t header = {};
+    uint8_t* out = nullptr;
+    do {
+        if (jpeg_dec_parse_header(dec, &io, &header) != JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "Failed to parse JPEG header, size: %u", size);
+            break;
+        }
+        size_t out_size = (size_t)header.width * header.height * 2;
+        // 解码器要求输出缓冲16字节对齐
+        out = (uint8_t*)jpeg_calloc_align(out_size, 16);
+        if (out == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate %u bytes for decoded image", out_size);
+            break;
+        }
+        io.outbuf = out;
+        if (jpeg_dec_process(dec, &io) != JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "Failed to decode JPEG image, size: %u", size);
+            jpeg_free_align(out);
+            out = nullptr;
+            break;
+        }
+        image_dsc_.data = out;
+        image_dsc_.data_size = out_size;
+        image_dsc_.header.magic = LV_IMAGE_HEADER_MAGIC;
+        image_dsc_.header.cf = LV_COLOR_FORMAT_RGB565;
+        image_dsc_.header.w = header.width;
+        image_dsc_.header.h = header.height;
+        image_dsc_.header.stride = header.width * 2;
+    } while (false);
+    jpeg_dec_close(dec);
+
+    if (out == nullptr) {
+        throw std::runtime_error("Failed to decode JPEG image");
+    }
+}
+
+LvglJpegImage::~LvglJpegImage() {
+    if (image_dsc_.data != nullptr) {
+        jpeg_free_align((void*)image_dsc_.data);
+        image_dsc_.data = nullptr;
+    }
+}
+
 LvglAllocatedImage::LvglAllocatedImage(void* data, size_t size) {
     bzero(&image_dsc_, sizeof(image_dsc_));
     image_dsc_.data_size = size;
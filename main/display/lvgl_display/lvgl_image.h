@@ -41,6 +41,19 @@ private:
     const lv_img_dsc_t* image_dsc_;
 };
 
+// JPEG专用:构造时就用esp_new_jpeg解成RGB565位图(S3上走SIMD优化路径),
+// 解码发生在调用线程,LVGL任务渲染时只是普通位图贴图,不再卡在软解上
+class LvglJpegImage : public LvglImage {
+public:
+    LvglJpegImage(const uint8_t* jpeg_data, size_t size);
+    virtual ~LvglJpegImage();
+    virtual const lv_img_dsc_t* image_dsc() const override { return &image_dsc_; }
+    static bool IsJpeg(const uint8_t* data, size_t size);
+
+private:
+    lv_img_dsc_t image_dsc_;
+};
+
 class LvglAllocatedImage : public LvglImage {
 public:
     LvglAllocatedImage(void* data, size_t size);
@@ -5,9 +5,11 @@
 
 #include <string>
 #include <algorithm>
+#include <cstring>
 
 #include <esp_log.h>
 #include <esp_err.h>
+#include <esp_heap_caps.h>
 #include <esp_lvgl_port.h>
 #include <font_awesome.h>
 
@@ -46,35 +48,36 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
     lvgl_port_init(&port_cfg);
 
     ESP_LOGI(TAG, "Adding OLED display");
-    const lvgl_port_display_cfg_t display_cfg = {
-        .io_handle = panel_io_,
-        .panel_handle = panel_,
-        .control_handle = nullptr,
-        .buffer_size = static_cast<uint32_t>(width_ * height_),
-        .double_buffer = false,
-        .trans_size = 0,
-        .hres = static_cast<uint32_t>(width_),
-        .vres = static_cast<uint32_t>(height_),
-        .monochrome = true,
-        .rotation = {
-            .swap_xy = false,
-            .mirror_x = mirror_x,
-            .mirror_y = mirror_y,
-        },
-        .flags = {
-            .buff_dma = 1,
-            .buff_spiram = 0,
-            .sw_rotate = 0,
-            .full_refresh = 0,
-            .direct_mode = 0,
-        },
-    };
-
-    display_ = lvgl_port_add_disp(&display_cfg);
+    ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_, mirror_x, mirror_y));
+
+    /* 不走lvgl_port_add_disp(它对单色屏整帧重发):自建lv_display,
+     * DIRECT模式下LVGL只重绘失效区域、整帧缓冲始终是最新画面,flush里
+     * 按8行页与影子帧比对,只把变过的页发I2C。400kHz总线上整帧约10ms,
+     * 流式字幕通常只动一两页,总线占用降一个数量级。LVGL刷新定时器
+     * 本身就把一个周期内的连续失效合并成一次flush(周期由
+     * UpdateRenderInterval按设备状态调速)。 */
+    size_t stride = width_ / 8;
+    size_t page_bytes = stride * height_;
+    /* I1缓冲开头是8字节调色板,位图紧随其后 */
+    draw_buf_ = (uint8_t*)heap_caps_malloc(8 + page_bytes, MALLOC_CAP_INTERNAL);
+    shadow_buf_ = (uint8_t*)heap_caps_malloc(page_bytes, MALLOC_CAP_INTERNAL);
+    page_buf_ = (uint8_t*)heap_caps_malloc(page_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    assert(draw_buf_ != nullptr && shadow_buf_ != nullptr && page_buf_ != nullptr);
+    /* 影子帧初值取反,保证首帧所有页都判脏、完整刷一遍屏 */
+    memset(shadow_buf_, 0xFF, page_bytes);
+
+    lvgl_port_lock(0);
+    display_ = lv_display_create(width_, height_);
     if (display_ == nullptr) {
+        lvgl_port_unlock();
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    lv_display_set_color_format(display_, LV_COLOR_FORMAT_I1);
+    lv_display_set_buffers(display_, draw_buf_, nullptr, 8 + page_bytes, LV_DISPLAY_RENDER_MODE_DIRECT);
+    lv_display_set_user_data(display_, this);
+    lv_display_set_flush_cb(display_, OnLvglFlush);
+    lvgl_port_unlock();
 
     if (height_ == 64) {
         SetupUI_128x64();
@@ -97,6 +100,11 @@ OledDisplay::~OledDisplay() {
         lv_obj_del(container_);
     }
 
+    if (display_ != nullptr) {
+        lvgl_port_lock(0);
+        lv_display_delete(display_);
+        lvgl_port_unlock();
+    }
     if (panel_ != nullptr) {
         esp_lcd_panel_del(panel_);
     }
@@ -104,6 +112,65 @@ OledDisplay::~OledDisplay() {
         esp_lcd_panel_io_del(panel_io_);
     }
     lvgl_port_deinit();
+
+    if (draw_buf_ != nullptr) {
+        heap_caps_free(draw_buf_);
+    }
+    if (shadow_buf_ != nullptr) {
+        heap_caps_free(shadow_buf_);
+    }
+    if (page_buf_ != nullptr) {
+        heap_caps_free(page_buf_);
+    }
+}
+
+void OledDisplay::OnLvglFlush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+    auto self = static_cast<OledDisplay*>(lv_display_get_user_data(display));
+    /* DIRECT模式下px_map指向整帧缓冲;一个刷新周期的多块失效区域
+     * 攒到最后一次flush统一比对下发 */
+    if (lv_display_flush_is_last(display)) {
+        self->FlushDirtyPages(self->draw_buf_ + 8);
+    }
+    lv_display_flush_ready(display);
+}
+
+void OledDisplay::FlushDirtyPages(const uint8_t* bitmap) {
+    int stride = width_ / 8;
+    int pages = height_ / 8;
+
+    /* I1是行序位图(每行width/8字节,高位在左),SSD1306要列序页字节
+     * (每字节是一列8行,bit0在上),先整帧转置再比对 */
+    for (int page = 0; page < pages; page++) {
+        uint8_t* dst = page_buf_ + page * width_;
+        const uint8_t* rows = bitmap + page * 8 * stride;
+        for (int x = 0; x < width_; x++) {
+            const uint8_t* col = rows + (x >> 3);
+            uint8_t mask = 0x80 >> (x & 7);
+            uint8_t v = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                if (col[bit * stride] & mask) {
+                    v |= 1 << bit;
+                }
+            }
+            dst[x] = v;
+        }
+    }
+
+    /* 与影子帧逐页比对,连续脏页合并成一次传输 */
+    int first_dirty = -1;
+    for (int page = 0; page <= pages; page++) {
+        bool dirty = page < pages &&
+            memcmp(page_buf_ + page * width_, shadow_buf_ + page * width_, width_) != 0;
+        if (dirty && first_dirty < 0) {
+            first_dirty = page;
+        }
+        if (!dirty && first_dirty >= 0) {
+            size_t offset = first_dirty * width_;
+            memcpy(shadow_buf_ + offset, page_buf_ + offset, (page - first_dirty) * width_);
+            esp_lcd_panel_draw_bitmap(panel_, 0, first_dirty * 8, width_, page * 8, page_buf_ + offset);
+            first_dirty = -1;
+        }
+    }
 }
 
 bool OledDisplay::Lock(int timeout_ms) {
@@ -124,13 +191,29 @@ void OledDisplay::SetChatMessage(const char* role, const char* content) {
     std::string content_str = content;
     std::replace(content_str.begin(), content_str.end(), '\n', ' ');
 
+    /* 流式更新每个token重发全文:没变就跳过,纯追加只拷贝增量,
+     * 标签以static文本引用常驻缓冲,免去每次整段strdup */
+    bool changed = content_str != chat_message_text_;
+    if (changed) {
+        if (!chat_message_text_.empty() &&
+            content_str.compare(0, chat_message_text_.size(), chat_message_text_) == 0) {
+            chat_message_text_.append(content_str, chat_message_text_.size(), std::string::npos);
+        } else {
+            chat_message_text_ = std::move(content_str);
+        }
+    }
+
     if (content_right_ == nullptr) {
-        lv_label_set_text(chat_message_label_, content_str.c_str());
+        if (changed) {
+            lv_label_set_text_static(chat_message_label_, chat_message_text_.c_str());
+        }
     } else {
         if (content == nullptr || content[0] == '\0') {
             lv_obj_add_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
         } else {
-            lv_label_set_text(chat_message_label_, content_str.c_str());
+            if (changed) {
+                lv_label_set_text_static(chat_message_label_, chat_message_text_.c_str());
+            }
             lv_obj_remove_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
         }
     }
@@ -12,6 +12,14 @@ private:
     esp_lcd_panel_io_handle_t panel_io_ = nullptr;
     esp_lcd_panel_handle_t panel_ = nullptr;
 
+    // 脏页刷新:整帧I1渲染缓冲 + 页格式影子帧,flush时逐页比对只发变化的页
+    uint8_t* draw_buf_ = nullptr;
+    uint8_t* shadow_buf_ = nullptr;
+    uint8_t* page_buf_ = nullptr;
+
+    static void OnLvglFlush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map);
+    void FlushDirtyPages(const uint8_t* bitmap);
+
     lv_obj_t* status_bar_ = nullptr;
     lv_obj_t* content_ = nullptr;
     lv_obj_t* content_left_ = nullptr;
@@ -20,6 +28,8 @@ private:
     lv_obj_t* side_bar_ = nullptr;
     lv_obj_t *emotion_label_ = nullptr;
     lv_obj_t* chat_message_label_ = nullptr;
+    // 流式字幕的常驻文本缓冲(换行已替换为空格),标签以static文本引用
+    std::string chat_message_text_;
 
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
@@ -0,0 +1,82 @@
+#include "dns_prefetch.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lwip/netdb.h>
+
+#include <vector>
+
+#define TAG "DnsPrefetch"
+
+// scheme://host[:port]/path 里抠出host;IP直连和畸形URL返回空串跳过
+std::string DnsPrefetch::ExtractHost(const std::string& url) {
+    auto scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) {
+        return "";
+    }
+    auto host_start = scheme_end + 3;
+    auto host_end = url.find_first_of(":/", host_start);
+    auto host = url.substr(host_start, host_end == std::string::npos
+                                       ? std::string::npos : host_end - host_start);
+    // 纯IP不用解析
+    if (!host.empty() && host.find_first_not_of("0123456789.") == std::string::npos) {
+        return "";
+    }
+    return host;
+}
+
+void DnsPrefetch::PrefetchTask() {
+    std::vector<std::string> hosts;
+    auto add_host = [&hosts](const std::string& url) {
+        auto host = ExtractHost(url);
+        if (host.empty()) {
+            return;
+        }
+        for (const auto& existing : hosts) {
+            if (existing == host) {
+                return;
+            }
+        }
+        hosts.push_back(host);
+    };
+
+    {
+        Settings settings("websocket", false);
+        add_host(settings.GetString("url"));
+    }
+    {
+        Settings settings("wifi", false);
+        auto ota_url = settings.GetString("ota_url");
+        if (ota_url.empty()) {
+            ota_url = CONFIG_OTA_URL;
+        }
+        add_host(ota_url);
+    }
+
+    for (const auto& host : hosts) {
+        int64_t start = esp_timer_get_time();
+        struct addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* result = nullptr;
+        int err = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+        if (err == 0) {
+            freeaddrinfo(result);
+            ESP_LOGI(TAG, "Warmed %s in %lld ms", host.c_str(),
+                     (esp_timer_get_time() - start) / 1000);
+        } else {
+            ESP_LOGW(TAG, "Failed to resolve %s: %d", host.c_str(), err);
+        }
+    }
+}
+
+void DnsPrefetch::WarmKnownEndpoints() {
+    // 低优先级一次性任务,预热失败无所谓,连接路径自己还会解析
+    xTaskCreate([](void* arg) {
+        PrefetchTask();
+        vTaskDelete(NULL);
+    }, "dns_prefetch", 2048 * 2, nullptr, 1, nullptr);
+}
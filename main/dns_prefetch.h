@@ -0,0 +1,19 @@
+#ifndef DNS_PREFETCH_H
+#define DNS_PREFETCH_H
+
+#include <string>
+
+// 已知端点的DNS预热:网络就绪后在低优先级任务里把OTA/协议服务器的
+// 域名解析一遍,结果落进lwIP的DNS缓存。之后esp_http_client/
+// esp_websocket_client内部的同步解析就是缓存命中,会话建立和版本
+// 检查不再被拥塞网络上动辄数秒的DNS查询卡住
+class DnsPrefetch {
+public:
+    static void WarmKnownEndpoints();
+
+private:
+    static std::string ExtractHost(const std::string& url);
+    static void PrefetchTask();
+};
+
+#endif // DNS_PREFETCH_H
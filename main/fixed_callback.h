@@ -0,0 +1,123 @@
+#ifndef FIXED_CALLBACK_H
+#define FIXED_CALLBACK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 固定容量、不落堆的回调封装,替代音频/协议每帧热路径上的std::function:
+// 捕获对象原地构造在内部缓冲里,不走分配器;超出容量直接编译报错而不是
+// 悄悄堆分配。注册一次、每帧调用的回调(采集输出、下行音频包、音频服务
+// 事件)都应该用它;容量不敏感的冷路径(如Application::Schedule)继续用
+// std::function即可
+template <typename Signature, size_t Capacity = 16>
+class FixedCallback;
+
+template <typename R, typename... Args, size_t Capacity>
+class FixedCallback<R(Args...), Capacity> {
+public:
+    FixedCallback() = default;
+    FixedCallback(std::nullptr_t) {}
+
+    template <typename F, typename Decayed = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Decayed, FixedCallback>>>
+    FixedCallback(F&& callback) {
+        static_assert(sizeof(Decayed) <= Capacity,
+                      "回调捕获超过FixedCallback容量,改小捕获或调大Capacity");
+        static_assert(std::is_invocable_r_v<R, Decayed&, Args...>,
+                      "回调签名不匹配");
+        new (storage_) Decayed(std::forward<F>(callback));
+        invoke_ = [](void* obj, Args&&... args) -> R {
+            return (*static_cast<Decayed*>(obj))(std::forward<Args>(args)...);
+        };
+        manage_ = [](void* dst, void* src, Op op) {
+            switch (op) {
+                case Op::kCopy:
+                    new (dst) Decayed(*static_cast<const Decayed*>(src));
+                    break;
+                case Op::kMove:
+                    new (dst) Decayed(std::move(*static_cast<Decayed*>(src)));
+                    break;
+                case Op::kDestroy:
+                    static_cast<Decayed*>(dst)->~Decayed();
+                    break;
+            }
+        };
+    }
+
+    FixedCallback(const FixedCallback& other) {
+        CopyFrom(other);
+    }
+
+    FixedCallback(FixedCallback&& other) {
+        MoveFrom(other);
+    }
+
+    FixedCallback& operator=(const FixedCallback& other) {
+        if (this != &other) {
+            Reset();
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    FixedCallback& operator=(FixedCallback&& other) {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    FixedCallback& operator=(std::nullptr_t) {
+        Reset();
+        return *this;
+    }
+
+    ~FixedCallback() {
+        Reset();
+    }
+
+    R operator()(Args... args) {
+        return invoke_(storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+    bool operator==(std::nullptr_t) const { return invoke_ == nullptr; }
+    bool operator!=(std::nullptr_t) const { return invoke_ != nullptr; }
+
+private:
+    enum class Op { kCopy, kMove, kDestroy };
+
+    void Reset() {
+        if (invoke_ != nullptr) {
+            manage_(storage_, nullptr, Op::kDestroy);
+            invoke_ = nullptr;
+            manage_ = nullptr;
+        }
+    }
+
+    void CopyFrom(const FixedCallback& other) {
+        if (other.invoke_ != nullptr) {
+            other.manage_(storage_, const_cast<unsigned char*>(other.storage_), Op::kCopy);
+            invoke_ = other.invoke_;
+            manage_ = other.manage_;
+        }
+    }
+
+    void MoveFrom(FixedCallback& other) {
+        if (other.invoke_ != nullptr) {
+            other.manage_(storage_, other.storage_, Op::kMove);
+            invoke_ = other.invoke_;
+            manage_ = other.manage_;
+            other.Reset();
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    R (*invoke_)(void*, Args&&...) = nullptr;
+    void (*manage_)(void*, void*, Op) = nullptr;
+};
+
+#endif // FIXED_CALLBACK_H
@@ -0,0 +1,71 @@
+#include "flash_scheduler.h"
+#include "application.h"
+#include "metrics_registry.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+
+#include <algorithm>
+
+#define TAG "FlashScheduler"
+
+FlashScheduler::FlashScheduler() {
+    auto& metrics = MetricsRegistry::GetInstance();
+    metric_slices_ = metrics.Register("flash.erase_slices", kMetricCounter);
+    metric_wait_ms_ = metrics.Register("flash.idle_wait_ms", kMetricCounter);
+    metric_underruns_ = metrics.Register("flash.underruns", kMetricCounter);
+}
+
+/* 有界等窗:音频持续活跃(整首歌在播)时不存在空窗,最多等
+ * kMaxIdleWaitMs后照擦——单扇区擦除由DMA环深度兜底 */
+void FlashScheduler::WaitForAudioIdle() {
+    auto& audio = Application::GetInstance().GetAudioService();
+    int waited = 0;
+    while (waited < kMaxIdleWaitMs && audio.IsAudioActive()) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+        waited += 20;
+    }
+    if (waited > 0) {
+        MetricsRegistry::GetInstance().Add(metric_wait_ms_, waited);
+    }
+}
+
+esp_err_t FlashScheduler::EraseRange(const esp_partition_t* partition, size_t offset,
+                                     size_t size, Urgency urgency) {
+    auto& audio = Application::GetInstance().GetAudioService();
+    const size_t sector = esp_partition_get_main_flash_sector_size();
+    const size_t end = offset + size;
+    const uint32_t underruns_before = audio.GetDebugStatistics().playback_underrun_count;
+
+    for (size_t pos = offset; pos < end;) {
+        if (urgency == Urgency::kBackground) {
+            WaitForAudioIdle();
+        }
+        size_t chunk = std::min(sector, end - pos);
+        esp_err_t err;
+        {
+            std::lock_guard<std::mutex> lock(op_mutex_);
+            err = esp_partition_erase_range(partition, pos, chunk);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Erase failed at 0x%x on %s: %s", (unsigned int)pos,
+                     partition->label, esp_err_to_name(err));
+            return err;
+        }
+        MetricsRegistry::GetInstance().Add(metric_slices_, 1);
+        pos += chunk;
+        if (pos < end) {
+            // 片间让出一个tick:音频/渲染任务先跑
+            vTaskDelay(1);
+        }
+    }
+
+    /* 擦除窗口内新增的欠载归因给flash(同期的网络欠载也会算进来,
+     * 作为"是不是flash吵到音频了"的巡检指标足够) */
+    uint32_t delta = audio.GetDebugStatistics().playback_underrun_count - underruns_before;
+    if (delta > 0) {
+        MetricsRegistry::GetInstance().Add(metric_underruns_, delta);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,48 @@
+#ifndef FLASH_SCHEDULER_H
+#define FLASH_SCHEDULER_H
+
+#include <esp_partition.h>
+
+#include <mutex>
+
+/* 协作式flash擦除调度:OTA预擦、资产包下载、音乐溢出层此前各自直接
+ * 打esp_partition_erase_range,大范围擦除一口气挂起指令cache数百毫秒,
+ * 正砸在音频任务头上;多个写方并发时还会在flash芯片上互相排队。这里
+ * 把擦除切成单扇区片,片间让出CPU,所有片经同一互斥串行——单次cache
+ * 挂起的上界变成一个扇区的擦除时长;背景档在擦每片之前先等音频空窗
+ * (有界,不饿死写方)。遥测经MetricsRegistry:切片数、等窗毫秒、擦除
+ * 期间新增的播放欠载数(按擦除前后欠载计数差分归因)。NVS走自己的
+ * 分区和内部互斥,提交粒度本来就小,不在此列 */
+class FlashScheduler {
+public:
+    enum class Urgency {
+        kForeground,  // 有人在等进度(OTA/资产下载):只切片+串行,不等空窗
+        kBackground,  // 没人等(音乐溢出层):每片先等一小段音频空窗
+    };
+
+    static FlashScheduler& GetInstance() {
+        static FlashScheduler instance;
+        return instance;
+    }
+
+    // 切片擦除,offset/size须扇区对齐(与esp_partition_erase_range同约束)
+    esp_err_t EraseRange(const esp_partition_t* partition, size_t offset, size_t size,
+                         Urgency urgency);
+
+private:
+    FlashScheduler();
+    FlashScheduler(const FlashScheduler&) = delete;
+    FlashScheduler& operator=(const FlashScheduler&) = delete;
+
+    void WaitForAudioIdle();
+
+    // 背景档单片的最大等窗时长:再等下去溢出层吞吐就追不上码率了
+    static constexpr int kMaxIdleWaitMs = 100;
+
+    std::mutex op_mutex_;
+    int metric_slices_ = -1;
+    int metric_wait_ms_ = -1;
+    int metric_underruns_ = -1;
+};
+
+#endif // FLASH_SCHEDULER_H
@@ -0,0 +1,103 @@
+#include "heap_telemetry.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#define TAG "HeapTelemetry"
+
+static const char* const kTagNames[kHeapTagCount] = {
+    "audio",
+    "music",
+    "assets",
+    "display",
+    "protocol",
+};
+
+void HeapTelemetry::Track(HeapTag tag, size_t bytes) {
+    auto& stats = stats_[tag];
+    size_t current = stats.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    // CAS推高水位
+    size_t watermark = stats.watermark.load(std::memory_order_relaxed);
+    while (current > watermark &&
+           !stats.watermark.compare_exchange_weak(watermark, current, std::memory_order_relaxed)) {
+    }
+}
+
+void HeapTelemetry::Untrack(HeapTag tag, size_t bytes) {
+    stats_[tag].current.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void HeapTelemetry::RegisterLoadShedder(const char* name, std::function<void()> shed) {
+    std::lock_guard<std::mutex> lock(shedders_mutex_);
+    shedders_.push_back({name, std::move(shed)});
+}
+
+void HeapTelemetry::RegisterRecycler(const char* name, std::function<bool()> recycle) {
+    std::lock_guard<std::mutex> lock(shedders_mutex_);
+    recyclers_.push_back({name, std::move(recycle)});
+}
+
+void HeapTelemetry::CheckIdleMaintenance() {
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    if (largest >= kFragmentedLargestBlockBytes) {
+        return;
+    }
+    ESP_LOGW(TAG, "Internal RAM fragmented: largest block %u bytes (free %u), running maintenance",
+             (unsigned)largest, (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+
+    // 每个周期只做一个动作:回收本身(断链重连等)也有代价,摊开到
+    // 多个空闲周期里做,任何单次维护都不会被用户察觉
+    std::lock_guard<std::mutex> lock(shedders_mutex_);
+    for (size_t i = 0; i < recyclers_.size(); i++) {
+        auto& recycler = recyclers_[next_recycler_];
+        next_recycler_ = (next_recycler_ + 1) % recyclers_.size();
+        if (recycler.recycle()) {
+            ESP_LOGI(TAG, "Recycled %s, largest block now %u bytes", recycler.name,
+                     (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+            return;
+        }
+    }
+}
+
+void HeapTelemetry::Check() {
+    size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+
+    for (int i = 0; i < kHeapTagCount; i++) {
+        size_t watermark = stats_[i].watermark.load(std::memory_order_relaxed);
+        if (watermark > 0) {
+            ESP_LOGI(TAG, "%s: current %u, watermark %u", kTagNames[i],
+                     stats_[i].current.load(std::memory_order_relaxed), watermark);
+        }
+    }
+
+    if (!low_memory_ && free_internal < kLowInternalHeapBytes) {
+        low_memory_ = true;
+        ESP_LOGE(TAG, "Internal RAM low (%u bytes free), shedding load", free_internal);
+        std::lock_guard<std::mutex> lock(shedders_mutex_);
+        for (auto& shedder : shedders_) {
+            ESP_LOGW(TAG, "Shedding: %s", shedder.name);
+            shedder.shed();
+        }
+    } else if (low_memory_ && free_internal > kLowInternalHeapBytes * 3 / 2) {
+        low_memory_ = false;
+        ESP_LOGI(TAG, "Internal RAM recovered (%u bytes free)", free_internal);
+    }
+}
+
+void HeapTelemetry::AddHeapSection(cJSON* root) {
+    auto heap = cJSON_CreateObject();
+    cJSON_AddNumberToObject(heap, "free_internal", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    cJSON_AddNumberToObject(heap, "min_free_internal", heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    cJSON_AddNumberToObject(heap, "largest_block_internal", heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    cJSON_AddNumberToObject(heap, "free_spiram", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+
+    auto tags = cJSON_CreateObject();
+    for (int i = 0; i < kHeapTagCount; i++) {
+        auto item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "current", stats_[i].current.load(std::memory_order_relaxed));
+        cJSON_AddNumberToObject(item, "watermark", stats_[i].watermark.load(std::memory_order_relaxed));
+        cJSON_AddItemToObject(tags, kTagNames[i], item);
+    }
+    cJSON_AddItemToObject(heap, "tags", tags);
+    cJSON_AddItemToObject(root, "heap", heap);
+}
@@ -0,0 +1,86 @@
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <cJSON.h>
+
+// 按子系统归类的堆用量水位:现场OOM时能看出是音乐缓冲、资产缓存
+// 还是音频队列吃掉了内存。大块分配的归属方在分配/释放处打点,
+// 周期检查在内部RAM告急时触发已注册的卸载动作(停音乐预读等)
+enum HeapTag {
+    kHeapTagAudio = 0,
+    kHeapTagMusic,
+    kHeapTagAssets,
+    kHeapTagDisplay,
+    kHeapTagProtocol,
+    kHeapTagCount
+};
+
+class HeapTelemetry {
+public:
+    static HeapTelemetry& GetInstance() {
+        static HeapTelemetry instance;
+        return instance;
+    }
+
+    HeapTelemetry(const HeapTelemetry&) = delete;
+    HeapTelemetry& operator=(const HeapTelemetry&) = delete;
+
+    // 任意线程可调用,无锁
+    void Track(HeapTag tag, size_t bytes);
+    void Untrack(HeapTag tag, size_t bytes);
+
+    // 低内存时按注册顺序触发;name必须是静态生存期字符串
+    void RegisterLoadShedder(const char* name, std::function<void()> shed);
+
+    // 空闲维护动作:设备Idle且内部RAM碎片化(最大空闲块过小)时触发,
+    // 返回true表示确实做了回收。与卸载不同,回收的对象随后会按需重建
+    void RegisterRecycler(const char* name, std::function<bool()> recycle);
+
+    // 周期调用(主循环10秒一次):打印水位,内部RAM低于阈值时卸载负载
+    void Check();
+
+    // 主循环在kDeviceStateIdle时周期调用(60秒粒度):最大空闲块跌破
+    // 阈值就轮转触发一个回收动作,把"几周后TLS握手分不出整块"的
+    // 偶发硬故障换成用户无感的例行维护
+    void CheckIdleMaintenance();
+
+    // 把"heap"小节挂到设备状态JSON上(GetDeviceStatusJson用)
+    void AddHeapSection(cJSON* root);
+
+private:
+    HeapTelemetry() = default;
+
+    struct TagStats {
+        std::atomic<size_t> current{0};
+        std::atomic<size_t> watermark{0};
+    };
+
+    // 内部RAM低水位:低于此值触发卸载,回升50%后解除
+    static constexpr size_t kLowInternalHeapBytes = 40 * 1024;
+
+    // 碎片化判据:TLS握手瞬态需要约16KB连续内部RAM,留出余量。
+    // 总空闲够而最大块跌破此线,就是OpenAudioChannel将败未败的前兆
+    static constexpr size_t kFragmentedLargestBlockBytes = 20 * 1024;
+
+    TagStats stats_[kHeapTagCount];
+
+    struct Shedder {
+        const char* name;
+        std::function<void()> shed;
+    };
+    struct Recycler {
+        const char* name;
+        std::function<bool()> recycle;
+    };
+    std::mutex shedders_mutex_;
+    std::vector<Shedder> shedders_;
+    std::vector<Recycler> recyclers_;
+    size_t next_recycler_ = 0;
+    bool low_memory_ = false;
+};
+
+#endif // HEAP_TELEMETRY_H
@@ -0,0 +1,88 @@
+#include "http_pool.h"
+#include "board.h"
+
+#include <esp_log.h>
+
+#define TAG "HttpPool"
+
+PooledHttp::~PooledHttp() {
+    if (http_) {
+        HttpPool::GetInstance().Release(std::move(key_), std::move(http_));
+    }
+}
+
+PooledHttp& PooledHttp::operator=(PooledHttp&& other) {
+    if (this != &other) {
+        if (http_) {
+            HttpPool::GetInstance().Release(std::move(key_), std::move(http_));
+        }
+        key_ = std::move(other.key_);
+        http_ = std::move(other.http_);
+    }
+    return *this;
+}
+
+std::string HttpPool::MakeKey(const char* tag, const std::string& url, int connect_timeout) {
+    // 只取 scheme://host:port,路径和查询串不参与键
+    std::string origin = url;
+    auto scheme_end = origin.find("://");
+    if (scheme_end != std::string::npos) {
+        auto path_start = origin.find('/', scheme_end + 3);
+        if (path_start != std::string::npos) {
+            origin.resize(path_start);
+        }
+    }
+    return std::string(tag) + "|" + origin + "|" + std::to_string(connect_timeout);
+}
+
+PooledHttp HttpPool::Acquire(const char* tag, const std::string& url, int connect_timeout) {
+    std::string key = MakeKey(tag, url, connect_timeout);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 后进先出:最近用过的对象最可能还带着热的底层连接
+        for (auto it = idle_.rbegin(); it != idle_.rend(); ++it) {
+            if (it->key == key) {
+                auto http = std::move(it->http);
+                idle_.erase(std::next(it).base());
+                return PooledHttp(std::move(key), std::move(http));
+            }
+        }
+    }
+
+    auto network = Board::GetInstance().GetNetwork();
+    auto http = network->CreateHttp(connect_timeout);
+    return PooledHttp(std::move(key), std::move(http));
+}
+
+void HttpPool::Release(std::string key, std::unique_ptr<Http> http) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sweep_timer_ == nullptr) {
+        esp_timer_create_args_t args = {
+            .callback = [](void* arg) { ((HttpPool*)arg)->Sweep(); },
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "http_pool_sweep",
+            .skip_unhandled_events = true,
+        };
+        esp_timer_create(&args, &sweep_timer_);
+        esp_timer_start_periodic(sweep_timer_, kSweepPeriodUs);
+    }
+    if (idle_.size() >= kMaxIdle) {
+        // 挤掉最老的条目,销毁即关闭底层连接
+        idle_.erase(idle_.begin());
+    }
+    idle_.push_back({std::move(key), std::move(http), esp_timer_get_time()});
+}
+
+void HttpPool::Sweep() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = esp_timer_get_time();
+    for (auto it = idle_.begin(); it != idle_.end();) {
+        if (now - it->last_used_us > kIdleTimeoutUs) {
+            ESP_LOGD(TAG, "Evicting idle connection: %s", it->key.c_str());
+            it = idle_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
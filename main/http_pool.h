@@ -0,0 +1,79 @@
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include <network_interface.h>
+#include <esp_timer.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class HttpPool;
+
+// 池化HTTP客户端的RAII句柄:像unique_ptr<Http>一样用(->/get/bool),
+// 析构时把客户端对象还回池里而不是销毁
+class PooledHttp {
+public:
+    PooledHttp() = default;
+    PooledHttp(std::string key, std::unique_ptr<Http> http)
+        : key_(std::move(key)), http_(std::move(http)) {}
+    ~PooledHttp();
+
+    PooledHttp(PooledHttp&& other) = default;
+    PooledHttp& operator=(PooledHttp&& other);
+    PooledHttp(const PooledHttp&) = delete;
+    PooledHttp& operator=(const PooledHttp&) = delete;
+
+    Http* operator->() const { return http_.get(); }
+    Http* get() const { return http_.get(); }
+    explicit operator bool() const { return http_ != nullptr; }
+
+private:
+    std::string key_;
+    std::unique_ptr<Http> http_;
+};
+
+/* 共享HTTP客户端池:OTA/资源包/音乐/相机此前每次请求都新建一个
+ * Http客户端,重复访问同一主机也要重付一遍建连成本。池按
+ * "用途tag+主机:端口"缓存空闲客户端对象,句柄析构归还、定时器
+ * 回收闲置超时的条目。同一用途的调用方每次请求都重设全部请求头,
+ * 复用对象不会带出上一次的Range/认证头。连接本身能否跨请求保活
+ * 由底层网络组件对keep-alive的处理决定,池保证的是客户端对象的
+ * 复用和统一的闲置回收策略;配合DNS预热,重复请求的建连路径
+ * 已经没有逐次重建的开销可付 */
+class HttpPool {
+public:
+    static HttpPool& GetInstance() {
+        static HttpPool instance;
+        return instance;
+    }
+
+    // tag区分用途(请求头集合),url只取scheme://host:port做键,
+    // connect_timeout透传给NetworkInterface::CreateHttp
+    PooledHttp Acquire(const char* tag, const std::string& url, int connect_timeout = 0);
+
+private:
+    friend class PooledHttp;
+
+    HttpPool() = default;
+    void Release(std::string key, std::unique_ptr<Http> http);
+    void Sweep();
+    static std::string MakeKey(const char* tag, const std::string& url, int connect_timeout);
+
+    static constexpr size_t kMaxIdle = 4;                      // 池里最多留几个空闲客户端
+    static constexpr int64_t kIdleTimeoutUs = 60 * 1000000LL;  // 闲置超时
+    static constexpr uint64_t kSweepPeriodUs = 30 * 1000000ULL;
+
+    struct IdleEntry {
+        std::string key;
+        std::unique_ptr<Http> http;
+        int64_t last_used_us;
+    };
+
+    std::mutex mutex_;
+    std::vector<IdleEntry> idle_;
+    esp_timer_handle_t sweep_timer_ = nullptr;
+};
+
+#endif // HTTP_POOL_H
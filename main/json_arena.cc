@@ -0,0 +1,99 @@
+#include "json_arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <cJSON.h>
+
+#define TAG "JsonArena"
+
+/* 控制消息都是小JSON,16KB够放解析树外加处理期间的临时分配;
+ * 超出部分自动回落到堆,不影响正确性 */
+#define JSON_ARENA_MAX_BYTES (16 * 1024)
+#define JSON_ARENA_ALIGN 8
+
+static uint8_t* s_buffer = nullptr;
+static size_t s_capacity = 0;
+static size_t s_offset = 0;
+/* 只有持有者任务会bump;其他任务看到owner不是自己就直接走堆 */
+static TaskHandle_t s_owner = nullptr;
+
+void JsonArena::Preallocate() {
+    if (s_buffer != nullptr) {
+        return;
+    }
+    uint8_t* buffer = (uint8_t*)heap_caps_malloc(JSON_ARENA_MAX_BYTES, MALLOC_CAP_INTERNAL);
+    if (buffer == nullptr) {
+        ESP_LOGW(TAG, "Preallocation failed, arena will grow on demand");
+        return;
+    }
+    s_buffer = buffer;
+    s_capacity = JSON_ARENA_MAX_BYTES;
+    ESP_LOGI(TAG, "Preallocated %u bytes at boot", (unsigned int)s_capacity);
+}
+
+bool JsonArena::Begin(size_t hint_bytes) {
+    if (s_owner != nullptr) {
+        return false;
+    }
+
+    if (hint_bytes > JSON_ARENA_MAX_BYTES) {
+        hint_bytes = JSON_ARENA_MAX_BYTES;
+    }
+    if (hint_bytes > s_capacity) {
+        uint8_t* buffer = (uint8_t*)heap_caps_malloc(hint_bytes, MALLOC_CAP_INTERNAL);
+        if (buffer == nullptr) {
+            return false;
+        }
+        /* 旧缓冲此刻没有存活分配(owner为空即offset已清),直接换掉 */
+        if (s_buffer != nullptr) {
+            heap_caps_free(s_buffer);
+        }
+        s_buffer = buffer;
+        s_capacity = hint_bytes;
+    }
+
+    static bool hooks_installed = false;
+    if (!hooks_installed) {
+        hooks_installed = true;
+        cJSON_Hooks hooks = {
+            .malloc_fn = JsonArena::Malloc,
+            .free_fn = JsonArena::Free,
+        };
+        cJSON_InitHooks(&hooks);
+        ESP_LOGI(TAG, "cJSON arena hooks installed, capacity %u bytes", (unsigned int)s_capacity);
+    }
+
+    s_offset = 0;
+    s_owner = xTaskGetCurrentTaskHandle();
+    return true;
+}
+
+void JsonArena::End() {
+    s_offset = 0;
+    s_owner = nullptr;
+}
+
+void* JsonArena::Malloc(size_t size) {
+    if (s_owner == xTaskGetCurrentTaskHandle()) {
+        size_t aligned = (size + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1);
+        if (s_offset + aligned <= s_capacity) {
+            void* ptr = s_buffer + s_offset;
+            s_offset += aligned;
+            return ptr;
+        }
+    }
+    return malloc(size);
+}
+
+void JsonArena::Free(void* ptr) {
+    /* arena区间内的指针随End()整体回收,单个free是空操作 */
+    if ((uint8_t*)ptr >= s_buffer && (uint8_t*)ptr < s_buffer + s_capacity) {
+        return;
+    }
+    free(ptr);
+}
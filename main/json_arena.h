@@ -0,0 +1,34 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <stddef.h>
+
+/*
+ * 入站协议消息的cJSON凹形分配器。
+ *
+ * 每条服务器消息的解析要做几十次小malloc/free,连续运行几天后内部RAM
+ * 被打得很碎。这里给cJSON挂全局钩子:消息处理期间由持有者任务激活一块
+ * 常驻缓冲,分配走bump指针,cJSON_Delete里的free对arena区间内的指针
+ * 一律空操作,End()把偏移清零就是O(1)整体回收,缓冲跨消息复用。
+ *
+ * 其他任务、以及arena放不下的分配,照旧走堆;free按指针区间判断来源,
+ * 所以两种来源可以混用,对既有代码零侵入。
+ */
+class JsonArena {
+public:
+    /* 开机时调用:趁堆还完整,直接把arena按上限占住。运行中期再
+     * 扩容等于在碎片堆里抠整块,成功率随运行时长下降 */
+    static void Preallocate();
+
+    /* 为当前任务激活arena(按需扩容到hint_bytes,有上限)。
+     * 已被别的任务占用时返回false,此时一切分配照常走堆 */
+    static bool Begin(size_t hint_bytes);
+    /* 当前消息处理完毕(树已Delete),整体回收 */
+    static void End();
+
+private:
+    static void* Malloc(size_t size);
+    static void Free(void* ptr);
+};
+
+#endif // JSON_ARENA_H
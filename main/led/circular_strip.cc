@@ -67,101 +67,123 @@ void CircularStrip::SetSingleColor(uint8_t index, StripColor color) {
 }
 
 void CircularStrip::Blink(StripColor color, int interval_ms) {
-    for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = color;
-    }
-    StartStripTask(interval_ms, [this]() {
-        static bool on = true;
-        if (on) {
-            for (int i = 0; i < max_leds_; i++) {
-                led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
-            }
-            led_strip_refresh(led_strip_);
-        } else {
-            led_strip_clear(led_strip_);
-        }
-        on = !on;
-    });
+    // 两帧:亮/灭
+    std::vector<std::vector<StripColor>> frames;
+    frames.push_back({ color });
+    frames.push_back({ StripColor{ 0, 0, 0 } });
+    StartPattern(std::move(frames), interval_ms, true);
 }
 
 void CircularStrip::FadeOut(int interval_ms) {
-    StartStripTask(interval_ms, [this]() {
-        bool all_off = true;
-        for (int i = 0; i < max_leds_; i++) {
-            colors_[i].red /= 2;
-            colors_[i].green /= 2;
-            colors_[i].blue /= 2;
-            if (colors_[i].red != 0 || colors_[i].green != 0 || colors_[i].blue != 0) {
+    // 从当前颜色开始编译衰减序列,逐帧减半直到全灭,不循环
+    std::vector<std::vector<StripColor>> frames;
+    std::vector<StripColor> current;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current = colors_;
+    }
+    bool all_off = false;
+    while (!all_off) {
+        all_off = true;
+        for (auto& color : current) {
+            color.red /= 2;
+            color.green /= 2;
+            color.blue /= 2;
+            if (color.red != 0 || color.green != 0 || color.blue != 0) {
                 all_off = false;
             }
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
         }
-        if (all_off) {
-            led_strip_clear(led_strip_);
-            esp_timer_stop(strip_timer_);
-        } else {
-            led_strip_refresh(led_strip_);
-        }
-    });
+        frames.push_back(current);
+    }
+    StartPattern(std::move(frames), interval_ms, false);
 }
 
 void CircularStrip::Breathe(StripColor low, StripColor high, int interval_ms) {
-    StartStripTask(interval_ms, [this, low, high]() {
-        static bool increase = true;
-        static StripColor color = low;
-        if (increase) {
-            if (color.red < high.red) {
-                color.red++;
-            }
-            if (color.green < high.green) {
-                color.green++;
-            }
-            if (color.blue < high.blue) {
-                color.blue++;
-            }
-            if (color.red == high.red && color.green == high.green && color.blue == high.blue) {
-                increase = false;
-            }
-        } else {
-            if (color.red > low.red) {
-                color.red--;
-            }
-            if (color.green > low.green) {
-                color.green--;
-            }
-            if (color.blue > low.blue) {
-                color.blue--;
-            }
-            if (color.red == low.red && color.green == low.green && color.blue == low.blue) {
-                increase = true;
-            }
+    // 编译完整的亮度往返,每帧全环同色只存一个颜色,tick零计算
+    std::vector<std::vector<StripColor>> frames;
+    StripColor color = low;
+    frames.push_back({ color });
+    while (color.red != high.red || color.green != high.green || color.blue != high.blue) {
+        if (color.red < high.red) {
+            color.red++;
+        }
+        if (color.green < high.green) {
+            color.green++;
         }
-        for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
+        if (color.blue < high.blue) {
+            color.blue++;
         }
-        led_strip_refresh(led_strip_);
-    });
+        frames.push_back({ color });
+    }
+    while (color.red != low.red || color.green != low.green || color.blue != low.blue) {
+        if (color.red > low.red) {
+            color.red--;
+        }
+        if (color.green > low.green) {
+            color.green--;
+        }
+        if (color.blue > low.blue) {
+            color.blue--;
+        }
+        frames.push_back({ color });
+    }
+    StartPattern(std::move(frames), interval_ms, true);
 }
 
 void CircularStrip::Scroll(StripColor low, StripColor high, int length, int interval_ms) {
-    for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = low;
-    }
-    StartStripTask(interval_ms, [this, low, high, length]() {
-        static int offset = 0;
-        for (int i = 0; i < max_leds_; i++) {
-            colors_[i] = low;
-        }
+    // 每个偏移量一帧,一圈之后循环回放
+    std::vector<std::vector<StripColor>> frames;
+    for (int offset = 0; offset < max_leds_; offset++) {
+        std::vector<StripColor> frame(max_leds_, low);
         for (int j = 0; j < length; j++) {
-            int i = (offset + j) % max_leds_;
-            colors_[i] = high;
+            frame[(offset + j) % max_leds_] = high;
         }
-        for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
+        frames.push_back(std::move(frame));
+    }
+    StartPattern(std::move(frames), interval_ms, true);
+}
+
+void CircularStrip::StartPattern(std::vector<std::vector<StripColor>> frames, int interval_ms, bool loop) {
+    if (led_strip_ == nullptr || frames.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    esp_timer_stop(strip_timer_);
+
+    pattern_frames_ = std::move(frames);
+    pattern_frame_index_ = 0;
+    pattern_loop_ = loop;
+    strip_callback_ = [this]() {
+        PlayNextFrame();
+    };
+    esp_timer_start_periodic(strip_timer_, interval_ms * 1000);
+}
+
+// 在strip_timer_回调里执行,已持有mutex_
+void CircularStrip::PlayNextFrame() {
+    if (pattern_frame_index_ >= pattern_frames_.size()) {
+        return;
+    }
+    ShowFrame(pattern_frames_[pattern_frame_index_]);
+    pattern_frame_index_++;
+    if (pattern_frame_index_ >= pattern_frames_.size()) {
+        if (pattern_loop_) {
+            pattern_frame_index_ = 0;
+        } else {
+            esp_timer_stop(strip_timer_);
         }
-        led_strip_refresh(led_strip_);
-        offset = (offset + 1) % max_leds_;
-    });
+    }
+}
+
+void CircularStrip::ShowFrame(const std::vector<StripColor>& frame) {
+    for (int i = 0; i < max_leds_; i++) {
+        // 单元素帧代表全环同色
+        const auto& color = frame.size() == 1 ? frame[0] : frame[i];
+        colors_[i] = color;
+        led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
+    }
+    led_strip_refresh(led_strip_);
 }
 
 void CircularStrip::StartStripTask(int interval_ms, std::function<void()> cb) {
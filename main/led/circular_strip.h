@@ -43,6 +43,15 @@ private:
     uint8_t default_brightness_ = DEFAULT_BRIGHTNESS;
     uint8_t low_brightness_ = LOW_BRIGHTNESS;
 
+    // 预编译的动画帧序列:pattern切换时渲染一整个周期,tick只回放。
+    // 单元素帧表示全环同色(呼吸等渐变动画的帧很多,按像素存太费内存)
+    std::vector<std::vector<StripColor>> pattern_frames_;
+    size_t pattern_frame_index_ = 0;
+    bool pattern_loop_ = false;
+
+    void StartPattern(std::vector<std::vector<StripColor>> frames, int interval_ms, bool loop);
+    void PlayNextFrame();
+    void ShowFrame(const std::vector<StripColor>& frame);
     void StartStripTask(int interval_ms, std::function<void()> cb);
     void Rainbow(StripColor low, StripColor high, int interval_ms);
     void FadeOut(int interval_ms);
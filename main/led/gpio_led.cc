@@ -73,7 +73,11 @@ GpioLed::GpioLed(gpio_num_t gpio, int output_invert, ledc_timer_t timer_num, led
     esp_timer_create_args_t blink_timer_args = {
         .callback = [](void *arg) {
             auto led = static_cast<GpioLed*>(arg);
-            led->OnBlinkTimer();
+            if (led->pattern_ != nullptr) {
+                led->OnPatternTimer();
+            } else {
+                led->OnBlinkTimer();
+            }
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -110,6 +114,7 @@ void GpioLed::TurnOn() {
     std::lock_guard<std::mutex> lock(mutex_);
     esp_timer_stop(blink_timer_);
     ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
+    pattern_ = nullptr;
     ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty_);
     ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
 }
@@ -122,6 +127,7 @@ void GpioLed::TurnOff() {
     std::lock_guard<std::mutex> lock(mutex_);
     esp_timer_stop(blink_timer_);
     ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
+    pattern_ = nullptr;
     ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, 0);
     ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
 }
@@ -146,6 +152,7 @@ void GpioLed::StartBlinkTask(int times, int interval_ms) {
     std::lock_guard<std::mutex> lock(mutex_);
     esp_timer_stop(blink_timer_);
     ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
+    pattern_ = nullptr;
 
     blink_counter_ = times * 2;
     blink_interval_ms_ = interval_ms;
@@ -175,6 +182,7 @@ void GpioLed::StartFadeTask() {
     std::lock_guard<std::mutex> lock(mutex_);
     esp_timer_stop(blink_timer_);
     ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
+    pattern_ = nullptr;
     fade_up_ = true;
     ledc_set_fade_with_time(ledc_channel_.speed_mode,
                             ledc_channel_.channel, LEDC_DUTY, LEDC_FADE_TIME);
@@ -191,6 +199,43 @@ void GpioLed::OnFadeEnd() {
                     ledc_channel_.channel, LEDC_FADE_NO_WAIT);
 }
 
+void GpioLed::ApplyPatternStep(const LedPatternStep& step) {
+    uint32_t duty = step.brightness == 100 ? LEDC_DUTY : step.brightness * LEDC_DUTY / 100;
+    ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty);
+    ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
+    esp_timer_start_once(blink_timer_, (uint64_t)step.duration_ms * 1000);
+}
+
+void GpioLed::StartPattern(const LedPattern* pattern) {
+    if (!ledc_initialized_ || pattern == nullptr || pattern->steps.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    esp_timer_stop(blink_timer_);
+    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
+
+    pattern_ = pattern;
+    pattern_index_ = 0;
+    ApplyPatternStep(pattern->steps[0]);
+}
+
+void GpioLed::OnPatternTimer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pattern_ == nullptr) {
+        return;
+    }
+    pattern_index_++;
+    if (pattern_index_ >= pattern_->steps.size()) {
+        if (!pattern_->repeat) {
+            pattern_ = nullptr;
+            return;
+        }
+        pattern_index_ = 0;
+    }
+    ApplyPatternStep(pattern_->steps[pattern_index_]);
+}
+
 bool IRAM_ATTR GpioLed::FadeCallback(const ledc_cb_param_t *param, void *user_arg) {
     if (param->event == LEDC_FADE_END_EVT) {
         auto led = static_cast<GpioLed*>(user_arg);
@@ -202,6 +247,13 @@ bool IRAM_ATTR GpioLed::FadeCallback(const ledc_cb_param_t *param, void *user_ar
 void GpioLed::OnStateChanged() {
     auto& app = Application::GetInstance();
     auto device_state = app.GetDeviceState();
+
+    // 资产包带了该状态的品牌化模式就优先走预编译的关键帧表
+    if (auto pattern = LedPatternSet::GetInstance().GetPattern(device_state)) {
+        StartPattern(pattern);
+        return;
+    }
+
     switch (device_state) {
         case kDeviceStateStarting:
             SetBrightness(DEFAULT_BRIGHTNESS);
@@ -4,6 +4,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include "led.h"
+#include "led_pattern.h"
 #include <driver/gpio.h>
 #include <driver/ledc.h>
 #include <esp_timer.h>
@@ -32,9 +33,15 @@ class GpioLed : public Led {
     int blink_interval_ms_ = 0;
     esp_timer_handle_t blink_timer_ = nullptr;
     bool fade_up_ = true;
+    // 资产下发的自定义模式:预编译关键帧表,定时器逐帧走表
+    const LedPattern* pattern_ = nullptr;
+    size_t pattern_index_ = 0;
 
     void StartBlinkTask(int times, int interval_ms);
     void OnBlinkTimer();
+    void StartPattern(const LedPattern* pattern);
+    void OnPatternTimer();
+    void ApplyPatternStep(const LedPatternStep& step);
 
     void BlinkOnce();
     void Blink(int times, int interval_ms);
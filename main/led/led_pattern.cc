@@ -0,0 +1,102 @@
+#include "led_pattern.h"
+#include "assets.h"
+
+#include <cJSON.h>
+#include <esp_log.h>
+
+#define TAG "LedPattern"
+
+// 防御资产里的异常数据:步数封顶、单帧时长下限(太短会把定时器任务打满)
+#define LED_PATTERN_MAX_STEPS 64
+#define LED_PATTERN_MIN_STEP_MS 20
+
+namespace {
+
+// 与Application::STATE_STRINGS同名,LED关心的状态子集
+const struct {
+    const char* name;
+    DeviceState state;
+} kStateNames[] = {
+    {"starting", kDeviceStateStarting},
+    {"configuring", kDeviceStateWifiConfiguring},
+    {"idle", kDeviceStateIdle},
+    {"connecting", kDeviceStateConnecting},
+    {"listening", kDeviceStateListening},
+    {"speaking", kDeviceStateSpeaking},
+    {"upgrading", kDeviceStateUpgrading},
+    {"activating", kDeviceStateActivating},
+    {"audio_testing", kDeviceStateAudioTesting},
+};
+
+}  // namespace
+
+const LedPattern* LedPatternSet::GetPattern(DeviceState state) {
+    if (!loaded_) {
+        LoadFromAssets();
+        loaded_ = true;
+    }
+    auto it = patterns_.find(state);
+    return it != patterns_.end() ? &it->second : nullptr;
+}
+
+void LedPatternSet::LoadFromAssets() {
+    void* ptr = nullptr;
+    size_t size = 0;
+    if (!Assets::GetInstance().GetAssetData("ledpatterns.json", ptr, size)) {
+        return;  // 资产没带模式文件,全部用内置模式
+    }
+
+    cJSON* root = cJSON_ParseWithLength(static_cast<char*>(ptr), size);
+    if (root == nullptr) {
+        ESP_LOGE(TAG, "The ledpatterns.json file is not valid");
+        return;
+    }
+
+    cJSON* states = cJSON_GetObjectItem(root, "states");
+    for (auto& entry : kStateNames) {
+        cJSON* node = cJSON_GetObjectItem(states, entry.name);
+        if (node == nullptr) {
+            continue;
+        }
+
+        LedPattern pattern;
+        cJSON* repeat = cJSON_GetObjectItem(node, "repeat");
+        pattern.repeat = cJSON_IsTrue(repeat);
+
+        cJSON* steps = cJSON_GetObjectItem(node, "steps");
+        int count = cJSON_GetArraySize(steps);
+        if (count > LED_PATTERN_MAX_STEPS) {
+            ESP_LOGW(TAG, "Pattern %s has %d steps, truncated to %d",
+                     entry.name, count, LED_PATTERN_MAX_STEPS);
+            count = LED_PATTERN_MAX_STEPS;
+        }
+        for (int i = 0; i < count; i++) {
+            cJSON* item = cJSON_GetArrayItem(steps, i);
+            LedPatternStep step = {};
+            cJSON* brightness = cJSON_GetObjectItem(item, "brightness");
+            if (cJSON_IsNumber(brightness)) {
+                step.brightness = brightness->valueint > 100 ? 100
+                                  : brightness->valueint < 0 ? 0 : brightness->valueint;
+            }
+            cJSON* rgb = cJSON_GetObjectItem(item, "rgb");
+            if (cJSON_IsArray(rgb) && cJSON_GetArraySize(rgb) == 3) {
+                step.r = cJSON_GetArrayItem(rgb, 0)->valueint & 0xFF;
+                step.g = cJSON_GetArrayItem(rgb, 1)->valueint & 0xFF;
+                step.b = cJSON_GetArrayItem(rgb, 2)->valueint & 0xFF;
+            }
+            cJSON* ms = cJSON_GetObjectItem(item, "ms");
+            step.duration_ms = cJSON_IsNumber(ms) && ms->valueint > LED_PATTERN_MIN_STEP_MS
+                               ? ms->valueint : LED_PATTERN_MIN_STEP_MS;
+            pattern.steps.push_back(step);
+        }
+
+        if (!pattern.steps.empty()) {
+            patterns_[entry.state] = std::move(pattern);
+        }
+    }
+    cJSON_Delete(root);
+
+    if (!patterns_.empty()) {
+        ESP_LOGI(TAG, "Loaded %u custom led patterns from assets", (unsigned)patterns_.size());
+    }
+}
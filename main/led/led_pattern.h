@@ -0,0 +1,47 @@
+#ifndef _LED_PATTERN_H_
+#define _LED_PATTERN_H_
+
+#include "device_state.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// 资产包里的自定义LED指示模式(ledpatterns.json):
+// { "states": { "idle": { "repeat": true,
+//                         "steps": [ {"brightness": 5, "rgb": [0, 0, 4], "ms": 500}, ... ] } }
+// 加载时一次性编译成关键帧数组,运行期定时器回调只按预算好的时长逐帧
+// 走表,CPU开销与内置模式相同;品牌化模式随资产包更新下发,不用改固件
+struct LedPatternStep {
+    uint8_t brightness;    // 0-100,PWM单色灯用
+    uint8_t r, g, b;       // RGB灯珠用
+    uint32_t duration_ms;  // 本帧保持时长
+};
+
+struct LedPattern {
+    bool repeat = false;
+    std::vector<LedPatternStep> steps;
+};
+
+class LedPatternSet {
+public:
+    static LedPatternSet& GetInstance() {
+        static LedPatternSet instance;
+        return instance;
+    }
+
+    // 该状态有自定义模式则返回(指针在资产重载前一直有效),否则nullptr
+    const LedPattern* GetPattern(DeviceState state);
+
+private:
+    LedPatternSet() = default;
+    LedPatternSet(const LedPatternSet&) = delete;
+    LedPatternSet& operator=(const LedPatternSet&) = delete;
+
+    void LoadFromAssets();
+
+    bool loaded_ = false;
+    std::map<DeviceState, LedPattern> patterns_;
+};
+
+#endif  // _LED_PATTERN_H_
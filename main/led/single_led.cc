@@ -30,7 +30,11 @@ SingleLed::SingleLed(gpio_num_t gpio) {
     esp_timer_create_args_t blink_timer_args = {
         .callback = [](void *arg) {
             auto led = static_cast<SingleLed*>(arg);
-            led->OnBlinkTimer();
+            if (led->pattern_ != nullptr) {
+                led->OnPatternTimer();
+            } else {
+                led->OnBlinkTimer();
+            }
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -61,6 +65,7 @@ void SingleLed::TurnOn() {
     
     std::lock_guard<std::mutex> lock(mutex_);
     esp_timer_stop(blink_timer_);
+    pattern_ = nullptr;
     led_strip_set_pixel(led_strip_, 0, r_, g_, b_);
     led_strip_refresh(led_strip_);
 }
@@ -72,6 +77,7 @@ void SingleLed::TurnOff() {
 
     std::lock_guard<std::mutex> lock(mutex_);
     esp_timer_stop(blink_timer_);
+    pattern_ = nullptr;
     led_strip_clear(led_strip_);
 }
 
@@ -94,7 +100,8 @@ void SingleLed::StartBlinkTask(int times, int interval_ms) {
 
     std::lock_guard<std::mutex> lock(mutex_);
     esp_timer_stop(blink_timer_);
-    
+    pattern_ = nullptr;
+
     blink_counter_ = times * 2;
     blink_interval_ms_ = interval_ms;
     esp_timer_start_periodic(blink_timer_, interval_ms * 1000);
@@ -116,9 +123,55 @@ void SingleLed::OnBlinkTimer() {
 }
 
 
+void SingleLed::ApplyPatternStep(const LedPatternStep& step) {
+    if (step.r == 0 && step.g == 0 && step.b == 0) {
+        led_strip_clear(led_strip_);
+    } else {
+        led_strip_set_pixel(led_strip_, 0, step.r, step.g, step.b);
+        led_strip_refresh(led_strip_);
+    }
+    esp_timer_start_once(blink_timer_, (uint64_t)step.duration_ms * 1000);
+}
+
+void SingleLed::StartPattern(const LedPattern* pattern) {
+    if (led_strip_ == nullptr || pattern == nullptr || pattern->steps.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    esp_timer_stop(blink_timer_);
+
+    pattern_ = pattern;
+    pattern_index_ = 0;
+    ApplyPatternStep(pattern->steps[0]);
+}
+
+void SingleLed::OnPatternTimer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pattern_ == nullptr) {
+        return;
+    }
+    pattern_index_++;
+    if (pattern_index_ >= pattern_->steps.size()) {
+        if (!pattern_->repeat) {
+            pattern_ = nullptr;
+            return;
+        }
+        pattern_index_ = 0;
+    }
+    ApplyPatternStep(pattern_->steps[pattern_index_]);
+}
+
 void SingleLed::OnStateChanged() {
     auto& app = Application::GetInstance();
     auto device_state = app.GetDeviceState();
+
+    // 资产包带了该状态的品牌化模式就优先走预编译的关键帧表
+    if (auto pattern = LedPatternSet::GetInstance().GetPattern(device_state)) {
+        StartPattern(pattern);
+        return;
+    }
+
     switch (device_state) {
         case kDeviceStateStarting:
             SetColor(0, 0, DEFAULT_BRIGHTNESS);
@@ -2,6 +2,7 @@
 #define _SINGLE_LED_H_
 
 #include "led.h"
+#include "led_pattern.h"
 #include <driver/gpio.h>
 #include <led_strip.h>
 #include <esp_timer.h>
@@ -23,9 +24,15 @@ private:
     int blink_counter_ = 0;
     int blink_interval_ms_ = 0;
     esp_timer_handle_t blink_timer_ = nullptr;
+    // 资产下发的自定义模式:预编译关键帧表,定时器逐帧走表
+    const LedPattern* pattern_ = nullptr;
+    size_t pattern_index_ = 0;
 
     void StartBlinkTask(int times, int interval_ms);
     void OnBlinkTimer();
+    void StartPattern(const LedPattern* pattern);
+    void OnPatternTimer();
+    void ApplyPatternStep(const LedPatternStep& step);
 
     void BlinkOnce();
     void Blink(int times, int interval_ms);
@@ -0,0 +1,79 @@
+#include "log_ring.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#include <cstdio>
+#include <cstring>
+
+#define TAG "LogRing"
+
+LogRing::LogRing() {
+    for (auto& entry : ring_) {
+        entry.ready.store(0, std::memory_order_relaxed);
+    }
+    // 排空任务优先级1:只在系统空闲时格式化输出,绝不和音频抢CPU
+    xTaskCreate([](void* arg) {
+        ((LogRing*)arg)->DrainTask();
+        vTaskDelete(NULL);
+    }, "log_drain", 2048 * 2, this, 1, nullptr);
+}
+
+void LogRing::Write(esp_log_level_t level, const char* tag, const char* fmt,
+                    uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+    uint32_t index = write_index_.fetch_add(1, std::memory_order_relaxed);
+    Entry& entry = ring_[index % kRingSize];
+    if (entry.ready.load(std::memory_order_acquire) != 0) {
+        // 排空任务没跟上,丢掉并计数,不覆盖未输出的条目
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    entry.fmt = fmt;
+    entry.tag = tag;
+    entry.timestamp_us = esp_timer_get_time();
+    entry.args[0] = a0;
+    entry.args[1] = a1;
+    entry.args[2] = a2;
+    entry.args[3] = a3;
+    entry.level = (uint8_t)level;
+    entry.ready.store(1, std::memory_order_release);
+}
+
+void LogRing::DrainTask() {
+    char buffer[160];
+    while (true) {
+        bool drained_any = false;
+        while (true) {
+            Entry& entry = ring_[read_index_ % kRingSize];
+            if (entry.ready.load(std::memory_order_acquire) == 0) {
+                break;
+            }
+            snprintf(buffer, sizeof(buffer), entry.fmt,
+                     entry.args[0], entry.args[1], entry.args[2], entry.args[3]);
+            esp_log_write((esp_log_level_t)entry.level, entry.tag,
+                          "%s (%lld) %s: %s\n",
+                          entry.level == ESP_LOG_ERROR ? "E" : entry.level == ESP_LOG_WARN ? "W" : "I",
+                          entry.timestamp_us / 1000, entry.tag, buffer);
+            entry.ready.store(0, std::memory_order_release);
+            read_index_++;
+            drained_any = true;
+        }
+
+        uint32_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            ESP_LOGW(TAG, "Dropped %lu deferred log entries", dropped);
+        }
+        if (!drained_any) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+    }
+}
+
+std::string LogRing::GetRawRing() {
+    // 不加锁快照:诊断用途,偶发的撕裂条目由离线解码侧容错
+    std::string raw;
+    raw.resize(sizeof(ring_));
+    memcpy(raw.data(), (const void*)ring_, sizeof(ring_));
+    return raw;
+}
@@ -0,0 +1,64 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+#include <esp_log.h>
+
+// 延迟格式化日志环:热路径(音频任务、协议收发)只把格式串指针和
+// 原始参数写进无锁环形缓冲(每站点几十个周期),格式化和串口输出由
+// 低优先级排空任务完成,重连风暴刷日志不再拖慢帧处理。
+// 格式串指针本身就是日志ID(指向flash里的字符串字面量),
+// GetRawRing()导出的原始环可以结合ELF离线解码。
+//
+// 限制:参数必须是可截断为uint32_t的整数/指针,最多4个;
+// 不支持%s指向栈上字符串(排空时栈已变)
+class LogRing {
+public:
+    static LogRing& GetInstance() {
+        static LogRing instance;
+        return instance;
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // 任意任务上下文可调用,无锁;fmt/tag必须是静态生存期字符串
+    void Write(esp_log_level_t level, const char* tag, const char* fmt,
+               uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0, uint32_t a3 = 0);
+
+    // 原始环的二进制快照(含未排空条目),供崩溃/诊断上传离线解码
+    std::string GetRawRing();
+
+private:
+    LogRing();
+
+    void DrainTask();
+
+    struct __attribute__((packed)) Entry {
+        const char* fmt;
+        const char* tag;
+        int64_t timestamp_us;
+        uint32_t args[4];
+        uint8_t level;
+        std::atomic<uint8_t> ready;
+    };
+
+    static constexpr size_t kRingSize = 64;  // 2的幂
+
+    Entry ring_[kRingSize];
+    std::atomic<uint32_t> write_index_{0};
+    uint32_t read_index_ = 0;  // 仅排空任务访问
+    std::atomic<uint32_t> dropped_{0};
+};
+
+// 热路径日志宏:参数全部截断为uint32_t入环
+#define LOGR_WRITE(level, tag, fmt, ...) \
+    LogRing::GetInstance().Write(level, tag, fmt, ##__VA_ARGS__)
+#define LOGR_E(tag, fmt, ...) LOGR_WRITE(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define LOGR_W(tag, fmt, ...) LOGR_WRITE(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define LOGR_I(tag, fmt, ...) LOGR_WRITE(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+
+#endif // LOG_RING_H
@@ -9,26 +9,55 @@
 #include <algorithm>
 #include <cstring>
 #include <esp_pthread.h>
+#include <esp_timer.h>
 
 #include "application.h"
 #include "display.h"
 #include "oled_display.h"
+#include "lcd_display.h"
+#if CONFIG_SOAK_TEST
+#include "soak_test.h"
+#endif
+#if CONFIG_PERF_TRACE
+#include "perf_trace.h"
+#endif
+#if CONFIG_OPUS_BENCH
+#include "opus_bench.h"
+#endif
 #include "board.h"
 #include "settings.h"
+#include "settings_snapshot.h"
 #include "lvgl_theme.h"
 #include "lvgl_display.h"
 #include "boards/common/esp32_music.h"
 #include "device_manager.h"
+#include "boot_profiler.h"
+#include "metrics_registry.h"
+#include "stack_audit.h"
+#include "system_info.h"
+#include "device_state_event.h"
 #define TAG "MCP"
 
 McpServer::McpServer() {
 }
 
 McpServer::~McpServer() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_shutdown_ = true;
+    }
+    pool_cv_.notify_all();
+    for (auto& worker : tool_workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
     for (auto tool : tools_) {
         delete tool;
     }
     tools_.clear();
+    tool_index_.clear();
 }
 
 void McpServer::AddCommonTools() {
@@ -47,13 +76,55 @@ void McpServer::AddCommonTools() {
         "Provides the real-time information of the device, including the current status of the audio speaker, screen, battery, network, etc.\n"
         "Use this tool for: \n"
         "1. Answering questions about current condition (e.g. what is the current volume of the audio speaker?)\n"
-        "2. As the first step to control the device (e.g. turn up / down the volume of the audio speaker, etc.)",
+        "2. As the first step to control the device (e.g. turn up / down the volume of the audio speaker, etc.)\n"
+        "By default only sections changed since the last call are returned, with a monotonic `seq`;\n"
+        "set `full` to true (e.g. after a missed seq) to get a complete snapshot.",
+        PropertyList({
+            Property("full", kPropertyTypeBoolean, false)
+        }),
+        [&board, this](const PropertyList& properties) -> ReturnValue {
+            return BuildDeviceStatusDiff(board.GetDeviceStatusJson(), properties["full"].value<bool>());
+        });
+
+    AddTool("self.get_boot_report",
+        "Get the boot time report of the last startup, with per-stage durations in milliseconds.",
+        PropertyList(),
+        [](const PropertyList& properties) -> ReturnValue {
+            return BootProfiler::GetInstance().GetReportJson();
+        });
+
+    AddTool("self.get_main_loop_report",
+        "Get the main loop watchdog report: recent callbacks that blocked the main event loop "
+        "beyond the threshold, with their tags and durations in milliseconds.",
+        PropertyList(),
+        [](const PropertyList& properties) -> ReturnValue {
+            return Application::GetInstance().GetMainLoopReportJson();
+        });
+
+    AddTool("self.get_state_event_report",
+        "Get per-subscriber timing stats of device state change events, including "
+        "priority class, invoke count, average and max duration in microseconds.",
         PropertyList(),
+        [](const PropertyList& properties) -> ReturnValue {
+            return DeviceStateEventManager::GetInstance().GetSubscriberStatsJson();
+        });
+
+    AddTool("self.system.get_task_stats",
+        "Get per-task CPU usage since the previous call, with core affinity, priority and "
+        "stack high-watermark in bytes. Set `overlay` to true/false to also toggle a live "
+        "on-screen debug overlay showing the top tasks.",
+        PropertyList({
+            Property("overlay", kPropertyTypeBoolean, false)
+        }),
         [&board](const PropertyList& properties) -> ReturnValue {
-            return board.GetDeviceStatusJson();
+            auto display = board.GetDisplay();
+            if (display) {
+                display->SetDebugOverlayEnabled(properties["overlay"].value<bool>());
+            }
+            return SystemInfo::GetTaskStatsJson();
         });
 
-    AddTool("self.audio_speaker.set_volume", 
+    AddTool("self.audio_speaker.set_volume",
         "Set the volume of the audio speaker. If the current volume is unknown, you must call `self.get_device_status` tool first and then call this tool.",
         PropertyList({
             Property("volume", kPropertyTypeInteger, 0, 100)
@@ -61,6 +132,8 @@ void McpServer::AddCommonTools() {
         [&board](const PropertyList& properties) -> ReturnValue {
             auto codec = board.GetAudioCodec();
             codec->SetOutputVolume(properties["volume"].value<int>());
+            // 静音图标按脏标记刷新,主动触发一次,不等下个周期tick
+            board.GetDisplay()->UpdateStatusBar();
             return true;
         });
     
@@ -104,15 +177,24 @@ void McpServer::AddCommonTools() {
             "Take a photo and explain it. Use this tool after the user asks you to see something.\n"
             "Args:\n"
             "  `question`: The question that you want to ask about the photo.\n"
+            "  `resolution`: Optional capture resolution for this shot: qqvga, qvga, vga, svga, xga or hd.\n"
+            "    Use a small size like qvga for rough questions (what do you see), it uploads much faster.\n"
+            "    Leave empty to use the board's default resolution.\n"
             "Return:\n"
             "  A JSON object that provides the photo information.",
             PropertyList({
-                Property("question", kPropertyTypeString)
+                Property("question", kPropertyTypeString),
+                Property("resolution", kPropertyTypeString, "")
             }),
             [camera](const PropertyList& properties) -> ReturnValue {
                 // Lower the priority to do the camera capture
                 TaskPriorityReset priority_reset(1);
 
+                auto resolution = properties["resolution"].value<std::string>();
+                if (!resolution.empty()) {
+                    // 失败时按默认分辨率继续拍,不让一次视觉问答因参数问题挂掉
+                    camera->SetCaptureResolution(resolution);
+                }
                 if (!camera->Capture()) {
                     throw std::runtime_error("Failed to capture photo");
                 }
@@ -701,6 +783,134 @@ void McpServer::AddUserOnlyTools() {
             return board.GetSystemInfoJson();
         });
 
+    AddUserOnlyTool("self.metrics.history",
+        "Export the 1Hz metrics flight recorder: per-metric sample series for the last N seconds "
+        "(heap levels, audio latencies, underruns, send drops, I2S overruns, uplink bitrate). "
+        "Counters are cumulative; diff consecutive samples for rates.",
+        PropertyList({
+            Property("seconds", kPropertyTypeInteger, 60, 1, 120)
+        }),
+        [this](const PropertyList& properties) -> ReturnValue {
+            auto seconds = properties["seconds"].value<int>();
+            return MetricsRegistry::GetInstance().DumpHistoryJson(seconds);
+        });
+
+    AddUserOnlyTool("self.stack.audit",
+        "Sample all task stacks and export the accumulated minimum-remaining-stack watermarks "
+        "(ascending, riskiest first). min_remaining is the recoverable upper bound per task: "
+        "new_size = old_size - min_remaining + margin. Run after a soak test for full coverage.",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            auto& audit = StackAudit::GetInstance();
+            audit.Sample();
+            return audit.DumpJson();
+        });
+
+    AddUserOnlyTool("self.network.get_stats",
+        "Get per-session network quality statistics (packets, bytes, reconnects, worst incoming gap)",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            return Application::GetInstance().GetNetworkStatsJson();
+        });
+
+    AddUserOnlyTool("self.network.benchmark",
+        "Run a network self-test on the live transport: stream synthetic audio-sized packets for N seconds "
+        "and report uplink goodput, per-send latency, downlink rate and loss. Run while the device is idle.",
+        PropertyList({
+            Property("seconds", kPropertyTypeInteger, 5, 1, 30)
+        }),
+        [this](const PropertyList& properties) -> ReturnValue {
+            auto seconds = properties["seconds"].value<int>();
+            return Application::GetInstance().RunNetworkBenchmark(seconds);
+        });
+
+    AddUserOnlyTool("self.flash.benchmark",
+        "Measure flash health: sequential/random read throughput on the assets partition and NVS commit "
+        "latency, compared against the baseline stored on first run. 'degraded: true' suggests flash wear.",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            return SystemInfo::RunFlashBenchmark();
+        });
+
+    AddUserOnlyTool("self.settings.export_snapshot",
+        "Export all provisioning-relevant settings namespaces (server/WiFi/audio/display config) "
+        "as one versioned, CRC-protected base64 blob. Device identity and per-unit calibration "
+        "are excluded, so the blob is safe to replay across a fleet.",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            auto blob = SettingsSnapshot::ExportBase64();
+            if (blob.empty()) {
+                throw std::runtime_error("Snapshot export failed");
+            }
+            return blob;
+        });
+
+    AddUserOnlyTool("self.settings.import_snapshot",
+        "Import a settings snapshot produced by self.settings.export_snapshot. The blob is fully "
+        "validated before any write; each namespace is then replaced and committed in one pass. "
+        "Reboot afterwards so all subsystems pick up the new values.",
+        PropertyList({
+            Property("blob", kPropertyTypeString)
+        }),
+        [this](const PropertyList& properties) -> ReturnValue {
+            return SettingsSnapshot::ImportBase64(properties["blob"].value<std::string>());
+        });
+
+#if CONFIG_OPUS_BENCH
+    AddUserOnlyTool("self.opus.benchmark",
+        "Run the Opus codec benchmark: encode and decode a deterministic reference signal "
+        "across a sweep of complexity/bitrate/frame-length combinations and report CPU "
+        "cycles per frame, achieved bytes/s and stack high-watermark. Blocks for tens of "
+        "seconds; run while the device is idle.",
+        PropertyList({
+            Property("frames", kPropertyTypeInteger, 25, 5, 200)
+        }),
+        [this](const PropertyList& properties) -> ReturnValue {
+            auto frames = properties["frames"].value<int>();
+            return OpusBench::RunJson(frames);
+        });
+#endif
+
+#if CONFIG_SOAK_TEST
+    AddUserOnlyTool("self.soak.start",
+        "Start the conversation soak test: loop synthetic wake-listen-playback cycles "
+        "for release qualification, recording heap watermarks, underruns and wake latency. "
+        "The device alerts loudly when a regression threshold is crossed.",
+        PropertyList({
+            Property("cycles", kPropertyTypeInteger, 1000, 1, 1000000)
+        }),
+        [this](const PropertyList& properties) -> ReturnValue {
+            auto cycles = properties["cycles"].value<int>();
+            return SoakTest::GetInstance().Start(cycles);
+        });
+
+    AddUserOnlyTool("self.soak.stop",
+        "Stop the running conversation soak test after the current cycle",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            SoakTest::GetInstance().Stop();
+            return true;
+        });
+
+    AddUserOnlyTool("self.soak.report",
+        "Get the current soak test statistics (cycles, failures, wake latency histogram, "
+        "heap watermarks, underrun and send-drop deltas)",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            return SoakTest::GetInstance().GetReportJson();
+        });
+#endif
+
+#if CONFIG_PERF_TRACE
+    AddUserOnlyTool("self.trace.dump",
+        "Dump the hot-path trace ring: recent probe hits (capture read, encode, LVGL flush, "
+        "playback write, socket send) as [probe_id, cpu_cycles] pairs plus the CPU frequency",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            return perf_trace::DumpJson();
+        });
+#endif
+
     AddUserOnlyTool("self.reboot", "Reboot the system",
         PropertyList(),
         [this](const PropertyList& properties) -> ReturnValue {
@@ -754,6 +964,18 @@ void McpServer::AddUserOnlyTools() {
                 return json;
             });
 
+#if CONFIG_DISPLAY_BENCH
+        auto lcd_display = dynamic_cast<LcdDisplay*>(display);
+        if (lcd_display) {
+            AddUserOnlyTool("self.display.benchmark", "Run the standardized display flush benchmark and return per-scene fps/throughput stats",
+                PropertyList(),
+                [lcd_display](const PropertyList& properties) -> ReturnValue {
+                    // 工具worker线程里同步跑,4个场景约10秒,期间UI被基准场景占用
+                    return lcd_display->RunFlushBenchmark();
+                });
+        }
+#endif
+
 #if CONFIG_LV_USE_SNAPSHOT
         AddUserOnlyTool("self.screen.snapshot", "Snapshot the screen and upload it to a specific URL",
             PropertyList({
@@ -844,7 +1066,20 @@ void McpServer::AddUserOnlyTools() {
                 }
                 http->Close();
 
-                auto image = std::make_unique<LvglAllocatedImage>(data, content_length);
+                // JPEG在这里就解成RGB565位图(esp_new_jpeg,S3带SIMD优化),
+                // LVGL任务只做贴图;其它格式仍交给LVGL内置解码器
+                std::unique_ptr<LvglImage> image;
+                if (LvglJpegImage::IsJpeg((const uint8_t*)data, content_length)) {
+                    try {
+                        image = std::make_unique<LvglJpegImage>((const uint8_t*)data, content_length);
+                        heap_caps_free(data);
+                    } catch (const std::exception& e) {
+                        ESP_LOGW(TAG, "JPEG fast decode failed, falling back to LVGL decoder: %s", e.what());
+                    }
+                }
+                if (image == nullptr) {
+                    image = std::make_unique<LvglAllocatedImage>(data, content_length);
+                }
                 display->SetPreviewImage(std::move(image));
                 return true;
             });
@@ -868,15 +1103,59 @@ void McpServer::AddUserOnlyTools() {
     }
 }
 
+// 差分设备状态上报:逐节与上次发出的序列化结果比较,只回传变化的节。
+// seq单调递增,服务端发现跳号或首次连接时用full=true要整包;
+// 高频轮询下board信息、网络参数这类基本不变的节不再反复占用上行字节
+std::string McpServer::BuildDeviceStatusDiff(const std::string& full_json, bool want_full) {
+    std::lock_guard<std::mutex> lock(status_diff_mutex_);
+
+    cJSON* root = cJSON_Parse(full_json.c_str());
+    if (root == nullptr) {
+        return full_json;  // 解析不了就原样整包回传
+    }
+
+    status_seq_++;
+    bool full = want_full || last_status_sections_.empty();
+
+    cJSON* out = cJSON_CreateObject();
+    cJSON_AddNumberToObject(out, "seq", status_seq_);
+    cJSON_AddBoolToObject(out, "full", full);
+    for (cJSON* section = root->child; section != nullptr; section = section->next) {
+        if (section->string == nullptr) {
+            continue;
+        }
+        char* printed = cJSON_PrintUnformatted(section);
+        std::string serialized = printed;
+        cJSON_free(printed);
+
+        auto it = last_status_sections_.find(section->string);
+        bool changed = (it == last_status_sections_.end() || it->second != serialized);
+        if (changed) {
+            last_status_sections_[section->string] = std::move(serialized);
+        }
+        if (full || changed) {
+            cJSON_AddItemToObject(out, section->string, cJSON_Duplicate(section, 1));
+        }
+    }
+    cJSON_Delete(root);
+
+    char* out_str = cJSON_PrintUnformatted(out);
+    std::string result(out_str);
+    cJSON_free(out_str);
+    cJSON_Delete(out);
+    return result;
+}
+
 void McpServer::AddTool(McpTool* tool) {
     // Prevent adding duplicate tools
-    if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool* t) { return t->name() == tool->name(); }) != tools_.end()) {
+    if (tool_index_.find(tool->name()) != tool_index_.end()) {
         ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
         return;
     }
 
     ESP_LOGI(TAG, "Add tool: %s%s", tool->name().c_str(), tool->user_only() ? " [user]" : "");
     tools_.push_back(tool);
+    tool_index_[tool->name()] = tool;  // tools_保持注册顺序供列表分页,索引负责O(1)分发
 }
 
 void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
@@ -1003,12 +1282,12 @@ void McpServer::ParseMessage(const cJSON* json) {
     }
 }
 
-void McpServer::ReplyResult(int id, const std::string& result) {
-    std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
-    payload += std::to_string(id) + ",\"result\":";
-    payload += result;
-    payload += "}";
-    Application::GetInstance().SendMcpMessage(payload);
+void McpServer::ReplyResult(int id, std::string result) {
+    // JSON-RPC骨架原地包在结果外面,图片结果(几百KB的base64)从
+    // 工具线程一路移动到协议发送队列,全程只有编码时分配的那一个缓冲
+    result.insert(0, "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) + ",\"result\":");
+    result += "}";
+    Application::GetInstance().SendMcpMessage(std::move(result));
 }
 
 void McpServer::ReplyError(int id, const std::string& message) {
@@ -1017,7 +1296,7 @@ void McpServer::ReplyError(int id, const std::string& message) {
     payload += ",\"error\":{\"message\":\"";
     payload += message;
     payload += "\"}}";
-    Application::GetInstance().SendMcpMessage(payload);
+    Application::GetInstance().SendMcpMessage(std::move(payload));
 }
 
 void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_only_tools) {
@@ -1073,59 +1352,164 @@ void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_o
         json += "],\"nextCursor\":\"" + next_cursor + "\"}";
     }
     
-    ReplyResult(id, json);
+    ReplyResult(id, std::move(json));
 }
 
 void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments) {
-    auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
-                                 [&tool_name](const McpTool* tool) { 
-                                     return tool->name() == tool_name; 
-                                 });
-    
-    if (tool_iter == tools_.end()) {
+    auto index_iter = tool_index_.find(tool_name);
+    if (index_iter == tool_index_.end()) {
         ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
         ReplyError(id, "Unknown tool: " + tool_name);
         return;
     }
+    McpTool* tool = index_iter->second;
 
-    PropertyList arguments = (*tool_iter)->properties();
-    try {
-        for (auto& argument : arguments) {
-            bool found = false;
-            if (cJSON_IsObject(tool_arguments)) {
-                auto value = cJSON_GetObjectItem(tool_arguments, argument.name().c_str());
-                if (argument.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
-                    argument.set_value<bool>(value->valueint == 1);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeInteger && cJSON_IsNumber(value)) {
-                    argument.set_value<int>(value->valueint);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeString && cJSON_IsString(value)) {
-                    argument.set_value<std::string>(value->valuestring);
-                    found = true;
+    /* 按注册时编译好的扁平描述符单遍走JSON子链表直写参数槽位:范围校验
+     * 就地完成,不抛异常也不逐参数线性查cJSON(高频工具调用的热路径) */
+    PropertyList arguments = tool->properties();
+    const auto& compiled = tool->compiled_properties();
+    uint64_t found_mask = 0;
+    if (cJSON_IsObject(tool_arguments)) {
+        for (cJSON* item = tool_arguments->child; item != nullptr; item = item->next) {
+            if (item->string == nullptr) {
+                continue;
+            }
+            for (size_t i = 0; i < compiled.size(); i++) {
+                const auto& descriptor = compiled[i];
+                if ((found_mask & (1ULL << i)) || strcmp(item->string, descriptor.name) != 0) {
+                    continue;
                 }
+                if (descriptor.type == kPropertyTypeBoolean && cJSON_IsBool(item)) {
+                    arguments.at(i).set_value<bool>(item->valueint == 1);
+                    found_mask |= 1ULL << i;
+                } else if (descriptor.type == kPropertyTypeInteger && cJSON_IsNumber(item)) {
+                    if (descriptor.has_range &&
+                        (item->valueint < descriptor.min_value || item->valueint > descriptor.max_value)) {
+                        ESP_LOGE(TAG, "tools/call: Argument %s out of range [%d, %d]: %d",
+                                 descriptor.name, descriptor.min_value, descriptor.max_value, item->valueint);
+                        ReplyError(id, std::string("Argument out of range: ") + descriptor.name);
+                        return;
+                    }
+                    arguments.at(i).set_value<int>(item->valueint);
+                    found_mask |= 1ULL << i;
+                } else if (descriptor.type == kPropertyTypeString && cJSON_IsString(item)) {
+                    arguments.at(i).set_value<std::string>(item->valuestring);
+                    found_mask |= 1ULL << i;
+                }
+                break;
             }
+        }
+    }
+    for (size_t i = 0; i < compiled.size(); i++) {
+        if (!compiled[i].has_default && !(found_mask & (1ULL << i))) {
+            ESP_LOGE(TAG, "tools/call: Missing valid argument: %s", compiled[i].name);
+            ReplyError(id, std::string("Missing valid argument: ") + compiled[i].name);
+            return;
+        }
+    }
 
-            if (!argument.has_default_value() && !found) {
-                ESP_LOGE(TAG, "tools/call: Missing valid argument: %s", argument.name().c_str());
-                ReplyError(id, "Missing valid argument: " + argument.name());
-                return;
+    // 交给有界worker池执行;队列满了直接拒绝,突发调用不会无限堆积
+    StartToolWorkers();
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (pending_calls_.size() >= kMaxPendingCalls) {
+            ESP_LOGE(TAG, "tools/call: Pending queue full, rejecting %s", tool_name.c_str());
+            ReplyError(id, "Too many pending tool calls");
+            return;
+        }
+        pending_calls_.push(PendingCall{id, tool, std::move(arguments)});
+    }
+    pool_cv_.notify_one();
+}
+
+bool McpServer::CallToolFromLocal(const std::string& tool_name, PropertyList arguments) {
+    auto index_iter = tool_index_.find(tool_name);
+    if (index_iter == tool_index_.end()) {
+        ESP_LOGW(TAG, "local call: Unknown tool: %s", tool_name.c_str());
+        return false;
+    }
+    McpTool* tool = index_iter->second;
+
+    // 以工具声明的属性为底(带默认值和范围校验),调用方给的值覆盖同名项
+    PropertyList merged = tool->properties();
+    try {
+        for (auto& property : merged) {
+            for (auto& given : arguments) {
+                if (given.name() != property.name()) {
+                    continue;
+                }
+                if (property.type() == kPropertyTypeBoolean) {
+                    property.set_value<bool>(given.value<bool>());
+                } else if (property.type() == kPropertyTypeInteger) {
+                    property.set_value<int>(given.value<int>());
+                } else {
+                    property.set_value<std::string>(given.value<std::string>());
+                }
             }
         }
     } catch (const std::exception& e) {
-        ESP_LOGE(TAG, "tools/call: %s", e.what());
-        ReplyError(id, e.what());
+        ESP_LOGE(TAG, "local call: %s", e.what());
+        return false;
+    }
+
+    StartToolWorkers();
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (pending_calls_.size() >= kMaxPendingCalls) {
+            ESP_LOGW(TAG, "local call: Pending queue full, dropping %s", tool_name.c_str());
+            return false;
+        }
+        pending_calls_.push(PendingCall{kLocalCallId, tool, std::move(merged)});
+    }
+    pool_cv_.notify_one();
+    return true;
+}
+
+// 首次工具调用才拉起worker,纯语音会话不占这两份线程栈
+void McpServer::StartToolWorkers() {
+    if (!tool_workers_.empty()) {
         return;
     }
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.stack_size = 8192;
+    cfg.prio = 2;
+    cfg.thread_name = "mcp_tool";
+    esp_pthread_set_cfg(&cfg);
+    for (size_t i = 0; i < kToolWorkerCount; i++) {
+        tool_workers_.emplace_back([this]() { ToolWorkerLoop(); });
+    }
+}
 
-    // Use main thread to call the tool
-    auto& app = Application::GetInstance();
-    app.Schedule([this, id, tool_iter, arguments = std::move(arguments)]() {
+void McpServer::ToolWorkerLoop() {
+    while (true) {
+        PendingCall call{0, nullptr, PropertyList()};
+        {
+            std::unique_lock<std::mutex> lock(pool_mutex_);
+            pool_cv_.wait(lock, [this] { return pool_shutdown_ || !pending_calls_.empty(); });
+            if (pool_shutdown_) {
+                return;
+            }
+            call = std::move(pending_calls_.front());
+            pending_calls_.pop();
+        }
+
+        auto start_us = esp_timer_get_time();
         try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
+            auto result = call.tool->Call(call.arguments);
+            if (call.id != kLocalCallId) {
+                ReplyResult(call.id, std::move(result));
+            }
         } catch (const std::exception& e) {
             ESP_LOGE(TAG, "tools/call: %s", e.what());
-            ReplyError(id, e.what());
+            if (call.id != kLocalCallId) {
+                ReplyError(call.id, e.what());
+            }
         }
-    });
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        call.tool->RecordExecution(elapsed_us);
+        ESP_LOGD(TAG, "Tool %s took %lld us (avg %lld us over %lu calls, max %lld us)",
+                 call.tool->name().c_str(), (long long)elapsed_us,
+                 (long long)call.tool->average_time_us(), (unsigned long)call.tool->call_count(),
+                 (long long)call.tool->max_time_us());
+    }
 }
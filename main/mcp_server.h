@@ -4,45 +4,61 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <algorithm>
 #include <functional>
 #include <variant>
 #include <optional>
 #include <stdexcept>
 #include <thread>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
 #include <mbedtls/base64.h>
+#include <cstdio>
 
 #include <cJSON.h>
+#include <esp_log.h>
 
 class ImageContent {
 private:
-    std::string encoded_data_;
+    std::string data_;       // 原始图像字节,base64编码推迟到出报文时流式进行
     std::string mime_type_;
 
-    static std::string Base64Encode(const std::string& data) {
-        size_t dlen = 0, olen = 0;
-        mbedtls_base64_encode((unsigned char*)nullptr, 0, &dlen, (const unsigned char*)data.data(), data.size());
-        std::string result(dlen, 0);
-        mbedtls_base64_encode((unsigned char*)result.data(), result.size(), &olen, (const unsigned char*)data.data(), data.size());
-        return result;
-    }
+    static constexpr size_t kEncodeSegment = 3072;  // 3的倍数,段间拼接不产生padding
 
 public:
-    ImageContent(const std::string& mime_type, const std::string& data) {
-        mime_type_ = mime_type;
-        // base64 encode data
-        encoded_data_ = Base64Encode(data);
+    ImageContent(const std::string& mime_type, const std::string& data)
+        : data_(data), mime_type_(mime_type) {}
+    ImageContent(const std::string& mime_type, std::string&& data)
+        : data_(std::move(data)), mime_type_(mime_type) {}
+
+    size_t encoded_size() const { return (data_.size() + 2) / 3 * 4; }
+
+    // 按固定4KB段编码并直接追加到输出串,峰值暂存与图像大小无关
+    void AppendBase64(std::string& out) const {
+        unsigned char segment[kEncodeSegment / 3 * 4 + 1];
+        for (size_t offset = 0; offset < data_.size(); offset += kEncodeSegment) {
+            size_t chunk = std::min(kEncodeSegment, data_.size() - offset);
+            size_t olen = 0;
+            mbedtls_base64_encode(segment, sizeof(segment), &olen,
+                                  (const unsigned char*)data_.data() + offset, chunk);
+            out.append((const char*)segment, olen);
+        }
     }
 
-    std::string to_json() const {
-        cJSON *json = cJSON_CreateObject();
-        cJSON_AddStringToObject(json, "type", "image");
-        cJSON_AddStringToObject(json, "mimeType", mime_type_.c_str());
-        cJSON_AddStringToObject(json, "data", encoded_data_.c_str());
-        char* json_str = cJSON_PrintUnformatted(json);
-        std::string result(json_str);
-        cJSON_free(json_str);
-        cJSON_Delete(json);
-        return result;
+    // 直接拼出整个工具调用结果:内层ImageContent JSON按旧格式以转义字符串内嵌,
+    // base64和MIME类型都不含需转义的字符。输出串预留到最终大小,编码数据全程只有这一份;
+    // 余量同时覆盖后续原地insert的JSON-RPC骨架和协议信封,包装过程不再触发realloc
+    std::string to_result_json() const {
+        std::string out;
+        out.reserve(encoded_size() + mime_type_.size() + 320);
+        out += "{\"content\":[{\"type\":\"image\",\"image\":\"{\\\"type\\\":\\\"image\\\",\\\"mimeType\\\":\\\"";
+        out += mime_type_;
+        out += "\\\",\\\"data\\\":\\\"";
+        AppendBase64(out);
+        out += "\\\"}\"}],\"isError\":false}";
+        return out;
     }
 };
 
@@ -178,6 +194,9 @@ public:
     auto begin() { return properties_.begin(); }
     auto end() { return properties_.end(); }
 
+    inline size_t size() const { return properties_.size(); }
+    inline Property& at(size_t index) { return properties_[index]; }
+
     std::vector<std::string> GetRequired() const {
         std::vector<std::string> required;
         for (auto& property : properties_) {
@@ -206,32 +225,75 @@ public:
 };
 
 class McpTool {
+public:
+    /* 注册时编译好的扁平参数描述符:tools/call解析对JSON子链表单遍直写,
+     * 范围校验就地做掉,不再逐参数线性查cJSON也不走异常路径(高频机器人
+     * 控制工具每次调用都省掉这些开销) */
+    struct CompiledProperty {
+        const char* name;  // 指向properties_里的名字,与工具同生命周期
+        PropertyType type;
+        bool has_default;
+        bool has_range;
+        int min_value;
+        int max_value;
+    };
+
 private:
     std::string name_;
     std::string description_;
     PropertyList properties_;
+    std::vector<CompiledProperty> compiled_properties_;
     std::function<ReturnValue(const PropertyList&)> callback_;
     bool user_only_ = false;
+    mutable std::string cached_json_;  // 序列化schema缓存,tools/list轮询时直接复用
+
+    // 执行时间统计(微秒),由工具worker线程记录,用于定位慢工具
+    uint32_t call_count_ = 0;
+    int64_t total_time_us_ = 0;
+    int64_t max_time_us_ = 0;
 
 public:
     McpTool(const std::string& name, 
             const std::string& description, 
             const PropertyList& properties, 
             std::function<ReturnValue(const PropertyList&)> callback)
-        : name_(name), 
-        description_(description), 
-        properties_(properties), 
-        callback_(callback) {}
+        : name_(name),
+        description_(description),
+        properties_(properties),
+        callback_(callback) {
+        compiled_properties_.reserve(properties_.size());
+        for (auto& property : properties_) {
+            compiled_properties_.push_back({property.name().c_str(), property.type(),
+                property.has_default_value(), property.has_range(),
+                property.min_value(), property.max_value()});
+        }
+    }
 
-    void set_user_only(bool user_only) { user_only_ = user_only; }
+    void set_user_only(bool user_only) { user_only_ = user_only; cached_json_.clear(); }
     inline const std::string& name() const { return name_; }
     inline const std::string& description() const { return description_; }
     inline const PropertyList& properties() const { return properties_; }
+    inline const std::vector<CompiledProperty>& compiled_properties() const { return compiled_properties_; }
     inline bool user_only() const { return user_only_; }
 
+    void RecordExecution(int64_t elapsed_us) {
+        call_count_++;
+        total_time_us_ += elapsed_us;
+        if (elapsed_us > max_time_us_) {
+            max_time_us_ = elapsed_us;
+        }
+    }
+    inline uint32_t call_count() const { return call_count_; }
+    inline int64_t average_time_us() const { return call_count_ > 0 ? total_time_us_ / call_count_ : 0; }
+    inline int64_t max_time_us() const { return max_time_us_; }
+
     std::string to_json() const {
+        // 名字/描述/参数在注册后不变,序列化一次即可(user_only变化时缓存被清掉)
+        if (!cached_json_.empty()) {
+            return cached_json_;
+        }
         std::vector<std::string> required = properties_.GetRequired();
-        
+
         cJSON *json = cJSON_CreateObject();
         cJSON_AddStringToObject(json, "name", name_.c_str());
         cJSON_AddStringToObject(json, "description", description_.c_str());
@@ -262,52 +324,76 @@ public:
         }
         
         char *json_str = cJSON_PrintUnformatted(json);
-        std::string result(json_str);
+        cached_json_ = json_str;
         cJSON_free(json_str);
         cJSON_Delete(json);
-        
-        return result;
+
+        return cached_json_;
     }
 
     std::string Call(const PropertyList& properties) {
         ReturnValue return_value = callback_(properties);
-        // 返回结果
-        cJSON* result = cJSON_CreateObject();
-        cJSON* content = cJSON_CreateArray();
 
+        // 图片结果单独走流式拼接路径,不经过cJSON的多次整串拷贝
         if (std::holds_alternative<ImageContent*>(return_value)) {
             auto image_content = std::get<ImageContent*>(return_value);
-            cJSON* image = cJSON_CreateObject();
-            cJSON_AddStringToObject(image, "type", "image");
-            cJSON_AddStringToObject(image, "image", image_content->to_json().c_str());
-            cJSON_AddItemToArray(content, image);
+            std::string result_str = image_content->to_result_json();
             delete image_content;
-        } else {
-            cJSON* text = cJSON_CreateObject();
-            cJSON_AddStringToObject(text, "type", "text");
-            if (std::holds_alternative<std::string>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::get<std::string>(return_value).c_str());
-            } else if (std::holds_alternative<bool>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::get<bool>(return_value) ? "true" : "false");
-            } else if (std::holds_alternative<int>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::to_string(std::get<int>(return_value)).c_str());
-            } else if (std::holds_alternative<cJSON*>(return_value)) {
-                cJSON* json = std::get<cJSON*>(return_value);
-                char* json_str = cJSON_PrintUnformatted(json);
-                cJSON_AddStringToObject(text, "text", json_str);
-                cJSON_free(json_str);
-                cJSON_Delete(json);
-            }
-            cJSON_AddItemToArray(content, text);
+            return result_str;
         }
-        cJSON_AddItemToObject(result, "content", content);
-        cJSON_AddBoolToObject(result, "isError", false);
 
-        auto json_str = cJSON_PrintUnformatted(result);
-        std::string result_str(json_str);
-        cJSON_free(json_str);
-        cJSON_Delete(result);
-        return result_str;
+        // 文本结果的骨架是固定的,键名都是编译期字面量,直接往预留好的串里拼:
+        // 高频轮询工具(状态查询类)不再产生cJSON建树+整串打印的分配流量;
+        // 复杂负载(cJSON*)仍由cJSON序列化一次,这里只做转义内嵌
+        std::string text;
+        if (std::holds_alternative<std::string>(return_value)) {
+            text = std::move(std::get<std::string>(return_value));
+        } else if (std::holds_alternative<bool>(return_value)) {
+            text = std::get<bool>(return_value) ? "true" : "false";
+        } else if (std::holds_alternative<int>(return_value)) {
+            text = std::to_string(std::get<int>(return_value));
+        } else if (std::holds_alternative<cJSON*>(return_value)) {
+            cJSON* json = std::get<cJSON*>(return_value);
+            char* json_str = cJSON_PrintUnformatted(json);
+            text = json_str;
+            cJSON_free(json_str);
+            cJSON_Delete(json);
+        }
+
+        std::string result;
+        size_t reserved = text.size() + text.size() / 4 + 48;  // 为转义留1/4余量
+        result.reserve(reserved);
+        result += "{\"content\":[{\"type\":\"text\",\"text\":\"";
+        AppendJsonEscaped(result, text);
+        result += "\"}],\"isError\":false}";
+        // 调试统计:文本+结果两次分配,转义超出预留余量时字符串会再扩一次
+        ESP_LOGD("MCP", "Text reply: %u bytes, %d allocations",
+                 (unsigned int)result.size(), result.size() > reserved ? 3 : 2);
+        return result;
+    }
+
+private:
+    // 按JSON字符串规则转义后追加,不产生中间分配(调用方已预留空间)
+    static void AppendJsonEscaped(std::string& out, const std::string& s) {
+        for (char c : s) {
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20) {
+                        char buf[8];
+                        snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+                        out += buf;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
     }
 };
 
@@ -325,6 +411,9 @@ public:
     void AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
+    /* 本地指令直呼工具回调(见LocalCommandRecognizer):不走JSON-RPC信道,
+     * 结果不回传服务器。arguments需带齐无默认值的属性,复用worker池执行 */
+    bool CallToolFromLocal(const std::string& tool_name, PropertyList arguments);
 
 private:
     McpServer();
@@ -332,13 +421,39 @@ private:
 
     void ParseCapabilities(const cJSON* capabilities);
 
-    void ReplyResult(int id, const std::string& result);
+    void ReplyResult(int id, std::string result);
     void ReplyError(int id, const std::string& message);
 
     void GetToolsList(int id, const std::string& cursor, bool list_user_only_tools);
     void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments);
 
-    std::vector<McpTool*> tools_;
+    // 工具执行线程池:固定两个worker加有界待执行队列,长耗时回调(拍照上传、
+    // 网络请求)不再占住主循环,突发调用的内存和延迟都有上界
+    static constexpr size_t kToolWorkerCount = 2;
+    static constexpr size_t kMaxPendingCalls = 8;
+    // 本地直呼的占位id:worker执行后不回传结果(JSON-RPC的id恒为非负)
+    static constexpr int kLocalCallId = -1;
+    struct PendingCall {
+        int id;
+        McpTool* tool;
+        PropertyList arguments;
+    };
+    void StartToolWorkers();
+    void ToolWorkerLoop();
+
+    // 设备状态差分上报:缓存各节上次发出的序列化结果,只回传有变化的节
+    std::string BuildDeviceStatusDiff(const std::string& full_json, bool want_full);
+    std::mutex status_diff_mutex_;
+    std::map<std::string, std::string> last_status_sections_;
+    uint32_t status_seq_ = 0;
+
+    std::vector<McpTool*> tools_;                        // 注册顺序,tools/list分页遍历用
+    std::unordered_map<std::string, McpTool*> tool_index_;  // 名字散列索引,tools/call O(1)分发
+    std::queue<PendingCall> pending_calls_;
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cv_;
+    std::vector<std::thread> tool_workers_;
+    bool pool_shutdown_ = false;
 };
 
 #endif // MCP_SERVER_H
@@ -0,0 +1,79 @@
+#include "metrics_registry.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cJSON.h>
+
+#define TAG "Metrics"
+
+int MetricsRegistry::Register(const char* name, MetricType type) {
+    int id = slot_count_.fetch_add(1);
+    if (id >= (int)kMaxMetrics) {
+        slot_count_.store(kMaxMetrics);
+        ESP_LOGW(TAG, "Metric slots exhausted, dropping %s", name);
+        return -1;
+    }
+    slots_[id].name = name;
+    slots_[id].type = type;
+    return id;
+}
+
+void MetricsRegistry::Sample() {
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    if (history_ == nullptr) {
+        if (history_alloc_failed_) {
+            return;
+        }
+        // 11KB多一点,放PSRAM;没有PSRAM的板子退化为只有当前值没有历史
+        history_ = static_cast<int32_t*>(heap_caps_calloc(
+            kHistorySeconds * kMaxMetrics, sizeof(int32_t), MALLOC_CAP_SPIRAM));
+        if (history_ == nullptr) {
+            history_alloc_failed_ = true;
+            ESP_LOGW(TAG, "No PSRAM for metrics history, sampling disabled");
+            return;
+        }
+    }
+
+    int count = slot_count_.load();
+    int32_t* row = history_ + history_pos_ * kMaxMetrics;
+    for (int i = 0; i < count; i++) {
+        row[i] = slots_[i].value.load(std::memory_order_relaxed);
+    }
+    history_pos_ = (history_pos_ + 1) % kHistorySeconds;
+    if (history_filled_ < kHistorySeconds) {
+        history_filled_++;
+    }
+}
+
+std::string MetricsRegistry::DumpHistoryJson(int seconds) {
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    if (seconds < 1) {
+        seconds = 1;
+    }
+    size_t rows = (size_t)seconds > history_filled_ ? history_filled_ : (size_t)seconds;
+
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "interval_ms", 1000);
+    cJSON* metrics = cJSON_AddArrayToObject(root, "metrics");
+
+    int count = slot_count_.load();
+    for (int i = 0; i < count; i++) {
+        cJSON* metric = cJSON_CreateObject();
+        cJSON_AddStringToObject(metric, "name", slots_[i].name);
+        cJSON_AddStringToObject(metric, "type",
+                                slots_[i].type == kMetricCounter ? "counter" : "gauge");
+        cJSON* samples = cJSON_AddArrayToObject(metric, "samples");
+        // 时间正序:最旧的样本在前
+        for (size_t r = 0; r < rows; r++) {
+            size_t idx = (history_pos_ + kHistorySeconds - rows + r) % kHistorySeconds;
+            cJSON_AddItemToArray(samples, cJSON_CreateNumber(history_[idx * kMaxMetrics + i]));
+        }
+        cJSON_AddItemToArray(metrics, metric);
+    }
+
+    char* json = cJSON_PrintUnformatted(root);
+    std::string result(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return result;
+}
@@ -0,0 +1,71 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// 轻量指标注册表+历史环:子系统在启动期注册固定槽位的计数器/瞬时值,
+// 热路径打点只是一次宽松原子写;主循环时钟每秒把所有槽位快照进PSRAM
+// 环,保留最近两分钟。现场报卡顿时用self.metrics.history把故障前一
+// 分钟的飞行记录拉下来,不用等复现
+enum MetricType {
+    kMetricCounter = 0,  // 单调累计,看采样间差分
+    kMetricGauge,        // 瞬时值
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& GetInstance() {
+        static MetricsRegistry instance;
+        return instance;
+    }
+
+    // 启动期调用;name必须是静态生存期字符串。槽位用完返回-1,打点成空操作
+    int Register(const char* name, MetricType type);
+
+    void Set(int id, int32_t value) {
+        if (id >= 0) {
+            slots_[id].value.store(value, std::memory_order_relaxed);
+        }
+    }
+    void Add(int id, int32_t delta) {
+        if (id >= 0) {
+            slots_[id].value.fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+
+    // 主循环时钟1Hz调用:所有槽位快照进历史环(PSRAM,首次采样时分配)
+    void Sample();
+
+    // 最近seconds秒的历史:{"interval_ms":1000,"metrics":[{name,type,samples[]}...]}
+    std::string DumpHistoryJson(int seconds);
+
+private:
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    static constexpr size_t kMaxMetrics = 24;
+    static constexpr size_t kHistorySeconds = 120;
+
+    struct Slot {
+        const char* name = nullptr;
+        MetricType type = kMetricGauge;
+        std::atomic<int32_t> value{0};
+    };
+
+    Slot slots_[kMaxMetrics];
+    std::atomic<int> slot_count_{0};
+
+    // 环形历史:每秒一行,每行kMaxMetrics个快照
+    int32_t* history_ = nullptr;
+    size_t history_pos_ = 0;
+    size_t history_filled_ = 0;
+    bool history_alloc_failed_ = false;
+    std::mutex history_mutex_;  // Sample和Dump都是冷路径,直接互斥
+};
+
+#endif // METRICS_REGISTRY_H
@@ -0,0 +1,130 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <functional>
+
+// 多生产者单消费者无锁队列(Vyukov侵入式链表变体),用于Application::Schedule:
+// 音频回调、定时器和协议任务投递回调时不再抢互斥锁,主循环里慢回调
+// 也不会把投递方阻塞住。节点预分配成池,投递方用exchange抢占节点,
+// 池耗尽时退化为堆分配,不丢任务。
+class MpscTaskQueue {
+public:
+    explicit MpscTaskQueue(size_t pool_size = 16)
+        : pool_size_(pool_size), pool_(new Node[pool_size]) {
+        stub_.next.store(nullptr, std::memory_order_relaxed);
+        head_.store(&stub_, std::memory_order_relaxed);
+        tail_ = &stub_;
+        for (size_t i = 0; i < pool_size_; i++) {
+            pool_[i].from_pool = true;
+        }
+    }
+
+    ~MpscTaskQueue() {
+        while (auto task = Pop()) {
+        }
+        delete[] pool_;
+    }
+
+    MpscTaskQueue(const MpscTaskQueue&) = delete;
+    MpscTaskQueue& operator=(const MpscTaskQueue&) = delete;
+
+    // 出队结果:name是投递方给的静态字符串标签,用于慢回调归因
+    struct Item {
+        std::function<void()> task;
+        const char* name = nullptr;
+        explicit operator bool() const { return (bool)task; }
+    };
+
+    // 任意任务上下文可调用,无锁;name必须是静态生存期字符串
+    void Push(std::function<void()>&& task, const char* name = "unnamed") {
+        Node* node = AcquireNode();
+        node->task = std::move(task);
+        node->name = name;
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 仅限主循环(单消费者)调用;队列空返回空Item
+    Item Pop() {
+        Node* node = PopNode();
+        if (node == nullptr) {
+            return {};
+        }
+        Item item{std::move(node->task), node->name};
+        ReleaseNode(node);
+        return item;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::function<void()> task;
+        const char* name = nullptr;
+        std::atomic<bool> in_use{false};
+        bool from_pool = false;
+    };
+
+    Node* AcquireNode() {
+        // 池很小,线性扫一遍抢空闲节点;exchange保证同一节点不会被抢两次
+        for (size_t i = 0; i < pool_size_; i++) {
+            if (!pool_[i].in_use.exchange(true, std::memory_order_acquire)) {
+                return &pool_[i];
+            }
+        }
+        // 池耗尽(调度风暴),退化为堆分配
+        return new Node();
+    }
+
+    void ReleaseNode(Node* node) {
+        if (node->from_pool) {
+            node->task = nullptr;
+            node->in_use.store(false, std::memory_order_release);
+        } else {
+            delete node;
+        }
+    }
+
+    // Vyukov出队:stub节点避免头尾指针竞争,消费侧完全无等待,
+    // 仅在生产者half-push(已exchange未接链)时暂时返回空
+    Node* PopNode() {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail_ = next;
+            return tail;
+        }
+        Node* head = head_.load(std::memory_order_acquire);
+        if (tail != head) {
+            // 生产者正在接链,下一个MAIN_EVENT_SCHEDULE会再来取
+            return nullptr;
+        }
+        // 队列只剩这一个节点:把stub推回去作为新的链尾再取出它
+        stub_.next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+        prev->next.store(&stub_, std::memory_order_release);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    size_t pool_size_;
+    Node* pool_;
+    Node stub_;
+    std::atomic<Node*> head_;  // 生产端
+    Node* tail_;               // 消费端,仅主循环访问
+};
+
+#endif // MPSC_QUEUE_H
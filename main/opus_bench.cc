@@ -0,0 +1,210 @@
+#include "opus_bench.h"
+
+#include <opus_encoder.h>
+#include <opus_decoder.h>
+
+#include <esp_log.h>
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#define TAG "OpusBench"
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+constexpr int kComplexities[] = {0, 3, 5, 8, 10};
+constexpr int kBitrates[] = {8000, 12000, 16000, 24000};
+constexpr int kFrameDurationsMs[] = {20, 60};
+
+// 与编解码任务同档的栈,量出来的高水位才能直接换算回任务配置
+constexpr uint32_t kBenchStackBytes = 2048 * 13;
+
+std::atomic<bool> g_running{false};
+
+// 与audio_service.cc相同的SetBitrate版本探测:旧版esp-opus-encoder
+// 没有这个接口,那时只跑默认码率那一档,结果里标bitrate_applied=false
+template <typename T, typename = void>
+struct HasSetBitrate : std::false_type {};
+template <typename T>
+struct HasSetBitrate<T, std::void_t<decltype(std::declval<T&>().SetBitrate(0))>> : std::true_type {};
+
+template <typename T>
+bool ApplyEncoderBitrate(T* encoder, int bps) {
+    if constexpr (HasSetBitrate<T>::value) {
+        encoder->SetBitrate(bps);
+        return true;
+    }
+    return false;
+}
+
+/* 参考PCM:基频扫频+谐波+少量LCG噪声的"类语音"信号。完全确定,
+ * 不同板子、不同固件版本量到的是同一段输入,表才能横向比。
+ * 纯音会让编码器偷懒,纯噪声又会把它逼到最坏情况,都不代表语音 */
+void FillReferencePcm(std::vector<int16_t>& pcm) {
+    uint32_t lcg = 0x12345678;
+    float phase = 0.0f;
+    for (size_t i = 0; i < pcm.size(); i++) {
+        float t = (float)i / kSampleRate;
+        float f0 = 120.0f + 80.0f * sinf(2.0f * (float)M_PI * 0.7f * t);
+        phase += 2.0f * (float)M_PI * f0 / kSampleRate;
+        float s = 0.5f * sinf(phase) + 0.25f * sinf(2.0f * phase) + 0.12f * sinf(3.0f * phase);
+        lcg = lcg * 1664525u + 1013904223u;
+        s += ((int32_t)(lcg >> 16) - 32768) / 32768.0f * 0.05f;
+        pcm[i] = (int16_t)(s * 12000.0f);
+    }
+}
+
+struct BenchArgs {
+    int frames_per_combo;
+    cJSON* result;
+    SemaphoreHandle_t done;
+};
+
+void BenchTask(void* arg) {
+    auto* args = (BenchArgs*)arg;
+    const int frames = args->frames_per_combo;
+
+    // 1秒参考信号外加最长一帧,切片不用处理回绕
+    std::vector<int16_t> reference(kSampleRate + kSampleRate * 60 / 1000);
+    FillReferencePcm(reference);
+
+    auto root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "cpu_mhz", esp_rom_get_cpu_ticks_per_us());
+    cJSON_AddNumberToObject(root, "frames_per_combo", frames);
+    cJSON_AddNumberToObject(root, "stack_size", kBenchStackBytes);
+    bool bitrate_applied = true;
+    auto results = cJSON_CreateArray();
+
+    for (int frame_ms : kFrameDurationsMs) {
+        const int samples_per_frame = kSampleRate * frame_ms / 1000;
+        for (int complexity : kComplexities) {
+            for (int bitrate : kBitrates) {
+                OpusEncoderWrapper encoder(kSampleRate, 1, frame_ms);
+                encoder.SetComplexity(complexity);
+                encoder.SetDtx(false);  // 每帧都真编,DTX会让低能量帧白得发虚
+                if (!ApplyEncoderBitrate(&encoder, bitrate)) {
+                    bitrate_applied = false;
+                    if (bitrate != kBitrates[0]) {
+                        continue;  // 码率设不进去,各档结果相同,只跑一档
+                    }
+                }
+                OpusDecoderWrapper decoder(kSampleRate, 1, frame_ms);
+
+                uint64_t enc_cycles = 0, dec_cycles = 0;
+                uint32_t enc_max = 0, dec_max = 0;
+                size_t total_bytes = 0;
+                int failures = 0;
+                std::vector<int16_t> frame;
+                std::vector<uint8_t> opus;
+                std::vector<int16_t> decoded;
+
+                for (int i = 0; i < frames; i++) {
+                    size_t offset = ((size_t)i * samples_per_frame) % kSampleRate;
+                    frame.assign(reference.begin() + offset,
+                                 reference.begin() + offset + samples_per_frame);
+
+                    uint32_t t0 = esp_cpu_get_cycle_count();
+                    if (!encoder.Encode(std::move(frame), opus)) {
+                        failures++;
+                        continue;
+                    }
+                    uint32_t dt = esp_cpu_get_cycle_count() - t0;
+                    enc_cycles += dt;
+                    if (dt > enc_max) enc_max = dt;
+                    total_bytes += opus.size();
+
+                    t0 = esp_cpu_get_cycle_count();
+                    if (!decoder.Decode(std::move(opus), decoded)) {
+                        failures++;
+                        continue;
+                    }
+                    dt = esp_cpu_get_cycle_count() - t0;
+                    dec_cycles += dt;
+                    if (dt > dec_max) dec_max = dt;
+                }
+
+                int ok_frames = frames - failures;
+                if (ok_frames <= 0) ok_frames = 1;
+                uint32_t enc_avg = (uint32_t)(enc_cycles / ok_frames);
+                uint32_t dec_avg = (uint32_t)(dec_cycles / ok_frames);
+                uint32_t bytes_per_sec = (uint32_t)(total_bytes * 1000 / ((uint32_t)frames * frame_ms));
+                uint32_t stack_free_min = (uint32_t)uxTaskGetStackHighWaterMark(nullptr);
+
+                auto entry = cJSON_CreateObject();
+                cJSON_AddNumberToObject(entry, "frame_ms", frame_ms);
+                cJSON_AddNumberToObject(entry, "complexity", complexity);
+                cJSON_AddNumberToObject(entry, "bitrate", bitrate);
+                cJSON_AddNumberToObject(entry, "enc_cycles_avg", enc_avg);
+                cJSON_AddNumberToObject(entry, "enc_cycles_max", enc_max);
+                cJSON_AddNumberToObject(entry, "dec_cycles_avg", dec_avg);
+                cJSON_AddNumberToObject(entry, "dec_cycles_max", dec_max);
+                cJSON_AddNumberToObject(entry, "bytes_per_sec", bytes_per_sec);
+                cJSON_AddNumberToObject(entry, "stack_free_min", stack_free_min);
+                if (failures > 0) {
+                    cJSON_AddNumberToObject(entry, "failures", failures);
+                }
+                cJSON_AddItemToArray(results, entry);
+
+                // 机器可解析的表行,串口日志就能直接grep成表
+                ESP_LOGI(TAG, "OPUS_BENCH frame=%dms c=%d br=%d enc=%lu/%lu dec=%lu/%lu cyc B/s=%lu stack_min=%lu",
+                         frame_ms, complexity, bitrate,
+                         (unsigned long)enc_avg, (unsigned long)enc_max,
+                         (unsigned long)dec_avg, (unsigned long)dec_max,
+                         (unsigned long)bytes_per_sec, (unsigned long)stack_free_min);
+
+                vTaskDelay(1);  // 组合之间让一拍,喂看门狗也让别的任务喘口气
+            }
+        }
+    }
+
+    cJSON_AddItemToObject(root, "results", results);
+    cJSON_AddBoolToObject(root, "bitrate_applied", bitrate_applied);
+    // 高水位只降不升,最终值给出整个扫描过程的栈峰值占用
+    cJSON_AddNumberToObject(root, "peak_stack_bytes",
+                            kBenchStackBytes - (uint32_t)uxTaskGetStackHighWaterMark(nullptr));
+
+    args->result = root;
+    xSemaphoreGive(args->done);
+    vTaskDelete(nullptr);
+}
+
+}  // namespace
+
+cJSON* OpusBench::RunJson(int frames_per_combo) {
+    bool expected = false;
+    if (!g_running.compare_exchange_strong(expected, true)) {
+        auto json = cJSON_CreateObject();
+        cJSON_AddBoolToObject(json, "success", false);
+        cJSON_AddStringToObject(json, "error", "benchmark already running");
+        return json;
+    }
+
+    BenchArgs args = {};
+    args.frames_per_combo = frames_per_combo;
+    args.done = xSemaphoreCreateBinary();
+
+    // 独立任务跑:栈尺寸与真实编解码任务一致,高水位才有对照意义;
+    // 低优先级,不跟在播的音频抢核
+    if (xTaskCreate(BenchTask, "opus_bench", kBenchStackBytes, &args, 1, nullptr) != pdPASS) {
+        vSemaphoreDelete(args.done);
+        g_running.store(false);
+        auto json = cJSON_CreateObject();
+        cJSON_AddBoolToObject(json, "success", false);
+        cJSON_AddStringToObject(json, "error", "failed to create benchmark task");
+        return json;
+    }
+
+    xSemaphoreTake(args.done, portMAX_DELAY);
+    vSemaphoreDelete(args.done);
+    g_running.store(false);
+    return args.result;
+}
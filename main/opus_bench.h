@@ -0,0 +1,18 @@
+#ifndef OPUS_BENCH_H
+#define OPUS_BENCH_H
+
+#include <cJSON.h>
+
+// Opus编解码基准:对同一段确定性参考PCM,把编码器/解码器扫过全部
+// complexity/bitrate/帧长组合,报告每帧周期数、实际码率和基准任务的
+// 栈高水位。各SKU(esp32/c3/s3/p4)跑同一张表,每颗芯片的复杂度上限
+// 和Kconfig默认值就有数据可依,不再凭经验拍
+class OpusBench {
+public:
+    // 同步跑完整组合(在独立任务里执行,阻塞调用方几十秒),
+    // frames_per_combo为每个组合编码的帧数;返回结果JSON(所有权
+    // 交给调用方)。设备空闲时运行
+    static cJSON* RunJson(int frames_per_combo);
+};
+
+#endif
@@ -2,22 +2,33 @@
 #include "system_info.h"
 #include "settings.h"
 #include "assets/lang_config.h"
+#include "flash_scheduler.h"
 
 #include <cJSON.h>
 #include <esp_log.h>
 #include <esp_partition.h>
 #include <esp_ota_ops.h>
 #include <esp_app_format.h>
+#include <esp_delta_ota.h>
+#include <esp_crc.h>
 #include <esp_efuse.h>
 #include <esp_efuse_table.h>
+#include <esp_core_dump.h>
+#include <esp_heap_caps.h>
+#include <zlib.h>
 #ifdef SOC_HMAC_SUPPORTED
 #include <esp_hmac.h>
 #endif
 
 #include <cstring>
+#include <ctime>
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #define TAG "Ota"
 
@@ -49,10 +60,10 @@ std::string Ota::GetCheckVersionUrl() {
     return url;
 }
 
-std::unique_ptr<Http> Ota::SetupHttp() {
+PooledHttp Ota::SetupHttp() {
     auto& board = Board::GetInstance();
-    auto network = board.GetNetwork();
-    auto http = network->CreateHttp(0);
+    // 版本检查/激活/崩溃上报都打同一台OTA服务器,客户端走共享池复用
+    auto http = HttpPool::GetInstance().Acquire("ota", GetCheckVersionUrl());
     auto user_agent = SystemInfo::GetUserAgent();
     http->SetHeader("Activation-Version", has_serial_number_ ? "2" : "1");
     http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
@@ -68,7 +79,87 @@ std::unique_ptr<Http> Ota::SetupHttp() {
     return http;
 }
 
-/* 
+// 崩溃遥测:上次运行若在coredump分区留下了转储,压缩后通过和
+// 版本检查相同的鉴权HTTP通道上传到 <ota_url>/coredump。
+// 上传成功才擦除转储,失败保留到下次开机重试
+bool Ota::UploadCoreDump() {
+    size_t dump_addr = 0;
+    size_t dump_size = 0;
+    if (esp_core_dump_image_check() != ESP_OK ||
+        esp_core_dump_image_get(&dump_addr, &dump_size) != ESP_OK || dump_size == 0) {
+        return false;
+    }
+    ESP_LOGW(TAG, "Found core dump in flash (%u bytes), uploading", dump_size);
+
+    auto partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                              ESP_PARTITION_SUBTYPE_DATA_COREDUMP, nullptr);
+    if (partition == nullptr) {
+        ESP_LOGE(TAG, "No coredump partition found");
+        return false;
+    }
+
+    auto raw = (uint8_t*)heap_caps_malloc(dump_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (raw == nullptr) {
+        raw = (uint8_t*)heap_caps_malloc(dump_size, MALLOC_CAP_8BIT);
+    }
+    if (raw == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for core dump", dump_size);
+        return false;
+    }
+    if (esp_partition_read(partition, 0, raw, dump_size) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read coredump partition");
+        heap_caps_free(raw);
+        return false;
+    }
+
+    // zlib压缩后再上传,转储内容大多是稀疏栈帧,通常能压掉一半以上
+    uLongf compressed_size = compressBound(dump_size);
+    std::string body;
+    body.resize(compressed_size);
+    bool compressed = compress2((Bytef*)body.data(), &compressed_size, raw, dump_size, Z_BEST_SPEED) == Z_OK;
+    if (compressed) {
+        body.resize(compressed_size);
+    } else {
+        ESP_LOGW(TAG, "Failed to compress core dump, uploading raw");
+        body.assign((const char*)raw, dump_size);
+    }
+    heap_caps_free(raw);
+
+    std::string url = GetCheckVersionUrl();
+    if (url.length() < 10) {
+        ESP_LOGE(TAG, "Check version URL is not properly set, keeping core dump");
+        return false;
+    }
+    if (url.back() != '/') {
+        url += "/";
+    }
+    url += "coredump";
+
+    auto http = SetupHttp();
+    http->SetHeader("Content-Type", "application/octet-stream");
+    http->SetHeader("X-Original-Size", std::to_string(dump_size).c_str());
+    if (compressed) {
+        http->SetHeader("X-Content-Encoding", "zlib");
+    }
+    http->SetContent(std::move(body));
+
+    if (!http->Open("POST", url)) {
+        ESP_LOGE(TAG, "Failed to open HTTP connection for core dump upload");
+        return false;
+    }
+    auto status_code = http->GetStatusCode();
+    http->Close();
+    if (status_code < 200 || status_code >= 300) {
+        ESP_LOGE(TAG, "Failed to upload core dump, status code: %d", status_code);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Core dump uploaded, erasing");
+    esp_core_dump_image_erase();
+    return true;
+}
+
+/*
  * Specification: https://ccnphfhqs21z.feishu.cn/wiki/FjW6wZmisimNBBkov6OcmfvknVd
  */
 bool Ota::CheckVersion() {
@@ -105,10 +196,60 @@ bool Ota::CheckVersion() {
     data = http->ReadAll();
     http->Close();
 
+    if (!ParseCheckVersionResponse(data, false)) {
+        return false;
+    }
+
+    // 应答缓存:设备已激活且没有待升级固件时把原始应答存进NVS,下次
+    // 冷启动可直接用缓存结果,不用等版本接口。Http封装读不到响应头,
+    // 做不了真正的ETag/If-None-Match,用"缓存+进Idle后后台复核"代替
+    Settings settings("ota", true);
+    if (!has_activation_code_ && !has_activation_challenge_ && !has_new_version_) {
+        // 存成blob,绕开NVS字符串4000字节的上限
+        settings.SetBlob("check_cache", data.data(), data.size());
+        settings.SetInt("check_cache_ts", (int)time(NULL));
+    } else {
+        settings.EraseKey("check_cache");
+    }
+    return true;
+}
+
+// 用上次缓存的版本应答完成检查,不发网络请求。命中返回true;
+// 无缓存/已过期/缓存里带激活要求时返回false,调用方走正常网络检查
+bool Ota::CheckVersionFromCache() {
+    auto app_desc = esp_app_get_description();
+    current_version_ = app_desc->version;
+
+    Settings settings("ota", false);
+    std::string data = settings.GetBlob("check_cache");
+    if (data.empty()) {
+        return false;
+    }
+
+    // 墙钟没同步过(冷上电)时age会算出离谱的值,自然落回网络检查
+    int64_t age = (int64_t)time(NULL) - settings.GetInt("check_cache_ts");
+    if (age < 0 || age > 24 * 3600) {
+        ESP_LOGI(TAG, "Version cache expired, falling back to network check");
+        return false;
+    }
+
+    if (!ParseCheckVersionResponse(data, true)) {
+        return false;
+    }
+    // 缓存只在无激活要求时写入,解析出激活段说明内容异常,不信任
+    if (has_activation_code_ || has_activation_challenge_) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Version check served from cached response (age %llds)", (long long)age);
+    return true;
+}
+
+bool Ota::ParseCheckVersionResponse(const std::string& data, bool from_cache) {
     // Response: { "firmware": { "version": "1.0.0", "url": "http://" } }
     // Parse the JSON response and check if the version is newer
     // If it is, set has_new_version_ to true and store the new version and URL
-    
+
     cJSON *root = cJSON_Parse(data.c_str());
     if (root == NULL) {
         ESP_LOGE(TAG, "Failed to parse JSON response");
@@ -183,7 +324,10 @@ bool Ota::CheckVersion() {
 
     has_server_time_ = false;
     cJSON *server_time = cJSON_GetObjectItem(root, "server_time");
-    if (cJSON_IsObject(server_time)) {
+    if (from_cache) {
+        // 缓存里的时间戳是上次请求时刻的,不能拿来settimeofday,
+        // 等后台复核拿到新鲜应答再校时
+    } else if (cJSON_IsObject(server_time)) {
         cJSON *timestamp = cJSON_GetObjectItem(server_time, "timestamp");
         cJSON *timezone_offset = cJSON_GetObjectItem(server_time, "timezone_offset");
         
@@ -217,6 +361,12 @@ bool Ota::CheckVersion() {
         if (cJSON_IsString(url)) {
             firmware_url_ = url->valuestring;
         }
+        // 服务器根据上报的当前版本可选下发增量补丁(bsdiff),没有则走完整镜像
+        firmware_patch_url_.clear();
+        cJSON *patch_url = cJSON_GetObjectItem(firmware, "patch_url");
+        if (cJSON_IsString(patch_url)) {
+            firmware_patch_url_ = patch_url->valuestring;
+        }
 
         if (cJSON_IsString(version) && cJSON_IsString(url)) {
             // Check if the version is newer, for example, 0.1.0 is newer than 0.0.1
@@ -260,9 +410,23 @@ void Ota::MarkCurrentVersionValid() {
     }
 }
 
+// 重新计算分区上已写入区间的CRC,断点续传前校验旧数据是否完好
+static uint32_t CalculatePartitionCrc(const esp_partition_t* partition, size_t length) {
+    auto buffer = std::make_unique<uint8_t[]>(4096);
+    uint32_t crc = 0;
+    for (size_t offset = 0; offset < length;) {
+        size_t chunk = std::min(length - offset, (size_t)4096);
+        if (esp_partition_read(partition, offset, buffer.get(), chunk) != ESP_OK) {
+            return 0;
+        }
+        crc = esp_crc32_le(crc, buffer.get(), chunk);
+        offset += chunk;
+    }
+    return crc;
+}
+
 bool Ota::Upgrade(const std::string& firmware_url) {
     ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
-    esp_ota_handle_t update_handle = 0;
     auto update_partition = esp_ota_get_next_update_partition(NULL);
     if (update_partition == NULL) {
         ESP_LOGE(TAG, "Failed to get update partition");
@@ -270,18 +434,51 @@ bool Ota::Upgrade(const std::string& firmware_url) {
     }
 
     ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, update_partition->address);
-    bool image_header_checked = false;
+
+    // 断点续传:进度按扇区边界保存(偏移 + 已写区间CRC),URL变了或CRC对不上就从头下载。
+    // Http封装拿不到响应头,所以用URL+flash回读CRC代替etag来判定旧数据是否可续
+    size_t resume_offset = 0;
+    uint32_t resume_crc = 0;
+    {
+        Settings settings("download", false);
+        if (settings.GetString("ota_url") == firmware_url) {
+            size_t saved_offset = (size_t)settings.GetInt("ota_offset");
+            uint32_t saved_crc = (uint32_t)settings.GetInt("ota_crc");
+            if (saved_offset > 0 && saved_offset <= update_partition->size) {
+                uint32_t crc = CalculatePartitionCrc(update_partition, saved_offset);
+                if (crc == saved_crc) {
+                    resume_offset = saved_offset;
+                    resume_crc = saved_crc;
+                    ESP_LOGI(TAG, "Resuming upgrade from offset %u", resume_offset);
+                } else {
+                    ESP_LOGW(TAG, "Stale resume data (crc mismatch), restarting download");
+                }
+            }
+        }
+    }
+
+    bool image_header_checked = resume_offset > 0;  // 续传时镜像头早已写入
     std::string image_header;
 
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(0);
+    auto http = HttpPool::GetInstance().Acquire("ota_firmware", firmware_url);
+    if (resume_offset > 0) {
+        http->SetHeader("Range", "bytes=" + std::to_string(resume_offset) + "-");
+    }
     if (!http->Open("GET", firmware_url)) {
         ESP_LOGE(TAG, "Failed to open HTTP connection");
         return false;
     }
 
-    if (http->GetStatusCode() != 200) {
-        ESP_LOGE(TAG, "Failed to get firmware, status code: %d", http->GetStatusCode());
+    int status_code = http->GetStatusCode();
+    if (status_code == 200) {
+        if (resume_offset > 0) {
+            ESP_LOGW(TAG, "Server does not support range requests, restarting download");
+            resume_offset = 0;
+            resume_crc = 0;
+            image_header_checked = false;
+        }
+    } else if (!(status_code == 206 && resume_offset > 0)) {
+        ESP_LOGE(TAG, "Failed to get firmware, status code: %d", status_code);
         return false;
     }
 
@@ -290,15 +487,267 @@ bool Ota::Upgrade(const std::string& firmware_url) {
         ESP_LOGE(TAG, "Failed to get content length");
         return false;
     }
+    size_t total_size = resume_offset + content_length;
+    if (total_size > update_partition->size) {
+        ESP_LOGE(TAG, "Firmware size (%u) is larger than partition size (%lu)", total_size, update_partition->size);
+        return false;
+    }
+
+    // 双缓冲流水线:网络侧填一块的同时写入线程刷另一块,下载和擦写互相重叠,
+    // 擦除卡顿不再反压到socket上
+    static constexpr size_t kOtaBufferSize = 4096;
+    struct PipelineBuffer {
+        std::unique_ptr<uint8_t[]> data;
+        size_t len = 0;
+        bool full = false;
+    };
+    PipelineBuffer buffers[2];
+    for (auto& b : buffers) {
+        b.data = std::make_unique<uint8_t[]>(kOtaBufferSize);
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool download_done = false;
+    esp_err_t write_error = ESP_OK;
+
+    // 断点续传需要任意偏移写入,改用esp_partition_*裸写;
+    // 镜像完整性由最后esp_ota_set_boot_partition的校验兜底
+    static constexpr size_t kProgressSaveInterval = 64 * 1024;
+    const size_t sector_size = esp_partition_get_main_flash_sector_size();
+
+    std::thread writer([&]() {
+        // 预擦除剩余区间,与下载起步阶段重叠;续传偏移保存时保证扇区对齐,
+        // 已写好的数据不会被碰到
+        size_t erase_size = (total_size - resume_offset + sector_size - 1) / sector_size * sector_size;
+        if (resume_offset + erase_size > update_partition->size) {
+            erase_size = update_partition->size - resume_offset;
+        }
+        // 切片擦除:预擦几MB不再一口气挂起cache,升级中的提示音不破音
+        esp_err_t err = FlashScheduler::GetInstance().EraseRange(
+            update_partition, resume_offset, erase_size, FlashScheduler::Urgency::kForeground);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to erase update partition: %s", esp_err_to_name(err));
+            std::lock_guard<std::mutex> lock(mutex);
+            write_error = err;
+            cv.notify_all();
+            return;
+        }
+
+        size_t write_offset = resume_offset;
+        size_t last_saved_offset = resume_offset;
+        uint32_t crc = resume_crc;
+        int index = 0;
+        while (true) {
+            size_t len;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]() { return buffers[index].full || download_done || write_error != ESP_OK; });
+                if (write_error != ESP_OK || !buffers[index].full) {
+                    break;  // 出错或下载结束且已排空
+                }
+                len = buffers[index].len;
+            }
+
+            err = esp_partition_write(update_partition, write_offset, buffers[index].data.get(), len);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
+                std::lock_guard<std::mutex> lock(mutex);
+                write_error = err;
+                cv.notify_all();
+                break;
+            }
+            crc = esp_crc32_le(crc, buffers[index].data.get(), len);
+            write_offset += len;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffers[index].full = false;
+            }
+            cv.notify_all();
+            index ^= 1;
+
+            // 每写满64KB且落在扇区边界时持久化一次断点,限制NVS磨损
+            if (write_offset % sector_size == 0 && write_offset - last_saved_offset >= kProgressSaveInterval) {
+                Settings settings("download", true);
+                settings.SetString("ota_url", firmware_url);
+                settings.SetInt("ota_offset", (int32_t)write_offset);
+                settings.SetInt("ota_crc", (int32_t)crc);
+                last_saved_offset = write_offset;
+            }
+        }
+    });
+
+    size_t downloaded = 0, recent_read = 0;
+    auto last_calc_time = esp_timer_get_time();
+    int index = 0;
+    bool download_failed = false;
+    bool eof = false;
+    while (!eof) {
+        {
+            // 等当前缓冲被写入线程取走
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return !buffers[index].full || write_error != ESP_OK; });
+            if (write_error != ESP_OK) {
+                download_failed = true;
+                break;
+            }
+        }
+
+        // 尽量把整块缓冲读满,保证写入偏移始终扇区对齐(断点保存依赖这一点)
+        size_t filled = 0;
+        while (filled < kOtaBufferSize) {
+            int ret = http->Read((char*)buffers[index].data.get() + filled, kOtaBufferSize - filled);
+            if (ret < 0) {
+                ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
+                download_failed = true;
+                break;
+            }
+            if (ret == 0) {
+                eof = true;
+                break;
+            }
+            filled += ret;
+
+            // Calculate speed and progress every second
+            recent_read += ret;
+            downloaded += ret;
+            if (esp_timer_get_time() - last_calc_time >= 1000000) {
+                size_t progress = (resume_offset + downloaded) * 100 / total_size;
+                ESP_LOGI(TAG, "Progress: %u%% (%u/%u), Speed: %uB/s", progress, resume_offset + downloaded, total_size, recent_read);
+                if (upgrade_callback_) {
+                    upgrade_callback_(progress, recent_read);
+                }
+                last_calc_time = esp_timer_get_time();
+                recent_read = 0;
+            }
+        }
+        if (download_failed || filled == 0) {
+            break;
+        }
+
+        if (!image_header_checked) {
+            image_header.append((char*)buffers[index].data.get(), filled);
+            if (image_header.size() >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
+                esp_app_desc_t new_app_info;
+                memcpy(&new_app_info, image_header.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
+
+                auto current_version = esp_app_get_description()->version;
+                ESP_LOGI(TAG, "Current version: %s, New version: %s", current_version, new_app_info.version);
+
+                image_header_checked = true;
+                std::string().swap(image_header);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers[index].len = filled;
+            buffers[index].full = true;
+        }
+        cv.notify_all();
+        index ^= 1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        download_done = true;
+    }
+    cv.notify_all();
+    writer.join();
+    http->Close();
+
+    if (download_failed || write_error != ESP_OK || resume_offset + downloaded != total_size) {
+        // 断点已周期性落盘,下次对同一URL可从最近的保存点续传
+        ESP_LOGE(TAG, "Upgrade download incomplete (%u/%u)", resume_offset + downloaded, total_size);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Progress: 100%% (%u/%u)", total_size, total_size);
+    if (upgrade_callback_) {
+        upgrade_callback_(100, recent_read);
+    }
+
+    // 下载完成,清除断点状态(置0即可,续传判断要求offset>0)
+    {
+        Settings settings("download", true);
+        settings.SetInt("ota_offset", 0);
+    }
+
+    // esp_ota_set_boot_partition内部会对分区做完整的镜像校验,
+    // 等价于之前esp_ota_end的验证
+    esp_err_t err = esp_ota_set_boot_partition(update_partition);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Firmware upgrade successful");
+    return true;
+}
+
+// 增量补丁回调没有用户指针,走文件级上下文(同一时刻只会有一个升级在进行)
+static const esp_partition_t* delta_src_partition_ = nullptr;
+static esp_ota_handle_t delta_update_handle_ = 0;
+
+static esp_err_t DeltaOtaReadCallback(uint8_t* buf, size_t size, int src_offset) {
+    return esp_partition_read(delta_src_partition_, src_offset, buf, size);
+}
+
+static esp_err_t DeltaOtaWriteCallback(uint8_t* buf, size_t size, int dest_offset) {
+    // 补丁按顺序重建镜像,dest_offset单调递增,顺序写即可
+    return esp_ota_write(delta_update_handle_, buf, size);
+}
+
+bool Ota::UpgradeFromPatch(const std::string& patch_url) {
+    ESP_LOGI(TAG, "Upgrading firmware from patch %s", patch_url.c_str());
+    auto src_partition = esp_ota_get_running_partition();
+    auto update_partition = esp_ota_get_next_update_partition(NULL);
+    if (src_partition == NULL || update_partition == NULL) {
+        ESP_LOGE(TAG, "Failed to get partitions for delta upgrade");
+        return false;
+    }
+
+    auto http = HttpPool::GetInstance().Acquire("ota_firmware", patch_url);
+    if (!http->Open("GET", patch_url)) {
+        ESP_LOGE(TAG, "Failed to open HTTP connection");
+        return false;
+    }
+    if (http->GetStatusCode() != 200) {
+        ESP_LOGE(TAG, "Failed to get patch, status code: %d", http->GetStatusCode());
+        return false;
+    }
+    size_t content_length = http->GetBodyLength();
+    if (content_length == 0) {
+        ESP_LOGE(TAG, "Failed to get content length");
+        return false;
+    }
+
+    if (esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &delta_update_handle_) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to begin OTA");
+        return false;
+    }
+    delta_src_partition_ = src_partition;
+
+    esp_delta_ota_cfg_t cfg = {};
+    cfg.read_cb = DeltaOtaReadCallback;
+    cfg.write_cb = DeltaOtaWriteCallback;
+    auto delta_handle = esp_delta_ota_init(&cfg);
+    if (delta_handle == NULL) {
+        ESP_LOGE(TAG, "Failed to init delta OTA");
+        esp_ota_abort(delta_update_handle_);
+        return false;
+    }
 
     char buffer[512];
     size_t total_read = 0, recent_read = 0;
     auto last_calc_time = esp_timer_get_time();
+    bool patch_ok = true;
     while (true) {
         int ret = http->Read(buffer, sizeof(buffer));
         if (ret < 0) {
             ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
-            return false;
+            patch_ok = false;
+            break;
         }
 
         // Calculate speed and progress every second
@@ -306,7 +755,7 @@ bool Ota::Upgrade(const std::string& firmware_url) {
         total_read += ret;
         if (esp_timer_get_time() - last_calc_time >= 1000000 || ret == 0) {
             size_t progress = total_read * 100 / content_length;
-            ESP_LOGI(TAG, "Progress: %u%% (%u/%u), Speed: %uB/s", progress, total_read, content_length, recent_read);
+            ESP_LOGI(TAG, "Patch progress: %u%% (%u/%u), Speed: %uB/s", progress, total_read, content_length, recent_read);
             if (upgrade_callback_) {
                 upgrade_callback_(progress, recent_read);
             }
@@ -318,35 +767,28 @@ bool Ota::Upgrade(const std::string& firmware_url) {
             break;
         }
 
-        if (!image_header_checked) {
-            image_header.append(buffer, ret);
-            if (image_header.size() >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
-                esp_app_desc_t new_app_info;
-                memcpy(&new_app_info, image_header.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
-                
-                auto current_version = esp_app_get_description()->version;
-                ESP_LOGI(TAG, "Current version: %s, New version: %s", current_version, new_app_info.version);
-
-                if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle)) {
-                    esp_ota_abort(update_handle);
-                    ESP_LOGE(TAG, "Failed to begin OTA");
-                    return false;
-                }
-
-                image_header_checked = true;
-                std::string().swap(image_header);
-            }
-        }
-        auto err = esp_ota_write(update_handle, buffer, ret);
+        esp_err_t err = esp_delta_ota_feed_patch(delta_handle, (const uint8_t*)buffer, ret);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
-            esp_ota_abort(update_handle);
-            return false;
+            ESP_LOGE(TAG, "Failed to apply patch data: %s", esp_err_to_name(err));
+            patch_ok = false;
+            break;
         }
     }
     http->Close();
 
-    esp_err_t err = esp_ota_end(update_handle);
+    if (patch_ok && esp_delta_ota_finalize(delta_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to finalize delta OTA");
+        patch_ok = false;
+    }
+    esp_delta_ota_deinit(delta_handle);
+    delta_src_partition_ = nullptr;
+
+    if (!patch_ok) {
+        esp_ota_abort(delta_update_handle_);
+        return false;
+    }
+
+    esp_err_t err = esp_ota_end(delta_update_handle_);
     if (err != ESP_OK) {
         if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
             ESP_LOGE(TAG, "Image validation failed, image is corrupted");
@@ -362,12 +804,19 @@ bool Ota::Upgrade(const std::string& firmware_url) {
         return false;
     }
 
-    ESP_LOGI(TAG, "Firmware upgrade successful");
+    ESP_LOGI(TAG, "Firmware upgrade successful (delta)");
     return true;
 }
 
 bool Ota::StartUpgrade(std::function<void(int progress, size_t speed)> callback) {
     upgrade_callback_ = callback;
+    // 优先走增量补丁,失败(补丁基准不符、链路中断等)再回退完整镜像
+    if (!firmware_patch_url_.empty()) {
+        if (UpgradeFromPatch(firmware_patch_url_)) {
+            return true;
+        }
+        ESP_LOGW(TAG, "Delta upgrade failed, falling back to full image");
+    }
     return Upgrade(firmware_url_);
 }
 
@@ -6,6 +6,7 @@
 
 #include <esp_err.h>
 #include "board.h"
+#include "http_pool.h"
 
 class Ota {
 public:
@@ -13,6 +14,7 @@ public:
     ~Ota();
 
     bool CheckVersion();
+    bool CheckVersionFromCache();
     esp_err_t Activate();
     bool HasActivationChallenge() { return has_activation_challenge_; }
     bool HasNewVersion() { return has_new_version_; }
@@ -23,6 +25,7 @@ public:
     bool StartUpgrade(std::function<void(int progress, size_t speed)> callback);
     bool StartUpgradeFromUrl(const std::string& url, std::function<void(int progress, size_t speed)> callback);
     void MarkCurrentVersionValid();
+    bool UploadCoreDump();
 
     const std::string& GetFirmwareVersion() const { return firmware_version_; }
     const std::string& GetCurrentVersion() const { return current_version_; }
@@ -44,16 +47,19 @@ private:
     std::string current_version_;
     std::string firmware_version_;
     std::string firmware_url_;
+    std::string firmware_patch_url_;
     std::string activation_challenge_;
     std::string serial_number_;
     int activation_timeout_ms_ = 30000;
 
+    bool ParseCheckVersionResponse(const std::string& data, bool from_cache);
     bool Upgrade(const std::string& firmware_url);
+    bool UpgradeFromPatch(const std::string& patch_url);
     std::function<void(int progress, size_t speed)> upgrade_callback_;
     std::vector<int> ParseVersion(const std::string& version);
     bool IsNewVersionAvailable(const std::string& currentVersion, const std::string& newVersion);
     std::string GetActivationPayload();
-    std::unique_ptr<Http> SetupHttp();
+    PooledHttp SetupHttp();
 };
 
 #endif // _OTA_H
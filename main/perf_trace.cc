@@ -0,0 +1,81 @@
+#include "perf_trace.h"
+
+#if CONFIG_PERF_TRACE
+
+#include <atomic>
+
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+#include <driver/gpio.h>
+#include <cJSON.h>
+
+namespace perf_trace {
+namespace {
+
+// 8字节/条,512条静态环 = 4KB DRAM;热路径只做一次fetch_add加两次写
+struct Event {
+    uint32_t cycles;
+    uint8_t probe;
+};
+
+constexpr uint32_t kRingSize = 512;  // 2的幂,索引直接按位与
+Event g_ring[kRingSize];
+std::atomic<uint32_t> g_write_index{0};
+
+#if CONFIG_PERF_TRACE_GPIO >= 0
+bool InitGpio() {
+    gpio_config_t config = {};
+    config.pin_bit_mask = 1ULL << CONFIG_PERF_TRACE_GPIO;
+    config.mode = GPIO_MODE_OUTPUT;
+    gpio_config(&config);
+    return true;
+}
+#endif
+
+}  // namespace
+
+void Record(PerfProbe probe) {
+    uint32_t index = g_write_index.fetch_add(1, std::memory_order_relaxed);
+    auto& event = g_ring[index & (kRingSize - 1)];
+    event.cycles = esp_cpu_get_cycle_count();
+    event.probe = probe;
+
+#if CONFIG_PERF_TRACE_GPIO >= 0
+    // 每次命中翻转一次:逻辑分析仪上每条边对应一个探针事件,
+    // 与环形缓冲里的周期数序列逐边对齐
+    static bool gpio_ready = InitGpio();
+    (void)gpio_ready;
+    static uint32_t toggle = 0;
+    gpio_set_level((gpio_num_t)CONFIG_PERF_TRACE_GPIO, ++toggle & 1);
+#endif
+}
+
+std::string DumpJson() {
+    // 无锁快照:先抓索引再读环,追尾的少数几条可能是撕裂数据,
+    // 对离线分析可接受(周期数不单调即可识别)
+    uint32_t end = g_write_index.load(std::memory_order_relaxed);
+    uint32_t count = end < kRingSize ? end : kRingSize;
+    uint32_t start = end - count;
+
+    auto root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "cpu_mhz", esp_rom_get_cpu_ticks_per_us());
+    auto events = cJSON_CreateArray();
+    for (uint32_t i = start; i < end; i++) {
+        auto& event = g_ring[i & (kRingSize - 1)];
+        auto entry = cJSON_CreateArray();
+        cJSON_AddItemToArray(entry, cJSON_CreateNumber(event.probe));
+        cJSON_AddItemToArray(entry, cJSON_CreateNumber(event.cycles));
+        cJSON_AddItemToArray(events, entry);
+    }
+    cJSON_AddItemToObject(root, "events", events);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
+
+}  // namespace perf_trace
+
+#endif  // CONFIG_PERF_TRACE
@@ -0,0 +1,42 @@
+#ifndef PERF_TRACE_H
+#define PERF_TRACE_H
+
+#include <cstdint>
+
+// 热路径打点:在采集读取、Opus编码前后、LVGL flush前后、DMA播放写入、
+// socket发送处埋标准化探针。开启CONFIG_PERF_TRACE后每次命中把CPU周期数
+// 记进无锁环形缓冲(MCP工具self.trace.dump导出),配置了PERF_TRACE_GPIO
+// 时同时翻转该引脚供逻辑分析仪抓时序。关闭时宏展开为空,零开销。
+// 探针ID跨子系统固定,抓出来的时间线可以跨固件版本对齐比较
+enum PerfProbe : uint8_t {
+    kProbeCaptureRead = 0,   // 采集:从codec DMA读出一帧
+    kProbeEncodeStart,       // Opus编码开始
+    kProbeEncodeEnd,         // Opus编码完成
+    kProbeFlushStart,        // LVGL把渲染好的区域交给面板
+    kProbeFlushFinish,       // 面板传输完成归还缓冲
+    kProbePlaybackWrite,     // 播放:PCM写入codec DMA(阻塞处)
+    kProbeSocketSend,        // 音频包进入传输层发送
+    kProbeCount
+};
+
+#if CONFIG_PERF_TRACE
+
+#include <string>
+
+namespace perf_trace {
+// 任意任务上下文可调用:记录CPU周期数进环形缓冲,并翻转跟踪GPIO
+void Record(PerfProbe probe);
+// 导出最近的打点(JSON):{"cpu_mhz":..,"events":[[probe,cycles],..]},
+// events按记录顺序,cycles为esp_cpu_get_cycle_count原始值
+std::string DumpJson();
+}  // namespace perf_trace
+
+#define PERF_TRACE_PROBE(p) perf_trace::Record(p)
+
+#else
+
+#define PERF_TRACE_PROBE(p) ((void)0)
+
+#endif  // CONFIG_PERF_TRACE
+
+#endif  // PERF_TRACE_H
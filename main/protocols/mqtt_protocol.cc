@@ -2,6 +2,8 @@
 #include "board.h"
 #include "application.h"
 #include "settings.h"
+#include "json_arena.h"
+#include "perf_trace.h"
 
 #include <esp_log.h>
 #include <cstring>
@@ -76,6 +78,7 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     mqtt_->SetKeepAlive(keepalive_interval);
 
     mqtt_->OnDisconnected([this]() {
+        network_stats_.reconnect_count++;
         if (on_disconnected_ != nullptr) {
             on_disconnected_();
         }
@@ -91,15 +94,24 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     });
 
     mqtt_->OnMessage([this](const std::string& topic, const std::string& payload) {
+        AccountIncoming(payload.size());
+        /* 解析树和处理期间的临时分配落在arena里,消息结束O(1)回收 */
+        bool arena = JsonArena::Begin(payload.size() * 3 + 512);
         cJSON* root = cJSON_Parse(payload.c_str());
         if (root == nullptr) {
             ESP_LOGE(TAG, "Failed to parse json message %s", payload.c_str());
+            if (arena) {
+                JsonArena::End();
+            }
             return;
         }
         cJSON* type = cJSON_GetObjectItem(root, "type");
         if (!cJSON_IsString(type)) {
             ESP_LOGE(TAG, "Message type is invalid");
             cJSON_Delete(root);
+            if (arena) {
+                JsonArena::End();
+            }
             return;
         }
 
@@ -113,10 +125,15 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
                     CloseAudioChannel();
                 });
             }
-        } else if (on_incoming_json_ != nullptr) {
-            on_incoming_json_(root);
+        } else if (!HandleMcpChunk(root)) {
+            if (on_incoming_json_ != nullptr) {
+                on_incoming_json_(root);
+            }
         }
         cJSON_Delete(root);
+        if (arena) {
+            JsonArena::End();
+        }
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
@@ -140,7 +157,7 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     return true;
 }
 
-bool MqttProtocol::SendText(const std::string& text) {
+bool MqttProtocol::SendText(std::string text) {
     if (publish_topic_.empty()) {
         return false;
     }
@@ -149,33 +166,41 @@ bool MqttProtocol::SendText(const std::string& text) {
         SetError(Lang::Strings::SERVER_ERROR);
         return false;
     }
+    AccountOutgoing(text.size());
     return true;
 }
 
 bool MqttProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+    PERF_TRACE_PROBE(kProbeSocketSend);
     std::lock_guard<std::mutex> lock(channel_mutex_);
     if (udp_ == nullptr) {
         return false;
     }
 
-    std::string nonce(aes_nonce_);
-    *(uint16_t*)&nonce[2] = htons(packet->payload.size());
-    *(uint32_t*)&nonce[8] = htonl(packet->timestamp);
-    *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
+    // 头部直接写进复用的发送缓冲区,CTR 计数器用栈上副本,稳态不再分配堆内存
+    size_t header_size = aes_nonce_.size();
+    send_buffer_.resize(header_size + packet->payload.size());
+    memcpy(send_buffer_.data(), aes_nonce_.data(), header_size);
+    *(uint16_t*)&send_buffer_[2] = htons(packet->payload.size());
+    *(uint32_t*)&send_buffer_[8] = htonl(packet->timestamp);
+    *(uint32_t*)&send_buffer_[12] = htonl(++local_sequence_);
 
-    std::string encrypted;
-    encrypted.resize(aes_nonce_.size() + packet->payload.size());
-    memcpy(encrypted.data(), nonce.data(), nonce.size());
+    uint8_t nonce_counter[16];
+    memcpy(nonce_counter, send_buffer_.data(), sizeof(nonce_counter));
 
     size_t nc_off = 0;
     uint8_t stream_block[16] = {0};
-    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet->payload.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
-        (uint8_t*)packet->payload.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet->payload.size(), &nc_off, nonce_counter, stream_block,
+        (uint8_t*)packet->payload.data(), (uint8_t*)&send_buffer_[header_size]) != 0) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
         return false;
     }
 
-    return udp_->Send(encrypted) > 0;
+    if (udp_->Send(send_buffer_) <= 0) {
+        return false;
+    }
+    AccountOutgoing(send_buffer_.size());
+    return true;
 }
 
 void MqttProtocol::CloseAudioChannel() {
@@ -224,6 +249,7 @@ bool MqttProtocol::OpenAudioChannel() {
     auto network = Board::GetInstance().GetNetwork();
     udp_ = network->CreateUdp(2);
     udp_->OnMessage([this](const std::string& data) {
+        AccountIncoming(data.size());
         /*
          * UDP Encrypted OPUS Packet Format:
          * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
@@ -245,6 +271,10 @@ bool MqttProtocol::OpenAudioChannel() {
         }
         if (sequence != remote_sequence_ + 1) {
             ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+            if (remote_sequence_ > 0) {
+                // 序列号空洞计为下行丢包,自测工具和会话统计都用它
+                network_stats_.packets_lost += sequence - remote_sequence_ - 1;
+            }
         }
 
         size_t decrypted_size = data.size() - aes_nonce_.size();
@@ -256,8 +286,9 @@ bool MqttProtocol::OpenAudioChannel() {
         packet->sample_rate = server_sample_rate_;
         packet->frame_duration = server_frame_duration_;
         packet->timestamp = timestamp;
+        packet->sequence = sequence;
         packet->payload.resize(decrypted_size);
-        int ret = mbedtls_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, nonce, stream_block, encrypted, (uint8_t*)packet->payload.data());
+        int ret = mbedtls_aes_crypt_ctr(&aes_rx_ctx_, decrypted_size, &nc_off, nonce, stream_block, encrypted, (uint8_t*)packet->payload.data());
         if (ret != 0) {
             ESP_LOGE(TAG, "Failed to decrypt audio data, ret: %d", ret);
             return;
@@ -270,6 +301,7 @@ bool MqttProtocol::OpenAudioChannel() {
     });
 
     udp_->Connect(udp_server_, udp_port_);
+    network_stats_.channel_open_count++;
 
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
@@ -288,6 +320,8 @@ std::string MqttProtocol::GetHelloMessage() {
     cJSON_AddBoolToObject(features, "aec", true);
 #endif
     cJSON_AddBoolToObject(features, "mcp", true);
+    // 支持MCP大报文分块重组;服务器在hello里回声明后出站也启用分块
+    cJSON_AddBoolToObject(features, "mcp_chunking", true);
     cJSON_AddItemToObject(root, "features", features);
     cJSON* audio_params = cJSON_CreateObject();
     cJSON_AddStringToObject(audio_params, "format", "opus");
@@ -315,6 +349,12 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
         ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
     }
 
+    // 服务器回声明mcp_chunking后,超过单段上限的出站MCP报文才拆段发送
+    auto server_features = cJSON_GetObjectItem(root, "features");
+    if (cJSON_IsObject(server_features)) {
+        mcp_chunking_supported_ = cJSON_IsTrue(cJSON_GetObjectItem(server_features, "mcp_chunking"));
+    }
+
     // Get sample rate from hello message
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
     if (cJSON_IsObject(audio_params)) {
@@ -341,8 +381,13 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
     // auto encryption = cJSON_GetObjectItem(udp, "encryption")->valuestring;
     // ESP_LOGI(TAG, "UDP server: %s, port: %d, encryption: %s", udp_server_.c_str(), udp_port_, encryption);
     aes_nonce_ = DecodeHexString(nonce);
+    // 收发各一个会话级上下文,密钥只在hello时装一次;CTR两个方向都用
+    // 加密密钥调度,硬件AES(mbedtls port)按上下文持有密钥
+    std::string aes_key = DecodeHexString(key);
     mbedtls_aes_init(&aes_ctx_);
-    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
+    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)aes_key.c_str(), 128);
+    mbedtls_aes_init(&aes_rx_ctx_);
+    mbedtls_aes_setkey_enc(&aes_rx_ctx_, (const unsigned char*)aes_key.c_str(), 128);
     local_sequence_ = 0;
     remote_sequence_ = 0;
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
@@ -40,10 +40,17 @@ private:
     std::mutex channel_mutex_;
     std::unique_ptr<Mqtt> mqtt_;
     std::unique_ptr<Udp> udp_;
+    // 每个方向一个常驻上下文:发送侧在channel_mutex_下用aes_ctx_,
+    // 接收侧在UDP回调任务里用aes_rx_ctx_。两个任务不共享硬件AES上下文,
+    // 也就不需要为解密路径加锁
     mbedtls_aes_context aes_ctx_;
+    mbedtls_aes_context aes_rx_ctx_;
     std::string aes_nonce_;
     std::string udp_server_;
     int udp_port_;
+    // Reused across frames so the steady-state uplink costs one buffer write
+    // per frame instead of two heap allocations (guarded by channel_mutex_)
+    std::string send_buffer_;
     uint32_t local_sequence_;
     uint32_t remote_sequence_;
     esp_timer_handle_t reconnect_timer_;
@@ -52,7 +59,7 @@ private:
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
 
-    bool SendText(const std::string& text) override;
+    bool SendText(std::string text) override;
     std::string GetHelloMessage();
 };
 
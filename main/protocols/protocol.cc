@@ -1,6 +1,11 @@
 #include "protocol.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cstring>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #define TAG "Protocol"
 
@@ -8,8 +13,8 @@ void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
 
-void Protocol::OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback) {
-    on_incoming_audio_ = callback;
+void Protocol::OnIncomingAudio(FixedCallback<void(std::unique_ptr<AudioStreamPacket> packet)> callback) {
+    on_incoming_audio_ = std::move(callback);
 }
 
 void Protocol::OnAudioChannelOpened(std::function<void()> callback) {
@@ -45,13 +50,13 @@ void Protocol::SendAbortSpeaking(AbortReason reason) {
         message += ",\"reason\":\"wake_word_detected\"";
     }
     message += "}";
-    SendText(message);
+    SendText(std::move(message));
 }
 
 void Protocol::SendWakeWordDetected(const std::string& wake_word) {
     std::string json = "{\"session_id\":\"" + session_id_ + 
                       "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" + wake_word + "\"}";
-    SendText(json);
+    SendText(std::move(json));
 }
 
 void Protocol::SendStartListening(ListeningMode mode) {
@@ -65,17 +70,217 @@ void Protocol::SendStartListening(ListeningMode mode) {
         message += ",\"mode\":\"manual\"";
     }
     message += "}";
-    SendText(message);
+    SendText(std::move(message));
 }
 
 void Protocol::SendStopListening() {
     std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"listen\",\"state\":\"stop\"}";
-    SendText(message);
+    SendText(std::move(message));
 }
 
-void Protocol::SendMcpMessage(const std::string& payload) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"mcp\",\"payload\":" + payload + "}";
-    SendText(message);
+void Protocol::SendMcpMessage(std::string payload) {
+    if (mcp_chunking_supported_ && payload.size() > kMcpChunkBytes) {
+        SendMcpChunked(payload);
+        return;
+    }
+    // 外层信封原地包上去:头部insert用的是payload预留的余量,
+    // 几百KB的图片结果不再整串复制一次
+    payload.insert(0, "{\"session_id\":\"" + session_id_ + "\",\"type\":\"mcp\",\"payload\":");
+    payload += "}";
+    SendText(std::move(payload));
+}
+
+/* 出站分块:按kMcpChunkBytes切段,每段独立成帧。传输侧的峰值内存从整条
+ * 报文的信封副本降到单段大小,大响应(base64图片)不再要求对端单帧接收 */
+void Protocol::SendMcpChunked(const std::string& payload) {
+    uint32_t id = ++mcp_tx_id_;
+    uint32_t seq = 0;
+    for (size_t offset = 0; offset < payload.size(); offset += kMcpChunkBytes, seq++) {
+        size_t len = std::min(kMcpChunkBytes, payload.size() - offset);
+        bool final_chunk = offset + len >= payload.size();
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "session_id", session_id_.c_str());
+        cJSON_AddStringToObject(root, "type", "mcp_chunk");
+        cJSON_AddNumberToObject(root, "id", id);
+        cJSON_AddNumberToObject(root, "seq", seq);
+        cJSON_AddBoolToObject(root, "final", final_chunk);
+        // 片段是任意切开的JSON文本,交给cJSON做字符串转义
+        cJSON_AddStringToObject(root, "payload", std::string(payload, offset, len).c_str());
+        char* json_str = cJSON_PrintUnformatted(root);
+        std::string text(json_str);
+        cJSON_free(json_str);
+        cJSON_Delete(root);
+        SendText(std::move(text));
+    }
+}
+
+/* 入站重组:按(id,seq)顺序累积片段,乱序或超限即丢弃整条流(发端会重试
+ * 或降级整发)。终段到达后解析重组结果,包装成常规mcp信封交给上层 */
+bool Protocol::HandleMcpChunk(const cJSON* root) {
+    auto type = cJSON_GetObjectItem(root, "type");
+    if (!cJSON_IsString(type) || strcmp(type->valuestring, "mcp_chunk") != 0) {
+        return false;
+    }
+    auto id = cJSON_GetObjectItem(root, "id");
+    auto seq = cJSON_GetObjectItem(root, "seq");
+    auto part = cJSON_GetObjectItem(root, "payload");
+    if (!cJSON_IsNumber(id) || !cJSON_IsNumber(seq) || !cJSON_IsString(part)) {
+        ESP_LOGE(TAG, "Malformed mcp_chunk message");
+        return true;
+    }
+    if ((uint32_t)seq->valueint == 0) {
+        mcp_rx_id_ = (uint32_t)id->valueint;
+        mcp_rx_next_seq_ = 0;
+        mcp_reassembly_.clear();
+    }
+    if ((uint32_t)id->valueint != mcp_rx_id_ || (uint32_t)seq->valueint != mcp_rx_next_seq_) {
+        ESP_LOGE(TAG, "mcp_chunk out of order (id %d seq %d, expected id %lu seq %lu), dropping stream",
+                 id->valueint, seq->valueint, (unsigned long)mcp_rx_id_, (unsigned long)mcp_rx_next_seq_);
+        std::string().swap(mcp_reassembly_);
+        mcp_rx_next_seq_ = 0;
+        return true;
+    }
+    size_t part_len = strlen(part->valuestring);
+    if (mcp_reassembly_.size() + part_len > kMcpReassemblyLimitBytes) {
+        ESP_LOGE(TAG, "mcp_chunk stream exceeds %u bytes, dropping", (unsigned)kMcpReassemblyLimitBytes);
+        std::string().swap(mcp_reassembly_);
+        mcp_rx_next_seq_ = 0;
+        return true;
+    }
+    mcp_reassembly_.append(part->valuestring, part_len);
+    mcp_rx_next_seq_++;
+
+    auto final_flag = cJSON_GetObjectItem(root, "final");
+    if (!cJSON_IsTrue(final_flag)) {
+        return true;
+    }
+    cJSON* payload = cJSON_ParseWithLength(mcp_reassembly_.data(), mcp_reassembly_.size());
+    std::string().swap(mcp_reassembly_);
+    mcp_rx_next_seq_ = 0;
+    if (payload == nullptr) {
+        ESP_LOGE(TAG, "Failed to parse reassembled MCP message");
+        return true;
+    }
+    cJSON* envelope = cJSON_CreateObject();
+    cJSON_AddStringToObject(envelope, "type", "mcp");
+    cJSON_AddItemToObject(envelope, "payload", payload);
+    if (on_incoming_json_ != nullptr) {
+        on_incoming_json_(envelope);
+    }
+    cJSON_Delete(envelope);
+    return true;
+}
+
+void Protocol::AccountOutgoing(size_t bytes) {
+    network_stats_.packets_sent++;
+    network_stats_.bytes_sent += bytes;
+}
+
+void Protocol::AccountIncoming(size_t bytes) {
+    if (network_stats_.packets_received > 0) {
+        auto gap_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - last_incoming_time_).count();
+        if ((uint32_t)gap_ms > network_stats_.max_incoming_gap_ms) {
+            network_stats_.max_incoming_gap_ms = gap_ms;
+        }
+    }
+    network_stats_.packets_received++;
+    network_stats_.bytes_received += bytes;
+}
+
+std::string Protocol::GetNetworkStatsJson() const {
+    auto root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "packets_sent", network_stats_.packets_sent);
+    cJSON_AddNumberToObject(root, "packets_received", network_stats_.packets_received);
+    cJSON_AddNumberToObject(root, "bytes_sent", (double)network_stats_.bytes_sent);
+    cJSON_AddNumberToObject(root, "bytes_received", (double)network_stats_.bytes_received);
+    cJSON_AddNumberToObject(root, "reconnect_count", network_stats_.reconnect_count);
+    cJSON_AddNumberToObject(root, "channel_open_count", network_stats_.channel_open_count);
+    cJSON_AddNumberToObject(root, "max_incoming_gap_ms", network_stats_.max_incoming_gap_ms);
+    cJSON_AddNumberToObject(root, "packets_lost", network_stats_.packets_lost);
+    cJSON_AddNumberToObject(root, "max_text_queued_bytes", network_stats_.max_text_queued_bytes);
+    cJSON_AddNumberToObject(root, "max_audio_batch_bytes", network_stats_.max_audio_batch_bytes);
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
+
+/* 现场网络自测。服务器没有echo端点,所以不做回显RTT:上行用真实音频
+ * 4倍节奏的合成帧量接受速率和单次发送阻塞分布(TCP背压/重传会把阻塞
+ * 时间拉长,这就是"现场感觉慢"的量化);下行吞吐、丢包(UDP按序列号
+ * 空洞计数)和最坏到包间隔取自窗口内的被动计数。建议在Idle态跑,
+ * 合成帧在listen窗口之外,服务器不会拿去转写 */
+std::string Protocol::RunNetworkBench(int seconds) {
+    if (!IsAudioChannelOpened()) {
+        return "{\"error\":\"audio channel not opened\"}";
+    }
+
+    const size_t kPayloadBytes = 120;   // 典型60ms Opus帧大小
+    const int kBurstPerTick = 4;        // 每10ms发4帧,约4倍于真实音频负载
+    NetworkStats before = network_stats_;
+
+    uint32_t rng = 0x6E657462;
+    uint32_t sent = 0;
+    uint32_t failed = 0;
+    uint64_t sent_bytes = 0;
+    int64_t send_us_total = 0;
+    int64_t send_us_max = 0;
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + (int64_t)seconds * 1000000;
+
+    while (esp_timer_get_time() < end_us) {
+        for (int i = 0; i < kBurstPerTick; i++) {
+            auto packet = std::make_unique<AudioStreamPacket>();
+            packet->sample_rate = server_sample_rate_;
+            packet->frame_duration = server_frame_duration_;
+            packet->payload.resize(kPayloadBytes);
+            for (auto& b : packet->payload) {
+                rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                b = (uint8_t)rng;
+            }
+
+            int64_t t0 = esp_timer_get_time();
+            bool ok = SendAudio(std::move(packet));
+            int64_t dt = esp_timer_get_time() - t0;
+            if (ok) {
+                sent++;
+                sent_bytes += kPayloadBytes;
+                send_us_total += dt;
+                if (dt > send_us_max) {
+                    send_us_max = dt;
+                }
+            } else {
+                failed++;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    int64_t window_us = esp_timer_get_time() - start_us;
+    double window_s = (double)window_us / 1e6;
+    uint64_t rx_bytes = network_stats_.bytes_received - before.bytes_received;
+    uint32_t rx_packets = network_stats_.packets_received - before.packets_received;
+    uint32_t lost = network_stats_.packets_lost - before.packets_lost;
+
+    auto root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "window_s", window_s);
+    cJSON_AddNumberToObject(root, "uplink_packets", sent);
+    cJSON_AddNumberToObject(root, "uplink_failed", failed);
+    cJSON_AddNumberToObject(root, "uplink_kbps", (double)sent_bytes * 8.0 / 1000.0 / window_s);
+    cJSON_AddNumberToObject(root, "send_avg_us", sent > 0 ? (double)send_us_total / sent : 0);
+    cJSON_AddNumberToObject(root, "send_max_us", (double)send_us_max);
+    cJSON_AddNumberToObject(root, "downlink_packets", rx_packets);
+    cJSON_AddNumberToObject(root, "downlink_kbps", (double)rx_bytes * 8.0 / 1000.0 / window_s);
+    cJSON_AddNumberToObject(root, "downlink_lost", lost);
+    cJSON_AddNumberToObject(root, "max_incoming_gap_ms", network_stats_.max_incoming_gap_ms);
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    ESP_LOGI(TAG, "NETWORK_BENCH %s", json.c_str());
+    return json;
 }
 
 bool Protocol::IsTimeout() const {
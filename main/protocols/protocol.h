@@ -7,17 +7,22 @@
 #include <chrono>
 #include <vector>
 
+#include "fixed_callback.h"
+
 struct AudioStreamPacket {
     int sample_rate = 0;
     int frame_duration = 0;
     uint32_t timestamp = 0;
+    // Stream sequence number when the transport carries one (0 = unknown),
+    // used by the decode path to detect and conceal lost frames
+    uint32_t sequence = 0;
     std::vector<uint8_t> payload;
 };
 
 struct BinaryProtocol2 {
     uint16_t version;
     uint16_t type;          // Message type (0: OPUS, 1: JSON)
-    uint32_t reserved;      // Reserved for future use
+    uint32_t reserved;      // Frame sequence number (0 when the peer does not fill it)
     uint32_t timestamp;     // Timestamp in milliseconds (used for server-side AEC)
     uint32_t payload_size;  // Payload size in bytes
     uint8_t payload[];      // Payload data
@@ -30,6 +35,25 @@ struct BinaryProtocol3 {
     uint8_t payload[];
 } __attribute__((packed));
 
+/* Per-session link quality counters for fleet triage. Counted at the
+ * application layer: payload plus framing headers, not raw socket bytes. */
+struct NetworkStats {
+    uint32_t packets_sent = 0;
+    uint32_t packets_received = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    uint32_t reconnect_count = 0;
+    uint32_t channel_open_count = 0;
+    // Worst gap between incoming packets while the channel was open
+    uint32_t max_incoming_gap_ms = 0;
+    // Downlink frames missing by sequence-number gap (UDP transport only;
+    // TCP-based transports never lose frames, they stall instead)
+    uint32_t packets_lost = 0;
+    // 发送侧两类负载的排队峰值:审计大JSON对实时音频的挤占程度
+    uint32_t max_text_queued_bytes = 0;
+    uint32_t max_audio_batch_bytes = 0;
+};
+
 enum AbortReason {
     kAbortReasonNone,
     kAbortReasonWakeWordDetected
@@ -54,8 +78,16 @@ public:
     inline const std::string& session_id() const {
         return session_id_;
     }
+    inline const NetworkStats& network_stats() const {
+        return network_stats_;
+    }
+    std::string GetNetworkStatsJson() const;
+    // 现场网络自测:往已打开的音频通道压合成帧若干秒,返回统计JSON。
+    // 阻塞调用方任务,不要在主循环里跑
+    std::string RunNetworkBench(int seconds);
 
-    void OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback);
+    // 每个音频包都会触发,用固定容量委托;其余回调频率低,保留std::function
+    void OnIncomingAudio(FixedCallback<void(std::unique_ptr<AudioStreamPacket> packet)> callback);
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
@@ -72,11 +104,17 @@ public:
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
-    virtual void SendMcpMessage(const std::string& message);
+    virtual void SendMcpMessage(std::string payload);
+
+    /* MCP分块传输:单帧装不下的大报文拆成带{id,seq,final}头的段,对端按序
+     * 重组。出站分块仅在服务器hello的features里声明mcp_chunking后启用;
+     * 入站重组始终在位(服务器不发分块时零开销) */
+    static constexpr size_t kMcpChunkBytes = 8 * 1024;
+    static constexpr size_t kMcpReassemblyLimitBytes = 256 * 1024;
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
-    std::function<void(std::unique_ptr<AudioStreamPacket> packet)> on_incoming_audio_;
+    FixedCallback<void(std::unique_ptr<AudioStreamPacket> packet)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
     std::function<void(const std::string& message)> on_network_error_;
@@ -86,10 +124,26 @@ protected:
     int server_sample_rate_ = 24000;
     int server_frame_duration_ = 60;
     bool error_occurred_ = false;
+    bool mcp_chunking_supported_ = false;  // 服务器hello声明mcp_chunking后置位
+    // 入站分块重组状态:当前流id、期望序号与累积缓冲(只在接收线程触碰)
+    uint32_t mcp_rx_id_ = 0;
+    uint32_t mcp_rx_next_seq_ = 0;
+    std::string mcp_reassembly_;
+    uint32_t mcp_tx_id_ = 0;
     std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
+    NetworkStats network_stats_;
 
-    virtual bool SendText(const std::string& text) = 0;
+    // 按值传递+移动:大报文(相机结果)从工具线程到发送队列全程零拷贝
+    virtual bool SendText(std::string text) = 0;
+    // 子类在分发非hello消息前调用:消费mcp_chunk段,终段重组解析后以
+    // 等价的{"type":"mcp","payload":...}信封回调,上层不感知分块
+    bool HandleMcpChunk(const cJSON* root);
+    void SendMcpChunked(const std::string& payload);
+    // Call AccountIncoming before updating last_incoming_time_, it uses the
+    // previous arrival to track the worst inter-packet gap
+    void AccountOutgoing(size_t bytes);
+    void AccountIncoming(size_t bytes);
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
 };
@@ -0,0 +1,128 @@
+#include "udp_audio_channel.h"
+#include "board.h"
+
+#include <esp_log.h>
+#include <cstring>
+#include <arpa/inet.h>
+
+#define TAG "UdpAudio"
+
+UdpAudioChannel::~UdpAudioChannel() {
+    Close();
+}
+
+bool UdpAudioChannel::Open(const std::string& server, int port, const std::string& key, const std::string& nonce,
+                           int sample_rate, int frame_duration) {
+    if (server.empty() || port <= 0 || key.empty() || nonce.empty()) {
+        ESP_LOGE(TAG, "Invalid udp channel parameters");
+        return false;
+    }
+
+    sample_rate_ = sample_rate;
+    frame_duration_ = frame_duration;
+    aes_nonce_ = DecodeHexString(nonce);
+    mbedtls_aes_init(&aes_ctx_);
+    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
+    local_sequence_ = 0;
+    remote_sequence_ = 0;
+
+    auto network = Board::GetInstance().GetNetwork();
+    udp_ = network->CreateUdp(2);
+    udp_->OnMessage([this](const std::string& data) {
+        if (data.size() < aes_nonce_.size()) {
+            ESP_LOGE(TAG, "Invalid audio packet size: %u", data.size());
+            return;
+        }
+        if (data[0] != 0x01) {
+            ESP_LOGE(TAG, "Invalid audio packet type: %x", data[0]);
+            return;
+        }
+        uint32_t timestamp = ntohl(*(uint32_t*)&data[8]);
+        uint32_t sequence = ntohl(*(uint32_t*)&data[12]);
+        if (sequence < remote_sequence_) {
+            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
+            return;
+        }
+        if (sequence != remote_sequence_ + 1) {
+            ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+        }
+
+        size_t decrypted_size = data.size() - aes_nonce_.size();
+        size_t nc_off = 0;
+        uint8_t stream_block[16] = {0};
+        auto nonce = (uint8_t*)data.data();
+        auto encrypted = (uint8_t*)data.data() + aes_nonce_.size();
+        auto packet = std::make_unique<AudioStreamPacket>();
+        packet->sample_rate = sample_rate_;
+        packet->frame_duration = frame_duration_;
+        packet->timestamp = timestamp;
+        packet->sequence = sequence;
+        packet->payload.resize(decrypted_size);
+        int ret = mbedtls_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, nonce, stream_block, encrypted, (uint8_t*)packet->payload.data());
+        if (ret != 0) {
+            ESP_LOGE(TAG, "Failed to decrypt audio data, ret: %d", ret);
+            return;
+        }
+        if (on_incoming_audio_ != nullptr) {
+            on_incoming_audio_(std::move(packet));
+        }
+        remote_sequence_ = sequence;
+    });
+
+    udp_->Connect(server, port);
+    ESP_LOGI(TAG, "Audio channel opened: %s:%d", server.c_str(), port);
+    return true;
+}
+
+void UdpAudioChannel::Close() {
+    udp_.reset();
+}
+
+bool UdpAudioChannel::Send(const AudioStreamPacket& packet) {
+    if (udp_ == nullptr) {
+        return false;
+    }
+
+    // 头部直接写进复用的发送缓冲区,CTR 计数器用栈上副本,稳态不再分配堆内存
+    size_t header_size = aes_nonce_.size();
+    send_buffer_.resize(header_size + packet.payload.size());
+    memcpy(send_buffer_.data(), aes_nonce_.data(), header_size);
+    *(uint16_t*)&send_buffer_[2] = htons(packet.payload.size());
+    *(uint32_t*)&send_buffer_[8] = htonl(packet.timestamp);
+    *(uint32_t*)&send_buffer_[12] = htonl(++local_sequence_);
+
+    uint8_t nonce_counter[16];
+    memcpy(nonce_counter, send_buffer_.data(), sizeof(nonce_counter));
+
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet.payload.size(), &nc_off, nonce_counter, stream_block,
+        (uint8_t*)packet.payload.data(), (uint8_t*)&send_buffer_[header_size]) != 0) {
+        ESP_LOGE(TAG, "Failed to encrypt audio data");
+        return false;
+    }
+
+    return udp_->Send(send_buffer_) > 0;
+}
+
+void UdpAudioChannel::OnIncomingAudio(FixedCallback<void(std::unique_ptr<AudioStreamPacket>)> callback) {
+    on_incoming_audio_ = std::move(callback);
+}
+
+// 辅助函数,将单个十六进制字符转换为对应的数值
+static inline uint8_t CharToHex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return 0;  // 对于无效输入,返回0
+}
+
+std::string UdpAudioChannel::DecodeHexString(const std::string& hex_string) {
+    std::string decoded;
+    decoded.reserve(hex_string.size() / 2);
+    for (size_t i = 0; i < hex_string.size(); i += 2) {
+        char byte = (CharToHex(hex_string[i]) << 4) | CharToHex(hex_string[i + 1]);
+        decoded.push_back(byte);
+    }
+    return decoded;
+}
@@ -0,0 +1,49 @@
+#ifndef _UDP_AUDIO_CHANNEL_H_
+#define _UDP_AUDIO_CHANNEL_H_
+
+#include "protocol.h"
+
+#include <udp.h>
+#include <mbedtls/aes.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+/*
+ * MqttProtocol 的 AES-CTR UDP 音频通道抽出来的独立实现,
+ * 供 WebsocketProtocol 混合模式复用:控制 JSON 仍走原连接,
+ * Opus 帧走 UDP,丢一个包只损失一帧,不会因 TCP 重传卡住整个解码队列。
+ *
+ * UDP Encrypted OPUS Packet Format:
+ * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
+ * |payload payload_len|
+ */
+class UdpAudioChannel {
+public:
+    ~UdpAudioChannel();
+
+    // key 和 nonce 为服务器 hello 下发的十六进制字符串
+    bool Open(const std::string& server, int port, const std::string& key, const std::string& nonce,
+              int sample_rate, int frame_duration);
+    void Close();
+    bool IsOpened() const { return udp_ != nullptr; }
+
+    bool Send(const AudioStreamPacket& packet);
+    void OnIncomingAudio(FixedCallback<void(std::unique_ptr<AudioStreamPacket>)> callback);
+
+    static std::string DecodeHexString(const std::string& hex_string);
+
+private:
+    std::unique_ptr<Udp> udp_;
+    // Reused across frames so steady-state sends do not allocate
+    std::string send_buffer_;
+    mbedtls_aes_context aes_ctx_;
+    std::string aes_nonce_;
+    uint32_t local_sequence_ = 0;
+    uint32_t remote_sequence_ = 0;
+    int sample_rate_ = 0;
+    int frame_duration_ = 0;
+    FixedCallback<void(std::unique_ptr<AudioStreamPacket>)> on_incoming_audio_;
+};
+
+#endif
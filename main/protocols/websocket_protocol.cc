@@ -3,8 +3,11 @@
 #include "system_info.h"
 #include "application.h"
 #include "settings.h"
+#include "json_arena.h"
+#include "perf_trace.h"
 
 #include <cstring>
+#include <algorithm>
 #include <cJSON.h>
 #include <esp_log.h>
 #include <arpa/inet.h>
@@ -14,60 +17,219 @@
 
 WebsocketProtocol::WebsocketProtocol() {
     event_group_handle_ = xEventGroupCreate();
+
+    xTaskCreate([](void* arg) {
+        auto this_ = (WebsocketProtocol*)arg;
+        this_->SendTextTask();
+        xEventGroupSetBits(this_->event_group_handle_, WEBSOCKET_PROTOCOL_SEND_TASK_STOPPED_EVENT);
+        vTaskDelete(NULL);
+    }, "ws_send", 4096, this, 3, nullptr);
 }
 
 WebsocketProtocol::~WebsocketProtocol() {
+    xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SEND_TASK_QUIT_EVENT);
+    xEventGroupWaitBits(event_group_handle_, WEBSOCKET_PROTOCOL_SEND_TASK_STOPPED_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(1000));
     vEventGroupDelete(event_group_handle_);
 }
 
+void WebsocketProtocol::SendTextTask() {
+    while (true) {
+        EventBits_t bits = xEventGroupWaitBits(event_group_handle_,
+            WEBSOCKET_PROTOCOL_SEND_TEXT_EVENT | WEBSOCKET_PROTOCOL_SEND_TASK_QUIT_EVENT,
+            pdTRUE, pdFALSE, portMAX_DELAY);
+        if (bits & WEBSOCKET_PROTOCOL_SEND_TASK_QUIT_EVENT) {
+            break;
+        }
+
+        while (true) {
+            std::string text;
+            {
+                std::lock_guard<std::mutex> lock(send_text_mutex_);
+                if (send_text_queue_.empty()) {
+                    break;
+                }
+                text = std::move(send_text_queue_.front());
+                send_text_queue_.pop_front();
+                text_queued_bytes_ -= text.size();
+            }
+            send_text_cv_.notify_all();
+
+            /* 无法分块的大报文只能整条占住socket,音频帧在它发完前拿不到
+             * TX锁——记一条现场可见的告警,方便归因"说话突然卡一下" */
+            if (text.size() > 16 * 1024) {
+                ESP_LOGW(TAG, "Sending %u bytes of text in one frame, audio waits for its duration",
+                         (unsigned)text.size());
+            }
+
+            std::lock_guard<std::mutex> lock(websocket_mutex_);
+            if (websocket_ == nullptr || !websocket_->IsConnected()) {
+                continue;
+            }
+            if (!websocket_->Send(text)) {
+                ESP_LOGE(TAG, "Failed to send text: %s", text.c_str());
+                SetError(Lang::Strings::SERVER_ERROR);
+                continue;
+            }
+            AccountOutgoing(text.size());
+        }
+    }
+}
+
+// 轻量提取 "type" 字段,不值得为排队去重完整解析一遍 JSON
+std::string WebsocketProtocol::ExtractMessageType(const std::string& text) {
+    const char* key = "\"type\":\"";
+    auto pos = text.find(key);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += strlen(key);
+    auto end = text.find('"', pos);
+    if (end == std::string::npos) {
+        return "";
+    }
+    return text.substr(pos, end - pos);
+}
+
 bool WebsocketProtocol::Start() {
-    // Only connect to server when audio channel is needed
+#if CONFIG_WEBSOCKET_CONNECTION_PREWARM
+    /* Pay the TCP + TLS + websocket handshake now, while nobody is waiting,
+     * so the first conversation starts on a warm connection */
+    xTaskCreate([](void* arg) {
+        auto this_ = (WebsocketProtocol*)arg;
+        if (!this_->IsAudioChannelOpened()) {
+            this_->OpenAudioChannel();
+        }
+        vTaskDelete(NULL);
+    }, "ws_prewarm", 4096, this, 1, nullptr);
+#endif
+    // Otherwise only connect to server when audio channel is needed
     return true;
 }
 
+// 调用方持有 batch_mutex_,且已确认 websocket_ 在连
+bool WebsocketProtocol::FlushAudioBatch() {
+    if (batched_frames_ == 0) {
+        return true;
+    }
+    if (batch_buffer_.size() > network_stats_.max_audio_batch_bytes) {
+        network_stats_.max_audio_batch_bytes = batch_buffer_.size();
+    }
+    bool ok = websocket_->Send(batch_buffer_.data(), batch_buffer_.size(), true);
+    batch_buffer_.clear();
+    batched_frames_ = 0;
+    return ok;
+}
+
 bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+    PERF_TRACE_PROBE(kProbeSocketSend);
+    if (udp_channel_ != nullptr && udp_channel_->IsOpened()) {
+        // Hybrid mode: one lost datagram costs one frame instead of a TCP stall
+        if (!udp_channel_->Send(*packet)) {
+            return false;
+        }
+        AccountOutgoing(packet->payload.size());
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(batch_mutex_);
     if (websocket_ == nullptr || !websocket_->IsConnected()) {
+        batch_buffer_.clear();
+        batched_frames_ = 0;
         return false;
     }
 
     if (version_ == 2) {
-        std::string serialized;
-        serialized.resize(sizeof(BinaryProtocol2) + packet->payload.size());
-        auto bp2 = (BinaryProtocol2*)serialized.data();
+        size_t offset = batch_buffer_.size();
+        batch_buffer_.resize(offset + sizeof(BinaryProtocol2) + packet->payload.size());
+        auto bp2 = (BinaryProtocol2*)(batch_buffer_.data() + offset);
         bp2->version = htons(version_);
         bp2->type = 0;
-        bp2->reserved = 0;
+        bp2->reserved = htonl(++send_sequence_);
         bp2->timestamp = htonl(packet->timestamp);
         bp2->payload_size = htonl(packet->payload.size());
         memcpy(bp2->payload, packet->payload.data(), packet->payload.size());
-
-        return websocket_->Send(serialized.data(), serialized.size(), true);
+        AccountOutgoing(sizeof(BinaryProtocol2) + packet->payload.size());
     } else if (version_ == 3) {
-        std::string serialized;
-        serialized.resize(sizeof(BinaryProtocol3) + packet->payload.size());
-        auto bp3 = (BinaryProtocol3*)serialized.data();
+        size_t offset = batch_buffer_.size();
+        batch_buffer_.resize(offset + sizeof(BinaryProtocol3) + packet->payload.size());
+        auto bp3 = (BinaryProtocol3*)(batch_buffer_.data() + offset);
         bp3->type = 0;
         bp3->reserved = 0;
         bp3->payload_size = htons(packet->payload.size());
         memcpy(bp3->payload, packet->payload.data(), packet->payload.size());
-
-        return websocket_->Send(serialized.data(), serialized.size(), true);
+        AccountOutgoing(sizeof(BinaryProtocol3) + packet->payload.size());
     } else {
-        return websocket_->Send(packet->payload.data(), packet->payload.size(), true);
+        // Version 1 frames carry no length header, so they cannot be concatenated
+        if (!websocket_->Send(packet->payload.data(), packet->payload.size(), true)) {
+            return false;
+        }
+        AccountOutgoing(packet->payload.size());
+        return true;
     }
+
+    /* Each versioned frame is self-delimiting, so several of them can share one
+     * websocket message to amortize the TLS record and websocket header cost.
+     * audio_batch_frames_ 是 hello 协商结果,未获服务器确认时为 1(逐帧发) */
+    if (++batched_frames_ < audio_batch_frames_) {
+        return true;
+    }
+    return FlushAudioBatch();
 }
 
-bool WebsocketProtocol::SendText(const std::string& text) {
-    if (websocket_ == nullptr || !websocket_->IsConnected()) {
-        return false;
+void WebsocketProtocol::SendStopListening() {
+    /* 一句话的尾巴(不足一批的≤N-1帧)正是服务器端点判定最需要的音频,
+     * 必须随本句发出,不能压在缓冲里等下一句的首批捎带过期帧 */
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        if (websocket_ != nullptr && websocket_->IsConnected()) {
+            FlushAudioBatch();
+        } else {
+            batch_buffer_.clear();
+            batched_frames_ = 0;
+        }
     }
+    Protocol::SendStopListening();
+}
 
-    if (!websocket_->Send(text)) {
-        ESP_LOGE(TAG, "Failed to send text: %s", text.c_str());
-        SetError(Lang::Strings::SERVER_ERROR);
+bool WebsocketProtocol::SendText(std::string text) {
+    if (websocket_ == nullptr || !websocket_->IsConnected()) {
         return false;
     }
 
+    {
+        std::unique_lock<std::mutex> lock(send_text_mutex_);
+        if (send_text_queue_.size() >= WEBSOCKET_PROTOCOL_MAX_PENDING_TEXT) {
+            auto type = ExtractMessageType(text);
+            if (type == "mcp_chunk") {
+                /* 分块流的段既不能丢也不能乱序:对入队方施加背压,等ws_send
+                 * 腾出空间(调用方是工具worker线程,短暂阻塞无害) */
+                if (!send_text_cv_.wait_for(lock, std::chrono::seconds(10), [this] {
+                        return send_text_queue_.size() < WEBSOCKET_PROTOCOL_MAX_PENDING_TEXT; })) {
+                    ESP_LOGE(TAG, "Text queue stalled, dropping mcp_chunk stream");
+                    return false;
+                }
+            } else {
+                /* Under pressure a newer message supersedes the oldest queued one
+                 * of the same type (periodic state updates are idempotent); only
+                 * if no same-type message is queued does the oldest overall go */
+                auto it = std::find_if(send_text_queue_.begin(), send_text_queue_.end(),
+                    [&type](const std::string& pending) { return ExtractMessageType(pending) == type; });
+                if (it != send_text_queue_.end()) {
+                    text_queued_bytes_ -= it->size();
+                    send_text_queue_.erase(it);
+                } else {
+                    ESP_LOGW(TAG, "Text queue full, dropping oldest message");
+                    text_queued_bytes_ -= send_text_queue_.front().size();
+                    send_text_queue_.pop_front();
+                }
+            }
+        }
+        text_queued_bytes_ += text.size();
+        if (text_queued_bytes_ > network_stats_.max_text_queued_bytes) {
+            network_stats_.max_text_queued_bytes = text_queued_bytes_;
+        }
+        send_text_queue_.push_back(std::move(text));
+    }
+    xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SEND_TEXT_EVENT);
     return true;
 }
 
@@ -76,22 +238,48 @@ bool WebsocketProtocol::IsAudioChannelOpened() const {
 }
 
 void WebsocketProtocol::CloseAudioChannel() {
+    udp_channel_.reset();
+    {
+        // 丢弃半批:会话已经结束,这些帧补发进新会话只会污染它
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch_buffer_.clear();
+        batched_frames_ = 0;
+    }
+    std::lock_guard<std::mutex> lock(websocket_mutex_);
     websocket_.reset();
 }
 
 bool WebsocketProtocol::OpenAudioChannel() {
-    Settings settings("websocket", false);
-    std::string url = settings.GetString("url");
-    std::string token = settings.GetString("token");
-    int version = settings.GetInt("version");
-    if (version != 0) {
-        version_ = version;
+    if (url_.empty()) {
+        Settings settings("websocket", false);
+        url_ = settings.GetString("url");
+        token_ = settings.GetString("token");
+        int version = settings.GetInt("version");
+        if (version != 0) {
+            version_ = version;
+        }
     }
+    std::string url = url_;
+    std::string token = token_;
 
     error_occurred_ = false;
+    udp_channel_.reset();
+    udp_server_.clear();
+    udp_port_ = 0;
+    {
+        // 上一条连接的残批不能带进新会话
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch_buffer_.clear();
+        batched_frames_ = 0;
+    }
+    // 合并发送要重新协商;乐观开通道期间也因此保持逐帧发,天然安全
+    audio_batch_frames_ = 1;
 
     auto network = Board::GetInstance().GetNetwork();
-    websocket_ = network->CreateWebSocket(1);
+    {
+        std::lock_guard<std::mutex> lock(websocket_mutex_);
+        websocket_ = network->CreateWebSocket(1);
+    }
     if (websocket_ == nullptr) {
         ESP_LOGE(TAG, "Failed to create websocket");
         return false;
@@ -109,32 +297,51 @@ bool WebsocketProtocol::OpenAudioChannel() {
     websocket_->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
 
     websocket_->OnData([this](const char* data, size_t len, bool binary) {
+        AccountIncoming(len);
         if (binary) {
             if (on_incoming_audio_ != nullptr) {
+                /* Parse frames in place on the receive buffer. Versioned frames
+                 * are self-delimiting, so one websocket message may carry
+                 * several of them; the single copy per frame goes straight into
+                 * the packet payload with no intermediate staging. */
                 if (version_ == 2) {
-                    BinaryProtocol2* bp2 = (BinaryProtocol2*)data;
-                    bp2->version = ntohs(bp2->version);
-                    bp2->type = ntohs(bp2->type);
-                    bp2->timestamp = ntohl(bp2->timestamp);
-                    bp2->payload_size = ntohl(bp2->payload_size);
-                    auto payload = (uint8_t*)bp2->payload;
-                    on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = bp2->timestamp,
-                        .payload = std::vector<uint8_t>(payload, payload + bp2->payload_size)
-                    }));
+                    const uint8_t* p = (const uint8_t*)data;
+                    const uint8_t* end = p + len;
+                    while (p + sizeof(BinaryProtocol2) <= end) {
+                        auto bp2 = (const BinaryProtocol2*)p;
+                        uint32_t timestamp = ntohl(bp2->timestamp);
+                        uint32_t payload_size = ntohl(bp2->payload_size);
+                        if (bp2->payload + payload_size > end) {
+                            ESP_LOGE(TAG, "Truncated binary frame: %lu > %d", (unsigned long)payload_size, (int)(end - bp2->payload));
+                            break;
+                        }
+                        on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
+                            .sample_rate = server_sample_rate_,
+                            .frame_duration = server_frame_duration_,
+                            .timestamp = timestamp,
+                            .sequence = ntohl(bp2->reserved),
+                            .payload = std::vector<uint8_t>(bp2->payload, bp2->payload + payload_size)
+                        }));
+                        p = bp2->payload + payload_size;
+                    }
                 } else if (version_ == 3) {
-                    BinaryProtocol3* bp3 = (BinaryProtocol3*)data;
-                    bp3->type = bp3->type;
-                    bp3->payload_size = ntohs(bp3->payload_size);
-                    auto payload = (uint8_t*)bp3->payload;
-                    on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = 0,
-                        .payload = std::vector<uint8_t>(payload, payload + bp3->payload_size)
-                    }));
+                    const uint8_t* p = (const uint8_t*)data;
+                    const uint8_t* end = p + len;
+                    while (p + sizeof(BinaryProtocol3) <= end) {
+                        auto bp3 = (const BinaryProtocol3*)p;
+                        uint16_t payload_size = ntohs(bp3->payload_size);
+                        if (bp3->payload + payload_size > end) {
+                            ESP_LOGE(TAG, "Truncated binary frame: %u > %d", payload_size, (int)(end - bp3->payload));
+                            break;
+                        }
+                        on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
+                            .sample_rate = server_sample_rate_,
+                            .frame_duration = server_frame_duration_,
+                            .timestamp = 0,
+                            .payload = std::vector<uint8_t>(bp3->payload, bp3->payload + payload_size)
+                        }));
+                        p = bp3->payload + payload_size;
+                    }
                 } else {
                     on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
                         .sample_rate = server_sample_rate_,
@@ -145,27 +352,22 @@ bool WebsocketProtocol::OpenAudioChannel() {
                 }
             }
         } else {
-            // Parse JSON data
-            auto root = cJSON_Parse(data);
-            auto type = cJSON_GetObjectItem(root, "type");
-            if (cJSON_IsString(type)) {
-                if (strcmp(type->valuestring, "hello") == 0) {
-                    ParseServerHello(root);
-                } else {
-                    if (on_incoming_json_ != nullptr) {
-                        on_incoming_json_(root);
-                    }
-                }
+            if (len >= WEBSOCKET_PROTOCOL_INLINE_JSON_LIMIT) {
+                /* 大报文(典型是下发给 MCP 的配置 blob)拷贝后丢给主循环解析,
+                 * 网络任务立刻回去收音频帧,解析期间不再丢帧 */
+                Application::GetInstance().Schedule([this, payload = std::string(data, len)]() {
+                    ParseIncomingJson(payload.c_str());
+                });
             } else {
-                ESP_LOGE(TAG, "Missing message type, data: %s", data);
+                ParseIncomingJson(data);
             }
-            cJSON_Delete(root);
         }
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
     websocket_->OnDisconnected([this]() {
         ESP_LOGI(TAG, "Websocket disconnected");
+        network_stats_.reconnect_count++;
         if (on_audio_channel_closed_ != nullptr) {
             on_audio_channel_closed_();
         }
@@ -184,6 +386,23 @@ bool WebsocketProtocol::OpenAudioChannel() {
         return false;
     }
 
+    /* 同一服务器重连时用缓存的 hello 参数乐观开通道:音频立即开始流动,
+     * 省掉一个 RTT;服务器 hello 到达后若参数不同再校正(下行参数本来
+     * 就是按包自适应的,校正是无感的) */
+    optimistic_opened_ = false;
+    {
+        Settings settings("ws_hello", false);
+        if (settings.GetString("url") == url && settings.GetInt("sample_rate") > 0) {
+            server_sample_rate_ = settings.GetInt("sample_rate");
+            server_frame_duration_ = settings.GetInt("frame_duration", 60);
+            optimistic_opened_ = true;
+            ESP_LOGI(TAG, "Using cached server hello: %d Hz, %d ms", server_sample_rate_, server_frame_duration_);
+            if (on_audio_channel_opened_ != nullptr) {
+                on_audio_channel_opened_();
+            }
+        }
+    }
+
     // Wait for server hello
     EventBits_t bits = xEventGroupWaitBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
     if (!(bits & WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT)) {
@@ -192,7 +411,26 @@ bool WebsocketProtocol::OpenAudioChannel() {
         return false;
     }
 
-    if (on_audio_channel_opened_ != nullptr) {
+    network_stats_.channel_open_count++;
+
+    // 服务器 hello 下发了 udp 字段时切到混合模式:音频帧走 UDP
+    if (!udp_server_.empty()) {
+        udp_channel_ = std::make_unique<UdpAudioChannel>();
+        udp_channel_->OnIncomingAudio([this](std::unique_ptr<AudioStreamPacket> packet) {
+            AccountIncoming(packet->payload.size());
+            if (on_incoming_audio_ != nullptr) {
+                on_incoming_audio_(std::move(packet));
+            }
+            last_incoming_time_ = std::chrono::steady_clock::now();
+        });
+        if (!udp_channel_->Open(udp_server_, udp_port_, udp_key_, udp_nonce_,
+                                server_sample_rate_, server_frame_duration_)) {
+            ESP_LOGW(TAG, "Failed to open udp audio channel, fall back to websocket");
+            udp_channel_.reset();
+        }
+    }
+
+    if (!optimistic_opened_ && on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
     }
 
@@ -209,6 +447,20 @@ std::string WebsocketProtocol::GetHelloMessage() {
     cJSON_AddBoolToObject(features, "aec", true);
 #endif
     cJSON_AddBoolToObject(features, "mcp", true);
+    // 支持MCP大报文分块重组;服务器在hello里回声明后出站也启用分块
+    cJSON_AddBoolToObject(features, "mcp_chunking", true);
+    // 告知服务器支持混合模式,服务器可在 hello 里下发 udp 通道参数
+    cJSON_AddBoolToObject(features, "udp", true);
+#if CONFIG_WEBSOCKET_AUDIO_BATCH_FRAMES > 1
+    /* 通告上行合并帧数上限;服务器在 hello 里回声明(true 或更小的数)
+     * 后才真正合并,旧服务器不认识该字段则保持逐帧发 */
+    cJSON_AddNumberToObject(features, "audio_batch", CONFIG_WEBSOCKET_AUDIO_BATCH_FRAMES);
+#endif
+#if !CONFIG_USE_SERVER_AEC
+    /* 不开服务器 AEC 时上行不需要逐帧时间戳,告知支持 4 字节的 v3 帧头
+     * (v2 是 16 字节),服务器可在 hello 里下发 version 切换 */
+    cJSON_AddBoolToObject(features, "bp3", true);
+#endif
     cJSON_AddItemToObject(root, "features", features);
     cJSON_AddStringToObject(root, "transport", "websocket");
     cJSON* audio_params = cJSON_CreateObject();
@@ -224,6 +476,29 @@ std::string WebsocketProtocol::GetHelloMessage() {
     return message;
 }
 
+void WebsocketProtocol::ParseIncomingJson(const char* data) {
+    /* 解析树和处理期间的临时分配都落在arena里,消息结束O(1)回收,
+     * 不再每条消息做几十次小malloc/free打碎内部RAM */
+    bool arena = JsonArena::Begin(strlen(data) * 3 + 512);
+    auto root = cJSON_Parse(data);
+    auto type = cJSON_GetObjectItem(root, "type");
+    if (cJSON_IsString(type)) {
+        if (strcmp(type->valuestring, "hello") == 0) {
+            ParseServerHello(root);
+        } else if (!HandleMcpChunk(root)) {
+            if (on_incoming_json_ != nullptr) {
+                on_incoming_json_(root);
+            }
+        }
+    } else {
+        ESP_LOGE(TAG, "Missing message type, data: %s", data);
+    }
+    cJSON_Delete(root);
+    if (arena) {
+        JsonArena::End();
+    }
+}
+
 void WebsocketProtocol::ParseServerHello(const cJSON* root) {
     auto transport = cJSON_GetObjectItem(root, "transport");
     if (transport == nullptr || strcmp(transport->valuestring, "websocket") != 0) {
@@ -231,12 +506,50 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         return;
     }
 
+    /* 帧头版本协商:服务器 hello 可下发 version 切换双向帧格式。hello 一定
+     * 先于音频帧到达,这里切换不会撕裂已在途的帧。v3 头不带时间戳,开了
+     * 服务器 AEC 需要逐帧时间戳对齐,不接受降到 v3 */
+    auto version = cJSON_GetObjectItem(root, "version");
+    if (cJSON_IsNumber(version) && version->valueint != version_) {
+#if CONFIG_USE_SERVER_AEC
+        if (version->valueint == 3) {
+            ESP_LOGW(TAG, "Server offered version 3 but server AEC needs timestamps, keeping version %d", version_);
+        } else
+#endif
+        if (version->valueint >= 1 && version->valueint <= 3) {
+            ESP_LOGI(TAG, "Switching to binary protocol version %d", version->valueint);
+            version_ = version->valueint;
+        } else {
+            ESP_LOGW(TAG, "Ignoring unsupported protocol version %d", version->valueint);
+        }
+    }
+
+    int previous_sample_rate = server_sample_rate_;
+    int previous_frame_duration = server_frame_duration_;
+
     auto session_id = cJSON_GetObjectItem(root, "session_id");
     if (cJSON_IsString(session_id)) {
         session_id_ = session_id->valuestring;
         ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
     }
 
+    // 服务器回声明mcp_chunking后,超过单段上限的出站MCP报文才拆段发送
+    auto server_features = cJSON_GetObjectItem(root, "features");
+    if (cJSON_IsObject(server_features)) {
+        mcp_chunking_supported_ = cJSON_IsTrue(cJSON_GetObjectItem(server_features, "mcp_chunking"));
+        /* 上行合并帧数取服务器确认值与本地上限的较小者;服务器没回声明
+         * 就保持1。v1帧不自界定,协商结果对它不生效(发送路径单独处理) */
+        auto audio_batch = cJSON_GetObjectItem(server_features, "audio_batch");
+        if (cJSON_IsNumber(audio_batch)) {
+            audio_batch_frames_ = std::min(audio_batch->valueint, CONFIG_WEBSOCKET_AUDIO_BATCH_FRAMES);
+        } else if (cJSON_IsTrue(audio_batch)) {
+            audio_batch_frames_ = CONFIG_WEBSOCKET_AUDIO_BATCH_FRAMES;
+        }
+        if (audio_batch_frames_ < 1) {
+            audio_batch_frames_ = 1;
+        }
+    }
+
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
     if (cJSON_IsObject(audio_params)) {
         auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
@@ -249,5 +562,40 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         }
     }
 
+    if (optimistic_opened_ &&
+        (server_sample_rate_ != previous_sample_rate || server_frame_duration_ != previous_frame_duration)) {
+        // 解码参数按包自适应,这里只需要记录一次校正
+        ESP_LOGW(TAG, "Server hello differs from cache: %d Hz, %d ms", server_sample_rate_, server_frame_duration_);
+    }
+
+    // 更新 hello 缓存,下次重连同一服务器可以乐观开通道
+    {
+        Settings settings("ws_hello", true);
+        if (settings.GetString("url") != url_ ||
+            settings.GetInt("sample_rate") != server_sample_rate_ ||
+            settings.GetInt("frame_duration") != server_frame_duration_) {
+            settings.SetString("url", url_);
+            settings.SetInt("sample_rate", server_sample_rate_);
+            settings.SetInt("frame_duration", server_frame_duration_);
+        }
+    }
+
+    // 可选的混合模式:服务器下发 udp 字段时,音频帧改走加密 UDP 通道
+    auto udp = cJSON_GetObjectItem(root, "udp");
+    if (cJSON_IsObject(udp)) {
+        auto server = cJSON_GetObjectItem(udp, "server");
+        auto port = cJSON_GetObjectItem(udp, "port");
+        auto key = cJSON_GetObjectItem(udp, "key");
+        auto nonce = cJSON_GetObjectItem(udp, "nonce");
+        if (cJSON_IsString(server) && cJSON_IsNumber(port) && cJSON_IsString(key) && cJSON_IsString(nonce)) {
+            udp_server_ = server->valuestring;
+            udp_port_ = port->valueint;
+            udp_key_ = key->valuestring;
+            udp_nonce_ = nonce->valuestring;
+        } else {
+            ESP_LOGE(TAG, "Incomplete udp channel parameters in server hello");
+        }
+    }
+
     xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
 }
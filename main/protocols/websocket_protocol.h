@@ -3,12 +3,25 @@
 
 
 #include "protocol.h"
+#include "udp_audio_channel.h"
 
 #include <web_socket.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 #define WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
+#define WEBSOCKET_PROTOCOL_SEND_TEXT_EVENT (1 << 1)
+#define WEBSOCKET_PROTOCOL_SEND_TASK_QUIT_EVENT (1 << 2)
+#define WEBSOCKET_PROTOCOL_SEND_TASK_STOPPED_EVENT (1 << 3)
+
+// Outbound JSON queue depth; above this the oldest same-type message is superseded
+#define WEBSOCKET_PROTOCOL_MAX_PENDING_TEXT 16
+// Incoming JSON above this size is parsed on the main loop, not the network task
+#define WEBSOCKET_PROTOCOL_INLINE_JSON_LIMIT 4096
 
 class WebsocketProtocol : public Protocol {
 public:
@@ -17,6 +30,7 @@ public:
 
     bool Start() override;
     bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
+    void SendStopListening() override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
@@ -25,9 +39,46 @@ private:
     EventGroupHandle_t event_group_handle_;
     std::unique_ptr<WebSocket> websocket_;
     int version_ = 1;
+    // Cached connection settings so reconnects skip the NVS reads
+    std::string url_;
+    std::string token_;
+    // Channel was opened with the cached server hello before the real one arrived
+    bool optimistic_opened_ = false;
+    // Uplink frame counter, carried in BinaryProtocol2's reserved field
+    uint32_t send_sequence_ = 0;
+    // Uplink frame batching (only used when WEBSOCKET_AUDIO_BATCH_FRAMES > 1).
+    // 数据路径之外,结束监听/开关通道也要清刷半批,所以单独上锁
+    std::string batch_buffer_;
+    int batched_frames_ = 0;
+    std::mutex batch_mutex_;
+    // hello协商出的合并帧数:服务器回声明audio_batch前保持1(逐帧发)
+    int audio_batch_frames_ = 1;
+    // Hybrid mode: control JSON stays on the websocket, Opus frames go over
+    // the MQTT-style AES-CTR UDP channel when the server hello offers one
+    std::unique_ptr<UdpAudioChannel> udp_channel_;
+    /* Asynchronous outbound JSON: SendText only enqueues, a dedicated task does
+     * the blocking socket writes so the main loop latency stays flat.
+     * 两类负载的调度:音频帧在数据路径上直接发,JSON逐条由本任务发——
+     * 每条消息发完释放客户端TX锁,高优先级的音频路径在下一条边界立刻
+     * 插进去;大MCP报文经分块后每段就是一条消息,音频的额外延迟被限制
+     * 在单段的传输时间内 */
+    std::deque<std::string> send_text_queue_;
+    std::mutex send_text_mutex_;
+    std::condition_variable send_text_cv_;  // 队列腾出空间时唤醒被背压的入队方
+    size_t text_queued_bytes_ = 0;          // 当前排队的JSON字节数(guarded by send_text_mutex_)
+    // Guards websocket_ lifetime against the sender task (not the data path)
+    std::mutex websocket_mutex_;
+    std::string udp_server_;
+    int udp_port_ = 0;
+    std::string udp_key_;
+    std::string udp_nonce_;
 
+    bool FlushAudioBatch();
+    void SendTextTask();
+    void ParseIncomingJson(const char* data);
+    static std::string ExtractMessageType(const std::string& text);
     void ParseServerHello(const cJSON* root);
-    bool SendText(const std::string& text) override;
+    bool SendText(std::string text) override;
     std::string GetHelloMessage();
 };
 
@@ -0,0 +1,80 @@
+#include "session_snapshot.h"
+
+#include <cstring>
+#include <ctime>
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_sleep.h>
+#include <esp_app_desc.h>
+
+#define TAG "SessionSnapshot"
+
+#define SNAPSHOT_MAGIC 0x58535353  // "XSSS"
+// OTA检查最多延迟到下一次冷启动或24小时,取先到者
+#define SNAPSHOT_MAX_AGE_S (24 * 3600)
+
+namespace {
+
+struct SnapshotData {
+    uint32_t magic;
+    int64_t saved_at;  // time()时间戳,RTC时钟深睡期间继续走
+    uint8_t protocol_kind;
+    char firmware_version[32];
+    char session_id[33];
+};
+
+// RTC慢速内存,深睡期间保持供电,掉电或上电复位后内容为随机值(靠魔数判别)
+RTC_DATA_ATTR SnapshotData snapshot_data;
+
+}  // namespace
+
+bool SessionSnapshot::CanFastResume() {
+    // 只有深睡唤醒才考虑快路径,冷启动/软复位/崩溃重启都完整走一遍
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        return false;
+    }
+    if (snapshot_data.magic != SNAPSHOT_MAGIC ||
+        snapshot_data.protocol_kind == kProtocolNone) {
+        return false;
+    }
+    // 深睡期间完成过OTA升级是不可能的,但防御固件版本不一致的脏快照
+    auto app_desc = esp_app_get_description();
+    if (strncmp(snapshot_data.firmware_version, app_desc->version,
+                sizeof(snapshot_data.firmware_version)) != 0) {
+        Invalidate();
+        return false;
+    }
+    int64_t now = (int64_t)time(nullptr);
+    if (now < snapshot_data.saved_at || now - snapshot_data.saved_at > SNAPSHOT_MAX_AGE_S) {
+        ESP_LOGI(TAG, "Snapshot expired (age %lld s), doing full boot", (long long)(now - snapshot_data.saved_at));
+        Invalidate();
+        return false;
+    }
+    return true;
+}
+
+SessionSnapshot::ProtocolKind SessionSnapshot::protocol_kind() {
+    return (ProtocolKind)snapshot_data.protocol_kind;
+}
+
+const char* SessionSnapshot::session_id() {
+    snapshot_data.session_id[sizeof(snapshot_data.session_id) - 1] = '\0';
+    return snapshot_data.session_id;
+}
+
+void SessionSnapshot::Save(ProtocolKind kind, const std::string& session_id) {
+    snapshot_data.protocol_kind = kind;
+    snapshot_data.saved_at = (int64_t)time(nullptr);
+    auto app_desc = esp_app_get_description();
+    strncpy(snapshot_data.firmware_version, app_desc->version, sizeof(snapshot_data.firmware_version) - 1);
+    snapshot_data.firmware_version[sizeof(snapshot_data.firmware_version) - 1] = '\0';
+    strncpy(snapshot_data.session_id, session_id.c_str(), sizeof(snapshot_data.session_id) - 1);
+    snapshot_data.session_id[sizeof(snapshot_data.session_id) - 1] = '\0';
+    snapshot_data.magic = SNAPSHOT_MAGIC;
+}
+
+void SessionSnapshot::Invalidate() {
+    snapshot_data.magic = 0;
+    snapshot_data.protocol_kind = kProtocolNone;
+}
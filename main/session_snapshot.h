@@ -0,0 +1,30 @@
+#ifndef SESSION_SNAPSHOT_H
+#define SESSION_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+
+// 会话快照:把上次启动确定下来的会话参数留在RTC内存里,深睡唤醒后
+// Application::Start走快路径——跳过资产检查和OTA检查(省一次TLS往返),
+// 直接用缓存的协议类型重连。端点地址本来就在NVS里,websocket的hello
+// 参数也有NVS缓存,所以快照只需要记协议类型和新鲜度信息。
+// 掉电、复位或固件版本变化后快照自动失效,下一次冷启动仍完整检查。
+class SessionSnapshot {
+public:
+    enum ProtocolKind : uint8_t {
+        kProtocolNone = 0,
+        kProtocolMqtt = 1,
+        kProtocolWebsocket = 2,
+    };
+
+    // 本次启动是否为深睡唤醒、且快照仍然有效(魔数、固件版本、有效期)
+    static bool CanFastResume();
+    static ProtocolKind protocol_kind();
+    static const char* session_id();
+    // 启动流程完整走完(协议启动成功)后记录快照
+    static void Save(ProtocolKind kind, const std::string& session_id);
+    // 配置可能已变(激活、重新配网)时主动作废
+    static void Invalidate();
+};
+
+#endif // SESSION_SNAPSHOT_H
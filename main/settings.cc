@@ -1,10 +1,119 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
 
+#include <map>
+#include <mutex>
+#include <utility>
+
 #define TAG "Settings"
 
+namespace {
+
+// 写合并层:Set*先落在RAM里,由定时器批量提交NVS。
+// 连续的设置风暴(闹钟编辑、网络切换)只产生一次flash提交,
+// 主循环不再被毫秒级的逐键写入卡顿
+struct PendingValue {
+    enum class Type { kString, kInt, kBool, kBlob, kErase };
+    Type type;
+    std::string string_value;
+    int32_t int_value = 0;
+    bool bool_value = false;
+};
+
+std::mutex g_pending_mutex;
+std::map<std::pair<std::string, std::string>, PendingValue> g_pending_writes;
+esp_timer_handle_t g_flush_timer = nullptr;
+
+constexpr int64_t kFlushDelayUs = 1000 * 1000;  // 合并1秒内的写入
+
+void FlushTimerCallback(void*) {
+    Settings::Flush();
+}
+
+void ScheduleFlushLocked() {
+    if (g_flush_timer == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = FlushTimerCallback;
+        args.name = "settings_flush";
+        ESP_ERROR_CHECK(esp_timer_create(&args, &g_flush_timer));
+    }
+    if (!esp_timer_is_active(g_flush_timer)) {
+        ESP_ERROR_CHECK(esp_timer_start_once(g_flush_timer, kFlushDelayUs));
+    }
+}
+
+}  // namespace
+
+void Settings::Flush() {
+    std::map<std::pair<std::string, std::string>, PendingValue> pending;
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        pending.swap(g_pending_writes);
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    // map按(namespace, key)有序,同一命名空间的写入连在一起,
+    // 每个命名空间只开关一次句柄、提交一次
+    nvs_handle_t handle = 0;
+    std::string current_ns;
+    bool dirty = false;
+    auto commit_and_close = [&]() {
+        if (handle != 0) {
+            if (dirty) {
+                ESP_ERROR_CHECK(nvs_commit(handle));
+            }
+            nvs_close(handle);
+            handle = 0;
+            dirty = false;
+        }
+    };
+
+    for (auto& item : pending) {
+        const std::string& ns = item.first.first;
+        const std::string& key = item.first.second;
+        PendingValue& value = item.second;
+
+        if (ns != current_ns || handle == 0) {
+            commit_and_close();
+            current_ns = ns;
+            if (nvs_open(ns.c_str(), NVS_READWRITE, &handle) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to open namespace %s for flush", ns.c_str());
+                handle = 0;
+                continue;
+            }
+        }
+
+        switch (value.type) {
+        case PendingValue::Type::kString:
+            ESP_ERROR_CHECK(nvs_set_str(handle, key.c_str(), value.string_value.c_str()));
+            break;
+        case PendingValue::Type::kInt:
+            ESP_ERROR_CHECK(nvs_set_i32(handle, key.c_str(), value.int_value));
+            break;
+        case PendingValue::Type::kBool:
+            ESP_ERROR_CHECK(nvs_set_u8(handle, key.c_str(), value.bool_value ? 1 : 0));
+            break;
+        case PendingValue::Type::kBlob:
+            ESP_ERROR_CHECK(nvs_set_blob(handle, key.c_str(), value.string_value.data(), value.string_value.size()));
+            break;
+        case PendingValue::Type::kErase: {
+            auto ret = nvs_erase_key(handle, key.c_str());
+            if (ret != ESP_ERR_NVS_NOT_FOUND) {
+                ESP_ERROR_CHECK(ret);
+            }
+            break;
+        }
+        }
+        dirty = true;
+    }
+    commit_and_close();
+}
+
 Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
     nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
 }
@@ -19,6 +128,18 @@ Settings::~Settings() {
 }
 
 std::string Settings::GetString(const std::string& key, const std::string& default_value) {
+    // 读穿透:先查未落盘的写合并条目
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto it = g_pending_writes.find({ns_, key});
+        if (it != g_pending_writes.end()) {
+            if (it->second.type == PendingValue::Type::kString) {
+                return it->second.string_value;
+            }
+            return default_value;  // 已被删除或改成了其他类型
+        }
+    }
+
     if (nvs_handle_ == 0) {
         return default_value;
     }
@@ -39,14 +160,28 @@ std::string Settings::GetString(const std::string& key, const std::string& defau
 
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto& pending = g_pending_writes[{ns_, key}];
+        pending.type = PendingValue::Type::kString;
+        pending.string_value = value;
+        ScheduleFlushLocked();
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto it = g_pending_writes.find({ns_, key});
+        if (it != g_pending_writes.end()) {
+            if (it->second.type == PendingValue::Type::kInt) {
+                return it->second.int_value;
+            }
+            return default_value;
+        }
+    }
+
     if (nvs_handle_ == 0) {
         return default_value;
     }
@@ -60,14 +195,28 @@ int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
 
 void Settings::SetInt(const std::string& key, int32_t value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto& pending = g_pending_writes[{ns_, key}];
+        pending.type = PendingValue::Type::kInt;
+        pending.int_value = value;
+        ScheduleFlushLocked();
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 bool Settings::GetBool(const std::string& key, bool default_value) {
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto it = g_pending_writes.find({ns_, key});
+        if (it != g_pending_writes.end()) {
+            if (it->second.type == PendingValue::Type::kBool) {
+                return it->second.bool_value;
+            }
+            return default_value;
+        }
+    }
+
     if (nvs_handle_ == 0) {
         return default_value;
     }
@@ -81,8 +230,51 @@ bool Settings::GetBool(const std::string& key, bool default_value) {
 
 void Settings::SetBool(const std::string& key, bool value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_u8(nvs_handle_, key.c_str(), value ? 1 : 0));
-        dirty_ = true;
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto& pending = g_pending_writes[{ns_, key}];
+        pending.type = PendingValue::Type::kBool;
+        pending.bool_value = value;
+        ScheduleFlushLocked();
+    } else {
+        ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
+    }
+}
+
+std::string Settings::GetBlob(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto it = g_pending_writes.find({ns_, key});
+        if (it != g_pending_writes.end()) {
+            if (it->second.type == PendingValue::Type::kBlob) {
+                return it->second.string_value;
+            }
+            return "";
+        }
+    }
+
+    if (nvs_handle_ == 0) {
+        return "";
+    }
+
+    size_t length = 0;
+    if (nvs_get_blob(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK || length == 0) {
+        return "";
+    }
+
+    // std::string可以携带NUL字节,直接当字节容器用
+    std::string value;
+    value.resize(length);
+    ESP_ERROR_CHECK(nvs_get_blob(nvs_handle_, key.c_str(), value.data(), &length));
+    return value;
+}
+
+void Settings::SetBlob(const std::string& key, const void* data, size_t size) {
+    if (read_write_) {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto& pending = g_pending_writes[{ns_, key}];
+        pending.type = PendingValue::Type::kBlob;
+        pending.string_value.assign(static_cast<const char*>(data), size);
+        ScheduleFlushLocked();
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -90,18 +282,50 @@ void Settings::SetBool(const std::string& key, bool value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        auto& pending = g_pending_writes[{ns_, key}];
+        pending.type = PendingValue::Type::kErase;
+        pending.string_value.clear();
+        ScheduleFlushLocked();
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
+int32_t Settings::BenchmarkCommitUs() {
+    nvs_handle_t handle;
+    if (nvs_open("flash_bench", NVS_READWRITE, &handle) != ESP_OK) {
+        return -1;
+    }
+
+    const int kRounds = 4;
+    int64_t total_us = 0;
+    for (int i = 0; i < kRounds; i++) {
+        int64_t t0 = esp_timer_get_time();
+        // 每轮换值,保证NVS真的追加新条目而不是识别为无变化
+        nvs_set_i32(handle, "probe", (int32_t)(t0 & 0x7FFFFFFF) + i);
+        nvs_commit(handle);
+        total_us += esp_timer_get_time() - t0;
+    }
+    nvs_close(handle);
+    return (int32_t)(total_us / kRounds);
+}
+
 void Settings::EraseAll() {
     if (read_write_) {
+        // 全量擦除走不了写合并(语义是"清空"),先丢弃本命名空间的待写条目再直写
+        {
+            std::lock_guard<std::mutex> lock(g_pending_mutex);
+            for (auto it = g_pending_writes.begin(); it != g_pending_writes.end();) {
+                if (it->first.first == ns_) {
+                    it = g_pending_writes.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
         ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        dirty_ = true;
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
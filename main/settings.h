@@ -9,12 +9,22 @@ public:
     Settings(const std::string& ns, bool read_write = false);
     ~Settings();
 
+    // 把写合并层里的待写条目立即提交到NVS(重启前必须调用)
+    static void Flush();
+
+    // NVS提交延迟基准:直写+commit取平均微秒数,失败返回-1。
+    // 用独立的bench命名空间,不经过写合并层,量的是真实落盘耗时
+    static int32_t BenchmarkCommitUs();
+
     std::string GetString(const std::string& key, const std::string& default_value = "");
     void SetString(const std::string& key, const std::string& value);
     int32_t GetInt(const std::string& key, int32_t default_value = 0);
     void SetInt(const std::string& key, int32_t value);
     bool GetBool(const std::string& key, bool default_value = false);
     void SetBool(const std::string& key, bool value);
+    // 二进制记录整存整取(版本号由调用方放在记录头里),不存在时返回空
+    std::string GetBlob(const std::string& key);
+    void SetBlob(const std::string& key, const void* data, size_t size);
     void EraseKey(const std::string& key);
     void EraseAll();
 
@@ -0,0 +1,319 @@
+#include "settings_snapshot.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_crc.h>
+#include <nvs_flash.h>
+#include <nvs.h>
+#include <mbedtls/base64.h>
+
+#include <cstring>
+#include <vector>
+
+#define TAG "SettingsSnapshot"
+
+namespace {
+
+// 可跨设备复制的命名空间。注意不含:
+//   board        — 设备uuid,克隆会让整批设备顶同一个身份
+//   *_trims      — 舵机/电机出厂校准,逐台不同
+//   crash/download/ws_hello — 本地状态和缓存,换了机器没有意义
+//   sparkbot     — 板级本地状态
+constexpr const char* kWhitelist[] = {
+    "wifi", "websocket", "mqtt", "network", "ota",
+    "vendor", "audio", "display", "led_strip",
+};
+
+constexpr char kMagic[4] = {'X', 'Z', 'S', 'S'};
+constexpr uint8_t kVersion = 1;
+
+// 快照布局(小端):
+//   magic[4] version u8 reserved u8 entry_count u16 <entries...> crc32 u32
+// 条目:ns_len u8, ns, key_len u8, key, type u8(nvs_type_t), val_len u16, val
+// U8存1字节,I32存4字节小端,STR不含结尾NUL,BLOB原样
+
+void PutU16(std::string& out, uint16_t v) {
+    out.push_back((char)(v & 0xFF));
+    out.push_back((char)(v >> 8));
+}
+
+bool IsWhitelisted(const std::string& ns) {
+    for (auto* name : kWhitelist) {
+        if (ns == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct StagedEntry {
+    std::string ns;
+    std::string key;
+    uint8_t type;
+    std::string value;
+};
+
+cJSON* MakeError(const char* message) {
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "success", false);
+    cJSON_AddStringToObject(json, "error", message);
+    return json;
+}
+
+}  // namespace
+
+std::string SettingsSnapshot::ExportBase64() {
+    // 写合并层里可能还有没落盘的条目,先刷下去,快照才是当前值
+    Settings::Flush();
+
+    std::string payload;
+    uint16_t entry_count = 0;
+
+    for (auto* ns : kWhitelist) {
+        nvs_iterator_t it = nullptr;
+        esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, ns, NVS_TYPE_ANY, &it);
+        if (err != ESP_OK) {
+            continue;  // 该命名空间还没有任何键
+        }
+
+        nvs_handle_t handle = 0;
+        if (nvs_open(ns, NVS_READONLY, &handle) != ESP_OK) {
+            nvs_entry_release(it);
+            continue;
+        }
+
+        while (err == ESP_OK) {
+            nvs_entry_info_t info;
+            nvs_entry_info(it, &info);
+
+            std::string value;
+            bool supported = true;
+            switch (info.type) {
+            case NVS_TYPE_U8: {
+                uint8_t v = 0;
+                ESP_ERROR_CHECK(nvs_get_u8(handle, info.key, &v));
+                value.assign(1, (char)v);
+                break;
+            }
+            case NVS_TYPE_I32: {
+                int32_t v = 0;
+                ESP_ERROR_CHECK(nvs_get_i32(handle, info.key, &v));
+                uint32_t u = (uint32_t)v;
+                value.push_back((char)(u & 0xFF));
+                value.push_back((char)((u >> 8) & 0xFF));
+                value.push_back((char)((u >> 16) & 0xFF));
+                value.push_back((char)((u >> 24) & 0xFF));
+                break;
+            }
+            case NVS_TYPE_STR: {
+                size_t length = 0;
+                if (nvs_get_str(handle, info.key, nullptr, &length) == ESP_OK && length > 0) {
+                    value.resize(length);
+                    ESP_ERROR_CHECK(nvs_get_str(handle, info.key, value.data(), &length));
+                    while (!value.empty() && value.back() == '\0') {
+                        value.pop_back();
+                    }
+                }
+                break;
+            }
+            case NVS_TYPE_BLOB: {
+                size_t length = 0;
+                if (nvs_get_blob(handle, info.key, nullptr, &length) == ESP_OK && length > 0) {
+                    value.resize(length);
+                    ESP_ERROR_CHECK(nvs_get_blob(handle, info.key, value.data(), &length));
+                }
+                break;
+            }
+            default:
+                // Settings封装只产出这四种;其他类型是手写的,跳过并留日志
+                ESP_LOGW(TAG, "Skipping %s/%s: unsupported type %d", ns, info.key, info.type);
+                supported = false;
+                break;
+            }
+
+            if (supported && value.size() <= 0xFFFF) {
+                size_t ns_len = strlen(ns);
+                payload.push_back((char)ns_len);
+                payload.append(ns, ns_len);
+                size_t key_len = strlen(info.key);
+                payload.push_back((char)key_len);
+                payload.append(info.key, key_len);
+                payload.push_back((char)info.type);
+                PutU16(payload, (uint16_t)value.size());
+                payload.append(value);
+                entry_count++;
+            }
+
+            err = nvs_entry_next(&it);
+        }
+        nvs_entry_release(it);
+        nvs_close(handle);
+    }
+
+    std::string blob;
+    blob.reserve(sizeof(kMagic) + 4 + payload.size() + 4);
+    blob.append(kMagic, sizeof(kMagic));
+    blob.push_back((char)kVersion);
+    blob.push_back(0);  // reserved
+    PutU16(blob, entry_count);
+    blob.append(payload);
+    uint32_t crc = esp_crc32_le(0, (const uint8_t*)blob.data(), blob.size());
+    blob.push_back((char)(crc & 0xFF));
+    blob.push_back((char)((crc >> 8) & 0xFF));
+    blob.push_back((char)((crc >> 16) & 0xFF));
+    blob.push_back((char)((crc >> 24) & 0xFF));
+
+    size_t encoded_len = 0;
+    mbedtls_base64_encode(nullptr, 0, &encoded_len, (const uint8_t*)blob.data(), blob.size());
+    std::string encoded;
+    encoded.resize(encoded_len);
+    if (mbedtls_base64_encode((uint8_t*)encoded.data(), encoded.size(), &encoded_len,
+                              (const uint8_t*)blob.data(), blob.size()) != 0) {
+        ESP_LOGE(TAG, "base64 encode failed");
+        return "";
+    }
+    encoded.resize(encoded_len);
+    ESP_LOGI(TAG, "Exported %u entries, %u bytes (base64 %u)",
+             entry_count, (unsigned)blob.size(), (unsigned)encoded.size());
+    return encoded;
+}
+
+cJSON* SettingsSnapshot::ImportBase64(const std::string& encoded) {
+    size_t decoded_len = 0;
+    mbedtls_base64_decode(nullptr, 0, &decoded_len, (const uint8_t*)encoded.data(), encoded.size());
+    std::string blob;
+    blob.resize(decoded_len);
+    if (mbedtls_base64_decode((uint8_t*)blob.data(), blob.size(), &decoded_len,
+                              (const uint8_t*)encoded.data(), encoded.size()) != 0) {
+        return MakeError("invalid base64");
+    }
+    blob.resize(decoded_len);
+
+    // --- 第一段:只解析,任何失败都不碰NVS ---
+    if (blob.size() < sizeof(kMagic) + 4 + 4 || memcmp(blob.data(), kMagic, sizeof(kMagic)) != 0) {
+        return MakeError("not a settings snapshot");
+    }
+    if ((uint8_t)blob[4] != kVersion) {
+        return MakeError("unsupported snapshot version");
+    }
+    uint32_t stored_crc = (uint8_t)blob[blob.size() - 4] |
+                          ((uint8_t)blob[blob.size() - 3] << 8) |
+                          ((uint8_t)blob[blob.size() - 2] << 16) |
+                          ((uint32_t)(uint8_t)blob[blob.size() - 1] << 24);
+    uint32_t crc = esp_crc32_le(0, (const uint8_t*)blob.data(), blob.size() - 4);
+    if (crc != stored_crc) {
+        return MakeError("crc mismatch");
+    }
+
+    uint16_t entry_count = (uint8_t)blob[6] | ((uint8_t)blob[7] << 8);
+    size_t pos = 8;
+    size_t end = blob.size() - 4;
+    std::vector<StagedEntry> staged;
+    staged.reserve(entry_count);
+
+    for (uint16_t i = 0; i < entry_count; i++) {
+        if (pos >= end) {
+            return MakeError("truncated snapshot");
+        }
+        size_t ns_len = (uint8_t)blob[pos++];
+        if (pos + ns_len > end) {
+            return MakeError("truncated snapshot");
+        }
+        std::string ns = blob.substr(pos, ns_len);
+        pos += ns_len;
+
+        if (pos >= end) {
+            return MakeError("truncated snapshot");
+        }
+        size_t key_len = (uint8_t)blob[pos++];
+        // NVS键上限15字符,超了说明blob坏了
+        if (key_len == 0 || key_len > NVS_KEY_NAME_MAX_SIZE - 1 || pos + key_len > end) {
+            return MakeError("invalid key");
+        }
+        std::string key = blob.substr(pos, key_len);
+        pos += key_len;
+
+        if (pos + 3 > end) {
+            return MakeError("truncated snapshot");
+        }
+        uint8_t type = (uint8_t)blob[pos++];
+        size_t val_len = (uint8_t)blob[pos] | ((uint8_t)blob[pos + 1] << 8);
+        pos += 2;
+        if (pos + val_len > end) {
+            return MakeError("truncated snapshot");
+        }
+
+        if (!IsWhitelisted(ns)) {
+            return MakeError("namespace not in whitelist");
+        }
+        if (type != NVS_TYPE_U8 && type != NVS_TYPE_I32 &&
+            type != NVS_TYPE_STR && type != NVS_TYPE_BLOB) {
+            return MakeError("unsupported entry type");
+        }
+        if ((type == NVS_TYPE_U8 && val_len != 1) || (type == NVS_TYPE_I32 && val_len != 4)) {
+            return MakeError("bad value length");
+        }
+
+        staged.push_back({std::move(ns), std::move(key), type, blob.substr(pos, val_len)});
+        pos += val_len;
+    }
+    if (pos != end) {
+        return MakeError("trailing bytes in snapshot");
+    }
+
+    // --- 第二段:先排空写合并层(免得旧的待写条目晚于导入落盘),
+    // 再逐命名空间清空-写入-提交。staged按导出顺序天然按命名空间分组 ---
+    Settings::Flush();
+
+    int namespaces_applied = 0;
+    nvs_handle_t handle = 0;
+    std::string current_ns;
+    auto commit_and_close = [&]() {
+        if (handle != 0) {
+            ESP_ERROR_CHECK(nvs_commit(handle));
+            nvs_close(handle);
+            handle = 0;
+        }
+    };
+
+    for (auto& entry : staged) {
+        if (entry.ns != current_ns || handle == 0) {
+            commit_and_close();
+            current_ns = entry.ns;
+            if (nvs_open(entry.ns.c_str(), NVS_READWRITE, &handle) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to open namespace %s", entry.ns.c_str());
+                handle = 0;
+                continue;
+            }
+            // 快照语义是"替换",不在快照里的旧键一并清掉
+            ESP_ERROR_CHECK(nvs_erase_all(handle));
+            namespaces_applied++;
+        }
+
+        switch (entry.type) {
+        case NVS_TYPE_U8:
+            ESP_ERROR_CHECK(nvs_set_u8(handle, entry.key.c_str(), (uint8_t)entry.value[0]));
+            break;
+        case NVS_TYPE_I32: {
+            uint32_t u = (uint8_t)entry.value[0] | ((uint8_t)entry.value[1] << 8) |
+                         ((uint8_t)entry.value[2] << 16) | ((uint32_t)(uint8_t)entry.value[3] << 24);
+            ESP_ERROR_CHECK(nvs_set_i32(handle, entry.key.c_str(), (int32_t)u));
+            break;
+        }
+        case NVS_TYPE_STR:
+            ESP_ERROR_CHECK(nvs_set_str(handle, entry.key.c_str(), entry.value.c_str()));
+            break;
+        case NVS_TYPE_BLOB:
+            ESP_ERROR_CHECK(nvs_set_blob(handle, entry.key.c_str(), entry.value.data(), entry.value.size()));
+            break;
+        }
+    }
+    commit_and_close();
+
+    ESP_LOGI(TAG, "Imported %u entries into %d namespaces", (unsigned)staged.size(), namespaces_applied);
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "success", true);
+    cJSON_AddNumberToObject(json, "namespaces", namespaces_applied);
+    cJSON_AddNumberToObject(json, "entries", (double)staged.size());
+    return json;
+}
@@ -0,0 +1,28 @@
+#ifndef SETTINGS_SNAPSHOT_H
+#define SETTINGS_SNAPSHOT_H
+
+#include <string>
+
+#include <cJSON.h>
+
+// 批量配置快照:把白名单内的Settings命名空间整体导出为一个带版本号
+// 和CRC的二进制blob(base64包装走MCP),新设备一次导入、按命名空间
+// 原子落盘,批量开通从几十次MCP往返缩到一来一回。
+//
+// 白名单只收"可以在整批设备间复制"的配置:服务器地址、WiFi、音频/
+// 显示偏好等。设备身份(board里的uuid)、出厂校准(*_trims)、本地
+// 缓存(download/ws_hello/crash)一律不进快照,克隆它们是事故不是功能。
+class SettingsSnapshot {
+public:
+    // 先Flush写合并层再逐命名空间枚举NVS,返回base64编码的快照。
+    // 失败返回空串
+    static std::string ExportBase64();
+
+    // 两段式导入:先完整解码+校验(magic/版本/CRC/白名单/长度),
+    // 任何一处不过直接返回错误、NVS一个字节都不动;校验通过后逐
+    // 命名空间"清空-写入-提交",每个命名空间一次commit。
+    // 返回结果JSON(所有权交给调用方)
+    static cJSON* ImportBase64(const std::string& blob);
+};
+
+#endif
@@ -0,0 +1,224 @@
+#include "soak_test.h"
+#include "application.h"
+#include "stack_audit.h"
+#include "board.h"
+#include "display.h"
+#include "assets/lang_config.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <cJSON.h>
+
+#define TAG "SoakTest"
+
+namespace {
+
+// 每轮换一个表情,顺带压一遍表情GIF的解码/渲染路径
+const char* const kEmotions[] = {
+    "happy", "thinking", "laughing", "surprised", "neutral",
+};
+
+// 等待设备进入目标状态,返回耗时ms,超时返回-1
+int WaitForState(DeviceState state, uint32_t timeout_ms) {
+    auto& app = Application::GetInstance();
+    int64_t t0 = esp_timer_get_time();
+    while ((esp_timer_get_time() - t0) / 1000 < timeout_ms) {
+        if (app.GetDeviceState() == state) {
+            return (int)((esp_timer_get_time() - t0) / 1000);
+        }
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    return -1;
+}
+
+}  // namespace
+
+bool SoakTest::Start(int cycles) {
+    bool expected = false;
+    if (!running_.compare_exchange_strong(expected, true)) {
+        ESP_LOGW(TAG, "Soak test already running");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        cycles_done_ = 0;
+        cycles_failed_ = 0;
+        wake_timeout_count_ = 0;
+        for (auto& bucket : latency_histogram_) {
+            bucket = 0;
+        }
+        max_wake_latency_ms_ = 0;
+        baseline_free_heap_ = 0;
+        min_free_heap_ = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        auto& stats = Application::GetInstance().GetAudioService().GetDebugStatistics();
+        start_underruns_ = stats.playback_underrun_count;
+        start_send_drops_ = stats.send_drop_count;
+        fail_reason_.clear();
+    }
+    stop_requested_ = false;
+    target_cycles_ = cycles;
+
+    xTaskCreate([](void* arg) {
+        auto self = (SoakTest*)arg;
+        self->RunLoop();
+        self->running_ = false;
+        vTaskDelete(NULL);
+    }, "soak_test", 4096 * 2, this, 1, nullptr);
+
+    ESP_LOGI(TAG, "Soak test started, %d cycles", cycles);
+    return true;
+}
+
+void SoakTest::Stop() {
+    stop_requested_ = true;
+}
+
+void SoakTest::Fail(const char* reason) {
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        fail_reason_ = reason;
+    }
+    // 大声报警:红屏Alert+错误日志,机架巡检一眼能看到
+    ESP_LOGE(TAG, "SOAK_FAIL %s (after %lu cycles)", reason, (unsigned long)cycles_done_);
+    Application::GetInstance().Alert(Lang::Strings::ERROR, reason, "circle_xmark",
+                                     Lang::Sounds::OGG_EXCLAMATION);
+}
+
+bool SoakTest::RunOneCycle(int cycle) {
+    auto& app = Application::GetInstance();
+
+    // 等设备空闲再发起下一轮,服务器收尾的TTS可能还在播
+    if (WaitForState(kDeviceStateIdle, 30000) < 0) {
+        Fail("Device stuck outside idle for 30s");
+        return false;
+    }
+
+    /* 真实采集路径上没有AfeWakeWord之前的注入点(PCM直接从codec DMA
+     * 进AFE),所以从检测回调之后开始合成:走WakeWordInvoke,覆盖
+     * 唤醒词上报、开通道、状态机切换等检测下游的全部环节 */
+    int64_t t0 = esp_timer_get_time();
+    app.WakeWordInvoke("你好小智");
+    int latency_ms = WaitForState(kDeviceStateListening, kWakeTimeoutMs);
+
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        if (latency_ms < 0) {
+            wake_timeout_count_++;
+            cycles_failed_++;
+        } else {
+            static const uint32_t kBucketEdgesMs[] = {250, 500, 1000, 2000};
+            int bucket = 4;
+            for (int i = 0; i < 4; i++) {
+                if ((uint32_t)latency_ms < kBucketEdgesMs[i]) {
+                    bucket = i;
+                    break;
+                }
+            }
+            latency_histogram_[bucket]++;
+            if ((uint32_t)latency_ms > max_wake_latency_ms_) {
+                max_wake_latency_ms_ = latency_ms;
+            }
+        }
+    }
+
+    if (latency_ms >= 0) {
+        // 保持Listening几秒:真实的采集->AFE->Opus编码->上行链路全程在跑
+        vTaskDelay(pdMS_TO_TICKS(3000));
+        app.StopListening();
+    } else {
+        // 超时的轮次把会话收掉,别让下一轮卡在Connecting上
+        app.StopListening();
+    }
+
+    // 下行通路:播放预缓存提示音,压解码/重采样/播放队列
+    app.PlaySound(Lang::Sounds::OGG_SUCCESS);
+    auto display = Board::GetInstance().GetDisplay();
+    if (display != nullptr) {
+        display->SetEmotion(kEmotions[cycle % (sizeof(kEmotions) / sizeof(kEmotions[0]))]);
+    }
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // 回归检查:堆漂移按热身后的基线算,欠载/丢帧看总量增速
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    auto& stats = app.GetAudioService().GetDebugStatistics();
+    uint32_t underrun_delta;
+    uint32_t drop_delta;
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        cycles_done_++;
+        if (free_heap < min_free_heap_) {
+            min_free_heap_ = free_heap;
+        }
+        if (cycle == kWarmupCycles) {
+            baseline_free_heap_ = free_heap;
+        }
+        underrun_delta = stats.playback_underrun_count - start_underruns_;
+        drop_delta = stats.send_drop_count - start_send_drops_;
+    }
+
+    if (baseline_free_heap_ > 0 &&
+        free_heap + kHeapDriftThresholdBytes < baseline_free_heap_) {
+        Fail("Internal heap drifted below warmup baseline");
+        return false;
+    }
+    // 偶发欠载可以接受(网络抖动),持续每轮都欠载说明回归了
+    if (cycle > kWarmupCycles && underrun_delta > (uint32_t)(5 + cycle)) {
+        Fail("Playback underruns accumulating every cycle");
+        return false;
+    }
+    if (cycle > kWarmupCycles && drop_delta > (uint32_t)(5 + cycle)) {
+        Fail("Uplink send drops accumulating every cycle");
+        return false;
+    }
+    return true;
+}
+
+void SoakTest::RunLoop() {
+    for (int cycle = 0; cycle < target_cycles_ && !stop_requested_; cycle++) {
+        if (!RunOneCycle(cycle)) {
+            return;
+        }
+        // 每轮刷一次全任务栈水位:烤机覆盖的就是真实负载下的最深调用链
+        StackAudit::GetInstance().Sample();
+        if ((cycle + 1) % 10 == 0) {
+            ESP_LOGI(TAG, "SOAK %s", GetReportJson().c_str());
+        }
+    }
+    ESP_LOGI(TAG, "Soak test finished: %s", GetReportJson().c_str());
+}
+
+std::string SoakTest::GetReportJson() {
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    auto& stats = Application::GetInstance().GetAudioService().GetDebugStatistics();
+
+    auto root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "running", running_.load());
+    cJSON_AddNumberToObject(root, "cycles_done", cycles_done_);
+    cJSON_AddNumberToObject(root, "cycles_failed", cycles_failed_);
+    cJSON_AddNumberToObject(root, "wake_timeouts", wake_timeout_count_);
+    auto histogram = cJSON_CreateArray();
+    for (auto bucket : latency_histogram_) {
+        cJSON_AddItemToArray(histogram, cJSON_CreateNumber(bucket));
+    }
+    cJSON_AddItemToObject(root, "wake_latency_hist", histogram);
+    cJSON_AddNumberToObject(root, "max_wake_latency_ms", max_wake_latency_ms_);
+    cJSON_AddNumberToObject(root, "baseline_free_heap", baseline_free_heap_);
+    cJSON_AddNumberToObject(root, "min_free_heap", min_free_heap_);
+    cJSON_AddNumberToObject(root, "free_heap",
+                            heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    cJSON_AddNumberToObject(root, "underruns", stats.playback_underrun_count - start_underruns_);
+    cJSON_AddNumberToObject(root, "send_drops", stats.send_drop_count - start_send_drops_);
+    if (!fail_reason_.empty()) {
+        cJSON_AddStringToObject(root, "fail_reason", fail_reason_.c_str());
+    }
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
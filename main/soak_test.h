@@ -0,0 +1,65 @@
+#ifndef SOAK_TEST_H
+#define SOAK_TEST_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+// 烤机模式:循环合成会话(唤醒->收音上行->结束->放提示音->切表情),
+// 连跑数小时并记录堆水位、播放欠载和唤醒时延直方图,越过回归阈值
+// 立即大声报警。放机架上过夜跑,替代真人逐板对话做发版性能回归
+class SoakTest {
+public:
+    static SoakTest& GetInstance() {
+        static SoakTest instance;
+        return instance;
+    }
+
+    SoakTest(const SoakTest&) = delete;
+    SoakTest& operator=(const SoakTest&) = delete;
+
+    // 启动烤机任务,cycles为合成会话次数;已在跑时返回false
+    bool Start(int cycles);
+    // 请求停止,当前会话收尾后退出
+    void Stop();
+    bool IsRunning() const { return running_.load(); }
+    // 当前统计(JSON):会话数、失败数、时延直方图、堆水位、欠载增量
+    std::string GetReportJson();
+
+private:
+    SoakTest() = default;
+
+    void RunLoop();
+    // 跑一轮合成会话,返回false表示触发了回归阈值,循环应当停止
+    bool RunOneCycle(int cycle);
+    void Fail(const char* reason);
+
+    // 热身轮数:前几轮各缓存还在填充,堆基线在热身结束后才记录
+    static constexpr int kWarmupCycles = 8;
+    // 空闲堆相对基线跌过此值视为泄漏
+    static constexpr size_t kHeapDriftThresholdBytes = 16 * 1024;
+    // 唤醒->Listening超过此值计为一次超时失败
+    static constexpr uint32_t kWakeTimeoutMs = 10000;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+    int target_cycles_ = 0;
+
+    // 统计(guarded by report_mutex_,MCP工具并发读)
+    mutable std::mutex report_mutex_;
+    uint32_t cycles_done_ = 0;
+    uint32_t cycles_failed_ = 0;
+    uint32_t wake_timeout_count_ = 0;
+    // 唤醒->进入Listening的时延,桶边界 250/500/1000/2000ms
+    uint32_t latency_histogram_[5] = {};
+    uint32_t max_wake_latency_ms_ = 0;
+    size_t baseline_free_heap_ = 0;
+    size_t min_free_heap_ = 0;
+    uint32_t start_underruns_ = 0;
+    uint32_t start_send_drops_ = 0;
+    std::string fail_reason_;
+};
+
+#endif // SOAK_TEST_H
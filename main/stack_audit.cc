@@ -0,0 +1,71 @@
+#include "stack_audit.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <cJSON.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#define TAG "StackAudit"
+
+void StackAudit::Sample() {
+    UBaseType_t array_size = uxTaskGetNumberOfTasks() + 5;
+    auto array = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * array_size);
+    if (array == nullptr) {
+        return;
+    }
+    array_size = uxTaskGetSystemState(array, array_size, nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (UBaseType_t i = 0; i < array_size; i++) {
+        auto& status = array[i];
+        uint32_t remaining = (uint32_t)status.usStackHighWaterMark * sizeof(StackType_t);
+        auto it = tasks_.find(status.pcTaskName);
+        if (it == tasks_.end()) {
+            it = tasks_.emplace(status.pcTaskName, TaskWatermark{remaining, 0, false}).first;
+        } else if (remaining < it->second.min_remaining) {
+            it->second.min_remaining = remaining;
+        }
+        it->second.priority = (uint32_t)status.uxCurrentPriority;
+
+        if (it->second.min_remaining < kAlarmBytes && !it->second.alarmed) {
+            it->second.alarmed = true;
+            ESP_LOGE(TAG, "Stack alarm: task %s down to %lu bytes remaining",
+                     status.pcTaskName, (unsigned long)it->second.min_remaining);
+        }
+    }
+    free(array);
+}
+
+std::string StackAudit::DumpJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 剩余量升序:最危险/最无可回收的任务排最前
+    std::vector<std::pair<const std::string*, const TaskWatermark*>> sorted;
+    sorted.reserve(tasks_.size());
+    for (auto& entry : tasks_) {
+        sorted.push_back({&entry.first, &entry.second});
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second->min_remaining < b.second->min_remaining;
+    });
+
+    auto root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "alarm_bytes", kAlarmBytes);
+    auto tasks = cJSON_AddArrayToObject(root, "tasks");
+    for (auto& entry : sorted) {
+        auto task = cJSON_CreateObject();
+        cJSON_AddStringToObject(task, "name", entry.first->c_str());
+        cJSON_AddNumberToObject(task, "min_remaining", entry.second->min_remaining);
+        cJSON_AddNumberToObject(task, "priority", entry.second->priority);
+        cJSON_AddItemToArray(tasks, task);
+    }
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
@@ -0,0 +1,45 @@
+#ifndef STACK_AUDIT_H
+#define STACK_AUDIT_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// 栈审计:按任务名累计整个运行期的最小剩余栈(watermark),给各任务创建
+// 点的栈大小回收提供实测依据——几十个任务的保守硬编码栈常驻吃掉数十KB
+// 内部RAM。烤机循环每轮采样一次覆盖真实负载,self.stack.audit按需采样
+// 并导出;剩余量跌破告警线的任务立即大声报警(每任务只报一次)
+class StackAudit {
+public:
+    static StackAudit& GetInstance() {
+        static StackAudit instance;
+        return instance;
+    }
+
+    StackAudit(const StackAudit&) = delete;
+    StackAudit& operator=(const StackAudit&) = delete;
+
+    // 遍历所有任务刷新最小剩余栈;O(任务数)且短暂挂起调度器,别放热路径
+    void Sample();
+    // {"alarm_bytes":...,"tasks":[{name,min_remaining,priority}...]},剩余量升序。
+    // min_remaining就是该任务可回收的上界:新栈 = 旧栈 - min_remaining + 余量
+    std::string DumpJson();
+
+private:
+    StackAudit() = default;
+
+    // 剩余栈低于此值视为险情:一次溢出就是看门狗复位,宁可误报
+    static constexpr uint32_t kAlarmBytes = 512;
+
+    struct TaskWatermark {
+        uint32_t min_remaining = 0;
+        uint32_t priority = 0;
+        bool alarmed = false;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, TaskWatermark> tasks_;
+};
+
+#endif // STACK_AUDIT_H
@@ -1,7 +1,14 @@
 #include "system_info.h"
+#include "assets.h"
+#include "settings.h"
 
 #include <freertos/task.h>
+#include <freertos/idf_additions.h>
 #include <esp_log.h>
+#include <cJSON.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <esp_flash.h>
 #include <esp_mac.h>
 #include <esp_system.h>
@@ -144,8 +151,146 @@ void SystemInfo::PrintTaskList() {
     ESP_LOGI(TAG, "Task list: \n%s", buffer);
 }
 
+std::vector<TaskCpuStat> SystemInfo::SampleTaskStats() {
+    std::vector<TaskCpuStat> stats;
+
+    // 上一次采样的各任务运行计数,用于差分;任务句柄复用的误差对诊断可接受。
+    // MCP工具和调试悬浮层可能并发调用,差分状态要加锁
+    static std::mutex sample_mutex;
+    static std::map<TaskHandle_t, configRUN_TIME_COUNTER_TYPE> prev_counters;
+    static configRUN_TIME_COUNTER_TYPE prev_total_run_time = 0;
+    std::lock_guard<std::mutex> lock(sample_mutex);
+
+    UBaseType_t array_size = uxTaskGetNumberOfTasks() + 5;
+    auto array = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * array_size);
+    if (array == nullptr) {
+        return stats;
+    }
+    configRUN_TIME_COUNTER_TYPE total_run_time;
+    array_size = uxTaskGetSystemState(array, array_size, &total_run_time);
+    if (array_size == 0) {
+        free(array);
+        return stats;
+    }
+
+    configRUN_TIME_COUNTER_TYPE total_elapsed = total_run_time - prev_total_run_time;
+    std::map<TaskHandle_t, configRUN_TIME_COUNTER_TYPE> counters;
+    for (UBaseType_t i = 0; i < array_size; i++) {
+        auto& status = array[i];
+        counters[status.xHandle] = status.ulRunTimeCounter;
+
+        configRUN_TIME_COUNTER_TYPE prev = 0;
+        auto it = prev_counters.find(status.xHandle);
+        if (it != prev_counters.end()) {
+            prev = it->second;
+        }
+        uint32_t percent = 0;
+        if (total_elapsed > 0) {
+            percent = (uint32_t)(((uint64_t)(status.ulRunTimeCounter - prev) * 100) /
+                                 ((uint64_t)total_elapsed * CONFIG_FREERTOS_NUMBER_OF_CORES));
+        }
+
+        BaseType_t core_id = xTaskGetCoreID(status.xHandle);
+        stats.push_back(TaskCpuStat{
+            .name = status.pcTaskName,
+            .cpu_percent = percent,
+            .core_id = core_id == tskNO_AFFINITY ? -1 : (int)core_id,
+            .stack_high_water = (uint32_t)status.usStackHighWaterMark,
+            .priority = (uint32_t)status.uxCurrentPriority,
+        });
+    }
+    free(array);
+
+    // 旧map整体换掉,已删除任务的计数自然被清理
+    prev_counters = std::move(counters);
+    prev_total_run_time = total_run_time;
+
+    std::sort(stats.begin(), stats.end(), [](const TaskCpuStat& a, const TaskCpuStat& b) {
+        return a.cpu_percent > b.cpu_percent;
+    });
+    return stats;
+}
+
+std::string SystemInfo::GetTaskStatsJson() {
+    auto stats = SampleTaskStats();
+    auto root = cJSON_CreateObject();
+    auto tasks = cJSON_CreateArray();
+    for (const auto& stat : stats) {
+        auto task = cJSON_CreateObject();
+        cJSON_AddStringToObject(task, "name", stat.name.c_str());
+        cJSON_AddNumberToObject(task, "cpu_percent", stat.cpu_percent);
+        cJSON_AddNumberToObject(task, "core", stat.core_id);
+        cJSON_AddNumberToObject(task, "stack_free", stat.stack_high_water);
+        cJSON_AddNumberToObject(task, "priority", stat.priority);
+        cJSON_AddItemToArray(tasks, task);
+    }
+    cJSON_AddItemToObject(root, "tasks", tasks);
+    cJSON_AddNumberToObject(root, "cores", CONFIG_FREERTOS_NUMBER_OF_CORES);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
+
 void SystemInfo::PrintHeapStats() {
     int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
     int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
     ESP_LOGI(TAG, "free sram: %u minimal sram: %u", free_sram, min_free_sram);
 }
+
+std::string SystemInfo::RunFlashBenchmark() {
+    float seq_mbps = 0;
+    float rand_mbps = 0;
+    bool reads_ok = Assets::GetInstance().BenchmarkReads(&seq_mbps, &rand_mbps);
+    int32_t commit_us = Settings::BenchmarkCommitUs();
+
+    // 基线以KB/s存成int,避免NVS里放浮点
+    Settings baseline("flash_bench", true);
+    int32_t base_seq_kbps = baseline.GetInt("seq_kbps", 0);
+    int32_t base_rand_kbps = baseline.GetInt("rand_kbps", 0);
+    int32_t base_commit_us = baseline.GetInt("commit_us", 0);
+
+    bool degraded = false;
+    if (reads_ok) {
+        int32_t seq_kbps = (int32_t)(seq_mbps * 1024);
+        int32_t rand_kbps = (int32_t)(rand_mbps * 1024);
+        if (base_seq_kbps == 0) {
+            // 首次运行:存为基线
+            baseline.SetInt("seq_kbps", seq_kbps);
+            baseline.SetInt("rand_kbps", rand_kbps);
+            baseline.SetInt("commit_us", commit_us);
+            base_seq_kbps = seq_kbps;
+            base_rand_kbps = rand_kbps;
+            base_commit_us = commit_us;
+        } else {
+            // 读吞吐比基线掉30%以上、或提交延迟涨到3倍就算退化(磨损征兆)
+            degraded = seq_kbps < base_seq_kbps * 7 / 10 ||
+                       rand_kbps < base_rand_kbps * 7 / 10 ||
+                       (commit_us > 0 && base_commit_us > 0 && commit_us > base_commit_us * 3);
+        }
+    }
+
+    auto root = cJSON_CreateObject();
+    if (reads_ok) {
+        cJSON_AddNumberToObject(root, "seq_read_mbps", seq_mbps);
+        cJSON_AddNumberToObject(root, "rand_read_mbps", rand_mbps);
+    }
+    cJSON_AddNumberToObject(root, "nvs_commit_us", commit_us);
+    cJSON_AddNumberToObject(root, "baseline_seq_kbps", base_seq_kbps);
+    cJSON_AddNumberToObject(root, "baseline_rand_kbps", base_rand_kbps);
+    cJSON_AddNumberToObject(root, "baseline_commit_us", base_commit_us);
+    cJSON_AddBoolToObject(root, "degraded", degraded);
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+
+    if (degraded) {
+        ESP_LOGW(TAG, "FLASH_BENCH degraded %s", json.c_str());
+    } else {
+        ESP_LOGI(TAG, "FLASH_BENCH %s", json.c_str());
+    }
+    return json;
+}
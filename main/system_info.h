@@ -2,10 +2,20 @@
 #define _SYSTEM_INFO_H_
 
 #include <string>
+#include <vector>
 
 #include <esp_err.h>
 #include <freertos/FreeRTOS.h>
 
+// 单个任务的CPU/栈采样结果,百分比是相对上一次采样的差分
+struct TaskCpuStat {
+    std::string name;
+    uint32_t cpu_percent;       // 0-100,全核归一化
+    int core_id;                // -1 表示无亲和性
+    uint32_t stack_high_water;  // 历史最小剩余栈(字节)
+    uint32_t priority;
+};
+
 class SystemInfo {
 public:
     static size_t GetFlashSize();
@@ -17,6 +27,13 @@ public:
     static esp_err_t PrintTaskCpuUsage(TickType_t xTicksToWait);
     static void PrintTaskList();
     static void PrintHeapStats();
+    // 按需差分采样:与上一次调用之间的运行时间做差,不阻塞等待采样窗口。
+    // 首次调用返回自开机以来的占比,结果按CPU占用降序
+    static std::vector<TaskCpuStat> SampleTaskStats();
+    static std::string GetTaskStatsJson();
+    // flash健康基准:资产分区顺序/随机读吞吐 + NVS提交延迟,返回JSON。
+    // 首次运行把结果存为基线,之后每次与基线对比并标记退化
+    static std::string RunFlashBenchmark();
 };
 
 #endif // _SYSTEM_INFO_H_
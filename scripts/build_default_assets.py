@@ -17,6 +17,7 @@ import shutil
 import sys
 import json
 import struct
+import uuid
 from datetime import datetime
 
 
@@ -275,7 +276,10 @@ def process_extra_files(extra_files_dir, assets_dir):
 def generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files=None, multinet_model_info=None):
     """Generate index.json file"""
     index_data = {
-        "version": 1
+        "version": 1,
+        # Unique per packaging run; firmware uses it to tell image
+        # generations apart for its NVS-cached warm-boot fast paths
+        "generation": str(uuid.uuid4())
     }
     
     if srmodels:
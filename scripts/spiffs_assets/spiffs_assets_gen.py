@@ -8,6 +8,7 @@ import shutil
 import math
 import sys
 import time
+import zlib
 import numpy as np
 import importlib
 import subprocess
@@ -45,6 +46,7 @@ class PackModelsConfig:
     image_file: str
     assets_path: str
     name_length: int
+    compress: bool = False
 
 def generate_header_filename(path):
     asset_name = os.path.basename(path)
@@ -57,8 +59,10 @@ def compute_checksum(data):
     return checksum
 
 def sort_key(filename):
-    basename, extension = os.path.splitext(filename)
-    return extension, basename
+    # Sort by raw name so the mmap table is strcmp-ordered and the device
+    # can binary-search it in place (firmware falls back to a linear scan
+    # for images built before this change).
+    return filename
 
 def download_v8_script(convert_path):
     """
@@ -429,13 +433,21 @@ def pack_assets(config: PackModelsConfig):
             else:
                 width, height = 0, 0
 
-        file_info_list.append((file_name, len(merged_data), file_size, width, height))
-        # Add 0x5A5A prefix to merged_data
-        merged_data.extend(b'\x5A' * 2)
-
         with open(file_path, 'rb') as bin_file:
             bin_data = bin_file.read()
 
+        # Optionally deflate the payload, keeping it only when it actually
+        # saves space. Compressed entries get a 'ZC' magic plus the original
+        # size so the firmware can decompress transparently.
+        prefix = b'\x5A' * 2
+        if config.compress:
+            compressed = zlib.compress(bin_data, 9)
+            if len(compressed) + 4 < len(bin_data) * 9 // 10:
+                prefix = b'\x5A\x43' + len(bin_data).to_bytes(4, byteorder='little')
+                bin_data = compressed
+
+        file_info_list.append((file_name, len(merged_data), len(bin_data), width, height))
+        merged_data.extend(prefix)
         merged_data.extend(bin_data)
 
     total_files = len(file_info_list)
@@ -557,7 +569,8 @@ def process_assets_build(config_data):
         include_path=include_path,
         image_file=image_file,
         assets_path=assets_path,
-        name_length=name_length
+        name_length=name_length,
+        compress=config_data.get('support_compress', False)
     )
 
     print('--support_format:', support_format)